@@ -14,21 +14,30 @@
 #include "libs/ntest.cpp"
 
 #include "analytics.cpp"
+#include "date_time_format.cpp"
 #include "debug_log.cpp"
+#include "directory_changes.cpp"
+#include "directory_enumeration.cpp"
+#include "directory_traversal.cpp"
 #include "drop_target.cpp"
 #include "explorer.cpp"
 #include "explorer_drop_source.cpp"
 #include "explorer_file_op_progress_sink.cpp"
 #include "file_operations.cpp"
+#include "filesystem_index.cpp"
 #include "finder.cpp"
+#include "fuzzy_match.cpp"
+#include "icon_cache.cpp"
 #include "icon_glyphs.cpp"
 #include "icon_library.cpp"
 #include "imgui_dependent_functions.cpp"
 #include "imgui_extension.cpp"
 #include "imspinner_demo.cpp"
+#include "link_resolution.cpp"
 #include "main_menu_bar.cpp"
 #include "miscellaneous_functions.cpp"
 #include "miscellaneous_globals.cpp"
+#include "name_pattern.cpp"
 #include "path.cpp"
 #include "pinned.cpp"
 #include "popup_modal_bulk_rename.cpp"
@@ -39,12 +48,15 @@
 #include "popup_modal_new_pin.cpp"
 #include "popup_modal_single_rename.cpp"
 #include "recent_files.cpp"
+#include "row_sort.cpp"
 #include "settings.cpp"
 #include "stdafx.cpp"
 #include "style.cpp"
+#include "substring_search.cpp"
 #include "swan_glfw_opengl3.cpp"
 // #include "swan_win32_dx11.cpp"
 #include "tests.cpp"
 #include "theme_editor.cpp"
+#include "trigram_index.cpp"
 #include "undelete_directory_progress_sink.cpp"
 #include "util.cpp"
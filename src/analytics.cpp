@@ -12,6 +12,42 @@ bool swan_windows::render_analytics(std::array<swan_windows::id, (u64)swan_windo
         imgui::Text("%.0f FPS", io.Framerate);
         imgui::SameLineSpaced(2);
         imgui::Text("%.3f ms/frame", 1000.0f / io.Framerate);
+        {
+            //? Of the previous frame, every texture switch splits a draw command.
+            ImDrawData const *draw_data = imgui::GetDrawData();
+            s32 num_draw_cmds = 0;
+            for (s32 i = 0; draw_data != nullptr && i < draw_data->CmdListsCount; ++i) {
+                num_draw_cmds += draw_data->CmdLists[i]->CmdBuffer.Size;
+            }
+            imgui::SameLineSpaced(2);
+            imgui::Text("%d draw commands", num_draw_cmds);
+        }
+
+        imgui::SeparatorText("Icon atlas");
+        {
+            auto &icons = global_state::icons();
+            std::scoped_lock lock(icons.mutex);
+
+            imgui::Text("pages: %zu of %ux%u (%zu before evicting)", icons.atlas.pages.size(), icon_atlas::page_size, icon_atlas::page_size, icon_atlas::soft_max_pages);
+            imgui::Text("occupancy: %.1lf %%, reclaimable: %.1lf %%", icons.atlas.occupancy() * 100.0, icons.atlas.fragmentation() * 100.0);
+            imgui::Text("icons: %zu, repacks: %zu, evictions: %zu", icons.num_icons, icons.num_repacks, icons.num_evictions);
+        }
+
+        imgui::SeparatorText("Icon store");
+        {
+            auto &icons = global_state::icons();
+            f64 cold_start_us;
+            {
+                std::scoped_lock lock(icons.mutex);
+                cold_start_us = icons.cold_start_us;
+            }
+            std::scoped_lock lock(icons.store.mutex);
+
+            imgui::Text("records: %zu, mapped: %zu bytes", icons.store.records.size(), icons.store.size);
+            imgui::Text("hits: %zu, stale: %zu", icons.store.num_hits, icons.store.num_stale);
+            if (cold_start_us < 0) imgui::TextUnformatted("cold start: icons still loading");
+            else imgui::Text("cold start: %.1lf ms until every icon was drawn", cold_start_us / 1000.0);
+        }
 
         imgui::Separator();
 
@@ -124,7 +124,7 @@ namespace swan_popup_modals
     constexpr char const *label_new_file = " New File ## popup_modal";
     constexpr char const *label_new_directory = " New Directory ## popup_modal";
 
-    void open_single_rename(explorer_window &expl_opened_from, explorer_window::dirent const &rename_target, std::function<void ()> on_rename_callback) noexcept;
+    void open_single_rename(explorer_window &expl_opened_from, basic_dirent const &rename_target, std::function<void ()> on_rename_callback) noexcept;
     void open_bulk_rename(explorer_window &expl_opened_from, std::function<void ()> on_rename_callback) noexcept;
     void open_error(char const *action, char const *failure, bool beautify_action = false, bool beautify_failure = false) noexcept;
     void open_new_pin(swan_path const &initial_path_value, bool mutable_path) noexcept;
@@ -194,6 +194,9 @@ namespace global_state
     std::vector<s64> &delete_icon_textures_queue() noexcept;
 
     std::array<explorer_window, global_constants::num_explorers> &explorers() noexcept;
+    directory_listing_cache &listing_cache() noexcept;
+    link_resolution_cache &link_cache() noexcept;
+    icon_cache &icons() noexcept;
 
 } // namespace global_state
 
@@ -266,9 +269,10 @@ ImVec4 compute_drive_usage_color(f32 fraction_used) noexcept;
 
 bool find_in_swan_explorer_0(char const *full_path) noexcept;
 
-std::pair<s64, ImVec2> load_icon_texture(char const *full_path_utf8 = nullptr,
-                                         wchar_t const *full_path_utf16 = nullptr,
-                                         char const *debug_label = nullptr) noexcept;
+/// Asks the shell for the small icon of a file and copies its pixels out. Doesn't touch OpenGL, so workers can call it
+/// (with COM initialized on their thread), the UI thread then packs the pixels into the icon atlas (see `icon_cache::update`).
+/// With `by_extension` the path needn't exist, the shell answers with the icon of its type.
+bool extract_icon_pixels(wchar_t const *full_path_utf16, icon_pixels &out, bool by_extension = false) noexcept;
 
 void delete_icon_texture(s64 &id, char const *debug_label = nullptr) noexcept;
 
@@ -280,8 +284,7 @@ void pop_back(global_state::completed_file_operations &obj) noexcept;
 
 void erase(global_state::recent_files &obj,
            std::deque<recent_file>::iterator first,
-           std::deque<recent_file>::iterator last,
-           bool delete_icon_texture = true) noexcept;
+           std::deque<recent_file>::iterator last) noexcept;
 
 void open_file_properties(char const *full_path_utf8) noexcept;
 
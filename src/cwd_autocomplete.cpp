@@ -1,6 +1,7 @@
 #include "stdafx.hpp"
 #include "data_types.hpp"
 #include "imgui_dependent_functions.hpp"
+#include "directory_enumeration.hpp"
 
 struct directory_completion_suggestions
 {
@@ -30,57 +31,41 @@ void find_cwd_completion_suggestions(directory_completion_suggestions &completio
     completion_suggestions.search_task.active_token.store(true);
     SCOPE_EXIT { completion_suggestions.search_task.active_token.store(false); };
 
-    wchar_t search_path_utf16[MAX_PATH];
+    directory_enumerator enumerator;
 
-    if (!utf8_to_utf16(parent_path_utf8.data(), search_path_utf16, lengthof(search_path_utf16))) {
+    if (!enumerator.open(parent_path_utf8.data())) {
+        print_debug_msg("directory_enumerator::open failed [%s]", parent_path_utf8.data());
         return;
     }
 
-    if (search_path_utf16[wcslen(search_path_utf16) - 1] != L'\\') {
-        (void) StrCatW(search_path_utf16, L"\\");
-    }
-    (void) StrCatW(search_path_utf16, L"*");
-
-    WIN32_FIND_DATAW find_data;
-    HANDLE find_handle = FindFirstFileW(search_path_utf16, &find_data);
-    SCOPE_EXIT { FindClose(find_handle); };
-
-    if (find_handle == INVALID_HANDLE_VALUE) {
-        print_debug_msg("find_handle == INVALID_HANDLE_VALUE [%s]", parent_path_utf8.data());
-        return;
-    }
+    directory_entry_batch batch = {};
 
-    do {
-        if (search_task.cancellation_token.load() == true) {
-            return;
-        }
+    while (enumerator.next_batch(batch) > 0) {
+        for (auto const &found : batch.entries) {
+            if (search_task.cancellation_token.load() == true) {
+                return;
+            }
 
-        if (!(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
-            continue;
-        }
+            if (found.kind != directory_entry_kind::directory) {
+                continue;
+            }
 
-        swan_path found_file_name = path_create("");
+            char const *found_file_name = batch.name(found);
 
-        if (!utf16_to_utf8(find_data.cFileName, found_file_name.data(), found_file_name.size())) {
-            continue;
-        }
-        if (path_equals_exactly(found_file_name, ".") || path_equals_exactly(found_file_name, "..")) {
-            continue;
-        }
-        if (cstr_eq(found_file_name.data(), search_value.data())) {
-            continue;
-        }
+            if (cstr_eq(found_file_name, search_value.data())) {
+                continue;
+            }
 
-        if (cstr_starts_with(found_file_name.data(), search_value.data())) {
-            std::scoped_lock lock(search_task.result_mutex);
-            search_task.result.emplace_back(directory_completion_suggestions::match::type::starts_with, found_file_name);
-        }
-        else if (strstr(found_file_name.data(), search_value.data())) {
-            std::scoped_lock lock(search_task.result_mutex);
-            search_task.result.emplace_back(directory_completion_suggestions::match::type::substr, found_file_name);
+            if (cstr_starts_with(found_file_name, search_value.data())) {
+                std::scoped_lock lock(search_task.result_mutex);
+                search_task.result.emplace_back(directory_completion_suggestions::match::type::starts_with, path_create(found_file_name, found.name_len));
+            }
+            else if (strstr(found_file_name, search_value.data())) {
+                std::scoped_lock lock(search_task.result_mutex);
+                search_task.result.emplace_back(directory_completion_suggestions::match::type::substr, path_create(found_file_name, found.name_len));
+            }
         }
     }
-    while (FindNextFileW(find_handle, &find_data));
 }
 
 #if 0
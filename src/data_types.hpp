@@ -16,6 +16,15 @@ typedef BS::thread_pool swan_thread_pool_t;
 
 #include "path.hpp"
 #include "util.hpp"
+#include "directory_enumeration.hpp"
+#include "directory_traversal.hpp"
+#include "directory_changes.hpp"
+#include "filesystem_index.hpp"
+#include "fuzzy_match.hpp"
+#include "icon_cache.hpp"
+#include "link_resolution.hpp"
+#include "name_pattern.hpp"
+#include "substring_search.hpp"
 
 inline ImVec4 default_success_color() noexcept { return ImVec4(0, 1, 0, 1); }
 inline ImVec4 default_warning_color() noexcept { return ImVec4(1, 0.5f, 0, 1); }
@@ -50,6 +59,72 @@ struct async_task
     std::atomic_bool active_token = false;
 };
 
+/// Append only list of heap allocated items, readable while other threads append, without locks. Appending claims an index
+/// with an atomic increment, items live in segments of slots allocated on first use and never move.
+/// An item becomes visible (`get` stops returning nullptr) once stored, items may become visible slightly out of order.
+template <typename T>
+struct append_only_list
+{
+    static constexpr u64 slots_per_segment = 1024;
+    static constexpr u64 max_segments = 4096; // 4M items
+
+    append_only_list() noexcept = default;
+    append_only_list(append_only_list const &) = delete;
+    append_only_list &operator=(append_only_list const &) = delete;
+    ~append_only_list() noexcept { clear(); }
+
+    /// Any thread. The index of the item, UINT64_MAX if every slot is taken, in which case the item is dropped.
+    u64 push_back(T &&item) noexcept
+    {
+        u64 idx = this->num_reserved.fetch_add(1);
+        u64 segment_idx = idx / slots_per_segment;
+        if (segment_idx >= max_segments) {
+            return UINT64_MAX;
+        }
+        auto *segment = this->segments[segment_idx].load(std::memory_order_acquire);
+        if (segment == nullptr) {
+            auto *fresh = new std::atomic<T *>[slots_per_segment]();
+            if (this->segments[segment_idx].compare_exchange_strong(segment, fresh, std::memory_order_acq_rel)) {
+                segment = fresh;
+            } else {
+                delete[] fresh; // another thread got there first, `segment` is theirs
+            }
+        }
+        segment[idx % slots_per_segment].store(new T(std::move(item)), std::memory_order_release);
+        return idx;
+    }
+
+    /// Any thread. Nullptr until item `idx` is stored.
+    T const *get(u64 idx) const noexcept
+    {
+        u64 segment_idx = idx / slots_per_segment;
+        if (segment_idx >= max_segments) {
+            return nullptr;
+        }
+        auto *segment = this->segments[segment_idx].load(std::memory_order_acquire);
+        return segment == nullptr ? nullptr : segment[idx % slots_per_segment].load(std::memory_order_acquire);
+    }
+
+    /// Frees every item, nothing may be appending or reading.
+    void clear() noexcept
+    {
+        for (auto &segment_ptr : this->segments) {
+            auto *segment = segment_ptr.exchange(nullptr);
+            if (segment == nullptr) {
+                continue;
+            }
+            for (u64 i = 0; i < slots_per_segment; ++i) {
+                delete segment[i].load();
+            }
+            delete[] segment;
+        }
+        this->num_reserved.store(0);
+    }
+
+    std::array<std::atomic<std::atomic<T *> *>, max_segments> segments = {};
+    std::atomic<u64> num_reserved = 0;
+};
+
 struct generic_result
 {
     bool success;
@@ -57,6 +132,91 @@ struct generic_result
     std::string error_or_utf8_path;
 };
 
+/// Growable array of bits, e.g. one flag per row of a column-wise table. Bits past `size()` in the last word are always zero.
+struct packed_bits
+{
+    std::vector<u64> words = {};
+    u64 num_bits = 0;
+
+    u64 size() const noexcept { return num_bits; }
+
+    bool get(u64 idx) const noexcept
+    {
+        assert(idx < num_bits);
+        return (words[idx >> 6] >> (idx & 63)) & 1;
+    }
+
+    void set(u64 idx, bool value) noexcept
+    {
+        assert(idx < num_bits);
+        u64 mask = u64(1) << (idx & 63);
+        if (value) words[idx >> 6] |= mask;
+        else       words[idx >> 6] &= ~mask;
+    }
+
+    void push_back(bool value) noexcept
+    {
+        if ((num_bits & 63) == 0) {
+            words.push_back(0);
+        }
+        ++num_bits;
+        set(num_bits - 1, value);
+    }
+
+    void assign(u64 count, bool value) noexcept
+    {
+        num_bits = count;
+        words.assign((count + 63) / 64, value ? u64(-1) : u64(0));
+        if (value && (count & 63)) {
+            words.back() = (u64(1) << (count & 63)) - 1;
+        }
+    }
+
+    u64 count_set() const noexcept
+    {
+        u64 result = 0;
+        for (u64 word : words) {
+            result += (u64)std::popcount(word);
+        }
+        return result;
+    }
+
+    void clear() noexcept { words.clear(); num_bits = 0; }
+};
+
+/// Set of names (e.g. file names within one directory), stored back to back in an arena and indexed by an open addressing
+/// hash table. A lookup is one hash plus one memcmp per hash collision, instead of a scan or sort of `swan_path`s.
+struct name_hash_set
+{
+    struct slot
+    {
+        u64 hash;
+        u32 name_offset;
+        u16 name_len;
+        u8 state; // 0 = empty, 1 = occupied, 2 = erased
+    };
+
+    std::vector<slot> slots = {}; // size is 0 or a power of two
+    std::vector<char> names = {};
+    u64 num_occupied = 0;
+    u64 num_erased = 0;
+
+    static u64 hash(std::string_view name) noexcept;
+
+    u64 size() const noexcept { return num_occupied; }
+    bool empty() const noexcept { return num_occupied == 0; }
+    void clear() noexcept;
+    void reserve(u64 num_names) noexcept;
+
+    bool insert(std::string_view name) noexcept; // false if already present
+    bool contains(std::string_view name) const noexcept;
+    bool erase(std::string_view name) noexcept; // false if not present
+
+private:
+    u64 find_slot(std::string_view name, u64 name_hash) const noexcept; // index of the matching slot, or of the empty slot ending the probe
+    void rehash(u64 num_slots) noexcept;
+};
+
 struct winapi_error
 {
     DWORD code;
@@ -128,6 +288,8 @@ struct basic_dirent
 
     static bool is_symlink(kind t) noexcept;
     static char const *kind_description(kind t) noexcept;
+    static char const *kind_short_cstr(kind t) noexcept;
+    static char const *kind_icon(kind t) noexcept;
 };
 
 struct drive_info
@@ -142,8 +304,7 @@ typedef static_vector<drive_info, ('Z' - 'A' + 1)> drive_info_array_t;
 
 struct drive_entry
 {
-    s64 icon_GLtexID = 0; // -1 means load failed, 0 means no load attempted, > 0 means valid
-    ImVec2 icon_size = {};
+    icon_handle icon = {};
     drive_info info;
 };
 typedef static_vector<drive_entry, ('Z' - 'A' + 1)> drive_entry_array_t;
@@ -177,6 +338,8 @@ struct swan_settings
     ImVec4 symlink_color = default_symlink_color();
 
     s32 num_max_file_operations = 100'000;
+    s32 explorer_parallel_filter_min_entries = 50'000; // directories with at least this many entries are filtered on the thread pool, 0 never
+    s32 finder_num_threads = 0; // how many threads a finder search walks directories with, 0 for one per hardware thread
 
     s32 window_x = 10, window_y = 40; //! must be adjacent, y must come after x in memory
     s32 window_w = 1280, window_h = 720; //! must be adjacent, h must come after w in memory
@@ -250,44 +413,231 @@ struct swan_settings
 
 enum update_cwd_entries_actions : u8
 {
-    nil              = 0b00, // 0
-    query_filesystem = 0b01, // 1
-    filter           = 0b10, // 2
-    full_refresh     = 0b11, // 3
+    nil                   = 0b000, // 0
+    query_filesystem      = 0b001, // 1
+    filter                = 0b010, // 2
+    full_refresh          = 0b011, // 3
+    blocking              = 0b100, // 4, list on the calling thread and merge before returning instead of streaming from the thread pool
+    full_refresh_blocking = 0b111, // 7
+};
+
+/// Totals shown in the explorer header, over all children of the cwd.
+struct cwd_count_info
+{
+    u64 selected_dirents;
+    u64 selected_directories;
+    // u64 selected_symlinks;
+    u64 selected_files;
+    u64 selected_files_size;
+
+    u64 filtered_dirents;
+    u64 filtered_directories;
+    // u64 filtered_symlinks;
+    u64 filtered_files;
+
+    u64 child_dirents;
+    u64 child_directories;
+    // u64 child_symlinks;
+    u64 child_files;
+
+    bool operator==(cwd_count_info const &) const noexcept = default;
 };
 
 struct explorer_window
 {
-    struct dirent
+    /// Renderer-only state for one row of `cwd_entries`.
+    /// Kept out of the hot columns so that sorting and filtering don't drag it through the cache.
+    struct dirent_ui_state
     {
-        basic_dirent basic = {};
-        ptrdiff_t highlight_start_idx = 0;
-        u64 highlight_len = 0;
+        highlight_spans highlight = {};
+        s32 filter_score = 0; // fuzzy filter score, ranks rows when sorting by score
         u32 spotlight_frames_remaining = 0;
-        s64 icon_GLtexID = 0; // -1 means load failed, 0 means no load attempted, > 0 means valid
-        ImVec2 icon_size = {};
-
-    #define CACHE_FORMATTED_STRING_COLUMNS 1
-    #if CACHE_FORMATTED_STRING_COLUMNS
-        std::array<char, 64> creation_time;
-        std::array<char, 64> last_write_time;
-        std::array<char, 32> formatted_size;
-    #endif
-
-        bool filtered = false;
-        bool selected = false;
-        bool cut = false;
+        icon_handle icon = {}; // empty until the row is first shown
         bool context_menu_active = false;
     };
 
+    /// Text of the size and time columns, formatted only for rows the table clipper shows.
+    /// Direct-mapped by row: a slot remembers the values it was formatted from and is redone when the row's values differ,
+    /// so sorting, filtering and change notifications need no invalidation, and rows never scrolled to cost nothing.
+    struct column_text_cache
+    {
+        struct slot
+        {
+            u64 size;
+            u64 creation_time;
+            u64 last_write_time;
+            u32 format_generation; // 0 means never formatted
+            u32 size_unit_multiplier;
+            std::array<char, 16> size_text;
+            std::array<char, 48> creation_time_text;
+            std::array<char, 48> last_write_time_text;
+        };
+
+        static constexpr u64 num_slots = 256; // more than a table shows at once
+
+        std::vector<slot> slots = {};
+    };
+
+    struct dirent;
+
+    /// All direct children of the cwd, stored column-wise: row `i` of every column describes the same entry.
+    /// Names live back to back in a single arena instead of one ~1 KB `swan_path` per entry.
+    /// Rows are kept in display order, i.e. unfiltered rows (sorted) followed by filtered rows.
+    struct dirent_table
+    {
+        //? Hot columns, read by sort/filter/render for every row.
+        std::vector<u32> name_offsets = {};                 // into `names`
+        std::vector<u16> name_lengths = {};                 // excluding NUL
+        std::vector<u64> sizes = {};
+        std::vector<u64> creation_times = {};               // FILETIME as u64
+        std::vector<u64> last_write_times = {};             // FILETIME as u64
+        std::vector<u32> ids = {};
+        std::vector<basic_dirent::kind> kinds = {};
+        packed_bits selected = {};
+        packed_bits filtered = {};
+        packed_bits cut = {};
+
+        //? Cold column, only touched for rows the table renderer shows.
+        std::vector<dirent_ui_state> ui = {};
+
+        std::vector<char> names = {}; // NUL terminated UTF-8 names, back to back
+
+        //? Header totals, kept current by `dirent::set_selected` so clicking around doesn't rescan every row.
+        //? Anything which rewrites whole columns (listing, filtering, change notifications) marks them stale instead,
+        //? and the next `up_to_date_counts` recounts once.
+        cwd_count_info counts = {};
+        bool counts_stale = true;
+
+        cwd_count_info const &up_to_date_counts() noexcept;
+        cwd_count_info recount() const noexcept; // full pass over every row, ignores `counts`
+        void count_selection_change(u64 row, bool selected) noexcept;
+        void invalidate_counts() noexcept { counts_stale = true; }
+
+        u64 count() const noexcept { return ids.size(); }
+        bool empty() const noexcept { return ids.empty(); }
+
+        char const *name(u64 row) const noexcept { return names.data() + name_offsets[row]; }
+        bool is_path_dotdot(u64 row) const noexcept { return name_lengths[row] == 2 && name(row)[0] == '.' && name(row)[1] == '.'; }
+        u64 find_id(u32 id) const noexcept; // row of the entry with `id`, u64(-1) if there is none
+
+        /// New state of one entry, for `apply_changes`: what change notifications said about its name, and what querying it found.
+        struct change
+        {
+            std::string_view name = {};
+            std::string_view renamed_from = {}; // if renamed, the row of its old name passes on its id, selection and context menu
+            bool exists = false;
+            bool select = false;          // select its row
+            bool unresolved_link = false; // `kind` is a guess, a row which already was a link keeps its kind until resolved
+            basic_dirent::kind kind = basic_dirent::kind::file;
+            u64 size = 0;
+            u64 creation_time = 0;
+            u64 last_write_time = 0;
+            u64 row = u64(-1);            // set by `apply_changes`: its row afterwards, u64(-1) if it doesn't exist
+        };
+
+        /// Brings the rows in line with `changes` without sorting everything again. Rows are expected in display order, i.e. sorted
+        /// unfiltered rows then filtered rows: untouched rows keep their order, changed and new ones are merged in with `row_less`.
+        /// `filter_new_rows(first_row)` sets `filtered` for rows pushed from `first_row` on. An entry which changed kind or name gets
+        /// a new row (filtered and sorted as what it is now) but keeps its id, selection and context menu. Returns the first filtered row.
+        u64 apply_changes(std::vector<change> &changes, std::function<void (u64 first_row)> const &filter_new_rows,
+                          std::function<bool (u32 left, u32 right)> const &row_less) noexcept;
+
+        u64 push_back(std::string_view name, basic_dirent::kind kind, u64 size, u64 creation_time, u64 last_write_time, u32 id) noexcept;
+        void swap_rows(u64 row_a, u64 row_b) noexcept;
+        void apply_permutation(std::vector<u32> const &new_to_old_row) noexcept; // row `i` afterwards is row `new_to_old_row[i]` before, rows not mentioned are dropped
+        void permute_prefix(std::vector<u32> const &new_to_old_row) noexcept; // like `apply_permutation` within rows [0, new_to_old_row.size()), later rows stay put
+        void compact_names() noexcept; // drops names of rows removed by `apply_permutation` from the arena
+        void reserve(u64 num_rows, u64 num_name_bytes) noexcept;
+        void clear() noexcept;
+
+        basic_dirent make_basic_dirent(u64 row) const noexcept; // materializes a full `swan_path`, for code paths that need one
+
+        u64 bytes_occupied() const noexcept;
+        u64 bytes_reserved() const noexcept;
+
+        dirent operator[](u64 row) noexcept { return { this, row }; }
+
+        struct iterator
+        {
+            dirent_table *table;
+            u64 row;
+
+            dirent operator*() const noexcept { return { table, row }; }
+            iterator &operator++() noexcept { ++row; return *this; }
+            bool operator!=(iterator const &other) const noexcept { return row != other.row; }
+        };
+
+        iterator begin() noexcept { return { this, 0 }; }
+        iterator end() noexcept { return { this, count() }; }
+    };
+
+    /// Handle to one row of a `dirent_table`. Cheap to copy, invalidated by anything which reorders or clears the table.
+    struct dirent
+    {
+        dirent_table *table;
+        u64 row;
+
+        char const *name() const noexcept { return table->name(row); }
+        u16 name_len() const noexcept { return table->name_lengths[row]; }
+        basic_dirent::kind type() const noexcept { return table->kinds[row]; }
+        u64 size() const noexcept { return table->sizes[row]; }
+        u32 id() const noexcept { return table->ids[row]; }
+        FILETIME creation_time_raw() const noexcept { return one_u64_to_filetime(table->creation_times[row]); }
+        FILETIME last_write_time_raw() const noexcept { return one_u64_to_filetime(table->last_write_times[row]); }
+        dirent_ui_state &ui() const noexcept { return table->ui[row]; }
+        basic_dirent basic() const noexcept { return table->make_basic_dirent(row); }
+
+        bool selected() const noexcept { return table->selected.get(row); }
+        bool filtered() const noexcept { return table->filtered.get(row); }
+        bool cut() const noexcept { return table->cut.get(row); }
+        void set_selected(bool value) const noexcept { if (selected() != value) { table->selected.set(row, value); table->count_selection_change(row, value); } }
+        void set_filtered(bool value) const noexcept { table->filtered.set(row, value); table->invalidate_counts(); }
+        void set_cut(bool value) const noexcept { table->cut.set(row, value); }
+
+        bool is_path_dotdot() const noexcept { return table->is_path_dotdot(row); }
+        bool is_dotdot_dir() const noexcept { return type() == basic_dirent::kind::directory && is_path_dotdot(); }
+        bool is_directory() const noexcept { return type() == basic_dirent::kind::directory; }
+        bool is_symlink() const noexcept { return basic_dirent::is_symlink(type()); }
+        bool is_symlink_to_file() const noexcept { return type() == basic_dirent::kind::symlink_to_file; }
+        bool is_symlink_to_directory() const noexcept { return type() == basic_dirent::kind::symlink_to_directory; }
+        bool is_symlink_ambiguous() const noexcept { return type() == basic_dirent::kind::symlink_ambiguous; }
+        bool is_file() const noexcept { return type() == basic_dirent::kind::file; }
+        char const *kind_short_cstr() const noexcept { return basic_dirent::kind_short_cstr(type()); }
+        char const *kind_icon() const noexcept { return basic_dirent::kind_icon(type()); }
+    };
+
     enum filter_mode : u64
     {
         contains = 0,
         regex_match,
-        // glob,
+        glob,
+        fuzzy,
         count,
     };
 
+    /// `filter_text` compiled for `filter_mode` and `filter_case_sensitive`, rebuilt by `compile_filter` only when one of those changes.
+    struct compiled_filter
+    {
+        std::string text = {};
+        filter_mode mode = filter_mode::count;
+        bool case_sensitive = false;
+        substring_matcher substring = {}; // contains
+        name_pattern pattern = {};        // regex_match, glob
+        fuzzy_matcher fuzzy = {};         // fuzzy
+    };
+
+    /// The query which the `filtered` flags of `cwd_entries` currently reflect, recorded by `filter_cwd_entries`.
+    struct applied_filter
+    {
+        std::string text = {};
+        filter_mode mode = filter_mode::count;
+        bool case_sensitive = false;
+        bool polarity = true;
+        bool show_directories = true;
+        bool show_files = true;
+        bool valid = false;
+    };
+
     enum cwd_entries_table_col : ImGuiID
     {
         cwd_entries_table_col_number,
@@ -327,6 +677,59 @@ struct explorer_window
         std::string_view parent_dir,
         std::source_location sloc = std::source_location::current()) noexcept;
 
+    /// Moves batches published by the listing task into `cwd_entries`, filters and sorts. Called once per frame by the UI thread.
+    /// @return Number of merged entries which were selected, either preserved from before the refresh or from `select_cwd_entries_on_next_update`.
+    u64 merge_cwd_listing() noexcept;
+
+    struct update_cwd_entries_timers;
+    void filter_cwd_entries(u64 first_row, update_cwd_entries_timers &timers) noexcept;
+
+    /// Re-tests only the visible rows [0, `first_filtered_cwd_dirent_row`) when the filter query refines `filter_applied`:
+    /// contains mode showing matches, same case sensitivity and type toggles, and the new text contains the old text.
+    /// Rows which no longer match are moved behind the visible ones, which keep their sorted order.
+    /// @return False if the query isn't a refinement, everything has to be filtered and sorted instead.
+    bool narrow_cwd_entries_filter(update_cwd_entries_timers &timers) noexcept;
+
+    /// Brings `filter_compiled` up to date with the filter inputs, sets `filter_error` if the pattern doesn't compile.
+    /// @return False if there is no valid pattern, entries are then only filtered by type.
+    bool compile_filter(update_cwd_entries_timers &timers) noexcept;
+
+    /// Applies change notifications to `cwd_entries` in place: vanished rows are dropped, new and modified rows are queried and
+    /// (re)inserted at their sorted position, everything else keeps its icon, formatting and selection.
+    /// @return False if the changes can't be applied incrementally (overflowed, listing in flight), the caller should re-query instead.
+    bool apply_cwd_changes(directory_change_batch const &changes) noexcept;
+
+    /// Adds the names of selected rows to `cwd_listing_preserve_select`, queues icon textures for deletion and clears `cwd_entries`.
+    void release_cwd_entries(update_cwd_entries_timers &timers) noexcept;
+
+    /// Stores a copy of `cwd_entries` in the global directory listing cache, keyed by `cwd_entries_path`.
+    void cache_cwd_entries(u64 dir_last_write_time) noexcept;
+
+    /// Caches `cwd_entries` when navigating away, stamped with `cwd_entries_dir_write_time` rather than the directory's current
+    /// last write time, which may already cover changes the rows lack. Skipped while anything may still be missing from them:
+    /// a listing in progress, a requested refresh, or change notifications not read yet.
+    void cache_cwd_entries_before_leaving() noexcept;
+
+    /// Links (.lnk shortcuts) whose targets a worker has to classify, taken from `cwd_entries` at the time of the request.
+    struct link_job
+    {
+        directory_entry_batch links = {}; // name and last write time of every link
+        std::vector<u32> ids = {};        // parallel to links.entries
+    };
+
+    struct resolved_link
+    {
+        u32 id;
+        basic_dirent::kind kind;
+    };
+
+    /// Hands `rows` (which should be links) to thread pool workers in small jobs. Their kinds are patched in by `merge_resolved_links`.
+    void resolve_links_async(std::vector<u32> const &rows) noexcept;
+
+    /// Patches kinds resolved by workers into `cwd_entries`, then filters and sorts again. Called once per frame by the UI thread.
+    /// @return True if any row changed kind.
+    bool merge_resolved_links() noexcept;
+
     void advance_history(swan_path const &new_latest_entry) noexcept;
 
     // 104 byte alignment members
@@ -337,6 +740,32 @@ struct explorer_window
 
     std::mutex shlwapi_task_initialization_mutex = {};
     std::mutex select_cwd_entries_on_next_update_mutex = {};
+    std::mutex resolved_links_mutex = {};
+
+    /// Output of the thread pool task which lists the cwd. Every request bumps `cwd_listing_generation`,
+    /// a task only publishes while its generation is the latest one, so a superseded listing never reaches `cwd_entries`.
+    struct cwd_listing
+    {
+        struct batch
+        {
+            directory_entry_batch entries = {};
+            std::vector<basic_dirent::kind> kinds = {}; // parallel to entries.entries, .lnk files are resolved by the task
+            u32 first_id = 0;
+            time_point_precise_t time_published = {};
+        };
+
+        std::vector<batch> batches = {}; // published, not yet merged
+        u64 generation = 0;
+        u64 dir_last_write_time = 0; // of the listed directory itself, queried before listing, 0 if unknown
+        f64 queue_latency_us = 0;
+        f64 filesystem_us = 0;
+        bool opened = false;
+        bool finished = false;
+        bool replace = false;   // batches replace the rows on screen instead of adding to them, set when revalidating a cached listing
+        bool unchanged = false; // revalidation found the directory untouched since it was cached, nothing to merge
+    };
+
+    progressive_task<cwd_listing> cwd_listing_task = {};
 
     // 72 byte alignment members
 
@@ -362,8 +791,11 @@ struct explorer_window
 
     // 24 byte alignment members
 
-    std::vector<dirent> cwd_entries = {};                           // all direct children of the cwd
-    std::vector<swan_path> select_cwd_entries_on_next_update = {};  // entries to select on the next update of cwd_entries
+    dirent_table cwd_entries = {};                                  // all direct children of the cwd
+    column_text_cache cwd_entries_column_text = {};                 // size and time column text of rows on screen
+    std::vector<resolved_link> resolved_links = {};                 // published by link resolution workers, guarded by resolved_links_mutex
+    name_hash_set select_cwd_entries_on_next_update = {};           // entries to select on the next update of cwd_entries
+    name_hash_set cwd_listing_preserve_select = {};                 // entries selected before the refresh, reselected as the listing is merged
 
     drive_entry_array_t drives = {};
 
@@ -378,6 +810,8 @@ struct explorer_window
 
     char const *name = nullptr;
     filter_mode filter_mode = filter_mode::contains;    // persisted in file
+    compiled_filter filter_compiled = {};
+    applied_filter filter_applied = {};
     u64 cwd_latest_selected_dirent_idx = u64(-1);       // idx of most recently clicked cwd entry
     u64 wd_history_pos = 0;                             // where in wd_history we are, persisted in file
     u64 nth_last_cwd_dirent_scrolled = u64(-1);
@@ -386,9 +820,12 @@ struct explorer_window
     time_point_precise_t read_dir_changes_refresh_request_time = {};
     time_point_precise_t last_filesystem_query_time = {};
     time_point_precise_t last_drives_refresh_time = {};
-    dirent *context_menu_target = nullptr;
     s64 tabbing_focus_idx = -1;
-    std::vector<dirent>::iterator first_filtered_cwd_dirent_iter;
+    u64 first_filtered_cwd_dirent_row = 0;
+    u64 cwd_entries_dir_write_time = 0;                 // of `cwd_entries_path` as of when `cwd_entries` were last known current, 0 if unknown
+    std::atomic<u64> cwd_listing_generation = 0;
+    std::atomic<u64> link_resolution_generation = 0;    // bumped whenever row ids are reassigned, see `resolve_links_async`
+    std::atomic<u64> num_links_resolving = 0;
 
     static u64 const NUM_TIMING_SAMPLES = 10;
 
@@ -398,17 +835,29 @@ struct explorer_window
         f64 searchpath_setup_us = 0;
         f64 filesystem_us = 0;
         f64 filter_us = 0;
-        f64 regex_ctor_us = 0;
-        f64 entries_to_select_sort = 0;
-        f64 entries_to_select_search = 0;
+        f64 regex_ctor_us = 0;     // compiling the filter pattern, only when it changed
+        f64 preserve_select_build_us = 0;  // hashing the names of selected entries before they are cleared
+        f64 entries_to_select_search = 0;  // looking up merged entries in both selection sets
+        f64 queue_latency_us = 0; // request until the listing task starts running on the thread pool
+        f64 merge_latency_us = 0; // longest wait of a published batch before the UI thread merged it
+        f64 merge_us = 0;         // UI thread time spent merging batches, summed over the whole listing
+        f64 cache_us = 0;         // looking up the listing cache and copying rows in or out of it
+        f64 filter_work_us = 0;   // filter time summed over every thread which took part, equals filter_us when it ran serially
+        u32 filter_threads = 0;   // threads the widest filter pass ran on, 1 when serial
+        bool cache_hit = false;
     };
 
+    update_cwd_entries_timers cwd_listing_timers = {}; // for the listing in flight, pushed to samples once it finishes
+
     mutable circular_buffer<update_cwd_entries_timers> update_cwd_entries_timing_samples = circular_buffer<update_cwd_entries_timers>(NUM_TIMING_SAMPLES);
     mutable circular_buffer<f64> sort_timing_samples                                     = circular_buffer<f64>(NUM_TIMING_SAMPLES);
     mutable circular_buffer<f64> save_to_disk_timing_samples                             = circular_buffer<f64>(NUM_TIMING_SAMPLES);
     mutable circular_buffer<f64> find_first_filtered_cwd_dirent_timing_samples           = circular_buffer<f64>(NUM_TIMING_SAMPLES);
+    mutable circular_buffer<f64> apply_cwd_changes_timing_samples                        = circular_buffer<f64>(NUM_TIMING_SAMPLES);
 
     mutable u64 num_file_finds = 0;
+    mutable u64 num_changes_applied = 0;
+    mutable u64 num_links_resolved = 0;
     mutable f64 check_if_pinned_us = 0;
     mutable f64 unpin_us = 0;
     mutable f64 update_cwd_entries_culmulative_us = 0;
@@ -423,7 +872,8 @@ struct explorer_window
     s32 id = -1;
     DWORD read_dir_changes_buffer_bytes_written = 0;
     s32 frame_count_when_cwd_entries_updated = -1;
-    std::array<std::byte, 64*1024> read_dir_changes_buffer = {};
+    u32 context_menu_target_id = UINT32_MAX;  // rather than its row, rows move around while the menu is open
+    alignas(DWORD) std::array<std::byte, 64*1024> read_dir_changes_buffer = {}; // FILE_NOTIFY_INFORMATION records must be DWORD aligned
     f32 cwd_input_text_scroll_x = -1;
 
     // 1 byte alignment members
@@ -431,9 +881,11 @@ struct explorer_window
     swan_path latest_valid_cwd = {};              // latest value of cwd which was a valid directory
     swan_path cwd = {};                           // current working directory, persisted in file
     swan_path read_dir_changes_target = {};       // value of current working directory when ReadDirectoryChangesW was called
+    swan_path cwd_entries_path = {};              // directory which cwd_entries was last listed from
     std::array<char, 256> filter_text = {};       // persisted in file
     bool filter_case_sensitive = false;           // persisted in file
     bool filter_polarity = true;                  // persisted in file
+    bool filter_sort_by_score = true;             // persisted in file, fuzzy mode ranks visible rows by score before the column sort specs
     bool filter_show_directories = true;          // persisted in file
     bool filter_show_files = true;                // persisted in file
     bool filter_show_symlink_directories = true;  // persisted in file
@@ -447,12 +899,16 @@ struct explorer_window
 
     bool show_filter_window = false;
     bool filter_text_input_focused = false;
+    bool cwd_entries_ranked_by_score = false;     // the last sort_cwd_entries ranked visible rows by fuzzy filter score
     bool cwd_latest_selected_dirent_idx_changed = false;
+    bool debug_verify_cwd_counts = false;         // recount every frame and assert the incrementally kept counts agree
     bool footer_hovered = false;
     bool footer_filter_info_hovered = false;
     bool footer_selection_info_hovered = false;
     bool footer_clipboard_hovered = false;
     bool tabbing_set_focus = false;
+    bool cwd_listing_pending = false; // listing requested and not fully merged yet
+    bool cwd_entries_cached = false;  // the listing cache holds exactly what cwd_entries holds, no need to store it again when leaving
 
     update_cwd_entries_actions update_request_from_outside = nil; /* how code from outside the Begin()/End() of the explorer window
                                                                      signals to the explorer to call update_cwd_entries */
@@ -460,6 +916,43 @@ struct explorer_window
     mutable s8 latest_save_to_disk_result = -1;
 };
 
+/// Recently listed directories, shared by all explorers. Navigating to a cached directory shows its rows straight away
+/// while the listing task revalidates them against the directory's last write time. Bounded by both entry count and bytes,
+/// the least recently used entries are evicted first. Only touched by the UI thread.
+struct directory_listing_cache
+{
+    struct entry
+    {
+        std::string key = {};             // see `normalize_key`
+        u64 dir_last_write_time = 0;      // of the directory itself when the listing was taken
+        u64 bytes = 0;
+        explorer_window::cwd_listing::batch listing = {};
+    };
+
+    static u64 const DEFAULT_MEMORY_BUDGET = 64 * 1024 * 1024;
+    static u64 const DEFAULT_MAX_ENTRIES = 64;
+
+    std::vector<entry> entries = {}; // most recently used first
+    u64 memory_budget = DEFAULT_MEMORY_BUDGET;
+    u64 max_entries = DEFAULT_MAX_ENTRIES;
+    u64 bytes_used = 0;
+    u64 num_hits = 0;
+    u64 num_misses = 0;
+    u64 num_evictions = 0;
+
+    /// Case folded (ASCII), '/' turned into '\\', trailing separators and spaces dropped.
+    static std::string normalize_key(std::string_view path) noexcept;
+
+    /// Counts a hit or a miss. A hit becomes the most recently used entry, the pointer is valid until the next `store`/`erase`.
+    entry const *find(std::string_view path) noexcept;
+
+    /// Replaces any existing entry for `path`, then evicts until within budget. A listing bigger than the whole budget is not stored.
+    void store(std::string_view path, u64 dir_last_write_time, explorer_window::cwd_listing::batch &&listing) noexcept;
+
+    bool erase(std::string_view path) noexcept;
+    void clear() noexcept;
+};
+
 struct finder_window
 {
     struct search_directory
@@ -468,20 +961,137 @@ struct finder_window
         swan_path path_utf8;
     };
 
+    /// 40 bytes: the name and the parent directory are stored once elsewhere, see `match_chunk` and `search_results`.
+    /// Creation time isn't kept, nothing in the finder shows it.
     struct match
     {
-        basic_dirent basic = {};
-        char const *file_name = nullptr;
-        ptrdiff_t highlight_start_idx = 0;
-        u64 highlight_len = 0;
+        u64 size;
+        u64 last_write_time; // 100ns ticks since 1601-01-01 UTC, like directory_entry
+        u32 id;
+        u32 parent;          // into search_results::directories
+        u32 name_offset;     // into match_chunk::names
+        u16 name_len;
+        u16 highlight_start;
+        u16 highlight_len;
+        basic_dirent::kind type;
+    };
+
+    /// Matches a worker found, their NUL terminated names back to back in an arena of the chunk's own.
+    struct match_chunk
+    {
+        std::vector<match> matches = {};
+        std::vector<char> names = {};
+
+        char const *name(match const &m) const noexcept { return names.data() + m.name_offset; }
+        u64 num_bytes() const noexcept { return sizeof(*this) + matches.capacity() * sizeof(match) + names.capacity(); }
+    };
+
+    /// Where search workers publish, neither publishing nor reading takes a lock. Every worker fills a chunk of its own and
+    /// hands it over full (or when it got old, see `search_directory_batch`), a published chunk is never touched again until `clear`.
+    /// Parent directories are interned by the worker which listed them, before the first chunk referring to them is published.
+    struct search_results
+    {
+        append_only_list<match_chunk> chunks = {};
+        append_only_list<std::string> directories = {}; // full paths, search directories as typed and subdirectories joined to them
+        std::atomic<u64> num_matches = 0;               // in published chunks
+        std::atomic<u64> num_bytes = 0;                 // of published chunks and interned directories
+
+        /// Any thread. Assigns ids in order of publication. False if the list is full, the chunk is dropped.
+        bool publish(match_chunk &&chunk) noexcept;
+
+        /// Any thread. UINT32_MAX if the list is full.
+        u32 intern_directory(std::string_view directory_utf8) noexcept;
+
+        /// Nothing may be publishing or reading.
+        void clear() noexcept;
+    };
+
+    struct match_row
+    {
+        match_chunk const *chunk;
+        match const *m;
+    };
+
+    /// The UI's view of `search_results`: the chunks published without gaps so far, indexed by row. UI thread only.
+    struct match_snapshot
+    {
+        std::vector<match_chunk const *> chunks = {};
+        std::vector<u64> first_rows = {}; // of each chunk
+        u64 num_rows = 0;
+
+        /// Takes in chunks published since the last update, stopping at the first one not published yet.
+        void update(search_results const &results) noexcept;
+        match_row row(u64 idx) const noexcept;
+        void clear() noexcept;
+    };
+
+    /// A directory tree the finder searches through a `filesystem_index` rather than by walking it.
+    /// Loaded from data\finder_index_<hash>.bin (or built) when added or on startup, walked again in the background to catch up
+    /// with what changed while swan wasn't running, then kept current from ReadDirectoryChangesW on the whole subtree.
+    struct indexed_root
+    {
+        enum class status : u8
+        {
+            loading,
+            building, // the first walk, there is nothing to search yet
+            ready,
+            failed,
+        };
+
+        std::string path_utf8 = {};
+        std::filesystem::path file_path = {};
+        std::atomic<status> state = status::loading;
+        std::atomic_bool building = false;           // a walk is running, also while `ready` when it refreshes
+        std::atomic_bool cancellation_token = false; // set when the root is removed or swan exits
+        std::atomic_bool dirty = false;              // changed since last saved
+        std::atomic<u64> last_query_us = 0;
+
+        std::mutex mutex = {}; // guards everything below, held while searching, changing or saving the index
+        std::unique_ptr<filesystem_index> index = std::make_unique<filesystem_index>();
+        std::vector<std::string> changes_during_build = {}; // applied again to the index the walk produces, it may have missed them
+
+        //? UI thread only, see `update_indexed_roots`.
+        HANDLE watch_handle = INVALID_HANDLE_VALUE;
+        OVERLAPPED watch_overlapped = {};
+        DWORD watch_bytes_written = 0;
+        time_point_precise_t watch_attempt_time = {};
+        alignas(DWORD) std::array<std::byte, 64*1024> watch_buffer = {}; // FILE_NOTIFY_INFORMATION records must be DWORD aligned
     };
 
-    progressive_task<std::vector<finder_window::match>> search_task = {};
+    //? Not a progressive_task: published chunks are read while the search runs, without the lock one of those would need.
+    async_task<search_results> search_task = {};
+    match_snapshot matches = {};
     std::array<char, 1024> search_value = {};
     std::vector<search_directory> search_directories = {};
-    std::atomic<u64> num_entries_checked = 0;
+    std::array<directory_traversal_counter, directory_traversal::max_threads> traversal_counters = {}; // one per search thread
+    time_point_precise_t search_start_time = {};
+    std::atomic<u64> search_duration_us = 0; // set once the search finishes or is cancelled, 0 while it runs
+    u64 search_num_threads = 0;
+    std::atomic<u64> search_index_us = 0;         // spent querying indexes, included in `search_duration_us`
+    std::atomic<u64> num_indexed_search_dirs = 0; // search directories answered by an index rather than walked
+    std::vector<std::shared_ptr<indexed_root>> indexed_roots = {}; // UI thread, tasks hold references of their own
     bool detailed_symlinks = false;
+    bool search_regex = false; // whole names matching the search value, see name_pattern
     bool focus_search_value_input = false;
+
+    /// Sum of the per thread counters, while the search runs or after it's done.
+    u64 num_entries_checked() const noexcept;
+
+    /// The full path of a match, only built for what needs one (opening, revealing), rows are drawn from the name and parent.
+    bool match_path(match_row const &row, swan_path &out) const noexcept;
+
+    /// UI thread. Loads or builds the index of `path_utf8` in the background, false if it's already indexed.
+    bool add_indexed_root(std::string_view path_utf8) noexcept;
+    void remove_indexed_root(u64 idx) noexcept;
+
+    /// UI thread, once per frame: picks up change notifications and applies them to the indexes in the background.
+    void update_indexed_roots() noexcept;
+
+    /// Stops walks in progress and saves indexes changed since they were last saved, for when swan exits.
+    void save_indexes() noexcept;
+
+    bool save_indexed_roots_to_disk() const noexcept;
+    bool load_indexed_roots_from_disk() noexcept;
 };
 
 struct symlink_data
@@ -522,10 +1132,8 @@ struct file_operation_command_buf
 
 struct completed_file_operation
 {
-    s64 src_icon_GLtexID = 0;
-    s64 dst_icon_GLtexID = 0;
-    ImVec2 src_icon_size = {};
-    ImVec2 dst_icon_size = {};
+    icon_handle src_icon = {};
+    icon_handle dst_icon = {};
     time_point_system_t completion_time = {};
     time_point_system_t undo_time = {};
     u32 group_id = {};
@@ -645,8 +1253,7 @@ struct recent_file
 
     boost::static_string<ACTION_MAX_LEN> action = {};
     time_point_system_t action_time = {};
-    s64 icon_GLtexID = 0;
-    ImVec2 icon_size = {};
+    icon_handle icon = {};
     swan_path path = {};
     std::string path2 = {}; // placed as temporary alternative to `path`, useful for some search/delete algorithms
     bool selected = false;
@@ -0,0 +1,227 @@
+#include "date_time_format.hpp"
+
+#if !defined(_WIN32)
+#   include <algorithm>
+#   include <cstring>
+#endif
+
+static constexpr s64 g_ticks_per_second = 10'000'000;
+static constexpr s64 g_seconds_per_day = 86'400;
+static constexpr s64 g_days_from_1601_to_1970 = 134'774;
+
+date_time_format::locale_names date_time_format::english_names() noexcept
+{
+    locale_names names = {};
+    names.months = { { {"January"}, {"February"}, {"March"}, {"April"}, {"May"}, {"June"},
+                       {"July"}, {"August"}, {"September"}, {"October"}, {"November"}, {"December"} } };
+    names.months_abbrev = { { {"Jan"}, {"Feb"}, {"Mar"}, {"Apr"}, {"May"}, {"Jun"}, {"Jul"}, {"Aug"}, {"Sep"}, {"Oct"}, {"Nov"}, {"Dec"} } };
+    names.days = { { {"Sunday"}, {"Monday"}, {"Tuesday"}, {"Wednesday"}, {"Thursday"}, {"Friday"}, {"Saturday"} } };
+    names.days_abbrev = { { {"Sun"}, {"Mon"}, {"Tue"}, {"Wed"}, {"Thu"}, {"Fri"}, {"Sat"} } };
+    names.am = { "AM" };
+    names.pm = { "PM" };
+    return names;
+}
+
+void date_time_format::compile(std::string_view date_pattern, std::string_view time_pattern, locale_names const &new_names, s64 new_utc_offset_minutes) noexcept
+{
+    this->fields.clear();
+    this->literals.clear();
+    this->names = new_names;
+    this->utc_offset_minutes = new_utc_offset_minutes;
+
+    auto add_literal = [&](std::string_view text) noexcept {
+        if (text.empty()) {
+            return;
+        }
+        if (!this->fields.empty() && this->fields.back().what == field::kind::literal) {
+            this->fields.back().literal_len += u16(text.size());
+        } else {
+            this->fields.push_back({ field::kind::literal, 0, u16(this->literals.size()), u16(text.size()) });
+        }
+        this->literals.append(text);
+    };
+
+    auto parse = [&](std::string_view pattern) noexcept {
+        for (u64 i = 0; i < pattern.size(); ) {
+            char ch = pattern[i];
+
+            if (ch == '\'') {
+                // quoted literal, '' is a quote both inside and outside of one
+                ++i;
+                if (i < pattern.size() && pattern[i] == '\'') {
+                    add_literal("'");
+                    ++i;
+                    continue;
+                }
+                while (i < pattern.size()) {
+                    if (pattern[i] == '\'') {
+                        if (i + 1 < pattern.size() && pattern[i + 1] == '\'') {
+                            add_literal("'");
+                            i += 2;
+                            continue;
+                        }
+                        ++i;
+                        break;
+                    }
+                    u64 start = i;
+                    while (i < pattern.size() && pattern[i] != '\'') {
+                        ++i;
+                    }
+                    add_literal(pattern.substr(start, i - start));
+                }
+                continue;
+            }
+
+            u64 run = 1;
+            while (i + run < pattern.size() && pattern[i + run] == ch) {
+                ++run;
+            }
+
+            field::kind what;
+            switch (ch) {
+                case 'd': what = run >= 3 ? field::kind::day_name : field::kind::day; break;
+                case 'M': what = run >= 3 ? field::kind::month_name : field::kind::month; break;
+                case 'y': what = field::kind::year; break;
+                case 'h': what = field::kind::hour_12; break;
+                case 'H': what = field::kind::hour_24; break;
+                case 'm': what = field::kind::minute; break;
+                case 's': what = field::kind::second; break;
+                case 't': what = field::kind::am_pm; break;
+                case 'g': i += run; continue; // era, nothing to show for the Gregorian calendar
+                default:
+                    add_literal(pattern.substr(i, run));
+                    i += run;
+                    continue;
+            }
+
+            this->fields.push_back({ what, u8(std::min(run, u64(UINT8_MAX))), 0, 0 });
+            i += run;
+        }
+    };
+
+    parse(date_pattern);
+    add_literal(" ");
+    parse(time_pattern);
+}
+
+namespace
+{
+    struct bounded_writer
+    {
+        char *out;
+        u64 capacity; // excluding the NUL
+        u64 len;
+
+        void put(char ch) noexcept
+        {
+            if (len < capacity) {
+                out[len++] = ch;
+            }
+        }
+
+        void put(char const *str, u64 str_len) noexcept
+        {
+            u64 n = std::min(str_len, capacity - len);
+            memcpy(out + len, str, n);
+            len += n;
+        }
+
+        void put_number(u64 value, u64 min_digits) noexcept
+        {
+            char digits[20];
+            u64 num_digits = 0;
+            do {
+                digits[num_digits++] = char('0' + (value % 10));
+                value /= 10;
+            } while (value != 0);
+
+            for (u64 i = num_digits; i < min_digits; ++i) {
+                put('0');
+            }
+            while (num_digits > 0) {
+                put(digits[--num_digits]);
+            }
+        }
+    };
+
+    struct civil_time
+    {
+        s64 year;
+        u32 month;    // [1, 12]
+        u32 day;      // [1, 31]
+        u32 weekday;  // [0, 6], Sunday first
+        u32 hour;
+        u32 minute;
+        u32 second;
+    };
+}
+
+/// Days since 1970-01-01 to a proleptic Gregorian date, from Howard Hinnant's `civil_from_days`.
+static
+civil_time civil_from_days(s64 days) noexcept
+{
+    civil_time t = {};
+
+    t.weekday = u32((days % 7 + 7 + 4) % 7); // 1970-01-01 was a Thursday
+
+    days += 719'468;
+    s64 era = (days >= 0 ? days : days - 146'096) / 146'097;
+    u64 day_of_era = u64(days - era * 146'097);
+    u64 year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36'524 - day_of_era / 146'096) / 365;
+    u64 day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    u64 month_from_march = (5 * day_of_year + 2) / 153;
+
+    t.day = u32(day_of_year - (153 * month_from_march + 2) / 5 + 1);
+    t.month = u32(month_from_march < 10 ? month_from_march + 3 : month_from_march - 9);
+    t.year = s64(year_of_era) + era * 400 + (t.month <= 2);
+
+    return t;
+}
+
+u64 date_time_format::format(u64 filetime, char *out, u64 out_size) const noexcept
+{
+    if (out_size == 0) {
+        return 0;
+    }
+
+    static date_time_format const s_iso = [] {
+        date_time_format iso = {};
+        iso.compile("yyyy-MM-dd", "HH:mm", english_names(), 0);
+        return iso;
+    }();
+    date_time_format const &patterns = this->fields.empty() ? s_iso : *this; // names and offset always come from this instance
+
+    s64 seconds = s64(filetime / g_ticks_per_second) + this->utc_offset_minutes * 60 - g_days_from_1601_to_1970 * g_seconds_per_day;
+    s64 days = seconds >= 0 ? seconds / g_seconds_per_day : (seconds - (g_seconds_per_day - 1)) / g_seconds_per_day;
+    s64 second_of_day = seconds - days * g_seconds_per_day;
+
+    civil_time t = civil_from_days(days);
+    t.hour = u32(second_of_day / 3600);
+    t.minute = u32(second_of_day / 60 % 60);
+    t.second = u32(second_of_day % 60);
+
+    bounded_writer w = { out, out_size - 1, 0 };
+
+    auto put_name = [&](name const &n, u64 max_len = UINT64_MAX) noexcept {
+        w.put(n.data(), std::min(u64(strnlen(n.data(), n.size())), max_len));
+    };
+
+    for (field const &f : patterns.fields) {
+        switch (f.what) {
+            case field::kind::literal:    w.put(patterns.literals.data() + f.literal_offset, f.literal_len); break;
+            case field::kind::day:        w.put_number(t.day, f.width); break;
+            case field::kind::day_name:   put_name(f.width == 3 ? this->names.days_abbrev[t.weekday] : this->names.days[t.weekday]); break;
+            case field::kind::month:      w.put_number(t.month, f.width); break;
+            case field::kind::month_name: put_name(f.width == 3 ? this->names.months_abbrev[t.month - 1] : this->names.months[t.month - 1]); break;
+            case field::kind::year:       w.put_number(f.width <= 2 ? u64(t.year % 100) : u64(t.year), f.width <= 2 ? f.width : 4); break;
+            case field::kind::hour_12:    w.put_number(t.hour % 12 == 0 ? 12 : t.hour % 12, f.width); break;
+            case field::kind::hour_24:    w.put_number(t.hour, f.width); break;
+            case field::kind::minute:     w.put_number(t.minute, f.width); break;
+            case field::kind::second:     w.put_number(t.second, f.width); break;
+            case field::kind::am_pm:      put_name(t.hour < 12 ? this->names.am : this->names.pm, f.width == 1 ? 1 : UINT64_MAX); break;
+        }
+    }
+
+    out[w.len] = '\0';
+    return w.len;
+}
@@ -5,6 +5,7 @@
 std::vector<debug_log_record>   debug_log::g_records = {};
 std::vector<u64>                debug_log::g_records_visible_indices;
 std::string                     debug_log::g_search_text = {};
+substring_matcher               debug_log::g_search_matcher = {};
 std::mutex                      debug_log::g_mutex = {};
 bool                            debug_log::g_logging_enabled = true;
 
@@ -111,8 +112,10 @@ bool swan_windows::render_debug_log(bool &open, [[maybe_unused]] bool any_popups
     if (search_text_edited) {
         std::scoped_lock lock(debug_log::g_mutex);
 
+        debug_log::g_search_matcher.compile(debug_log::g_search_text, false);
+
         debug_log::g_records_visible_indices.clear();
-        if (debug_log::g_search_text.empty()) {
+        if (debug_log::g_search_matcher.empty()) {
             debug_log::g_records_visible_indices.reserve(debug_log::g_records.size());
             for (u64 i = 0; i < debug_log::g_records.size(); ++i) {
                 debug_log::g_records_visible_indices.push_back(i);
@@ -120,7 +123,7 @@ bool swan_windows::render_debug_log(bool &open, [[maybe_unused]] bool any_popups
         }
         else {
             for (u64 i = 0; i < debug_log::g_records.size(); ++i) {
-                if (debug_log::g_records[i].matches_search_text(debug_log::g_search_text.c_str())) {
+                if (debug_log::g_records[i].matches_search_text(debug_log::g_search_matcher)) {
                     debug_log::g_records_visible_indices.push_back(i);
                 }
             }
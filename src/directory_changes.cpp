@@ -0,0 +1,166 @@
+#include "directory_changes.hpp"
+
+#if !defined(_WIN32)
+#   include <cerrno>
+#   include <cstring>
+#   include <sys/inotify.h>
+#   include <unistd.h>
+#endif
+
+void directory_change_batch::push_back(directory_change_kind kind, std::string_view name_utf8) noexcept
+{
+    directory_change change;
+    change.name_offset = (u32)this->names.size();
+    change.name_len = (u16)name_utf8.size();
+    change.kind = kind;
+
+    this->names.insert(this->names.end(), name_utf8.begin(), name_utf8.end());
+    this->names.push_back('\0');
+    this->changes.push_back(change);
+}
+
+void summarize_directory_changes(directory_change_batch const &batch, std::vector<directory_change_net> &out) noexcept
+{
+    out.clear();
+
+    static std::unordered_map<std::string_view, u64> s_idx_by_name = {};
+    s_idx_by_name.clear();
+
+    for (u64 i = 0; i < batch.changes.size(); ++i) {
+        auto const &change = batch.changes[i];
+        std::string_view name = batch.name_view(change);
+        bool exists = change.kind == directory_change_kind::added
+                   || change.kind == directory_change_kind::modified
+                   || change.kind == directory_change_kind::renamed_to;
+
+        auto [iter, inserted] = s_idx_by_name.try_emplace(name, out.size());
+        if (inserted) {
+            out.push_back({ name, exists, {} });
+        } else {
+            out[iter->second].exists = exists;
+        }
+        auto &net = out[iter->second];
+
+        if (change.kind == directory_change_kind::modified || change.kind == directory_change_kind::renamed_from) {
+            continue; // still the same entry, or one the matching `renamed_to` takes `renamed_from` over from
+        }
+        net.renamed_from = {};
+
+        if (change.kind == directory_change_kind::renamed_to && i > 0 && batch.changes[i - 1].kind == directory_change_kind::renamed_from) {
+            //? Follow a -> b -> c back to a, the only name the caller may still have a row for.
+            auto &previous = out[s_idx_by_name.at(batch.name_view(batch.changes[i - 1]))];
+            net.renamed_from = previous.renamed_from.empty() ? previous.name : previous.renamed_from;
+            previous.renamed_from = {};
+        }
+    }
+}
+
+#if defined(_WIN32)
+
+void decode_file_notify_information(void const *buffer, u64 num_bytes, directory_change_batch &out) noexcept
+{
+    if (num_bytes == 0) {
+        out.overflowed = true;
+        return;
+    }
+
+    auto const *record_bytes = static_cast<std::byte const *>(buffer);
+
+    while (true) {
+        auto const *record = reinterpret_cast<FILE_NOTIFY_INFORMATION const *>(record_bytes);
+
+        char name_utf8[MAX_PATH * 3];
+        s32 written = WideCharToMultiByte(CP_UTF8, 0, record->FileName, (s32)(record->FileNameLength / sizeof(wchar_t)),
+                                          name_utf8, (s32)sizeof(name_utf8), NULL, NULL);
+        if (written <= 0) {
+            out.overflowed = true; // can't tell what changed, be safe and have the caller re-query
+        }
+        else {
+            directory_change_kind kind;
+            switch (record->Action) {
+                case FILE_ACTION_ADDED:            kind = directory_change_kind::added;        break;
+                case FILE_ACTION_REMOVED:          kind = directory_change_kind::removed;      break;
+                case FILE_ACTION_RENAMED_OLD_NAME: kind = directory_change_kind::renamed_from; break;
+                case FILE_ACTION_RENAMED_NEW_NAME: kind = directory_change_kind::renamed_to;   break;
+                default:
+                case FILE_ACTION_MODIFIED:         kind = directory_change_kind::modified;     break;
+            }
+            out.push_back(kind, std::string_view(name_utf8, (u64)written));
+        }
+
+        if (record->NextEntryOffset == 0) {
+            break;
+        }
+        record_bytes += record->NextEntryOffset;
+        assert(record_bytes < static_cast<std::byte const *>(buffer) + num_bytes);
+    }
+}
+
+#else // POSIX
+
+bool directory_watcher::open(char const *directory_path_utf8) noexcept
+{
+    close();
+
+    this->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (this->inotify_fd < 0) {
+        return false;
+    }
+
+    u32 mask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+    this->watch_descriptor = inotify_add_watch(this->inotify_fd, directory_path_utf8, mask);
+    if (this->watch_descriptor < 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+u64 directory_watcher::poll(directory_change_batch &out) noexcept
+{
+    u64 num_changes_before = out.changes.size();
+
+    alignas(inotify_event) char buffer[16 * 1024];
+
+    while (true) {
+        ssize_t bytes_read = ::read(this->inotify_fd, buffer, sizeof(buffer));
+        if (bytes_read <= 0) {
+            break; // EAGAIN once drained
+        }
+
+        for (char const *ptr = buffer; ptr < buffer + bytes_read; ) {
+            auto const *event = reinterpret_cast<inotify_event const *>(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                out.overflowed = true;
+                continue;
+            }
+            if (event->len == 0) {
+                continue; // event about the watched directory itself
+            }
+
+            directory_change_kind kind;
+            if      (event->mask & IN_CREATE)     kind = directory_change_kind::added;
+            else if (event->mask & IN_DELETE)     kind = directory_change_kind::removed;
+            else if (event->mask & IN_MOVED_FROM) kind = directory_change_kind::renamed_from;
+            else if (event->mask & IN_MOVED_TO)   kind = directory_change_kind::renamed_to;
+            else                                  kind = directory_change_kind::modified;
+
+            out.push_back(kind, std::string_view(event->name, strlen(event->name)));
+        }
+    }
+
+    return out.changes.size() - num_changes_before;
+}
+
+void directory_watcher::close() noexcept
+{
+    if (this->inotify_fd >= 0) {
+        ::close(this->inotify_fd); // also removes the watch
+        this->inotify_fd = -1;
+    }
+    this->watch_descriptor = -1;
+}
+
+#endif
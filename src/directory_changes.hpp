@@ -0,0 +1,84 @@
+#pragma once
+
+//? Change notifications for a single watched directory, decoded into backend independent deltas.
+
+#if defined(_WIN32)
+#   include "stdafx.hpp"
+#else
+#   include <string_view>
+#   include <unordered_map>
+#   include <vector>
+#endif
+
+#include "primitives.hpp"
+
+enum class directory_change_kind : u8
+{
+    added,
+    removed,
+    modified,
+    renamed_from, // old name of a rename, usually followed by the matching `renamed_to`
+    renamed_to,   // new name of a rename
+};
+
+struct directory_change
+{
+    u32 name_offset; // into directory_change_batch::names
+    u16 name_len;    // in bytes, excluding NUL
+    directory_change_kind kind;
+};
+
+struct directory_change_batch
+{
+    std::vector<directory_change> changes = {};
+    std::vector<char> names = {}; // NUL terminated UTF-8 names, back to back
+    bool overflowed = false;      // the backend dropped events, only a full re-query gives a correct listing
+
+    void clear() noexcept { changes.clear(); names.clear(); overflowed = false; }
+    void push_back(directory_change_kind kind, std::string_view name_utf8) noexcept;
+    char const *name(directory_change const &change) const noexcept { return names.data() + change.name_offset; }
+    std::string_view name_view(directory_change const &change) const noexcept { return { names.data() + change.name_offset, change.name_len }; }
+};
+
+/// Net effect of a batch on one name. `exists` is the state implied by the last change mentioning the name,
+/// the caller still has to query the filesystem since the entry may have changed again since.
+struct directory_change_net
+{
+    std::string_view name;         // points into the batch's names
+    bool exists;
+    std::string_view renamed_from; // empty unless the entry got `name` by being renamed in this batch, its name before the batch
+};
+
+/// Collapses `batch` to one item per distinct name, in order of first mention, e.g. added+modified+removed becomes a single
+/// non-existent name, and a rename becomes the old name not existing plus the new name existing and `renamed_from` the old name.
+/// A `renamed_to` is paired with a `renamed_from` right before it, as both backends report them. Clears `out` first.
+void summarize_directory_changes(directory_change_batch const &batch, std::vector<directory_change_net> &out) noexcept;
+
+#if defined(_WIN32)
+
+/// Appends the FILE_NOTIFY_INFORMATION records of a buffer filled by ReadDirectoryChangesW to `out`.
+/// `num_bytes == 0` is how ReadDirectoryChangesW reports that its internal buffer overflowed, it sets `out.overflowed`.
+void decode_file_notify_information(void const *buffer, u64 num_bytes, directory_change_batch &out) noexcept;
+
+#else
+
+/// inotify counterpart of ReadDirectoryChangesW, watches a single directory (not its subtree).
+struct directory_watcher
+{
+    directory_watcher() noexcept = default;
+    directory_watcher(directory_watcher const &) = delete;
+    directory_watcher &operator=(directory_watcher const &) = delete;
+    ~directory_watcher() noexcept { close(); }
+
+    bool open(char const *directory_path_utf8) noexcept;
+
+    /// Appends pending changes to `out` without blocking. Returns the number of changes appended.
+    u64 poll(directory_change_batch &out) noexcept;
+
+    void close() noexcept;
+
+    s32 inotify_fd = -1;
+    s32 watch_descriptor = -1;
+};
+
+#endif
@@ -0,0 +1,306 @@
+#include "directory_enumeration.hpp"
+
+#if !defined(_WIN32)
+#   include <fcntl.h>
+#   include <string>
+#   include <sys/stat.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#endif
+
+static
+bool is_dot_or_dotdot(char const *name, u64 len, bool &is_dotdot) noexcept
+{
+    is_dotdot = len == 2 && name[0] == '.' && name[1] == '.';
+    return (len == 1 && name[0] == '.') || is_dotdot;
+}
+
+#if defined(_WIN32)
+
+//? Only name surrogates (symbolic links, junctions) point elsewhere, other reparse points such as cloud file placeholders
+//? or deduplicated files are the entry itself. For a reparse point, dwReserved0 of the find data holds its tag.
+static
+bool is_name_surrogate(DWORD attributes, DWORD reparse_tag) noexcept
+{
+    return (attributes & FILE_ATTRIBUTE_REPARSE_POINT) && IsReparseTagNameSurrogate(reparse_tag);
+}
+
+bool directory_enumerator::open(char const *directory_path_utf8, bool include_dotdot_) noexcept
+{
+    close();
+
+    this->include_dotdot = include_dotdot_;
+    this->num_entries_skipped = 0;
+
+    wchar_t search_path_utf16[2048];
+
+    s32 written = MultiByteToWideChar(CP_UTF8, 0, directory_path_utf8, -1, search_path_utf16, (s32)(std::size(search_path_utf16) - 2));
+    if (written <= 1) {
+        return false;
+    }
+
+    u64 len = (u64)written - 1;
+    if (search_path_utf16[len - 1] != L'\\' && search_path_utf16[len - 1] != L'/') {
+        search_path_utf16[len++] = L'\\';
+    }
+    search_path_utf16[len++] = L'*';
+    search_path_utf16[len] = L'\0';
+
+    //? FindExInfoBasic skips generating 8.3 short names, FIND_FIRST_EX_LARGE_FETCH asks for a bigger buffer per kernel round trip.
+    this->find_handle = FindFirstFileExW(search_path_utf16, FindExInfoBasic, &this->find_data, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+
+    if (this->find_handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    this->find_data_pending = true;
+    this->exhausted = false;
+    return true;
+}
+
+u64 directory_enumerator::next_batch(directory_entry_batch &batch, u64 max_entries) noexcept
+{
+    batch.clear();
+
+    while (!this->exhausted && batch.entries.size() < max_entries) {
+        if (!this->find_data_pending && !FindNextFileW(this->find_handle, &this->find_data)) {
+            this->exhausted = true;
+            break;
+        }
+        this->find_data_pending = false;
+
+        u64 name_len_utf16 = wcslen(this->find_data.cFileName);
+        u64 name_offset = batch.names.size();
+        u64 capacity = (name_len_utf16 * 3) + 1; // worst case UTF-8 expansion for BMP code points, surrogate pairs take 4 bytes for 2 units
+
+        batch.names.resize(name_offset + capacity);
+
+        s32 written = WideCharToMultiByte(CP_UTF8, 0, this->find_data.cFileName, (s32)name_len_utf16,
+                                          batch.names.data() + name_offset, (s32)capacity - 1, NULL, NULL);
+        if (written <= 0) {
+            batch.names.resize(name_offset);
+            ++this->num_entries_skipped;
+            continue;
+        }
+
+        char const *name = batch.names.data() + name_offset;
+        bool is_dotdot;
+        if (is_dot_or_dotdot(name, (u64)written, is_dotdot) && !(is_dotdot && this->include_dotdot)) {
+            batch.names.resize(name_offset);
+            continue;
+        }
+
+        batch.names.resize(name_offset + (u64)written + 1);
+        batch.names.back() = '\0';
+
+        directory_entry entry;
+        entry.size = (u64(this->find_data.nFileSizeHigh) << 32) | u64(this->find_data.nFileSizeLow);
+        entry.creation_time = (u64(this->find_data.ftCreationTime.dwHighDateTime) << 32) | u64(this->find_data.ftCreationTime.dwLowDateTime);
+        entry.last_write_time = (u64(this->find_data.ftLastWriteTime.dwHighDateTime) << 32) | u64(this->find_data.ftLastWriteTime.dwLowDateTime);
+        entry.name_offset = (u32)name_offset;
+        entry.name_len = (u16)written;
+        entry.kind = (this->find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ? directory_entry_kind::directory : directory_entry_kind::file;
+        entry.link = is_name_surrogate(this->find_data.dwFileAttributes, this->find_data.dwReserved0);
+
+        batch.entries.push_back(entry);
+    }
+
+    return batch.entries.size();
+}
+
+void directory_enumerator::close() noexcept
+{
+    if (this->find_handle != INVALID_HANDLE_VALUE) {
+        FindClose(this->find_handle);
+        this->find_handle = INVALID_HANDLE_VALUE;
+    }
+    this->find_data_pending = false;
+    this->exhausted = true;
+}
+
+static
+bool query_path_utf16(wchar_t const *path_utf16, directory_entry &entry) noexcept
+{
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (!GetFileAttributesExW(path_utf16, GetFileExInfoStandard, &attributes)) {
+        return false;
+    }
+
+    entry.size = (u64(attributes.nFileSizeHigh) << 32) | u64(attributes.nFileSizeLow);
+    entry.creation_time = (u64(attributes.ftCreationTime.dwHighDateTime) << 32) | u64(attributes.ftCreationTime.dwLowDateTime);
+    entry.last_write_time = (u64(attributes.ftLastWriteTime.dwHighDateTime) << 32) | u64(attributes.ftLastWriteTime.dwLowDateTime);
+    entry.kind = (attributes.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ? directory_entry_kind::directory : directory_entry_kind::file;
+    entry.link = false;
+
+    if (attributes.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+        //? The attribute data has no reparse tag, finding the path itself gives it (without following the link).
+        WIN32_FIND_DATAW find_data;
+        HANDLE find_handle = FindFirstFileExW(path_utf16, FindExInfoBasic, &find_data, FindExSearchNameMatch, NULL, 0);
+        if (find_handle != INVALID_HANDLE_VALUE) {
+            entry.link = is_name_surrogate(find_data.dwFileAttributes, find_data.dwReserved0);
+            FindClose(find_handle);
+        }
+    }
+    return true;
+}
+
+bool query_directory_entry(char const *directory_path_utf8, std::string_view name_utf8, directory_entry &entry) noexcept
+{
+    wchar_t full_path_utf16[2048];
+
+    s32 dir_len = MultiByteToWideChar(CP_UTF8, 0, directory_path_utf8, -1, full_path_utf16, (s32)std::size(full_path_utf16) - 1);
+    if (dir_len <= 1) {
+        return false;
+    }
+    u64 len = (u64)dir_len - 1;
+    if (full_path_utf16[len - 1] != L'\\' && full_path_utf16[len - 1] != L'/') {
+        full_path_utf16[len++] = L'\\';
+    }
+    s32 name_len = MultiByteToWideChar(CP_UTF8, 0, name_utf8.data(), (s32)name_utf8.size(), full_path_utf16 + len, (s32)(std::size(full_path_utf16) - len - 1));
+    if (name_len <= 0) {
+        return false;
+    }
+    full_path_utf16[len + (u64)name_len] = L'\0';
+
+    return query_path_utf16(full_path_utf16, entry);
+}
+
+bool query_path(char const *path_utf8, directory_entry &entry) noexcept
+{
+    wchar_t path_utf16[2048];
+
+    if (MultiByteToWideChar(CP_UTF8, 0, path_utf8, -1, path_utf16, (s32)std::size(path_utf16)) <= 1) {
+        return false;
+    }
+    return query_path_utf16(path_utf16, entry);
+}
+
+#else // POSIX
+
+struct linux_dirent64
+{
+    u64 d_ino;
+    s64 d_off;
+    u16 d_reclen;
+    u8 d_type;
+    char d_name[];
+};
+
+static
+u64 unix_time_to_filetime_ticks(s64 seconds, u32 nanoseconds) noexcept
+{
+    constexpr s64 seconds_between_1601_and_1970 = 11644473600LL;
+    return (u64)((seconds + seconds_between_1601_and_1970) * 10'000'000LL) + (nanoseconds / 100);
+}
+
+static
+bool statx_directory_entry(s32 dir_fd, char const *path, directory_entry &entry) noexcept
+{
+    struct statx stx;
+    u32 wanted = STATX_TYPE | STATX_SIZE | STATX_MTIME | STATX_BTIME;
+    if (statx(dir_fd, path, AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC, wanted, &stx) != 0) {
+        return false;
+    }
+
+    entry.size = stx.stx_size;
+    entry.last_write_time = unix_time_to_filetime_ticks(stx.stx_mtime.tv_sec, stx.stx_mtime.tv_nsec);
+    entry.creation_time = (stx.stx_mask & STATX_BTIME) ? unix_time_to_filetime_ticks(stx.stx_btime.tv_sec, stx.stx_btime.tv_nsec)
+                                                       : entry.last_write_time;
+
+    switch (stx.stx_mode & S_IFMT) {
+        case S_IFDIR: entry.kind = directory_entry_kind::directory; entry.size = 0; break;
+        case S_IFREG: entry.kind = directory_entry_kind::file;      break;
+        case S_IFLNK: entry.kind = directory_entry_kind::symlink;   break;
+        default:      entry.kind = directory_entry_kind::other;     break;
+    }
+    entry.link = entry.kind == directory_entry_kind::symlink;
+    return true;
+}
+
+bool directory_enumerator::open(char const *directory_path_utf8, bool include_dotdot_) noexcept
+{
+    close();
+
+    this->include_dotdot = include_dotdot_;
+    this->num_entries_skipped = 0;
+
+    this->dir_fd = ::open(directory_path_utf8, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (this->dir_fd < 0) {
+        return false;
+    }
+
+    if (this->dents_buffer == nullptr) {
+        this->dents_buffer = std::make_unique<char[]>(dents_buffer_size);
+    }
+    this->dents_buffer_len = 0;
+    this->dents_buffer_pos = 0;
+    this->exhausted = false;
+    return true;
+}
+
+u64 directory_enumerator::next_batch(directory_entry_batch &batch, u64 max_entries) noexcept
+{
+    batch.clear();
+
+    while (!this->exhausted && batch.entries.size() < max_entries) {
+        if (this->dents_buffer_pos >= this->dents_buffer_len) {
+            long bytes_read = syscall(SYS_getdents64, this->dir_fd, this->dents_buffer.get(), dents_buffer_size);
+            if (bytes_read <= 0) {
+                this->exhausted = true;
+                break;
+            }
+            this->dents_buffer_len = (u64)bytes_read;
+            this->dents_buffer_pos = 0;
+        }
+
+        auto const *dent = reinterpret_cast<linux_dirent64 const *>(this->dents_buffer.get() + this->dents_buffer_pos);
+        this->dents_buffer_pos += dent->d_reclen;
+
+        u64 name_len = strlen(dent->d_name);
+        bool is_dotdot;
+        if (is_dot_or_dotdot(dent->d_name, name_len, is_dotdot) && !(is_dotdot && this->include_dotdot)) {
+            continue;
+        }
+
+        directory_entry entry;
+        if (!statx_directory_entry(this->dir_fd, dent->d_name, entry)) {
+            ++this->num_entries_skipped; // raced with a delete, most likely
+            continue;
+        }
+        entry.name_offset = (u32)batch.names.size();
+        entry.name_len = (u16)name_len;
+
+        batch.names.insert(batch.names.end(), dent->d_name, dent->d_name + name_len + 1);
+        batch.entries.push_back(entry);
+    }
+
+    return batch.entries.size();
+}
+
+void directory_enumerator::close() noexcept
+{
+    if (this->dir_fd >= 0) {
+        ::close(this->dir_fd);
+        this->dir_fd = -1;
+    }
+    this->exhausted = true;
+}
+
+bool query_directory_entry(char const *directory_path_utf8, std::string_view name_utf8, directory_entry &entry) noexcept
+{
+    s32 dir_fd = ::open(directory_path_utf8, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) {
+        return false;
+    }
+    std::string name(name_utf8); // statx wants it NUL terminated
+    bool exists = statx_directory_entry(dir_fd, name.c_str(), entry);
+    ::close(dir_fd);
+    return exists;
+}
+
+bool query_path(char const *path_utf8, directory_entry &entry) noexcept
+{
+    return statx_directory_entry(AT_FDCWD, path_utf8, entry);
+}
+
+#endif
@@ -0,0 +1,115 @@
+#pragma once
+
+//? Batched directory enumeration shared by the explorer, the finder and cwd autocomplete.
+//? Deliberately free of ImGui and swan data types so the POSIX backend can be compiled and benchmarked on its own.
+//? Every module which only includes stdafx.hpp (Win32) or standard headers, plus primitives.hpp, keeps to the same rule for the
+//? same reason: the walkers, indexes, matchers and sorting built around this header can be tested and profiled off Windows.
+
+#if defined(_WIN32)
+#   include "stdafx.hpp"
+#else
+#   include <array>
+#   include <cstring>
+#   include <memory>
+#   include <string_view>
+#   include <vector>
+#endif
+
+#include "primitives.hpp"
+
+/// Kind of an entry as reported by the filesystem. Shortcuts (.lnk) are plain files at this level,
+/// interpreting them is up to the caller. Win32 never reports `symlink`: symbolic links and junctions keep the kind of
+/// what they point at, so they list like one, and are flagged `directory_entry::link` instead.
+enum class directory_entry_kind : u8
+{
+    file,
+    directory,
+    symlink,
+    other,
+};
+
+struct directory_entry
+{
+    u64 size;
+    u64 creation_time;   // 100ns ticks since 1601-01-01 UTC (FILETIME epoch) on every backend
+    u64 last_write_time; // 100ns ticks since 1601-01-01 UTC (FILETIME epoch) on every backend
+    u32 name_offset;     // into directory_entry_batch::names
+    u16 name_len;        // in bytes, excluding NUL
+    directory_entry_kind kind;
+    bool link;           // symlink or junction (name surrogate reparse point), recursive walks don't descend into it
+};
+
+struct directory_entry_batch
+{
+    std::vector<directory_entry> entries = {};
+    std::vector<char> names = {}; // NUL terminated UTF-8 names, back to back
+
+    void clear() noexcept { entries.clear(); names.clear(); }
+    char const *name(directory_entry const &entry) const noexcept { return names.data() + entry.name_offset; }
+    std::string_view name_view(directory_entry const &entry) const noexcept { return { names.data() + entry.name_offset, entry.name_len }; }
+};
+
+/// Streams the entries of a single directory in batches, converting names to UTF-8 straight into the batch's name arena.
+/// Win32: FindFirstFileExW with FindExInfoBasic + FIND_FIRST_EX_LARGE_FETCH. POSIX: getdents64 + statx.
+struct directory_enumerator
+{
+    static constexpr u64 default_batch_size = 4096;
+
+    directory_enumerator() noexcept = default;
+    directory_enumerator(directory_enumerator const &) = delete;
+    directory_enumerator &operator=(directory_enumerator const &) = delete;
+    ~directory_enumerator() noexcept { close(); }
+
+    /// Returns false if the directory could not be opened for listing. `directory_path_utf8` may or may not end with a separator.
+    bool open(char const *directory_path_utf8, bool include_dotdot = false) noexcept;
+
+    /// Clears `batch` and fills it with up to `max_entries` entries. Returns the number of entries produced, 0 once exhausted.
+    /// Entries whose name fails UTF-8 conversion are skipped, "." is always skipped, ".." is skipped unless requested in `open`.
+    u64 next_batch(directory_entry_batch &batch, u64 max_entries = default_batch_size) noexcept;
+
+    void close() noexcept;
+
+    bool include_dotdot = false;
+    bool exhausted = true;
+    u64 num_entries_skipped = 0;
+
+#if defined(_WIN32)
+    HANDLE find_handle = INVALID_HANDLE_VALUE;
+    WIN32_FIND_DATAW find_data = {};
+    bool find_data_pending = false;
+#else
+    static constexpr u64 dents_buffer_size = 64 * 1024;
+
+    s32 dir_fd = -1;
+    std::unique_ptr<char[]> dents_buffer = nullptr;
+    u64 dents_buffer_len = 0;
+    u64 dents_buffer_pos = 0;
+#endif
+};
+
+/// Queries size, times and kind of a single child of `directory_path_utf8`, for applying change notifications without re-listing.
+/// `entry.name_offset` and `entry.name_len` are left untouched. Returns false if the entry does not exist (anymore).
+bool query_directory_entry(char const *directory_path_utf8, std::string_view name_utf8, directory_entry &entry) noexcept;
+
+/// Same as `query_directory_entry` for a full path, e.g. to read a directory's own last write time.
+bool query_path(char const *path_utf8, directory_entry &entry) noexcept;
+
+/// Convenience wrapper: invokes `callback(batch, entry)` for every entry of `directory_path_utf8`.
+/// Iteration stops early if the callback returns false. Returns false if the directory could not be opened.
+template <typename Callback>
+bool enumerate_directory(char const *directory_path_utf8, directory_entry_batch &batch, Callback &&callback, bool include_dotdot = false) noexcept
+{
+    directory_enumerator enumerator;
+
+    if (!enumerator.open(directory_path_utf8, include_dotdot)) {
+        return false;
+    }
+    while (enumerator.next_batch(batch) > 0) {
+        for (auto const &entry : batch.entries) {
+            if (!callback(batch, entry)) {
+                return true;
+            }
+        }
+    }
+    return true;
+}
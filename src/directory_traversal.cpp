@@ -0,0 +1,166 @@
+#include "directory_traversal.hpp"
+
+#if !defined(_WIN32)
+#   include <algorithm>
+#   include <chrono>
+#   include <deque>
+#   include <memory>
+#   include <mutex>
+#   include <thread>
+#endif
+
+struct directory_traversal_state
+{
+    //? A mutex per queue rather than a lock free deque: a directory costs an open and a listing, far more than an uncontended lock.
+    struct alignas(64) work_queue
+    {
+        std::mutex mutex = {};
+        std::deque<std::string> directories = {};
+    };
+
+    directory_traversal_state(u64 num_workers_, directory_traversal const &traversal_, directory_traversal::visitor_t const &visit_) noexcept
+        : queues(new work_queue[num_workers_]), num_workers(num_workers_), traversal(&traversal_), visit(&visit_)
+    {
+    }
+
+    void push(u64 worker, std::string const &directory) noexcept
+    {
+        this->num_pending.fetch_add(1);
+        std::scoped_lock lock(this->queues[worker].mutex);
+        this->queues[worker].directories.push_back(directory);
+    }
+
+    bool pop(u64 worker, std::string &out) noexcept
+    {
+        auto &queue = this->queues[worker];
+        std::scoped_lock lock(queue.mutex);
+        if (queue.directories.empty()) {
+            return false;
+        }
+        out.swap(queue.directories.back());
+        queue.directories.pop_back();
+        return true;
+    }
+
+    bool steal(u64 thief, std::string &out) noexcept
+    {
+        for (u64 i = 1; i < this->num_workers; ++i) {
+            auto &victim = this->queues[(thief + i) % this->num_workers];
+            std::scoped_lock lock(victim.mutex);
+            if (!victim.directories.empty()) {
+                out.swap(victim.directories.front());
+                victim.directories.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::unique_ptr<work_queue[]> queues;
+    u64 num_workers;
+    std::atomic<u64> num_pending = 0; // queued or being listed, the walk is over once it drops to 0
+    std::atomic<u64> next_worker = 1; // 0 is the calling thread
+    std::atomic<u64> num_active_tasks = 0;
+    std::atomic_bool done = false;
+    directory_traversal const *traversal; // only valid until `done`
+    directory_traversal::visitor_t const *visit;
+};
+
+static
+void list_directory(directory_traversal_state &state, u64 self, std::string const &directory,
+                    directory_entry_batch &batch, std::string &sub_directory) noexcept
+{
+    auto const &traversal = *state.traversal;
+    directory_traversal_counter *counter = traversal.counters ? &traversal.counters[self] : nullptr;
+
+    if (counter) counter->num_directories.fetch_add(1, std::memory_order_relaxed);
+
+    directory_enumerator enumerator;
+    if (!enumerator.open(directory.c_str())) {
+        return;
+    }
+
+    while (!traversal.cancelled() && enumerator.next_batch(batch) > 0) {
+        (*state.visit)(self, directory, batch);
+
+        if (counter) counter->num_entries.fetch_add(batch.entries.size(), std::memory_order_relaxed);
+
+        for (auto const &entry : batch.entries) {
+            //? Links may point back up the tree, or at another tree entirely, only real directories are descended into.
+            if (entry.kind != directory_entry_kind::directory || entry.link) {
+                continue;
+            }
+            sub_directory = directory;
+            if (!sub_directory.empty() && sub_directory.back() != traversal.separator) {
+                sub_directory += traversal.separator;
+            }
+            sub_directory += batch.name_view(entry);
+            state.push(self, sub_directory);
+        }
+    }
+}
+
+static
+void traversal_worker(directory_traversal_state &state, u64 self) noexcept
+{
+    auto const &traversal = *state.traversal;
+    directory_traversal_counter *counter = traversal.counters ? &traversal.counters[self] : nullptr;
+
+    directory_entry_batch batch = {};
+    std::string directory = {};
+    std::string sub_directory = {};
+    u64 num_idle_rounds = 0;
+
+    while (!traversal.cancelled()) {
+        if (!state.pop(self, directory)) {
+            if (!state.steal(self, directory)) {
+                if (state.num_pending.load() == 0) {
+                    break;
+                }
+                //? Someone is still listing and may queue more, typically right at the start when there is one root for everyone.
+                if (++num_idle_rounds < 64) std::this_thread::yield();
+                else std::this_thread::sleep_for(std::chrono::microseconds(100));
+                continue;
+            }
+            if (counter) counter->num_steals.fetch_add(1, std::memory_order_relaxed);
+        }
+        num_idle_rounds = 0;
+
+        list_directory(state, self, directory, batch, sub_directory);
+
+        state.num_pending.fetch_sub(1);
+    }
+}
+
+void directory_traversal::run(std::vector<std::string> const &roots, visitor_t const &visit) const noexcept
+{
+    u64 num_workers = this->push_task ? std::clamp(this->num_threads, u64(1), max_threads) : 1;
+
+    auto state = std::make_shared<directory_traversal_state>(num_workers, *this, visit);
+
+    for (auto const &root : roots) {
+        state->push(0, root);
+    }
+
+    for (u64 i = 1; i < num_workers; ++i) {
+        this->push_task([state]() noexcept {
+            //? Announce before looking at `done`, `run` sets `done` before waiting for announced tasks, so one of the two sees the other.
+            state->num_active_tasks.fetch_add(1);
+            if (!state->done.load()) {
+                u64 self = state->next_worker.fetch_add(1);
+                if (self < state->num_workers) {
+                    traversal_worker(*state, self);
+                }
+            }
+            state->num_active_tasks.fetch_sub(1);
+        });
+    }
+
+    traversal_worker(*state, 0);
+
+    //? Every directory is listed (or the walk was cancelled), helpers still running are about to notice and return.
+    state->done.store(true);
+    while (state->num_active_tasks.load() != 0) {
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+//? Recursive directory walks spread over several threads, for the finder.
+
+#if defined(_WIN32)
+#   include "stdafx.hpp"
+#else
+#   include <atomic>
+#   include <functional>
+#   include <string>
+#   include <string_view>
+#   include <vector>
+#endif
+
+#include "primitives.hpp"
+#include "directory_enumeration.hpp"
+
+/// What one worker of a traversal got through. Each worker only writes its own, padded to a cache line so workers
+/// counting entries don't contend, readers sum them while the walk runs.
+struct alignas(64) directory_traversal_counter
+{
+    std::atomic<u64> num_entries = 0;
+    std::atomic<u64> num_directories = 0; // listed, including ones which couldn't be opened
+    std::atomic<u64> num_steals = 0;      // directories taken from another worker's queue
+
+    void reset() noexcept { num_entries.store(0); num_directories.store(0); num_steals.store(0); }
+};
+
+/// Walks directory trees on the calling thread and up to `num_threads - 1` tasks handed to `push_task`.
+/// Every discovered subdirectory becomes a unit of work on the queue of the worker which found it. Workers take their own
+/// most recent directories first (depth first, the parent's entries are still warm) and, once out of work, steal the oldest
+/// directory of another worker, the one near the top of a tree with the most left under it. Links (`directory_entry::link`)
+/// are visited but never descended into, so a junction pointing back up the tree can't make a walk endless.
+struct directory_traversal
+{
+    static constexpr u64 max_threads = 64;
+
+    /// Called for every batch of entries, on the worker which listed `directory_utf8`. Subdirectories are queued by the traversal,
+    /// the visitor only looks at entries. Runs concurrently with itself, anything it shares needs synchronizing.
+    typedef std::function<void (u64 worker, std::string_view directory_utf8, directory_entry_batch const &batch)> visitor_t;
+
+    std::function<void (std::function<void ()>)> push_task = {};
+    u64 num_threads = 1;
+    char separator = '\\';
+    std::atomic_bool const *cancellation_token = nullptr; // checked between batches, the visitor may check it per entry
+    directory_traversal_counter *counters = nullptr;      // optional, `num_threads` of them, indexed by worker
+
+    /// Returns once every directory under `roots` was listed, or soon after cancellation.
+    /// Tasks which start late, after the walk is over, return straight away without touching anything the caller owns.
+    void run(std::vector<std::string> const &roots, visitor_t const &visit) const noexcept;
+
+    bool cancelled() const noexcept { return cancellation_token != nullptr && cancellation_token->load(std::memory_order_relaxed); }
+};
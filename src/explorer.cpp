@@ -5,12 +5,96 @@
 #include "scoped_timer.hpp"
 #include "util.hpp"
 #include "explorer_drop_source.hpp"
+#include "date_time_format.hpp"
+#include "directory_enumeration.hpp"
+#include "row_sort.hpp"
+#include "substring_search.hpp"
 
 static IShellLinkW *g_shell_link = nullptr;
 static IPersistFile *g_persist_file_interface = nullptr;
 static std::array<explorer_window, global_constants::num_explorers> g_explorers = {};
+static directory_listing_cache g_listing_cache = {};
+static link_resolution_cache g_link_cache = {};
 
 std::array<explorer_window, global_constants::num_explorers> &global_state::explorers() noexcept { return g_explorers; }
+directory_listing_cache &global_state::listing_cache() noexcept { return g_listing_cache; }
+link_resolution_cache &global_state::link_cache() noexcept { return g_link_cache; }
+
+std::string directory_listing_cache::normalize_key(std::string_view path) noexcept
+{
+    while (!path.empty() && (path.back() == '\\' || path.back() == '/' || path.back() == ' ')) {
+        path.remove_suffix(1);
+    }
+
+    std::string key(path);
+    for (char &ch : key) {
+        if (ch == '/') ch = '\\';
+        else ch = (char)tolower((unsigned char)ch);
+    }
+    return key;
+}
+
+directory_listing_cache::entry const *directory_listing_cache::find(std::string_view path) noexcept
+{
+    std::string key = normalize_key(path);
+
+    auto iter = std::find_if(this->entries.begin(), this->entries.end(), [&](entry const &e) noexcept { return e.key == key; });
+
+    if (iter == this->entries.end()) {
+        ++this->num_misses;
+        return nullptr;
+    }
+    ++this->num_hits;
+    std::rotate(this->entries.begin(), iter, iter + 1);
+    return &this->entries.front();
+}
+
+void directory_listing_cache::store(std::string_view path, u64 dir_last_write_time, explorer_window::cwd_listing::batch &&listing) noexcept
+{
+    (void) this->erase(path);
+
+    entry new_entry = {};
+    new_entry.key = normalize_key(path);
+    new_entry.dir_last_write_time = dir_last_write_time;
+    new_entry.listing = std::move(listing);
+    new_entry.bytes = sizeof(entry) + new_entry.key.capacity()
+                    + (new_entry.listing.entries.entries.capacity() * sizeof(directory_entry))
+                    + new_entry.listing.entries.names.capacity()
+                    + (new_entry.listing.kinds.capacity() * sizeof(basic_dirent::kind));
+
+    if (new_entry.bytes > this->memory_budget || this->max_entries == 0) {
+        return;
+    }
+
+    while (!this->entries.empty() && (this->bytes_used + new_entry.bytes > this->memory_budget || this->entries.size() >= this->max_entries)) {
+        this->bytes_used -= this->entries.back().bytes;
+        this->entries.pop_back();
+        ++this->num_evictions;
+    }
+
+    this->bytes_used += new_entry.bytes;
+    this->entries.insert(this->entries.begin(), std::move(new_entry));
+}
+
+bool directory_listing_cache::erase(std::string_view path) noexcept
+{
+    std::string key = normalize_key(path);
+
+    auto iter = std::find_if(this->entries.begin(), this->entries.end(), [&](entry const &e) noexcept { return e.key == key; });
+
+    if (iter == this->entries.end()) {
+        return false;
+    }
+    this->bytes_used -= iter->bytes;
+    this->entries.erase(iter);
+    return true;
+}
+
+void directory_listing_cache::clear() noexcept
+{
+    this->entries.clear();
+    this->bytes_used = 0;
+}
 
 void init_explorer_COM_GLFW_OpenGL3(GLFWwindow *window, char const *ini_file_path) noexcept
 {
@@ -130,25 +214,6 @@ catch (...) {
     print_debug_msg("FAILED catch(...)");
 }
 
-struct cwd_count_info
-{
-    u64 selected_dirents;
-    u64 selected_directories;
-    // u64 selected_symlinks;
-    u64 selected_files;
-    u64 selected_files_size;
-
-    u64 filtered_dirents;
-    u64 filtered_directories;
-    // u64 filtered_symlinks;
-    u64 filtered_files;
-
-    u64 child_dirents;
-    u64 child_directories;
-    // u64 child_symlinks;
-    u64 child_files;
-};
-
 static
 void render_count_summary(u64 cnt_dir, u64 cnt_file, u64 cnt_symlink = 0) noexcept
 {
@@ -177,6 +242,89 @@ render_table_rows_for_cwd_entries_result
     std::optional<swan_path> descend_target = std::nullopt;
     bool do_ascend = false;
 };
+//? The locale's short date and time patterns and UTC offset, re-read every minute so that a change of time zone,
+//? daylight saving or regional settings shows up without a restart. Only touched by the UI thread.
+static date_time_format g_date_time_format = {};
+static u32 g_date_time_format_generation = 0;
+static time_point_precise_t g_date_time_format_load_time = {};
+
+/// Returns a generation number which changes whenever the format does.
+static
+u32 refresh_date_time_format() noexcept
+{
+    time_point_precise_t now = get_time_precise();
+
+    if (g_date_time_format_generation != 0 && time_diff_ms(g_date_time_format_load_time, now) < 60'000) {
+        return g_date_time_format_generation;
+    }
+    g_date_time_format_load_time = now;
+
+    auto locale_string = [](LCTYPE type, auto &out_utf8) noexcept {
+        wchar_t buffer[80];
+        if (GetLocaleInfoEx(LOCALE_NAME_USER_DEFAULT, type, buffer, lengthof(buffer)) == 0) {
+            return false;
+        }
+        return utf16_to_utf8(buffer, out_utf8.data(), out_utf8.size()) > 0;
+    };
+
+    std::array<char, 80> date_pattern = {}, time_pattern = {};
+    if (!locale_string(LOCALE_SSHORTDATE, date_pattern)) date_pattern = { "yyyy-MM-dd" };
+    if (!locale_string(LOCALE_SSHORTTIME, time_pattern)) time_pattern = { "HH:mm" };
+
+    date_time_format::locale_names names = date_time_format::english_names();
+    for (u32 i = 0; i < 12; ++i) {
+        (void) locale_string(LOCALE_SMONTHNAME1 + i, names.months[i]);
+        (void) locale_string(LOCALE_SABBREVMONTHNAME1 + i, names.months_abbrev[i]);
+    }
+    for (u32 i = 0; i < 7; ++i) { // Windows starts the week on Monday
+        (void) locale_string(LOCALE_SDAYNAME1 + i, names.days[(i + 1) % 7]);
+        (void) locale_string(LOCALE_SABBREVDAYNAME1 + i, names.days_abbrev[(i + 1) % 7]);
+    }
+    (void) locale_string(LOCALE_S1159, names.am);
+    (void) locale_string(LOCALE_S2359, names.pm);
+
+    TIME_ZONE_INFORMATION time_zone;
+    s64 bias_minutes = 0; // UTC = local + bias
+    switch (GetTimeZoneInformation(&time_zone)) {
+        case TIME_ZONE_ID_DAYLIGHT: bias_minutes = time_zone.Bias + time_zone.DaylightBias; break;
+        case TIME_ZONE_ID_STANDARD: bias_minutes = time_zone.Bias + time_zone.StandardBias; break;
+        case TIME_ZONE_ID_UNKNOWN:  bias_minutes = time_zone.Bias; break;
+        default: break;
+    }
+
+    date_time_format fresh = {};
+    fresh.compile(date_pattern.data(), time_pattern.data(), names, -bias_minutes);
+
+    if (g_date_time_format_generation == 0 || !(fresh == g_date_time_format)) {
+        g_date_time_format = std::move(fresh);
+        ++g_date_time_format_generation;
+    }
+    return g_date_time_format_generation;
+}
+
+/// The column text slot for `row`, emptied if it was formatted with different settings. Its remembered values are then
+/// ones no row has, so every column is formatted again when drawn.
+static
+explorer_window::column_text_cache::slot &claim_column_text_slot(
+    explorer_window::column_text_cache &cache,
+    u64 row,
+    u32 format_generation,
+    u64 size_unit_multiplier) noexcept
+{
+    if (cache.slots.empty()) {
+        cache.slots.resize(explorer_window::column_text_cache::num_slots); // value initialized, format_generation 0 matches nothing
+    }
+
+    auto &slot = cache.slots[row % explorer_window::column_text_cache::num_slots];
+
+    if (slot.format_generation != format_generation || slot.size_unit_multiplier != size_unit_multiplier) {
+        slot.size = slot.creation_time = slot.last_write_time = UINT64_MAX;
+        slot.format_generation = format_generation;
+        slot.size_unit_multiplier = u32(size_unit_multiplier);
+    }
+    return slot;
+}
+
 static
 render_table_rows_for_cwd_entries_result render_table_rows_for_cwd_entries(
     explorer_window &expl,
@@ -190,7 +338,7 @@ struct render_dirent_context_menu_result
 {
     bool open_bulk_rename_popup;
     bool open_single_rename_popup;
-    explorer_window::dirent *single_dirent_to_be_renamed;
+    std::optional<basic_dirent> single_dirent_to_be_renamed;
     std::optional<ImRect> context_menu_rect;
 };
 static render_dirent_context_menu_result
@@ -199,38 +347,461 @@ render_dirent_context_menu(explorer_window &expl, cwd_count_info const &cnt, swa
 static
 void accept_move_dirents_drag_drop(explorer_window &expl) noexcept;
 
-u64 explorer_window::deselect_all_cwd_entries() noexcept
+u64 explorer_window::dirent_table::push_back(
+    std::string_view name,
+    basic_dirent::kind kind,
+    u64 size,
+    u64 creation_time,
+    u64 last_write_time,
+    u32 id) noexcept
+{
+    u64 row = this->count();
+
+    // this could throw on alloc failure, which will call std::terminate
+    this->name_offsets.push_back((u32)this->names.size());
+    this->name_lengths.push_back((u16)name.size());
+    this->names.insert(this->names.end(), name.begin(), name.end());
+    this->names.push_back('\0');
+
+    this->sizes.push_back(size);
+    this->creation_times.push_back(creation_time);
+    this->last_write_times.push_back(last_write_time);
+    this->ids.push_back(id);
+    this->kinds.push_back(kind);
+    this->selected.push_back(false);
+    this->filtered.push_back(false);
+    this->cut.push_back(false);
+    this->ui.emplace_back();
+
+    this->invalidate_counts();
+
+    return row;
+}
+
+void explorer_window::dirent_table::swap_rows(u64 row_a, u64 row_b) noexcept
+{
+    std::swap(this->name_offsets[row_a], this->name_offsets[row_b]);
+    std::swap(this->name_lengths[row_a], this->name_lengths[row_b]);
+    std::swap(this->sizes[row_a], this->sizes[row_b]);
+    std::swap(this->creation_times[row_a], this->creation_times[row_b]);
+    std::swap(this->last_write_times[row_a], this->last_write_times[row_b]);
+    std::swap(this->ids[row_a], this->ids[row_b]);
+    std::swap(this->kinds[row_a], this->kinds[row_b]);
+    std::swap(this->ui[row_a], this->ui[row_b]);
+
+    for (packed_bits *bits : { &this->selected, &this->filtered, &this->cut }) {
+        bool a = bits->get(row_a);
+        bits->set(row_a, bits->get(row_b));
+        bits->set(row_b, a);
+    }
+}
+
+void explorer_window::dirent_table::apply_permutation(std::vector<u32> const &new_to_old_row) noexcept
+{
+    assert(new_to_old_row.size() <= this->count());
+
+    u64 old_count = this->count();
+
+    auto gather = [&](auto &column) noexcept {
+        std::remove_reference_t<decltype(column)> gathered(new_to_old_row.size());
+        for (u64 i = 0; i < new_to_old_row.size(); ++i) {
+            gathered[i] = std::move(column[new_to_old_row[i]]);
+        }
+        std::swap(column, gathered);
+    };
+    auto gather_bits = [&](packed_bits &bits) noexcept {
+        packed_bits gathered = {};
+        gathered.assign(new_to_old_row.size(), false);
+        for (u64 i = 0; i < new_to_old_row.size(); ++i) {
+            if (bits.get(new_to_old_row[i])) gathered.set(i, true);
+        }
+        std::swap(bits, gathered);
+    };
+
+    gather(this->name_offsets);
+    gather(this->name_lengths);
+    gather(this->sizes);
+    gather(this->creation_times);
+    gather(this->last_write_times);
+    gather(this->ids);
+    gather(this->kinds);
+    gather(this->ui);
+    gather_bits(this->selected);
+    gather_bits(this->filtered);
+    gather_bits(this->cut);
+
+    if (new_to_old_row.size() < old_count) { // a pure reordering keeps every total
+        this->invalidate_counts();
+    }
+}
+
+void explorer_window::dirent_table::permute_prefix(std::vector<u32> const &new_to_old_row) noexcept
+{
+    assert(new_to_old_row.size() <= this->count());
+
+    auto gather = [&](auto &column) noexcept {
+        std::remove_reference_t<decltype(column)> gathered(new_to_old_row.size());
+        for (u64 i = 0; i < new_to_old_row.size(); ++i) {
+            gathered[i] = std::move(column[new_to_old_row[i]]);
+        }
+        std::move(gathered.begin(), gathered.end(), column.begin());
+    };
+    auto gather_bits = [&](packed_bits &bits) noexcept {
+        static std::vector<u8> s_gathered = {};
+        s_gathered.resize(new_to_old_row.size());
+        for (u64 i = 0; i < new_to_old_row.size(); ++i) {
+            s_gathered[i] = bits.get(new_to_old_row[i]);
+        }
+        for (u64 i = 0; i < new_to_old_row.size(); ++i) {
+            bits.set(i, s_gathered[i] != 0);
+        }
+    };
+
+    gather(this->name_offsets);
+    gather(this->name_lengths);
+    gather(this->sizes);
+    gather(this->creation_times);
+    gather(this->last_write_times);
+    gather(this->ids);
+    gather(this->kinds);
+    gather(this->ui);
+    gather_bits(this->selected);
+    gather_bits(this->filtered);
+    gather_bits(this->cut);
+}
+
+void explorer_window::dirent_table::compact_names() noexcept
+{
+    std::vector<char> compacted = {};
+    compacted.reserve(this->names.size());
+
+    for (u64 row = 0; row < this->count(); ++row) {
+        char const *name = this->name(row);
+        this->name_offsets[row] = (u32)compacted.size();
+        compacted.insert(compacted.end(), name, name + this->name_lengths[row] + 1);
+    }
+    std::swap(this->names, compacted);
+}
+
+u64 explorer_window::dirent_table::apply_changes(
+    std::vector<change> &changes,
+    std::function<void (u64 first_row)> const &filter_new_rows,
+    std::function<bool (u32 left, u32 right)> const &row_less) noexcept
+{
+    u64 num_rows_before = this->count();
+
+    // find the current row of every mentioned name, and the next free id, in a single pass over the table
+    static std::unordered_map<std::string_view, u64> s_change_idx_by_name = {};
+    static std::vector<u64> s_row_before = {};
+    s_change_idx_by_name.clear();
+    s_row_before.assign(changes.size(), u64(-1));
+    for (u64 i = 0; i < changes.size(); ++i) {
+        s_change_idx_by_name.emplace(changes[i].name, i);
+    }
+
+    u32 next_id = 0;
+    for (u64 row = 0; row < num_rows_before; ++row) {
+        next_id = std::max(next_id, this->ids[row] + 1);
+
+        auto iter = s_change_idx_by_name.find(std::string_view(this->name(row), this->name_lengths[row]));
+        if (iter != s_change_idx_by_name.end()) {
+            s_row_before[iter->second] = row;
+        }
+    }
+
+    //? 0 = keep in place, 1 = drop, 2 = reinsert at its sorted position
+    static std::vector<u8> s_row_fate = {};
+    s_row_fate.assign(num_rows_before, 0);
+
+    for (u64 i = 0; i < changes.size(); ++i) {
+        auto &change = changes[i];
+        u64 row = s_row_before[i];
+
+        if (row != u64(-1) && change.unresolved_link && basic_dirent::is_symlink(this->kinds[row])) {
+            change.kind = this->kinds[row]; // keep showing what the link resolved to before until it's resolved again
+        }
+
+        // the entry stays the same to the user across a change of kind or name
+        u32 replaced_id = UINT32_MAX;
+        bool replaced_selected = false;
+        bool replaced_context_menu_active = false;
+
+        auto replace = [&](u64 replaced_row) noexcept {
+            replaced_id = this->ids[replaced_row];
+            replaced_selected = this->selected.get(replaced_row);
+            replaced_context_menu_active = this->ui[replaced_row].context_menu_active;
+        };
+
+        if (row != u64(-1)) {
+            if (!change.exists || this->kinds[row] != change.kind) {
+                if (change.exists) {
+                    replace(row);
+                }
+                s_row_fate[row] = 1;
+                row = u64(-1);
+            }
+            else {
+                // same entry, new metadata: the sort key may have changed, so it moves
+                this->sizes[row] = change.size;
+                this->creation_times[row] = change.creation_time;
+                this->last_write_times[row] = change.last_write_time;
+                s_row_fate[row] = 2;
+            }
+        }
+
+        if (change.exists && row == u64(-1) && replaced_id == UINT32_MAX && !change.renamed_from.empty()) {
+            //? Only if the old name is gone, which also makes its row give its identity away at most once.
+            auto iter = s_change_idx_by_name.find(change.renamed_from);
+            if (iter != s_change_idx_by_name.end() && !changes[iter->second].exists && s_row_before[iter->second] != u64(-1)) {
+                replace(s_row_before[iter->second]);
+            }
+        }
+
+        if (change.exists && row == u64(-1)) {
+            u32 id = replaced_id != UINT32_MAX ? replaced_id : next_id++;
+            row = this->push_back(change.name, change.kind, change.size, change.creation_time, change.last_write_time, id);
+            this->selected.set(row, replaced_selected);
+            this->ui[row].context_menu_active = replaced_context_menu_active;
+        }
+
+        if (change.select && row != u64(-1)) {
+            this->selected.set(row, true);
+        }
+        change.row = row;
+    }
+
+    this->invalidate_counts(); // sizes and selection may have changed without any row being added or dropped
+
+    u64 num_rows_after = this->count();
+
+    if (num_rows_after > num_rows_before) {
+        filter_new_rows(num_rows_before);
+    }
+
+    // Keep the order of untouched rows and merge the (re)inserted ones in, instead of sorting everything again.
+    static std::vector<u32> s_kept_visible, s_kept_filtered, s_moved_visible, s_moved_filtered, s_new_to_old, s_old_to_new;
+    s_kept_visible.clear(); s_kept_filtered.clear(); s_moved_visible.clear(); s_moved_filtered.clear();
+
+    for (u64 row = 0; row < num_rows_after; ++row) {
+        u8 fate = row < num_rows_before ? s_row_fate[row] : 2;
+        if (fate == 1) {
+            continue;
+        }
+        bool filtered = this->filtered.get(row);
+        auto &bucket = fate == 0 ? (filtered ? s_kept_filtered : s_kept_visible) : (filtered ? s_moved_filtered : s_moved_visible);
+        bucket.push_back((u32)row);
+    }
+
+    std::sort(s_moved_visible.begin(), s_moved_visible.end(), row_less);
+
+    s_new_to_old.resize(s_kept_visible.size() + s_moved_visible.size());
+    std::merge(s_kept_visible.begin(), s_kept_visible.end(), s_moved_visible.begin(), s_moved_visible.end(), s_new_to_old.begin(), row_less);
+    u64 first_filtered_row = s_new_to_old.size();
+    s_new_to_old.insert(s_new_to_old.end(), s_kept_filtered.begin(), s_kept_filtered.end());
+    s_new_to_old.insert(s_new_to_old.end(), s_moved_filtered.begin(), s_moved_filtered.end());
+
+    this->apply_permutation(s_new_to_old);
+
+    s_old_to_new.assign(num_rows_after, UINT32_MAX);
+    for (u64 i = 0; i < s_new_to_old.size(); ++i) {
+        s_old_to_new[s_new_to_old[i]] = (u32)i;
+    }
+    for (auto &change : changes) {
+        if (change.row != u64(-1)) {
+            change.row = s_old_to_new[change.row];
+        }
+    }
+
+    //? Removed and renamed rows leave their names behind in the arena, reclaim once garbage outweighs live names.
+    u64 live_name_bytes = 0;
+    for (u64 row = 0; row < this->count(); ++row) {
+        live_name_bytes += this->name_lengths[row] + 1;
+    }
+    if (this->names.size() > live_name_bytes * 2) {
+        this->compact_names();
+    }
+
+    return first_filtered_row;
+}
+
+void explorer_window::dirent_table::reserve(u64 num_rows, u64 num_name_bytes) noexcept
+{
+    this->name_offsets.reserve(num_rows);
+    this->name_lengths.reserve(num_rows);
+    this->sizes.reserve(num_rows);
+    this->creation_times.reserve(num_rows);
+    this->last_write_times.reserve(num_rows);
+    this->ids.reserve(num_rows);
+    this->kinds.reserve(num_rows);
+    this->ui.reserve(num_rows);
+    this->names.reserve(num_name_bytes);
+}
+
+void explorer_window::dirent_table::clear() noexcept
+{
+    this->name_offsets.clear();
+    this->name_lengths.clear();
+    this->sizes.clear();
+    this->creation_times.clear();
+    this->last_write_times.clear();
+    this->ids.clear();
+    this->kinds.clear();
+    this->selected.clear();
+    this->filtered.clear();
+    this->cut.clear();
+    this->ui.clear();
+    this->names.clear();
+    this->counts = {};
+    this->counts_stale = false;
+}
+
+cwd_count_info explorer_window::dirent_table::recount() const noexcept
+{
+    cwd_count_info cnt = {};
+
+    for (u64 row = 0; row < this->count(); ++row) {
+        static_assert(u64(false) == 0);
+        static_assert(u64(true)  == 1);
+
+        basic_dirent::kind type = this->kinds[row];
+        bool filtered = this->filtered.get(row);
+        bool selected = this->selected.get(row);
+
+        bool is_path_dotdot = this->is_path_dotdot(row);
+        bool is_dir = type == basic_dirent::kind::directory || type == basic_dirent::kind::symlink_to_directory;
+        bool is_file = type == basic_dirent::kind::file || type == basic_dirent::kind::symlink_to_file;
+
+        cnt.filtered_directories += u64(filtered && is_dir);
+        cnt.filtered_files       += u64(filtered && is_file);
+
+        cnt.child_dirents     += 1; // u64(!is_path_dotdot);
+        cnt.child_directories += u64(is_dir);
+        cnt.child_files       += u64(is_file || type == basic_dirent::kind::symlink_ambiguous);
+
+        // cnt.filtered_symlinks += u64(filtered && basic_dirent::is_symlink(type));
+        // cnt.child_symlinks += u64(basic_dirent::is_symlink(type));
+
+        if (!filtered && selected) {
+            cnt.selected_directories += u64(selected && is_dir && !is_path_dotdot);
+            cnt.selected_files       += u64(selected && is_file);
+            cnt.selected_files_size  += u64(is_file) * this->sizes[row];
+
+            // cnt.selected_symlinks += u64(selected && basic_dirent::is_symlink(type));
+        }
+    }
+
+    cnt.filtered_dirents = cnt.filtered_directories + cnt.filtered_files; // + cnt.filtered_symlinks
+    cnt.selected_dirents = cnt.selected_directories + cnt.selected_files; // + cnt.selected_symlinks
+
+    return cnt;
+}
+
+cwd_count_info const &explorer_window::dirent_table::up_to_date_counts() noexcept
 {
-    u64 num_deselected = 0;
+    if (this->counts_stale) {
+        this->counts = this->recount();
+        this->counts_stale = false;
+    }
+    return this->counts;
+}
+
+void explorer_window::dirent_table::count_selection_change(u64 row, bool selected) noexcept
+{
+    //? Filtered rows don't count as selected, see `recount`. Their bit can still flip (e.g. invert deselects them).
+    if (this->counts_stale || this->filtered.get(row)) {
+        return;
+    }
+
+    basic_dirent::kind type = this->kinds[row];
+    bool is_dir = (type == basic_dirent::kind::directory || type == basic_dirent::kind::symlink_to_directory) && !this->is_path_dotdot(row);
+    bool is_file = type == basic_dirent::kind::file || type == basic_dirent::kind::symlink_to_file;
+
+    if (!is_dir && !is_file) {
+        return;
+    }
 
-    for (auto &dirent : this->cwd_entries) {
-        bool prev = dirent.selected;
-        bool &curr = dirent.selected;
-        curr = false;
-        num_deselected += curr != prev;
+    auto &cnt = this->counts;
+    if (selected) {
+        cnt.selected_directories += u64(is_dir);
+        cnt.selected_files       += u64(is_file);
+        cnt.selected_files_size  += u64(is_file) * this->sizes[row];
+        cnt.selected_dirents     += 1;
+    } else {
+        cnt.selected_directories -= u64(is_dir);
+        cnt.selected_files       -= u64(is_file);
+        cnt.selected_files_size  -= u64(is_file) * this->sizes[row];
+        cnt.selected_dirents     -= 1;
     }
+}
+
+u64 explorer_window::dirent_table::find_id(u32 id) const noexcept
+{
+    auto iter = std::find(this->ids.begin(), this->ids.end(), id);
+    return iter == this->ids.end() ? u64(-1) : u64(iter - this->ids.begin());
+}
+
+basic_dirent explorer_window::dirent_table::make_basic_dirent(u64 row) const noexcept
+{
+    basic_dirent retval = {};
+    retval.size = this->sizes[row];
+    retval.creation_time_raw = one_u64_to_filetime(this->creation_times[row]);
+    retval.last_write_time_raw = one_u64_to_filetime(this->last_write_times[row]);
+    retval.id = this->ids[row];
+    retval.type = this->kinds[row];
+    retval.path = path_create(this->name(row), this->name_lengths[row]);
+    return retval;
+}
+
+u64 explorer_window::dirent_table::bytes_occupied() const noexcept
+{
+    u64 bytes_per_row = sizeof(u32) + sizeof(u16) + (sizeof(u64) * 3) + sizeof(u32) + sizeof(basic_dirent::kind) + sizeof(dirent_ui_state);
+    u64 bits_bytes = (this->selected.words.size() + this->filtered.words.size() + this->cut.words.size()) * sizeof(u64);
+    return (this->count() * bytes_per_row) + bits_bytes + this->names.size();
+}
+
+u64 explorer_window::dirent_table::bytes_reserved() const noexcept
+{
+    return (this->name_offsets.capacity() * sizeof(u32))
+         + (this->name_lengths.capacity() * sizeof(u16))
+         + (this->sizes.capacity() * sizeof(u64))
+         + (this->creation_times.capacity() * sizeof(u64))
+         + (this->last_write_times.capacity() * sizeof(u64))
+         + (this->ids.capacity() * sizeof(u32))
+         + (this->kinds.capacity() * sizeof(basic_dirent::kind))
+         + (this->ui.capacity() * sizeof(dirent_ui_state))
+         + ((this->selected.words.capacity() + this->filtered.words.capacity() + this->cut.words.capacity()) * sizeof(u64))
+         + this->names.capacity();
+}
+
+u64 explorer_window::deselect_all_cwd_entries() noexcept
+{
+    u64 num_deselected = this->cwd_entries.selected.count_set();
+    this->cwd_entries.selected.assign(this->cwd_entries.count(), false);
+
+    auto &cnt = this->cwd_entries.counts;
+    cnt.selected_dirents = cnt.selected_directories = cnt.selected_files = cnt.selected_files_size = 0;
 
     return num_deselected;
 }
 
 void explorer_window::select_all_visible_cwd_entries(bool select_dotdot_dir) noexcept
 {
-    for (auto &dirent : this->cwd_entries) {
-        if ( (!select_dotdot_dir && dirent.basic.is_path_dotdot()) || dirent.filtered ) {
+    for (auto dirent : this->cwd_entries) {
+        if ( (!select_dotdot_dir && dirent.is_path_dotdot()) || dirent.filtered() ) {
             continue;
         } else {
-            dirent.selected = true;
+            dirent.set_selected(true);
         }
     }
 }
 
 void explorer_window::invert_selection_on_visible_cwd_entries() noexcept
 {
-    for (auto &dirent : this->cwd_entries) {
-        if (dirent.filtered) {
-            dirent.selected = false;
-        } else if (!dirent.basic.is_dotdot_dir()) {
-            dirent.selected = !dirent.selected;
+    for (auto dirent : this->cwd_entries) {
+        if (dirent.filtered()) {
+            dirent.set_selected(false);
+        } else if (!dirent.is_dotdot_dir()) {
+            dirent.set_selected(!dirent.selected());
         }
     }
 }
@@ -248,9 +819,7 @@ void explorer_window::set_latest_valid_cwd(swan_path const &new_latest_valid_cwd
 
 void explorer_window::uncut() noexcept
 {
-    for (auto &dirent : this->cwd_entries) {
-        dirent.cut = false;
-    }
+    this->cwd_entries.cut.assign(this->cwd_entries.count(), false);
 }
 
 void explorer_window::reset_filter() noexcept
@@ -264,6 +833,7 @@ void explorer_window::reset_filter() noexcept
     this->filter_show_symlink_files = true;
 
     this->filter_polarity = true;
+    this->filter_sort_by_score = true;
     this->filter_case_sensitive = false;
     this->filter_mode = explorer_window::filter_mode::contains;
 }
@@ -273,21 +843,21 @@ generic_result add_selected_entries_to_file_op_payload(explorer_window &expl, ch
 {
     std::stringstream err = {};
 
-    for (auto &dirent : expl.cwd_entries) {
-        if (!dirent.selected || dirent.basic.is_path_dotdot()) {
+    for (auto dirent : expl.cwd_entries) {
+        if (!dirent.selected() || dirent.is_path_dotdot()) {
             continue;
         }
 
         if (operation_type == file_operation_type::move) {
-            if (dirent.cut) {
+            if (dirent.cut()) {
                 continue; // prevent same dirent from being cut multiple times
                           // (although multiple copy commands of the same dirent are permitted, intentionally)
             } else {
-                dirent.cut = true;
+                dirent.set_cut(true);
             }
         }
 
-        if (operation_type == file_operation_type::copy && dirent.cut) {
+        if (operation_type == file_operation_type::copy && dirent.cut()) {
             // this situation wouldn't make sense, because you can't CopyItem after MoveItem since there's nothing left to copy
             // TODO: maybe indicate something to the user rather than ignoring their request?
             continue;
@@ -295,8 +865,8 @@ generic_result add_selected_entries_to_file_op_payload(explorer_window &expl, ch
 
         swan_path src = expl.cwd;
 
-        if (path_append(src, dirent.basic.path.data(), global_state::settings().dir_separator_utf8, true)) {
-            global_state::file_op_cmd_buf().items.push_back({ operation_desc, operation_type, dirent.basic.type, src });
+        if (path_append(src, dirent.name(), global_state::settings().dir_separator_utf8, true)) {
+            global_state::file_op_cmd_buf().items.push_back({ operation_desc, operation_type, dirent.type(), src });
         } else {
             err << "Current working directory path + [" << src.data() << "] exceeds max allowed path length.\n";
         }
@@ -467,12 +1037,12 @@ generic_result delete_selected_entries(explorer_window &expl, swan_settings cons
         wchar_t item_utf16[MAX_PATH];
         std::stringstream err = {};
 
-        for (auto const &item : expl.cwd_entries) {
-            if (!item.filtered && item.selected) {
+        for (auto item : expl.cwd_entries) {
+            if (!item.filtered() && item.selected()) {
                 cstr_clear(item_utf16);
 
-                if (!utf8_to_utf16(item.basic.path.data(), item_utf16, lengthof(item_utf16))) {
-                    err << "Conversion of [" << item.basic.path.data() << "] from UTF-8 to UTF-16.\n";
+                if (!utf8_to_utf16(item.name(), item_utf16, lengthof(item_utf16))) {
+                    err << "Conversion of [" << item.name() << "] from UTF-8 to UTF-16.\n";
                 }
 
                 packed_paths_to_delete_utf16.append(item_utf16).append(L"\n");
@@ -557,7 +1127,7 @@ generic_result move_files_into(swan_path const &destination_utf8, explorer_windo
 static
 generic_result handle_drag_drop_onto_dirent(
     explorer_window &expl,
-    explorer_window::dirent const &target_dirent,
+    explorer_window::dirent target_dirent,
     ImGuiPayload const *payload_wrapper,
     char dir_sep_utf8) noexcept
 {
@@ -565,7 +1135,7 @@ generic_result handle_drag_drop_onto_dirent(
     assert(payload_data != nullptr);
     swan_path destination_utf8 = expl.cwd;
 
-    if (target_dirent.basic.is_dotdot_dir()) {
+    if (target_dirent.is_dotdot_dir()) {
         // we cannot simply append ".." to `destination_utf8` and give that to `move_files_into`,
         // because shlwapi does not accept a path like "C:/some/path/../"
         while (path_pop_back_if_not(destination_utf8, dir_sep_utf8));
@@ -573,8 +1143,8 @@ generic_result handle_drag_drop_onto_dirent(
         return move_files_into(destination_utf8, expl, *payload_data);
     }
     else {
-        if (!path_append(destination_utf8, target_dirent.basic.path.data(), dir_sep_utf8, true)) {
-            return { false, make_str("Append current working directory to drop target [%s]", target_dirent.basic.path.data()) };
+        if (!path_append(destination_utf8, target_dirent.name(), dir_sep_utf8, true)) {
+            return { false, make_str("Append current working directory to drop target [%s]", target_dirent.name()) };
         } else {
             return move_files_into(destination_utf8, expl, *payload_data);
         }
@@ -719,10 +1289,10 @@ generic_result symlink_data::save(char const *lnk_file_path_utf8, char const *cw
 /// If symlink points to a directory, return the path of the pointed to directory in `error_or_utf8_path`.
 /// If data extraction fails, the reason is stated in `error_or_utf8_path`.
 static
-generic_result open_symlink(explorer_window::dirent const &dirent, explorer_window &expl) noexcept
+generic_result open_symlink(explorer_window::dirent dirent, explorer_window &expl) noexcept
 {
     symlink_data lnk_data = {};
-    auto extract_result = lnk_data.load(dirent.basic.path.data(), expl.cwd.data());
+    auto extract_result = lnk_data.load(dirent.name(), expl.cwd.data());
     if (!extract_result.success) {
         return extract_result; // propogate failure to caller
     }
@@ -760,102 +1330,1202 @@ generic_result open_symlink(explorer_window::dirent const &dirent, explorer_wind
     }
 }
 
+static constexpr s32 g_obj_precedence_table[(u64)basic_dirent::kind::count] = {
+    10, // directory
+    10, // symlink_to_directory
+    5,  // file
+    5,  // symlink_to_file
+    5,  // symlink_ambiguous
+    5,  // invalid_symlink
+};
+
+/// Strict weak ordering of two rows of `expl.cwd_entries` according to `expl.column_sort_specs`, ties broken by id.
+/// True if visible rows are ranked by their fuzzy filter score first, the column sort specs only break ties.
+static
+bool ranking_by_filter_score(explorer_window const &expl) noexcept
+{
+    return expl.filter_mode == explorer_window::filter_mode::fuzzy
+        && expl.filter_sort_by_score
+        && expl.filter_polarity == true
+        && !cstr_empty(expl.filter_text.data());
+}
+
+/// Used for the sorted insertion of rows from change notifications, must agree with the keys built by `sort_cwd_entries`.
+static
+bool cwd_entries_row_less(explorer_window const &expl, u32 left, u32 right) noexcept
+{
+    auto const &cwd_entries = expl.cwd_entries;
+    s64 delta = 0;
+
+    if (ranking_by_filter_score(expl) && cwd_entries.ui[left].filter_score != cwd_entries.ui[right].filter_score) {
+        return cwd_entries.ui[left].filter_score > cwd_entries.ui[right].filter_score;
+    }
+
+    for (auto const &col_sort_spec : expl.column_sort_specs) {
+        switch (col_sort_spec.ColumnUserID) {
+            default:
+            case explorer_window::cwd_entries_table_col_id: {
+                delta = s64(cwd_entries.ids[left]) - s64(cwd_entries.ids[right]);
+                break;
+            }
+            case explorer_window::cwd_entries_table_col_path: {
+                delta = collate_names(std::string_view(cwd_entries.name(right), cwd_entries.name_lengths[right]),
+                                      std::string_view(cwd_entries.name(left), cwd_entries.name_lengths[left]));
+                break;
+            }
+            case explorer_window::cwd_entries_table_col_object:
+            case explorer_window::cwd_entries_table_col_type: {
+                assert((s32)cwd_entries.kinds[right] >= 0);
+                delta = g_obj_precedence_table[(u64)cwd_entries.kinds[left]] - g_obj_precedence_table[(u64)cwd_entries.kinds[right]];
+                break;
+            }
+            case explorer_window::cwd_entries_table_col_size_formatted:
+            case explorer_window::cwd_entries_table_col_size_bytes: {
+                delta = s64(cwd_entries.sizes[left] - cwd_entries.sizes[right]);
+                break;
+            }
+            case explorer_window::cwd_entries_table_col_creation_time: {
+                u64 l = cwd_entries.creation_times[left], r = cwd_entries.creation_times[right];
+                delta = s64(l > r) - s64(l < r);
+                break;
+            }
+            case explorer_window::cwd_entries_table_col_last_write_time: {
+                u64 l = cwd_entries.last_write_times[left], r = cwd_entries.last_write_times[right];
+                delta = s64(l > r) - s64(l < r);
+                break;
+            }
+        }
+
+        if (delta > 0) {
+            return col_sort_spec.SortDirection == ImGuiSortDirection_Ascending;
+        }
+        else if (delta < 0) {
+            return col_sort_spec.SortDirection != ImGuiSortDirection_Ascending;
+        }
+        else { // delta == 0
+            continue; // go to next sort spec
+        }
+    }
+
+    return cwd_entries.ids[left] < cwd_entries.ids[right];
+}
+
 /// @brief Partitions and sorts `expl.cwd_entries` by `filtered` and `expl.sort_specs`, in place.
 /// Entries are partitioned by the `filtered` flag.
 /// The first partition contains the entries with `filtered == false`, sorted according to `expl.sort_specs`.
 /// The second partition contains entries with `filtered == true`, whose order is undefined.
-/// @return Iterator to the second partition, can be `cwd_entries.end()` if all entries are `filtered == false`.
+/// Only a permutation of row indices is sorted, the columns are gathered into the new order once at the end.
+/// Sort keys are prepared once up front so comparisons never switch on the column or compare strings.
+/// Large listings build keys and sort on the thread pool as well as the calling thread, unless `parallel` is false.
+/// In fuzzy filter mode visible rows can be ranked by their filter score ahead of the sort specs, see `ranking_by_filter_score`.
+/// @return Row index of the second partition, can be `cwd_entries.count()` if all entries are `filtered == false`.
 static
-std::vector<explorer_window::dirent>::iterator
-sort_cwd_entries(explorer_window &expl, std::source_location sloc = std::source_location::current()) noexcept
+u64 sort_cwd_entries(explorer_window &expl, bool parallel = true, std::source_location sloc = std::source_location::current()) noexcept
 {
     f64 sort_us = 0;
     SCOPE_EXIT { expl.sort_timing_samples.push_back(sort_us); };
     scoped_timer<timer_unit::MICROSECONDS> sort_timer(&sort_us);
 
-    auto &cwd_entries = expl.cwd_entries;
+    auto &cwd_entries = expl.cwd_entries;
+
+    print_debug_msg("[ %d ] sort_cwd_entries() called from [%s:%d]", expl.id, path_cfind_filename(sloc.file_name()), sloc.line());
+
+    u64 first_filtered_dirent = 0;
+
+    //? The partition reads the flags the filter pass left in `filtered` a word at a time: unfiltered rows, then filtered rows.
+    static std::vector<u32> s_rows = {};
+    s_rows.clear();
+    s_rows.reserve(cwd_entries.count());
+
+    auto const &filtered_words = cwd_entries.filtered.words;
+    for (u64 want_filtered = 0; want_filtered < 2; ++want_filtered) {
+        for (u64 w = 0; w < filtered_words.size(); ++w) {
+            u64 bits = want_filtered ? filtered_words[w] : ~filtered_words[w];
+            u64 num_rows_in_word = std::min(u64(64), cwd_entries.count() - (w * 64));
+            if (num_rows_in_word < 64) {
+                bits &= (u64(1) << num_rows_in_word) - 1;
+            }
+            while (bits != 0) {
+                s_rows.push_back(u32((w * 64) + (u64)std::countr_zero(bits)));
+                bits &= bits - 1;
+            }
+        }
+        if (want_filtered == 0) {
+            first_filtered_dirent = s_rows.size();
+        }
+    }
+
+    //? Keys are oriented so that "goes first" is always "smaller key", matching `cwd_entries_row_less`: ascending puts
+    //? higher precedence, bigger and newer first for the numeric columns, and A before Z for names.
+    static row_sort_keys s_keys = {};
+    s_keys.clear();
+    s_keys.tiebreak = cwd_entries.ids.data();
+
+    u64 num_rows = cwd_entries.count();
+
+    row_sort_executor executor = {};
+    if (parallel) {
+        auto &thread_pool = global_state::thread_pool();
+        executor.push_task = [&thread_pool](std::function<void ()> task) noexcept { thread_pool.push_task(std::move(task)); };
+        executor.num_threads = thread_pool.get_thread_count();
+    }
+
+    expl.cwd_entries_ranked_by_score = ranking_by_filter_score(expl);
+
+    if (expl.cwd_entries_ranked_by_score) {
+        auto &column = s_keys.add_column(row_sort_column::key_kind::numeric, num_rows);
+        for (u64 i = 0; i < first_filtered_dirent; ++i) {
+            u32 row = s_rows[i];
+            column.numeric_keys[row] = u64(s64(INT32_MAX) - cwd_entries.ui[row].filter_score); // best score first
+        }
+    }
+
+    for (auto const &col_sort_spec : expl.column_sort_specs) {
+        bool ascending = col_sort_spec.SortDirection == ImGuiSortDirection_Ascending;
+        u64 flip = ascending ? u64(-1) : 0; // xor with all ones reverses the order of unsigned keys
+
+        auto add_numeric_column = [&](auto &&key_of_row) noexcept {
+            auto &column = s_keys.add_column(row_sort_column::key_kind::numeric, num_rows);
+            for (u64 i = 0; i < first_filtered_dirent; ++i) {
+                u32 row = s_rows[i];
+                column.numeric_keys[row] = u64(key_of_row(row)) ^ flip;
+            }
+        };
+
+        switch (col_sort_spec.ColumnUserID) {
+            default:
+            case explorer_window::cwd_entries_table_col_id:
+                add_numeric_column([&](u32 row) noexcept { return cwd_entries.ids[row]; });
+                break;
+
+            case explorer_window::cwd_entries_table_col_path: {
+                auto &column = s_keys.add_column(row_sort_column::key_kind::collation, num_rows, !ascending);
+                column.set_collation_keys(s_rows.data(), first_filtered_dirent, [&](u32 row) noexcept {
+                    return std::string_view(cwd_entries.name(row), cwd_entries.name_lengths[row]);
+                }, executor);
+                break;
+            }
+            case explorer_window::cwd_entries_table_col_object:
+            case explorer_window::cwd_entries_table_col_type:
+                add_numeric_column([&](u32 row) noexcept { return g_obj_precedence_table[(u64)cwd_entries.kinds[row]]; });
+                break;
+
+            case explorer_window::cwd_entries_table_col_size_formatted:
+            case explorer_window::cwd_entries_table_col_size_bytes:
+                add_numeric_column([&](u32 row) noexcept { return cwd_entries.sizes[row]; });
+                break;
+
+            case explorer_window::cwd_entries_table_col_creation_time:
+                add_numeric_column([&](u32 row) noexcept { return cwd_entries.creation_times[row]; });
+                break;
+
+            case explorer_window::cwd_entries_table_col_last_write_time:
+                add_numeric_column([&](u32 row) noexcept { return cwd_entries.last_write_times[row]; });
+                break;
+        }
+    }
+
+    sort_rows(s_keys, s_rows.data(), first_filtered_dirent, executor);
+
+    cwd_entries.apply_permutation(s_rows);
+
+    return first_filtered_dirent;
+}
+
+static
+basic_dirent::kind dirent_kind_of_link(link_target_kind target) noexcept
+{
+    switch (target) {
+        case link_target_kind::directory: return basic_dirent::kind::symlink_to_directory;
+        case link_target_kind::file:      return basic_dirent::kind::symlink_to_file;
+        case link_target_kind::invalid:   return basic_dirent::kind::invalid_symlink;
+        default:                          return basic_dirent::kind::symlink_ambiguous;
+    }
+}
+
+/// Body of the thread pool task which lists `parent_dir` for `expl`. Publishes batches into `expl.cwd_listing_task`
+/// for as long as `generation` is the latest listing request, returns early once it has been superseded.
+/// Also called directly on the UI thread for `blocking` updates.
+/// A non-zero `cached_dir_write_time` means the rows on screen came from the listing cache: the task only lists if the
+/// directory was written since, and then publishes everything at once to replace the cached rows without flicker.
+static
+void list_cwd_entries_proc(explorer_window &expl, u64 generation, swan_path parent_dir, time_point_precise_t time_requested, u64 cached_dir_write_time) noexcept
+{
+    auto &task = expl.cwd_listing_task;
+    f64 queue_latency_us = (f64)time_diff_us(time_requested, get_time_precise());
+    f64 filesystem_us = 0;
+    bool revalidating = cached_dir_write_time != 0;
+    u64 dir_last_write_time = 0;
+    std::vector<explorer_window::cwd_listing::batch> held_batches = {}; // when revalidating, published together at the end
+
+    auto superseded = [&]() noexcept { return expl.cwd_listing_generation.load() != generation; };
+
+    auto publish = [&](explorer_window::cwd_listing::batch *batch, bool opened, bool finished, bool unchanged = false) noexcept -> bool {
+        if (revalidating && !finished) {
+            if (superseded()) {
+                return false;
+            }
+            held_batches.push_back(std::move(*batch));
+            return true;
+        }
+
+        std::scoped_lock lock(task.result_mutex);
+
+        if (superseded()) {
+            return false;
+        }
+        auto &listing = task.result;
+        time_point_precise_t now = get_time_precise();
+        for (auto &held : held_batches) {
+            held.time_published = now;
+            listing.batches.push_back(std::move(held));
+        }
+        if (batch != nullptr) {
+            batch->time_published = now;
+            listing.batches.push_back(std::move(*batch));
+        }
+        listing.dir_last_write_time = dir_last_write_time;
+        listing.queue_latency_us = queue_latency_us;
+        listing.filesystem_us = filesystem_us;
+        listing.opened = opened;
+        listing.finished = finished;
+        listing.replace = revalidating && !unchanged;
+        listing.unchanged = unchanged;
+        return true;
+    };
+
+    if (superseded()) {
+        return;
+    }
+
+    //? Queried before listing so that anything written mid listing leaves the cache entry looking stale.
+    {
+        scoped_timer<timer_unit::MICROSECONDS> dir_write_time_timer(&filesystem_us);
+        directory_entry dir_info;
+        if (query_path(parent_dir.data(), dir_info)) {
+            dir_last_write_time = dir_info.last_write_time;
+        }
+    }
+    if (revalidating && dir_last_write_time == cached_dir_write_time) {
+        (void) publish(nullptr, true, true, true);
+        return;
+    }
+
+    bool inside_recycle_bin = cstr_starts_with(parent_dir.data() + 1, ":\\$Recycle.Bin\\"); // assume drive letter is first char
+
+    //? Links are listed as ambiguous unless a previous resolution is still valid, the UI thread hands the rest
+    //? to `resolve_links_async` as their rows are merged so that a folder of shortcuts doesn't hold up the listing.
+    auto classifier = make_link_classifier();
+    auto &link_cache = global_state::link_cache();
+
+    std::string link_path = parent_dir.data(); // parent_dir with trailing separator, the link's name is appended per lookup
+    if (!link_path.empty() && link_path.back() != '\\') {
+        link_path.push_back('\\');
+    }
+    u64 link_path_dir_len = link_path.size();
+
+    auto link_kind = [&](directory_entry const &found, std::string_view name) noexcept -> basic_dirent::kind {
+        link_path.resize(link_path_dir_len);
+        link_path.append(name);
+
+        link_target_kind target;
+        if (link_cache.find(link_path, found.last_write_time, target)) {
+            return dirent_kind_of_link(target);
+        }
+        return basic_dirent::kind::symlink_ambiguous;
+    };
+
+    directory_enumerator enumerator;
+
+    if (!enumerator.open(parent_dir.data(), true)) {
+        print_debug_msg("[ %d ] directory_enumerator::open failed [%s]", expl.id, parent_dir.data());
+        (void) publish(nullptr, false, true);
+        return;
+    }
+
+    //? A small first batch gets something on screen quickly, after that big batches keep the number of merges low.
+    u64 batch_size = 256;
+    u32 entry_id = 0;
+    explorer_window::cwd_listing::batch batch = {};
+
+    while (true) {
+        u64 num_listed;
+        f64 next_batch_us = 0;
+        {
+            scoped_timer<timer_unit::MICROSECONDS> next_batch_timer(&next_batch_us);
+            num_listed = enumerator.next_batch(batch.entries, batch_size);
+        }
+        filesystem_us += next_batch_us;
+        if (num_listed == 0) {
+            break;
+        }
+        batch_size = directory_enumerator::default_batch_size;
+
+        batch.first_id = entry_id;
+        entry_id += (u32)num_listed;
+
+        batch.kinds.reserve(num_listed);
+        for (auto const &found : batch.entries.entries) {
+            std::string_view name_view = batch.entries.name_view(found);
+
+            if (found.kind == directory_entry_kind::directory) {
+                batch.kinds.push_back(basic_dirent::kind::directory);
+            }
+            else if (!inside_recycle_bin && classifier->is_link(name_view, found.kind)) {
+                batch.kinds.push_back(link_kind(found, name_view));
+            }
+            else {
+                batch.kinds.push_back(basic_dirent::kind::file);
+            }
+        }
+
+        if (!publish(&batch, true, false)) {
+            print_debug_msg("[ %d ] listing generation %zu superseded, abandoning [%s]", expl.id, generation, parent_dir.data());
+            return;
+        }
+        batch = {};
+    }
+
+    (void) publish(nullptr, true, true);
+}
+
+/// Body of the thread pool tasks started by `explorer_window::resolve_links_async`, classifies one job's links.
+/// Results are dropped if `expl`'s rows were replaced in the meantime, their ids would refer to other entries by then.
+static
+void resolve_links_proc(explorer_window &expl, u64 generation, swan_path parent_dir, explorer_window::link_job job) noexcept
+{
+    SCOPE_EXIT { expl.num_links_resolving -= job.ids.size(); };
+
+    auto superseded = [&]() noexcept { return expl.link_resolution_generation.load() != generation; };
+
+    auto classifier = make_link_classifier();
+    auto &link_cache = global_state::link_cache();
+
+    std::string link_path = parent_dir.data();
+    if (!link_path.empty() && link_path.back() != '\\') {
+        link_path.push_back('\\');
+    }
+    u64 link_path_dir_len = link_path.size();
+
+    std::vector<explorer_window::resolved_link> resolved = {};
+    resolved.reserve(job.ids.size());
+
+    for (u64 i = 0; i < job.ids.size(); ++i) {
+        if (superseded()) {
+            return;
+        }
+        auto const &link = job.links.entries[i];
+        link_path.resize(link_path_dir_len);
+        link_path.append(job.links.name_view(link));
+
+        link_target_kind target;
+        if (!link_cache.find(link_path, link.last_write_time, target)) {
+            target = classifier->classify(link_path.c_str());
+            link_cache.store(link_path, link.last_write_time, target);
+        }
+        resolved.push_back({ job.ids[i], dirent_kind_of_link(target) });
+    }
+
+    std::scoped_lock lock(expl.resolved_links_mutex);
+    if (!superseded()) {
+        expl.resolved_links.insert(expl.resolved_links.end(), resolved.begin(), resolved.end());
+    }
+}
+
+static
+bool filter_applied_is_current(explorer_window const &expl) noexcept
+{
+    auto const &applied = expl.filter_applied;
+
+    return applied.valid
+        && applied.mode == expl.filter_mode
+        && applied.case_sensitive == expl.filter_case_sensitive
+        && applied.polarity == expl.filter_polarity
+        && applied.show_directories == expl.filter_show_directories
+        && applied.show_files == expl.filter_show_files
+        && applied.text == std::string_view(expl.filter_text.data());
+}
+
+static
+void record_filter_applied(explorer_window &expl) noexcept
+{
+    auto &applied = expl.filter_applied;
+
+    applied.text.assign(expl.filter_text.data());
+    applied.mode = expl.filter_mode;
+    applied.case_sensitive = expl.filter_case_sensitive;
+    applied.polarity = expl.filter_polarity;
+    applied.show_directories = expl.filter_show_directories;
+    applied.show_files = expl.filter_show_files;
+    applied.valid = true;
+}
+
+/// How a filter pass over rows [first_row, end_row) is divided into jobs. Jobs cover whole 64 row words of `packed_bits`
+/// starting at a multiple of 64, so concurrent jobs never write the same word of `filtered`.
+struct filter_job_split
+{
+    u64 first_row;
+    u64 end_row;
+    u64 aligned_first_row;
+    u64 rows_per_job;
+    u64 num_jobs;
+
+    std::pair<u64, u64> rows_of(u64 job) const noexcept
+    {
+        return { std::max(first_row, aligned_first_row + (job * rows_per_job)),
+                 std::min(end_row, aligned_first_row + ((job + 1) * rows_per_job)) };
+    }
+};
+
+/// One job unless there are at least `explorer_parallel_filter_min_entries` rows (0 disables) and the thread pool has
+/// threads to spare, then a few jobs per thread to even out names which take longer to match than others.
+static
+filter_job_split split_filter_rows(u64 first_row, u64 end_row) noexcept
+{
+    u64 num_rows = end_row - std::min(first_row, end_row);
+    filter_job_split split = { first_row, end_row, first_row & ~u64(63), 0, 1 };
+
+    s32 parallel_min_rows = global_state::settings().explorer_parallel_filter_min_entries;
+    u64 num_threads = global_state::thread_pool().get_thread_count();
+
+    if (parallel_min_rows > 0 && num_rows >= u64(parallel_min_rows) && num_threads > 1) {
+        u64 num_aligned_rows = end_row - split.aligned_first_row;
+        u64 num_jobs_wanted = num_threads * 4;
+        split.rows_per_job = (((num_aligned_rows + num_jobs_wanted - 1) / num_jobs_wanted) + 63) & ~u64(63);
+        split.num_jobs = (num_aligned_rows + split.rows_per_job - 1) / split.rows_per_job;
+    }
+    else {
+        split.aligned_first_row = first_row;
+        split.rows_per_job = std::max(num_rows, u64(1));
+    }
+    return split;
+}
+
+/// Runs `job(index, begin row, end row)` for every job of `split`, on the thread pool and the calling thread if there is more than one.
+/// Adds the summed time of all jobs to `timers.filter_work_us` and records how many threads took part in `timers.filter_threads`.
+static
+void run_filter_jobs(filter_job_split const &split, explorer_window::update_cwd_entries_timers &timers,
+                     std::function<void (u64, u64, u64)> const &job) noexcept
+{
+    static std::atomic<u64> s_pass = 0;
+    u64 pass = ++s_pass;
+    std::atomic<u64> work_ns = 0;
+    std::atomic<u32> num_participants = 0;
+
+    auto run_job = [&](u64 index) noexcept {
+        thread_local u64 t_last_pass = 0; // the running thread's own, so each thread is counted once per pass
+        if (t_last_pass != pass) {
+            t_last_pass = pass;
+            ++num_participants;
+        }
+
+        f64 job_us = 0;
+        {
+            scoped_timer<timer_unit::MICROSECONDS> job_timer(&job_us);
+            auto [begin, end] = split.rows_of(index);
+            job(index, begin, end);
+        }
+        work_ns += u64(job_us * 1000);
+    };
+
+    if (split.num_jobs == 1) {
+        run_job(0);
+    } else {
+        auto &thread_pool = global_state::thread_pool();
+        row_sort_executor executor = {};
+        executor.push_task = [&thread_pool](std::function<void ()> task) noexcept { thread_pool.push_task(std::move(task)); };
+        executor.num_threads = thread_pool.get_thread_count();
+        executor.run(split.num_jobs, run_job);
+    }
+
+    timers.filter_work_us += f64(work_ns.load()) / 1000;
+    timers.filter_threads = std::max(timers.filter_threads, num_participants.load());
+}
+
+void explorer_window::filter_cwd_entries(u64 first_row, update_cwd_entries_timers &timers) noexcept
+{
+    f64 filter_us = 0;
+    SCOPE_EXIT { timers.filter_us += filter_us; };
+    scoped_timer<timer_unit::MICROSECONDS> filter_timer(&filter_us);
+
+    if (first_row == 0) {
+        this->filter_error.clear();
+        record_filter_applied(*this);
+    }
+    else if (!filter_applied_is_current(*this)) {
+        this->filter_applied.valid = false; // earlier rows were filtered by another query
+    }
+
+    bool dirent_type_to_visibility_table[(u64)basic_dirent::kind::count] = {
+        /* directory */                  this->filter_show_directories,
+        /* symlink_to_directory */       this->filter_show_directories, // filter_show_symlink_directories
+        /* file */                       this->filter_show_files,
+        /* symlink_to_file */            this->filter_show_files, // filter_show_files
+        /* symlink_ambiguous */          true,
+        /* invalid_symlink */            this->filter_show_files // filter_show_invalid_symlinks
+    };
+
+    bool apply_text_filter = !cstr_empty(this->filter_text.data()) && compile_filter(timers);
+    auto const &compiled = this->filter_compiled;
+
+    auto &cwd_entries = this->cwd_entries;
+
+    auto filter_rows = [&](u64 begin, u64 end) noexcept {
+        for (u64 row = begin; row < end; ++row) {
+            assert((s32)cwd_entries.kinds[row] != -1);
+            bool this_type_of_dirent_is_visible = dirent_type_to_visibility_table[(u64)cwd_entries.kinds[row]];
+
+            bool filtered_out = !this_type_of_dirent_is_visible;
+            auto &ui = cwd_entries.ui[row];
+            ui.highlight.clear();
+            ui.filter_score = 0;
+
+            if (this_type_of_dirent_is_visible && apply_text_filter) { // apply textual filter against dirent name
+                std::string_view dirent_name(cwd_entries.name(row), cwd_entries.name_lengths[row]);
+
+                switch (this->filter_mode) {
+                    default:
+                    case explorer_window::filter_mode::contains: {
+                        u64 match_len = 0;
+                        u64 match_start = compiled.substring.find(dirent_name, &match_len);
+                        filtered_out = this->filter_polarity != (match_start != substring_matcher::not_found);
+
+                        if (!filtered_out && filter_polarity == true) {
+                            // highlight just the substring
+                            ui.highlight.set(match_start, match_len);
+                        }
+
+                        break;
+                    }
+
+                    case explorer_window::filter_mode::regex_match:
+                    case explorer_window::filter_mode::glob: {
+                        filtered_out = this->filter_polarity != compiled.pattern.matches(dirent_name);
+
+                        if (!filtered_out && filter_polarity == true) {
+                            // highlight the whole path since patterns match whole names
+                            ui.highlight.set(0, cwd_entries.name_lengths[row]);
+                        }
+
+                        break;
+                    }
+
+                    case explorer_window::filter_mode::fuzzy: {
+                        bool highlight = filter_polarity == true;
+                        s32 score = compiled.fuzzy.score(dirent_name, highlight ? &ui.highlight : nullptr);
+                        filtered_out = this->filter_polarity != (score != fuzzy_matcher::no_match);
+
+                        if (!filtered_out && filter_polarity == true) {
+                            ui.filter_score = score;
+                        } else {
+                            ui.highlight.clear();
+                        }
+
+                        break;
+                    }
+                }
+            }
+
+            cwd_entries.filtered.set(row, filtered_out);
+        }
+    };
+
+    auto split = split_filter_rows(first_row, cwd_entries.count());
+    run_filter_jobs(split, timers, [&](u64, u64 begin, u64 end) noexcept { filter_rows(begin, end); });
+
+    cwd_entries.invalidate_counts();
+}
+
+bool explorer_window::narrow_cwd_entries_filter(update_cwd_entries_timers &timers) noexcept
+{
+    auto const &applied = this->filter_applied;
+    std::string_view text(this->filter_text.data());
+
+    //? A name containing the new text also contains any part of it, so in contains mode a longer query can only hide rows.
+    //? Rows hidden by type or by the old text stay hidden, only the visible ones need another look.
+    bool refines = applied.valid
+        && applied.mode == filter_mode::contains && this->filter_mode == filter_mode::contains
+        && applied.polarity == true && this->filter_polarity == true
+        && applied.case_sensitive == this->filter_case_sensitive
+        && applied.show_directories == this->filter_show_directories
+        && applied.show_files == this->filter_show_files
+        && !text.empty()
+        && text.find(applied.text) != std::string_view::npos
+        && this->first_filtered_cwd_dirent_row <= this->cwd_entries.count();
+
+    if (!refines) {
+        return false;
+    }
+
+    (void) compile_filter(timers); // can't fail in contains mode
+
+    f64 filter_us = 0;
+    SCOPE_EXIT { timers.filter_us += filter_us; };
+    scoped_timer<timer_unit::MICROSECONDS> filter_timer(&filter_us);
+
+    auto &cwd_entries = this->cwd_entries;
+    auto const &matcher = this->filter_compiled.substring;
+    u64 num_visible_before = this->first_filtered_cwd_dirent_row;
+
+    //? Every job collects its kept and dropped rows in row order, joining them job by job keeps that order.
+    auto split = split_filter_rows(0, num_visible_before);
+
+    static std::vector<std::vector<u32>> s_kept = {}, s_dropped = {};
+    s_kept.resize(std::max(s_kept.size(), split.num_jobs));
+    s_dropped.resize(std::max(s_dropped.size(), split.num_jobs));
+
+    run_filter_jobs(split, timers, [&](u64 job, u64 begin, u64 end) noexcept {
+        auto &kept = s_kept[job];
+        auto &dropped = s_dropped[job];
+        kept.clear();
+        dropped.clear();
+
+        for (u64 row = begin; row < end; ++row) {
+            std::string_view dirent_name(cwd_entries.name(row), cwd_entries.name_lengths[row]);
+            auto &ui = cwd_entries.ui[row];
+
+            u64 match_len = 0;
+            u64 match_start = matcher.find(dirent_name, &match_len);
+
+            if (match_start == substring_matcher::not_found) {
+                ui.highlight.clear();
+                cwd_entries.filtered.set(row, true);
+                dropped.push_back((u32)row);
+            } else {
+                ui.highlight.set(match_start, match_len);
+                kept.push_back((u32)row);
+            }
+        }
+    });
+
+    static std::vector<u32> s_new_to_old = {};
+    s_new_to_old.clear();
+    u64 num_dropped = 0;
+
+    for (u64 job = 0; job < split.num_jobs; ++job) {
+        s_new_to_old.insert(s_new_to_old.end(), s_kept[job].begin(), s_kept[job].end());
+        num_dropped += s_dropped[job].size();
+    }
+    if (num_dropped > 0) {
+        for (u64 job = 0; job < split.num_jobs; ++job) {
+            s_new_to_old.insert(s_new_to_old.end(), s_dropped[job].begin(), s_dropped[job].end());
+        }
+        cwd_entries.permute_prefix(s_new_to_old); // stable for the kept rows, so they stay sorted
+        cwd_entries.invalidate_counts();
+    }
+
+    this->first_filtered_cwd_dirent_row = num_visible_before - num_dropped;
+    record_filter_applied(*this);
+
+    return true;
+}
+
+bool explorer_window::compile_filter(update_cwd_entries_timers &timers) noexcept
+{
+    auto &compiled = this->filter_compiled;
+    std::string_view text(this->filter_text.data());
+
+    bool up_to_date = compiled.mode == this->filter_mode && compiled.case_sensitive == this->filter_case_sensitive && compiled.text == text;
+
+    if (!up_to_date) {
+        scoped_timer<timer_unit::MICROSECONDS> regex_ctor_timer(&timers.regex_ctor_us);
+
+        compiled.text.assign(text);
+        compiled.mode = this->filter_mode;
+        compiled.case_sensitive = this->filter_case_sensitive;
+
+        switch (this->filter_mode) {
+            default:
+            case explorer_window::filter_mode::contains:
+                compiled.substring.compile(text, this->filter_case_sensitive);
+                break;
+            case explorer_window::filter_mode::regex_match:
+                (void) compiled.pattern.compile(text, name_pattern::syntax::regex, this->filter_case_sensitive);
+                break;
+            case explorer_window::filter_mode::glob:
+                (void) compiled.pattern.compile(text, name_pattern::syntax::glob, this->filter_case_sensitive);
+                break;
+            case explorer_window::filter_mode::fuzzy:
+                (void) compiled.fuzzy.compile(text, this->filter_case_sensitive);
+                break;
+        }
+    }
+
+    if (this->filter_mode == explorer_window::filter_mode::contains) {
+        return true;
+    }
+    if (this->filter_mode == explorer_window::filter_mode::fuzzy) {
+        if (!compiled.fuzzy.error.empty()) {
+            this->filter_error = compiled.fuzzy.error;
+            return false;
+        }
+        return true;
+    }
+    if (!compiled.pattern.error.empty()) {
+        this->filter_error = compiled.pattern.error;
+        return false;
+    }
+    return true;
+}
+
+u64 explorer_window::merge_cwd_listing() noexcept
+{
+    if (!this->cwd_listing_pending) {
+        return 0;
+    }
+
+    static std::vector<cwd_listing::batch> s_batches = {};
+    s_batches.clear();
+
+    bool finished, opened, replace, unchanged;
+    u64 dir_last_write_time;
+    f64 queue_latency_us, filesystem_us;
+    {
+        std::scoped_lock lock(this->cwd_listing_task.result_mutex);
+        auto &listing = this->cwd_listing_task.result;
+        assert(listing.generation == this->cwd_listing_generation.load());
+
+        s_batches.swap(listing.batches);
+        finished = listing.finished;
+        opened = listing.opened;
+        replace = std::exchange(listing.replace, false);
+        unchanged = listing.unchanged;
+        dir_last_write_time = listing.dir_last_write_time;
+        queue_latency_us = listing.queue_latency_us;
+        filesystem_us = listing.filesystem_us;
+    }
+
+    if (s_batches.empty() && !finished) {
+        return 0;
+    }
+
+    auto &timers = this->cwd_listing_timers;
+    u64 num_entries_selected = 0;
+    f64 merge_us = 0;
+    {
+        scoped_timer<timer_unit::MICROSECONDS> merge_timer(&merge_us);
+
+        if (replace) {
+            // the directory changed since it was cached, swap the cached rows for the fresh listing
+            this->release_cwd_entries(timers);
+        }
+
+        time_point_precise_t now = get_time_precise();
+        u64 first_new_row = this->cwd_entries.count();
+
+        std::scoped_lock lock(this->select_cwd_entries_on_next_update_mutex); // prevent other threads from adding items mid merge
+
+        auto const &preserve_select = this->cwd_listing_preserve_select;
+        auto const &select_on_update = this->select_cwd_entries_on_next_update;
+        bool any_to_select = !preserve_select.empty() || !select_on_update.empty();
+
+        for (auto const &batch : s_batches) {
+            timers.merge_latency_us = std::max(timers.merge_latency_us, (f64)time_diff_us(batch.time_published, now));
+
+            this->cwd_entries.reserve(this->cwd_entries.count() + batch.entries.entries.size(),
+                                      this->cwd_entries.names.size() + batch.entries.names.size());
+
+            for (u64 i = 0; i < batch.entries.entries.size(); ++i) {
+                auto const &found = batch.entries.entries[i];
+                u32 id = batch.first_id + (u32)i;
+                char const *name = batch.entries.name(found);
+                std::string_view name_view = batch.entries.name_view(found);
+                basic_dirent::kind type = batch.kinds[i];
+
+                if (found.name_len >= sizeof(swan_path)) {
+                    continue;
+                }
+
+                if (name_view == "..") {
+                    if (global_state::settings().explorer_show_dotdot_dir) {
+                        (void) this->cwd_entries.push_back(name_view, type, found.size, found.creation_time, found.last_write_time, id);
+                    }
+                } else {
+                    bool select = false;
+
+                    if (any_to_select) {
+                        f64 search_us = 0;
+                        {
+                            scoped_timer<timer_unit::MICROSECONDS> search_timer(&search_us);
+                            select = preserve_select.contains(name_view) || select_on_update.contains(name_view);
+                        }
+                        num_entries_selected += u64(select);
+                        timers.entries_to_select_search += search_us;
+                    }
+
+                    u64 row = this->cwd_entries.push_back(name_view, type, found.size, found.creation_time, found.last_write_time, id);
+                    this->cwd_entries.selected.set(row, select);
+                }
+
+                ++this->num_file_finds;
+            }
+        }
+
+        if (first_new_row < this->cwd_entries.count()) {
+            this->filter_cwd_entries(first_new_row, timers);
+
+            static std::vector<u32> s_links_to_resolve = {};
+            s_links_to_resolve.clear();
+            for (u64 row = first_new_row; row < this->cwd_entries.count(); ++row) {
+                if (this->cwd_entries.kinds[row] == basic_dirent::kind::symlink_ambiguous) {
+                    s_links_to_resolve.push_back((u32)row);
+                }
+            }
+            if (!s_links_to_resolve.empty()) {
+                this->resolve_links_async(s_links_to_resolve);
+            }
+        }
+
+        if (finished) {
+            if (opened) {
+                this->refresh_message.clear();
+                this->refresh_message_tooltip.clear();
+            } else {
+                this->refresh_message = ICON_CI_ERROR " Listing failed";
+                this->refresh_message_tooltip = "The directory exists but could not be opened for listing.\n"
+                                                "Click to try again.";
+            }
+            this->last_filesystem_query_time = get_time_precise();
+            this->select_cwd_entries_on_next_update.clear();
+            this->cwd_listing_preserve_select.clear();
+            this->cwd_listing_pending = false;
+        }
+    }
+    timers.merge_us += merge_us;
+
+    this->first_filtered_cwd_dirent_row = sort_cwd_entries(*this);
+    this->frame_count_when_cwd_entries_updated = imgui::GetFrameCount();
+
+    if (finished) {
+        this->cwd_entries_dir_write_time = opened ? dir_last_write_time : 0;
+
+        if (!opened) {
+            (void) global_state::listing_cache().erase(this->cwd_entries_path.data());
+        }
+        else if (unchanged) {
+            this->cwd_entries_cached = true;
+        }
+        else if (dir_last_write_time != 0) {
+            f64 store_us = 0;
+            {
+                scoped_timer<timer_unit::MICROSECONDS> store_timer(&store_us);
+                this->cache_cwd_entries(dir_last_write_time);
+            }
+            timers.cache_us += store_us;
+        }
+
+        timers.queue_latency_us = queue_latency_us;
+        timers.filesystem_us = filesystem_us;
+        timers.total_us = timers.searchpath_setup_us + timers.filesystem_us + timers.merge_us + timers.cache_us;
+        this->update_cwd_entries_timing_samples.push_back(timers);
+        print_debug_msg("[ %d ] listing generation %zu merged, %zu entries", this->id, this->cwd_listing_generation.load(), this->cwd_entries.count());
+    }
+
+    s_batches.clear();
+
+    return num_entries_selected;
+}
+
+bool explorer_window::apply_cwd_changes(directory_change_batch const &changes) noexcept
+{
+    if (changes.overflowed || this->cwd_listing_pending) {
+        return false;
+    }
+    //? The changes are relative to what `cwd_entries` lists, a cwd the listing hasn't caught up with needs a full refresh.
+    if (!path_loosely_same(this->cwd_entries_path, this->cwd)) {
+        return false;
+    }
+
+    f64 apply_us = 0;
+    SCOPE_EXIT { this->apply_cwd_changes_timing_samples.push_back(apply_us); };
+    scoped_timer<timer_unit::MICROSECONDS> apply_timer(&apply_us);
+
+    static std::vector<directory_change_net> s_net = {};
+    summarize_directory_changes(changes, s_net);
+
+    if (s_net.empty()) {
+        return true;
+    }
+
+    auto &cwd_entries = this->cwd_entries;
+    u64 num_rows_before = cwd_entries.count();
+
+    bool inside_recycle_bin = cstr_starts_with(this->cwd_entries_path.data() + 1, ":\\$Recycle.Bin\\"); // assume drive letter is first char
+
+    static auto s_classifier = make_link_classifier(); // only asked `is_link` here, classifying is left to the workers
+
+    std::string link_path = this->cwd_entries_path.data();
+    if (!link_path.empty() && link_path.back() != '\\') {
+        link_path.push_back('\\');
+    }
+    u64 link_path_dir_len = link_path.size();
+
+    static std::vector<dirent_table::change> s_changes = {};
+    s_changes.clear();
+
+    for (auto const &net : s_net) {
+        std::string_view name = net.name;
+
+        if (name == ".." || name.size() >= sizeof(swan_path)) {
+            continue;
+        }
+
+        directory_entry found = {};
+        dirent_table::change change = {};
+        change.name = name;
+        change.renamed_from = net.renamed_from;
+        change.exists = net.exists && query_directory_entry(this->cwd_entries_path.data(), name, found);
+
+        if (change.exists) {
+            change.size = found.size;
+            change.creation_time = found.creation_time;
+            change.last_write_time = found.last_write_time;
+
+            if (found.kind == directory_entry_kind::directory) {
+                change.kind = basic_dirent::kind::directory;
+            }
+            else if (!inside_recycle_bin && s_classifier->is_link(name, found.kind)) {
+                link_path.resize(link_path_dir_len);
+                link_path.append(name);
+
+                link_target_kind target;
+                if (global_state::link_cache().find(link_path, found.last_write_time, target)) {
+                    change.kind = dirent_kind_of_link(target);
+                } else {
+                    change.kind = basic_dirent::kind::symlink_ambiguous;
+                    change.unresolved_link = true;
+                }
+            }
+
+            std::scoped_lock lock(this->select_cwd_entries_on_next_update_mutex);
+            change.select = this->select_cwd_entries_on_next_update.erase(name) != 0;
+        }
+
+        s_changes.push_back(change);
+        ++this->num_changes_applied;
+    }
+
+    //? Everything up to the read of these notifications is applied below. Anything since is either newer than this stamp,
+    //? or waiting in the re-armed watch's buffer, which keeps the rows out of the cache until applied.
+    directory_entry dir_info;
+    this->cwd_entries_dir_write_time = query_path(this->cwd_entries_path.data(), dir_info) ? dir_info.last_write_time : 0;
+
+    update_cwd_entries_timers timers = {};
+    this->first_filtered_cwd_dirent_row = cwd_entries.apply_changes(s_changes,
+        [&](u64 first_row) noexcept { this->filter_cwd_entries(first_row, timers); },
+        [&](u32 left, u32 right) noexcept { return cwd_entries_row_less(*this, left, right); });
+
+    static std::vector<u32> s_links_to_resolve = {};
+    s_links_to_resolve.clear();
+    for (auto const &change : s_changes) {
+        if (change.unresolved_link && change.row != u64(-1)) {
+            s_links_to_resolve.push_back((u32)change.row);
+        }
+    }
+    if (!s_links_to_resolve.empty()) {
+        this->resolve_links_async(s_links_to_resolve);
+    }
+
+    this->frame_count_when_cwd_entries_updated = imgui::GetFrameCount();
+    this->cwd_entries_cached = false;
+
+    print_debug_msg("[ %d ] applied %zu changes (%zu names), %zu -> %zu entries", this->id, changes.changes.size(), s_net.size(), num_rows_before, cwd_entries.count());
+
+    return true;
+}
+
+void explorer_window::release_cwd_entries(update_cwd_entries_timers &timers) noexcept
+{
+    {
+        f64 preserve_select_build_us = 0;
+        {
+            scoped_timer<timer_unit::MICROSECONDS> preserve_select_timer(&preserve_select_build_us);
+
+            auto &preserve_select = this->cwd_listing_preserve_select;
+            preserve_select.reserve(preserve_select.size() + this->cwd_entries.selected.count_set());
+
+            for (auto dirent : this->cwd_entries) {
+                if (dirent.selected()) {
+                    // this could throw on alloc failure, which will call std::terminate
+                    preserve_select.insert(std::string_view(dirent.name(), dirent.name_len()));
+                }
+            }
+        }
+        timers.preserve_select_build_us += preserve_select_build_us;
+    }
+
+    //? Icon handles are released with their rows, the cache frees textures after the frame that may still draw them.
+    this->cwd_entries.clear();
+
+    // ids are about to mean other entries, results of resolutions still in flight must not be patched in
+    ++this->link_resolution_generation;
+    this->context_menu_target_id = UINT32_MAX;
+    {
+        std::scoped_lock lock(this->resolved_links_mutex);
+        this->resolved_links.clear();
+    }
+}
+
+void explorer_window::resolve_links_async(std::vector<u32> const &rows) noexcept
+{
+    //? Small jobs spread a folder full of shortcuts over the whole pool, and a slow (e.g. network) target only holds up its own job.
+    u64 const links_per_job = 32;
+    u64 generation = this->link_resolution_generation.load();
+    auto const &cwd_entries = this->cwd_entries;
+
+    for (u64 first = 0; first < rows.size(); first += links_per_job) {
+        u64 last = std::min(first + links_per_job, rows.size());
+        link_job job = {};
+        job.ids.reserve(last - first);
+        job.links.entries.reserve(last - first);
+
+        for (u64 i = first; i < last; ++i) {
+            u32 row = rows[i];
+            char const *name = cwd_entries.name(row);
+
+            directory_entry link = {};
+            link.last_write_time = cwd_entries.last_write_times[row];
+            link.name_offset = (u32)job.links.names.size();
+            link.name_len = cwd_entries.name_lengths[row];
+
+            job.links.names.insert(job.links.names.end(), name, name + link.name_len + 1);
+            job.links.entries.push_back(link);
+            job.ids.push_back(cwd_entries.ids[row]);
+        }
+
+        this->num_links_resolving += job.ids.size();
+        global_state::thread_pool().push_task(resolve_links_proc, std::ref(*this), generation, this->cwd_entries_path, std::move(job));
+    }
+}
+
+bool explorer_window::merge_resolved_links() noexcept
+{
+    if (this->cwd_listing_pending) {
+        return false; // rows are still arriving, wait so every result finds its row
+    }
+
+    static std::vector<resolved_link> s_resolved = {};
+    s_resolved.clear();
+    {
+        std::scoped_lock lock(this->resolved_links_mutex);
+        s_resolved.swap(this->resolved_links);
+    }
+    if (s_resolved.empty()) {
+        return false;
+    }
+
+    std::sort(s_resolved.begin(), s_resolved.end(), [](resolved_link const &left, resolved_link const &right) noexcept { return left.id < right.id; });
 
-    print_debug_msg("[ %d ] sort_cwd_entries() called from [%s:%d]", expl.id, path_cfind_filename(sloc.file_name()), sloc.line());
+    auto &cwd_entries = this->cwd_entries;
+    u64 num_patched = 0;
 
-    using dir_ent_t = explorer_window::dirent;
+    for (u64 row = 0; row < cwd_entries.count(); ++row) {
+        if (!basic_dirent::is_symlink(cwd_entries.kinds[row])) {
+            continue;
+        }
+        auto iter = std::lower_bound(s_resolved.begin(), s_resolved.end(), cwd_entries.ids[row],
+                                     [](resolved_link const &resolved, u32 id) noexcept { return resolved.id < id; });
 
-    auto first_filtered_dirent = std::partition(cwd_entries.begin(), cwd_entries.end(), [](dir_ent_t const &dirent) noexcept {
-        return !dirent.filtered;
-    });
+        if (iter != s_resolved.end() && iter->id == cwd_entries.ids[row] && cwd_entries.kinds[row] != iter->kind) {
+            cwd_entries.kinds[row] = iter->kind;
+            ++num_patched;
+        }
+    }
 
-    s32 obj_precedence_table[(u64)basic_dirent::kind::count] = {
-        10, // directory
-        10, // symlink_to_directory
-        5,  // file
-        5,  // symlink_to_file
-        5,  // symlink_ambiguous
-        5,  // invalid_symlink
-    };
+    if (num_patched > 0) {
+        // the new kinds may change visibility (show directories/files) and sort position (by type)
+        update_cwd_entries_timers timers = {};
+        this->filter_cwd_entries(0, timers);
+        this->first_filtered_cwd_dirent_row = sort_cwd_entries(*this);
+        this->frame_count_when_cwd_entries_updated = imgui::GetFrameCount();
+        this->cwd_entries_cached = false;
+    }
+    this->num_links_resolved += s_resolved.size();
 
-    std::sort(cwd_entries.begin(), first_filtered_dirent, [&](dir_ent_t const &left, dir_ent_t const &right) noexcept -> bool {
-        s64 delta = 0;
+    return num_patched > 0;
+}
 
-        for (auto const &col_sort_spec : expl.column_sort_specs) {
-            switch (col_sort_spec.ColumnUserID) {
-                default:
-                case explorer_window::cwd_entries_table_col_id: {
-                    delta = left.basic.id - right.basic.id;
-                    break;
-                }
-                case explorer_window::cwd_entries_table_col_path: {
-                    delta = lstrcmpiA(right.basic.path.data(), left.basic.path.data());
-                    break;
-                }
-                case explorer_window::cwd_entries_table_col_object:
-                case explorer_window::cwd_entries_table_col_type: {
-                    assert((s32)right.basic.type >= 0);
-                    delta = obj_precedence_table[(u64)left.basic.type] - obj_precedence_table[(u64)right.basic.type];
-                    break;
-                }
-                // case explorer_window::cwd_entries_table_col_type: {
-                //     if (left.basic.type != right.basic.type) {
-                //         assert((s32)right.basic.type >= 0);
-                //         delta = obj_precedence_table[(u64)left.basic.type] - obj_precedence_table[(u64)right.basic.type];
-                //     } else {
-                //         delta = lstrcmpiA(path_cfind_file_ext(right.basic.path.data()), path_cfind_file_ext(left.basic.path.data()));
-                //     }
-                //     break;
-                // }
-                case explorer_window::cwd_entries_table_col_size_formatted:
-                case explorer_window::cwd_entries_table_col_size_bytes: {
-                    delta = left.basic.size - right.basic.size;
-                    break;
-                }
-                case explorer_window::cwd_entries_table_col_creation_time: {
-                    delta = CompareFileTime(&left.basic.creation_time_raw, &right.basic.creation_time_raw);
-                    break;
-                }
-                case explorer_window::cwd_entries_table_col_last_write_time: {
-                    delta = CompareFileTime(&left.basic.last_write_time_raw, &right.basic.last_write_time_raw);
-                    break;
-                }
-            }
+void explorer_window::cache_cwd_entries(u64 dir_last_write_time) noexcept
+{
+    auto const &cwd_entries = this->cwd_entries;
+
+    //? Stored in listing order so the id column means the same thing when the rows come back.
+    static std::vector<u32> s_rows_by_id = {};
+    s_rows_by_id.resize(cwd_entries.count());
+    std::iota(s_rows_by_id.begin(), s_rows_by_id.end(), 0);
+    std::sort(s_rows_by_id.begin(), s_rows_by_id.end(), [&](u32 left, u32 right) noexcept { return cwd_entries.ids[left] < cwd_entries.ids[right]; });
+
+    u64 num_name_bytes = 0;
+    for (u64 row = 0; row < cwd_entries.count(); ++row) {
+        num_name_bytes += cwd_entries.name_lengths[row] + 1;
+    }
+
+    cwd_listing::batch snapshot = {};
+    snapshot.entries.entries.reserve(cwd_entries.count());
+    snapshot.entries.names.reserve(num_name_bytes);
+    snapshot.kinds.reserve(cwd_entries.count());
+
+    for (u32 row : s_rows_by_id) {
+        directory_entry entry;
+        entry.size = cwd_entries.sizes[row];
+        entry.creation_time = cwd_entries.creation_times[row];
+        entry.last_write_time = cwd_entries.last_write_times[row];
+        entry.name_offset = (u32)snapshot.entries.names.size();
+        entry.name_len = cwd_entries.name_lengths[row];
+        entry.kind = cwd_entries.kinds[row] == basic_dirent::kind::directory ? directory_entry_kind::directory : directory_entry_kind::file;
+        entry.link = false;
+
+        char const *name = cwd_entries.name(row);
+        snapshot.entries.names.insert(snapshot.entries.names.end(), name, name + entry.name_len + 1);
+        snapshot.entries.entries.push_back(entry);
+        snapshot.kinds.push_back(cwd_entries.kinds[row]);
+    }
+
+    global_state::listing_cache().store(this->cwd_entries_path.data(), dir_last_write_time, std::move(snapshot));
+    this->cwd_entries_cached = true;
+}
 
-            if (delta > 0) {
-                return col_sort_spec.SortDirection == ImGuiSortDirection_Ascending;
-            }
-            else if (delta < 0) {
-                return col_sort_spec.SortDirection != ImGuiSortDirection_Ascending;
-            }
-            else { // delta == 0
-                continue; // go to next sort spec
-            }
-        }
+void explorer_window::cache_cwd_entries_before_leaving() noexcept
+{
+    //? Leaving a fully listed directory whose rows were changed in place (or never stored), remember them for coming back.
+    if (this->cwd_listing_pending || this->cwd_entries_cached || this->cwd_entries_path[0] == '\0' || this->cwd_entries_dir_write_time == 0) {
+        return;
+    }
+    //? A change which couldn't be applied, or is still in the notification buffer, is already covered by the directory's last
+    //? write time but not by the rows. Coming back would find the write time unchanged and keep showing stale rows.
+    if (this->read_dir_changes_refresh_request_time != time_point_precise_t()) {
+        return;
+    }
+    if (this->read_dir_changes_handle != INVALID_HANDLE_VALUE
+        && path_loosely_same(this->read_dir_changes_target, this->cwd_entries_path)
+        && HasOverlappedIoCompleted(&this->read_dir_changes_overlapped))
+    {
+        return;
+    }
+    this->cache_cwd_entries(this->cwd_entries_dir_write_time);
+}
 
-        if (delta == 0) {
-            return left.basic.id < right.basic.id;
+/// True if exactly the rows before `expl.first_filtered_cwd_dirent_row` are unfiltered, which are then still in sorted order.
+static
+bool visible_rows_unchanged(explorer_window const &expl) noexcept
+{
+    auto const &cwd_entries = expl.cwd_entries;
+    u64 boundary = expl.first_filtered_cwd_dirent_row;
+
+    if (boundary > cwd_entries.count()) {
+        return false;
+    }
+    for (u64 row = 0; row < boundary; ++row) {
+        if (cwd_entries.filtered.get(row)) {
+            return false;
         }
-        else {
-            return delta;
+    }
+    for (u64 row = boundary; row < cwd_entries.count(); ++row) {
+        if (!cwd_entries.filtered.get(row)) {
+            return false;
         }
-    });
-
-    return first_filtered_dirent;
+    }
+    return true;
 }
 
 explorer_window::update_cwd_entries_result explorer_window::update_cwd_entries(
@@ -875,41 +2545,52 @@ explorer_window::update_cwd_entries_result explorer_window::update_cwd_entries(
     this->tabbing_focus_idx = -1;
 
     update_cwd_entries_timers timers = {};
-    SCOPE_EXIT { this->update_cwd_entries_timing_samples.push_back(timers); };
-
-    char dir_sep_utf8 = global_state::settings().dir_separator_utf8;
+    bool listing_requested = false;
+    SCOPE_EXIT { if (!listing_requested) this->update_cwd_entries_timing_samples.push_back(timers); }; // a listing pushes its own sample once merged
 
     {
         scoped_timer<timer_unit::MICROSECONDS> function_timer(&timers.total_us);
 
         if (actions & query_filesystem) {
-            static std::vector<swan_path> s_preserve_select = {};
-            s_preserve_select.clear();
+            bool navigating = directory_listing_cache::normalize_key(parent_dir) != directory_listing_cache::normalize_key(this->cwd_entries_path.data());
 
-            for (auto const &dirent : this->cwd_entries) {
-                if (dirent.selected) {
-                    // this could throw on alloc failure, which will call std::terminate
-                    s_preserve_select.push_back(dirent.basic.path);
+            if (navigating) {
+                f64 store_us = 0;
+                {
+                    scoped_timer<timer_unit::MICROSECONDS> store_timer(&store_us);
+                    this->cache_cwd_entries_before_leaving();
                 }
+                timers.cache_us += store_us;
             }
-            // std::sort(s_preserve_select.begin(), s_preserve_select.end());
 
-            for (auto &e : this->cwd_entries) {
-                if (e.icon_GLtexID > 0) {
-                    // if we delete the icon texture immediately, ImGui will render a black square for the image
-                    // because the frame is drawn much later.
-                    // !delete_icon_texture(e.icon_GLtexID, "explorer_window::dirent");
+            //? If a previous listing is still being merged, its leftover names stay in the list since they weren't seen yet.
+            if (!this->cwd_listing_pending) {
+                this->cwd_listing_preserve_select.clear();
+            }
+            this->release_cwd_entries(timers);
+            this->cwd_entries_path = {};
+            this->cwd_entries_cached = false;
 
-                    // Instead, delete the texture after the frame (that we are currently rendering) is actually drawn by the GPU.
-                    global_state::delete_icon_textures_queue().push_back(e.icon_GLtexID);
-                }
+            // supersede any listing in flight, its task stops publishing as soon as it notices
+            u64 generation;
+            {
+                std::scoped_lock lock(this->cwd_listing_task.result_mutex);
+                generation = ++this->cwd_listing_generation;
+                auto &listing = this->cwd_listing_task.result;
+                listing.batches.clear();
+                listing.generation = generation;
+                listing.dir_last_write_time = 0;
+                listing.queue_latency_us = 0;
+                listing.filesystem_us = 0;
+                listing.opened = false;
+                listing.finished = false;
+                listing.replace = false;
+                listing.unchanged = false;
             }
-            this->cwd_entries.clear();
+            this->cwd_listing_pending = false;
 
             if (parent_dir != "") {
-                bool inside_recycle_bin;
-
-                wchar_t search_path_utf16[512]; cstr_clear(search_path_utf16);
+                swan_path parent_dir_trimmed = {};
                 {
                     scoped_timer<timer_unit::MICROSECONDS> searchpath_setup_timer(&timers.searchpath_setup_us);
 
@@ -917,242 +2598,78 @@ explorer_window::update_cwd_entries_result explorer_window::update_cwd_entries(
                     while (*(&parent_dir.back() - num_trailing_spaces) == ' ') {
                         ++num_trailing_spaces;
                     }
-                    swan_path parent_dir_trimmed = {};
                     strncpy(parent_dir_trimmed.data(), parent_dir.data(), parent_dir.size() - num_trailing_spaces);
                     path_force_separator(parent_dir_trimmed, '\\');
-
-                    (void) utf8_to_utf16(parent_dir_trimmed.data(), search_path_utf16, lengthof(search_path_utf16));
-
-                    wchar_t dir_sep_w[] = { (wchar_t)dir_sep_utf8, L'\0' };
-
-                    if (!parent_dir.ends_with(dir_sep_utf8)) {
-                        (void) StrCatW(search_path_utf16, dir_sep_w);
-                    }
-                    (void) StrCatW(search_path_utf16, L"*");
-
-                    inside_recycle_bin = cstr_starts_with(parent_dir_trimmed.data() + 1, ":\\$Recycle.Bin\\"); // assume drive letter is first char
-                }
-
-                // just for debug log
-                {
-                    char utf8_buffer[2048]; cstr_clear(utf8_buffer);
-
-                    if (!utf16_to_utf8(search_path_utf16, utf8_buffer, lengthof(utf8_buffer))) {
-                        return retval;
-                    }
-
-                    print_debug_msg("[ %d ] querying filesystem, search_path = [%s]", this->id, utf8_buffer);
-                }
-
-                std::scoped_lock lock(select_cwd_entries_on_next_update_mutex); // lock for rest of this function to prevent other threads from adding items and breaking order
-                {
-                    scoped_timer<timer_unit::MICROSECONDS> sort_timer(&timers.entries_to_select_sort);
-                    std::sort(select_cwd_entries_on_next_update.begin(), select_cwd_entries_on_next_update.end(), std::less<swan_path>());
                 }
 
-                scoped_timer<timer_unit::MICROSECONDS> filesystem_timer(&timers.filesystem_us);
-
-                WIN32_FIND_DATAW find_data;
-                HANDLE find_handle = FindFirstFileW(search_path_utf16, &find_data);
-                SCOPE_EXIT { FindClose(find_handle); };
-
-                if (find_handle == INVALID_HANDLE_VALUE) {
-                    print_debug_msg("[ %d ] find_handle == INVALID_HANDLE_VALUE", this->id);
+                //? Existence is answered here so callers can decide about history and cwd right away,
+                //? opening and reading the directory is left to the listing task.
+                if (!directory_exists(parent_dir_trimmed.data())) {
+                    print_debug_msg("[ %d ] directory_exists false, parent_dir = [%s]", this->id, parent_dir_trimmed.data());
                     return retval;
                 }
                 retval.parent_dir_exists = true;
 
-                u32 entry_id = 0;
-
-                do {
-                    explorer_window::dirent entry = {};
-                    entry.basic.id = entry_id;
-                    entry.basic.size = two_u32_to_one_u64(find_data.nFileSizeLow, find_data.nFileSizeHigh);
-                    entry.basic.creation_time_raw = find_data.ftCreationTime;
-                    entry.basic.last_write_time_raw = find_data.ftLastWriteTime;
-
-                    if (!utf16_to_utf8(find_data.cFileName, entry.basic.path.data(), entry.basic.path.size())) {
-                        continue;
-                    }
-
-                    if (path_equals_exactly(entry.basic.path, ".")) {
-                        continue;
-                    }
-
-                    if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
-                        entry.basic.type = basic_dirent::kind::directory;
-                    }
-                    else if (!inside_recycle_bin && path_ends_with(entry.basic.path, ".lnk")) {
-                        // TODO: this branch is quite slow, there should probably be an option to opt out of checking the type and validity of symlinks
-
-                        entry.basic.type = basic_dirent::kind::invalid_symlink; // default value, if something fails below
+                print_debug_msg("[ %d ] listing generation %zu, parent_dir = [%s]", this->id, generation, parent_dir_trimmed.data());
 
-                        static std::wstring full_path_utf16 = {};
-                        full_path_utf16.clear();
-                        full_path_utf16.append(search_path_utf16);
-                        full_path_utf16.pop_back(); // remove '*'
-                        full_path_utf16.append(find_data.cFileName);
+                this->cwd_entries_path = parent_dir_trimmed;
 
-                        // Load the shortcut
-                        HRESULT com_handle = g_persist_file_interface->Load(full_path_utf16.c_str(), STGM_READ);
-                        if (FAILED(com_handle)) {
-                            WCOUT_IF_DEBUG("FAILED IPersistFile::Load [" << full_path_utf16.c_str() << "]\n");
-                        }
-                        else {
-                            // Get the target path
-                            wchar_t target_path_utf16[MAX_PATH];
-                            com_handle = g_shell_link->GetPath(target_path_utf16, lengthof(target_path_utf16), NULL, SLGP_RAWPATH);
-                            if (FAILED(com_handle)) {
-                                WCOUT_IF_DEBUG("FAILED IShellLinkW::GetPath [" << full_path_utf16.c_str() << "]\n");
-                            }
-                            else {
-                                if      (PathIsDirectoryW(target_path_utf16)) entry.basic.type = basic_dirent::kind::symlink_to_directory;
-                                else if (PathFileExistsW(target_path_utf16))  entry.basic.type = basic_dirent::kind::symlink_to_file;
-                                else                                          entry.basic.type = basic_dirent::kind::invalid_symlink;
-                            }
+                //? Refreshing the same directory always lists it, the cache is only for coming back to a directory.
+                u64 cached_dir_write_time = 0;
+                if (navigating) {
+                    f64 lookup_us = 0;
+                    {
+                        scoped_timer<timer_unit::MICROSECONDS> lookup_timer(&lookup_us);
+
+                        auto const *cached = global_state::listing_cache().find(parent_dir_trimmed.data());
+                        if (cached != nullptr) {
+                            cached_dir_write_time = cached->dir_last_write_time;
+                            std::scoped_lock lock(this->cwd_listing_task.result_mutex);
+                            this->cwd_listing_task.result.batches.push_back(cached->listing); // copy, the cache keeps its own
+                            this->cwd_listing_task.result.batches.back().time_published = get_time_precise();
                         }
                     }
-                    else {
-                        entry.basic.type = basic_dirent::kind::file;
-                    }
-
-                    if (entry.basic.is_path_dotdot()) {
-                        if (global_state::settings().explorer_show_dotdot_dir) {
-                            this->cwd_entries.emplace_back(entry);
-                            std::swap(this->cwd_entries.back(), this->cwd_entries.front());
-                        }
-                    } else {
-                        // if (!s_preserve_select.empty()) {
-                        //     auto [first_iter, last_iter] = std::equal_range(s_preserve_select.begin(), s_preserve_select.end(), entry.basic.path);
-                        //     if (bool found = std::distance(first_iter, last_iter) == 1) {
-                        //         entry.selected = true;
-                        //         retval.num_entries_selected += 1;
-                        //         std::swap(*first_iter, s_preserve_select.back());
-                        //         s_preserve_select.pop_back();
-                        //     }
-                        // }
-                        //? Don't bother trying to make this more efficient, instead work on issue #3 which will eliminate this code
-                        for (auto prev_selected_entry = s_preserve_select.begin(); prev_selected_entry != s_preserve_select.end(); ++prev_selected_entry) {
-                            bool was_selected_before_refresh = path_equals_exactly(entry.basic.path, *prev_selected_entry);
-                            if (was_selected_before_refresh) {
-                                entry.selected = true;
-                                retval.num_entries_selected += 1;
-                                std::swap(*prev_selected_entry, s_preserve_select.back());
-                                s_preserve_select.pop_back();
-                                break;
-                            }
-                        }
-                        {
-                            f64 search_us = 0;
-                            scoped_timer<timer_unit::MICROSECONDS> search_timer(&search_us);
-
-                            if (!this->select_cwd_entries_on_next_update.empty()) {
-                                auto [first_iter, last_iter] = std::equal_range(this->select_cwd_entries_on_next_update.begin(),
-                                                                                this->select_cwd_entries_on_next_update.end(), entry.basic.path);
-                                if (bool found = std::distance(first_iter, last_iter) == 1) {
-                                    entry.selected = true;
-                                    retval.num_entries_selected += 1;
-                                }
-                            }
-                            timers.entries_to_select_search += search_us;
-                        }
+                    timers.cache_us += lookup_us;
+                    timers.cache_hit = cached_dir_write_time != 0;
+                }
 
-                        // this could throw on alloc failure, which will call std::terminate
-                        this->cwd_entries.emplace_back(entry);
-                    }
+                listing_requested = true;
+                this->cwd_listing_pending = true;
+                this->cwd_listing_timers = timers;
 
-                    ++this->num_file_finds;
-                    ++entry_id;
+                if (cached_dir_write_time != 0) {
+                    retval.num_entries_selected += this->merge_cwd_listing(); // show the cached rows this frame
                 }
-                while (FindNextFileW(find_handle, &find_data));
 
-                this->refresh_message.clear();
-                this->refresh_message_tooltip.clear();
-                this->last_filesystem_query_time = get_time_precise();
-                {
-                    // std::scoped_lock lock(select_cwd_entries_on_next_update_mutex);
-                    this->select_cwd_entries_on_next_update.clear();
+                if (actions & blocking) {
+                    list_cwd_entries_proc(*this, generation, parent_dir_trimmed, get_time_precise(), cached_dir_write_time);
+                    retval.num_entries_selected += this->merge_cwd_listing();
+                    assert(!this->cwd_listing_pending);
+                } else {
+                    global_state::thread_pool().push_task(list_cwd_entries_proc, std::ref(*this), generation, parent_dir_trimmed, get_time_precise(), cached_dir_write_time);
                 }
             }
         }
 
         if (actions & filter) {
-            scoped_timer<timer_unit::MICROSECONDS> filter_timer(&timers.filter_us);
-
-            this->filter_error.clear();
-
-            bool dirent_type_to_visibility_table[(u64)basic_dirent::kind::count] = {
-                /* directory */                  this->filter_show_directories,
-                /* symlink_to_directory */       this->filter_show_directories, // filter_show_symlink_directories
-                /* file */                       this->filter_show_files,
-                /* symlink_to_file */            this->filter_show_files, // filter_show_files
-                /* symlink_ambiguous */          true,
-                /* invalid_symlink */            this->filter_show_files // filter_show_invalid_symlinks
-            };
-
-            u64 filter_text_len = strlen(this->filter_text.data());
-
-            static std::regex s_filter_regex;
-            if (this->filter_mode == explorer_window::filter_mode::regex_match) {
-                try {
-                    scoped_timer<timer_unit::MICROSECONDS> regex_ctor_timer(&timers.regex_ctor_us);
-                    s_filter_regex = this->filter_text.data();
-                }
-                catch (std::exception const &except) {
-                    this->filter_error = except.what();
-                }
-            }
-
-            for (auto &dirent : this->cwd_entries) {
-                assert((s32)dirent.basic.type != -1);
-                bool this_type_of_dirent_is_visible = dirent_type_to_visibility_table[(u64)dirent.basic.type];
-
-                dirent.filtered = !this_type_of_dirent_is_visible;
-                dirent.highlight_start_idx = 0;
-                dirent.highlight_len = 0;
-
-                if (this_type_of_dirent_is_visible && filter_text_len > 0) { // apply textual filter against dirent name
-                    char const *dirent_name = dirent.basic.path.data();
-
-                    switch (this->filter_mode) {
-                        default:
-                        case explorer_window::filter_mode::contains: {
-                            auto matcher = this->filter_case_sensitive ? StrStrA : StrStrIA;
-
-                            char const *match_start = matcher(dirent_name, this->filter_text.data());;
-                            bool filtered_out = this->filter_polarity != (bool)match_start;
-                            dirent.filtered = filtered_out;
-
-                            if (!filtered_out && filter_polarity == true) {
-                                // highlight just the substring
-                                dirent.highlight_start_idx = std::distance(dirent_name, match_start);
-                                dirent.highlight_len = filter_text_len;
-                            }
-
-                            break;
-                        }
-
-                        case explorer_window::filter_mode::regex_match: {
-                            auto match_flags = std::regex_constants::match_default | (std::regex_constants::icase * (this->filter_case_sensitive == 0));
-
-                            bool filtered_out = this->filter_polarity != std::regex_match(dirent_name, s_filter_regex, (std::regex_constants::match_flag_type)match_flags);
-                            dirent.filtered = filtered_out;
-
-                            if (!filtered_out && filter_polarity == true) {
-                                // highlight the whole path since we are using std::regex_match
-                                dirent.highlight_start_idx = 0;
-                                dirent.highlight_len = path_length(dirent.basic.path);
-                            }
-
-                            break;
-                        }
-                    }
-                }
+            //? Only the filter query changed: rows [0, first_filtered_cwd_dirent_row) are visible in sorted order and the rest
+            //? are hidden, a refined query narrows that prefix in place and nothing needs sorting.
+            if (!(actions & query_filesystem) && this->narrow_cwd_entries_filter(timers)) {
+                this->frame_count_when_cwd_entries_updated = imgui::GetFrameCount();
+                return retval;
             }
+            this->filter_cwd_entries(0, timers);
         }
     }
 
-    (void) sort_cwd_entries(*this);
+    //? Same idea when a widened or toggled query leaves the same rows visible, e.g. backspacing over text that matches nothing new.
+    //? Not when ranking by fuzzy score (now or in the last sort), the order itself depends on the query then.
+    if (actions == filter && !ranking_by_filter_score(*this) && !this->cwd_entries_ranked_by_score && visible_rows_unchanged(*this)) {
+        this->frame_count_when_cwd_entries_updated = imgui::GetFrameCount();
+        return retval;
+    }
+
+    this->first_filtered_cwd_dirent_row = sort_cwd_entries(*this);
 
     this->frame_count_when_cwd_entries_updated = imgui::GetFrameCount();
 
@@ -1184,6 +2701,7 @@ bool explorer_window::save_to_disk() const noexcept
             out << "filter_mode "                       << (s32)filter_mode << '\n';
             out << "filter_case_sensitive "             << (s32)filter_case_sensitive << '\n';
             out << "filter_polarity "                   << (s32)filter_polarity << '\n';
+            out << "filter_sort_by_score "              << (s32)filter_sort_by_score << '\n';
             out << "filter_show_directories "           << (s32)filter_show_directories << '\n';
             out << "filter_show_symlink_directories "   << (s32)filter_show_symlink_directories << '\n';
             out << "filter_show_files "                 << (s32)filter_show_files << '\n';
@@ -1379,6 +2897,9 @@ bool explorer_window::load_from_disk(char dir_separator) noexcept
             else if (remainder == "polarity") {
                 this->filter_polarity = extract_bool();
             }
+            else if (remainder == "sort_by_score") {
+                this->filter_sort_by_score = extract_bool();
+            }
             else if (remainder == "show_directories") {
                 this->filter_show_directories = extract_bool();
             }
@@ -1674,37 +3195,60 @@ bool swan_windows::render_explorer_debug(explorer_window &expl, bool &open, bool
 
     expl.tree_node_open_debug_memory = imgui::TreeNode("Memory");
     if (expl.tree_node_open_debug_memory) {
-        std::array<char, 32> cwd_entries_occupied, cwd_entries_capacity, swan_path_occupied, swan_path_wasted;
-        f64 swan_path_waste_percent;
+        std::array<char, 32> cwd_entries_occupied, cwd_entries_capacity, legacy_occupied, bytes_saved, names_occupied, swan_path_equivalent;
+        f64 savings_percent;
         {
-            u64 elem_size = sizeof(explorer_window::dirent);
-            u64 num_elems = expl.cwd_entries.size();
-            u64 elem_capacity = expl.cwd_entries.capacity();
+            u64 bytes_occupied = expl.cwd_entries.bytes_occupied();
+            u64 bytes_reserved = expl.cwd_entries.bytes_reserved();
+
+            //? What the same rows cost as an array of { basic_dirent, ui state, 3 bools } before the columnar layout.
+            u64 legacy_elem_size = sizeof(basic_dirent) + sizeof(explorer_window::dirent_ui_state) + (sizeof(bool) * 3);
+            u64 legacy_bytes_occupied = expl.cwd_entries.count() * legacy_elem_size;
 
-            u64 bytes_occupied = num_elems * elem_size;
-            u64 bytes_reserved = elem_capacity * elem_size;
+            f64 usage_ratio = ( f64(bytes_occupied) + (legacy_bytes_occupied == 0) ) / ( f64(legacy_bytes_occupied) + (legacy_bytes_occupied == 0) );
+            savings_percent = 100.0 - (usage_ratio * 100.0);
 
             cwd_entries_occupied = format_file_size(bytes_occupied, size_unit_multiplier);
             cwd_entries_capacity = format_file_size(bytes_reserved, size_unit_multiplier);
+            legacy_occupied = format_file_size(legacy_bytes_occupied, size_unit_multiplier);
+            bytes_saved = format_file_size(legacy_bytes_occupied - std::min(legacy_bytes_occupied, bytes_occupied), size_unit_multiplier);
+        }
+        {
+            names_occupied = format_file_size(expl.cwd_entries.names.size(), size_unit_multiplier);
+            swan_path_equivalent = format_file_size(expl.cwd_entries.count() * sizeof(swan_path), size_unit_multiplier);
         }
+        imgui::Text("cwd_entries (used): %s", cwd_entries_occupied.data());
+        imgui::Text("cwd_entries (capacity): %s", cwd_entries_capacity.data());
+        imgui::Text("cwd_entries as array of dirents: %s, (%3.1lf %% saved, %s)", legacy_occupied.data(), savings_percent, bytes_saved.data());
+        imgui::Text("name arena: %s, (vs. %s as swan_path)", names_occupied.data(), swan_path_equivalent.data());
+
+        imgui::SeparatorText("Listing cache (all explorers)");
         {
-            u64 bytes_occupied = expl.cwd_entries.size() * sizeof(swan_path);
-            u64 bytes_actually_used = 0;
+            auto const &cache = global_state::listing_cache();
+            u64 num_lookups = cache.num_hits + cache.num_misses;
+            f64 hit_percent = num_lookups == 0 ? 0.0 : 100.0 * f64(cache.num_hits) / f64(num_lookups);
+            auto used = format_file_size(cache.bytes_used, size_unit_multiplier);
+            auto budget = format_file_size(cache.memory_budget, size_unit_multiplier);
 
-            for (auto const &dirent : expl.cwd_entries) {
-                bytes_actually_used += path_length(dirent.basic.path);
-            }
+            imgui::Text("entries: %zu / %zu", cache.entries.size(), cache.max_entries);
+            imgui::Text("memory: %s / %s", used.data(), budget.data());
+            imgui::Text("hits: %zu, misses: %zu (%3.1lf %% hit)", cache.num_hits, cache.num_misses, hit_percent);
+            imgui::Text("evictions: %zu", cache.num_evictions);
+        }
 
-            f64 usage_ratio = ( f64(bytes_actually_used) + (bytes_occupied == 0) ) / ( f64(bytes_occupied) + (bytes_occupied == 0) );
-            swan_path_waste_percent = 100.0 - (usage_ratio * 100.0);
-            u64 bytes_wasted = u64( bytes_occupied * (1.0 - usage_ratio) );
+        imgui::SeparatorText("Icon cache (all windows)");
+        {
+            auto &icons = global_state::icons();
+            std::scoped_lock lock(icons.mutex);
+            u64 num_lookups = icons.num_hits + icons.num_misses;
+            f64 hit_percent = num_lookups == 0 ? 0.0 : 100.0 * f64(icons.num_hits) / f64(num_lookups);
 
-            swan_path_occupied = format_file_size(bytes_occupied, size_unit_multiplier);
-            swan_path_wasted = format_file_size(bytes_wasted, size_unit_multiplier);
+            imgui::Text("entries: %zu (%zu unreferenced, kept up to %zu)", icons.slot_of_key.size(), icons.num_unreferenced, icon_cache::max_unreferenced);
+            imgui::Text("icons in atlas: %zu, atlas pages: %zu (%3.1lf %% occupied), repacks: %zu",
+                        icons.num_icons, icons.atlas.pages.size(), icons.atlas.occupancy() * 100.0, icons.num_repacks);
+            imgui::Text("hits: %zu, misses: %zu (%3.1lf %% hit)", icons.num_hits, icons.num_misses, hit_percent);
+            imgui::Text("evictions: %zu", icons.num_evictions);
         }
-        imgui::Text("cwd_entries (used): %s", cwd_entries_occupied.data());
-        imgui::Text("cwd_entries (capacity): %s", cwd_entries_capacity.data());
-        imgui::Text("swan_path footprint: %s, (%3.1lf %% waste, %s)", swan_path_occupied.data(), swan_path_waste_percent, swan_path_wasted.data());
 
         imgui::TreePop();
     }
@@ -1714,11 +3258,31 @@ bool swan_windows::render_explorer_debug(explorer_window &expl, bool &open, bool
     expl.tree_node_open_debug_performance = imgui::TreeNode("Performance");
     if (expl.tree_node_open_debug_performance) {
         imgui::SeparatorText("(Latest)");
-        imgui::Text("entries_to_select_sort: %.1lf us", expl.update_cwd_entries_timing_samples.empty() ? NAN : expl.update_cwd_entries_timing_samples.back().entries_to_select_sort);
+        if (!expl.update_cwd_entries_timing_samples.empty()) {
+            auto const &latest = expl.update_cwd_entries_timing_samples.back();
+            imgui::Text("filter: %.1lf us on %u thread(s), %.1lf us of work", latest.filter_us, latest.filter_threads, latest.filter_work_us);
+        }
+        imgui::Text("preserve_select_build: %.1lf us", expl.update_cwd_entries_timing_samples.empty() ? NAN : expl.update_cwd_entries_timing_samples.back().preserve_select_build_us);
         imgui::Text("entries_to_select_search: %.1lf us", expl.update_cwd_entries_timing_samples.empty() ? NAN : expl.update_cwd_entries_timing_samples.back().entries_to_select_search);
+        imgui::Text("queue_latency: %.1lf us", expl.update_cwd_entries_timing_samples.empty() ? NAN : expl.update_cwd_entries_timing_samples.back().queue_latency_us);
+        imgui::Text("merge_latency: %.1lf us", expl.update_cwd_entries_timing_samples.empty() ? NAN : expl.update_cwd_entries_timing_samples.back().merge_latency_us);
+        imgui::Text("merge: %.1lf us", expl.update_cwd_entries_timing_samples.empty() ? NAN : expl.update_cwd_entries_timing_samples.back().merge_us);
+        imgui::Text("cache: %.1lf us%s", expl.update_cwd_entries_timing_samples.empty() ? NAN : expl.update_cwd_entries_timing_samples.back().cache_us,
+                    !expl.update_cwd_entries_timing_samples.empty() && expl.update_cwd_entries_timing_samples.back().cache_hit ? " (hit)" : "");
+        imgui::Text("cwd_listing_generation: %zu%s", expl.cwd_listing_generation.load(), expl.cwd_listing_pending ? " (pending)" : "");
+        imgui::Checkbox("Verify count summaries every frame", &expl.debug_verify_cwd_counts);
+        {
+            auto &icons = global_state::icons();
+            std::scoped_lock lock(icons.mutex);
+            imgui::Text("icons (all windows): %zu loading, %zu awaiting upload, %zu uploaded last frame in %.1lf us",
+                        icons.num_loading, icons.loaded_icons.size(), icons.uploads_last_frame, icons.upload_us_last_frame);
+        }
+        imgui::Text("links resolving: %zu, link cache: %zu (%zu hits, %zu misses)", expl.num_links_resolving.load(), global_state::link_cache().size(),
+                    global_state::link_cache().num_hits.load(), global_state::link_cache().num_misses.load());
 
         imgui::SeparatorText("(Culmulative)");
         imgui::Text("num_file_finds: %zu", expl.num_file_finds);
+        imgui::Text("num_links_resolved: %zu", expl.num_links_resolved);
         imgui::Text("update_cwd_entries_culmulative: %.0lf ms", expl.update_cwd_entries_culmulative_us / 1000.);
         imgui::Text("filetime_to_string_culmulative: %.0lf ms", expl.filetime_to_string_culmulative_us / 1000.);
         imgui::Text("format_file_size_culmulative: %.0lf ms", expl.format_file_size_culmulative_us / 1000.);
@@ -1748,6 +3312,120 @@ bool swan_windows::render_explorer_debug(explorer_window &expl, bool &open, bool
             // imgui::ScopedColor c(ImGuiCol_PlotHistogram, compute_drive_usage_color(s_fraction_used));
             // imgui::ProgressBar(s_fraction_used);
         }
+
+        imgui::SeparatorText("sort_cwd_entries() on a synthetic listing");
+        {
+            static s32 s_num_rows = 1'000'000;
+            static f64 s_sort_ms = NAN;
+            static f64 s_serial_sort_ms = NAN;
+            static f64 s_per_comparison_ms = NAN;
+            static explorer_window s_bench = {};
+
+            {
+                imgui::ScopedItemWidth w(imgui::CalcTextSize("1000000000").x);
+                imgui::InputInt("Rows", &s_num_rows, 0, 0);
+                s_num_rows = std::clamp(s_num_rows, 1, 10'000'000);
+            }
+            imgui::SameLine();
+            if (imgui::Button("Sort with current columns")) {
+                auto &table = s_bench.cwd_entries;
+                table.clear();
+                table.reserve((u64)s_num_rows, (u64)s_num_rows * 16);
+
+                seed_fast_rand((u64)s_num_rows);
+                for (u32 id = 0; id < (u32)s_num_rows; ++id) {
+                    char name[32];
+                    s32 name_len = snprintf(name, sizeof(name), "%s_%07zu.%s", chance(2) ? "Report" : "image", fast_rand(0, 9'999'999), chance(3) ? "txt" : "PNG");
+                    bool is_directory = chance(10);
+                    u64 created = fast_rand(130'000'000'000'000'000ULL, 134'000'000'000'000'000ULL);
+                    table.push_back(std::string_view(name, (u64)name_len), is_directory ? basic_dirent::kind::directory : basic_dirent::kind::file,
+                                    is_directory ? 0 : fast_rand(0, 1ULL << 34), created, created + fast_rand(0, 10'000'000'000ULL), id);
+                }
+                s_bench.column_sort_specs = expl.column_sort_specs;
+
+                {
+                    explorer_window::dirent_table const generated = table; // both sorts start from the same order
+
+                    (void) sort_cwd_entries(s_bench, false);
+                    s_serial_sort_ms = s_bench.sort_timing_samples.back() / 1000.;
+
+                    table = generated;
+                }
+                (void) sort_cwd_entries(s_bench);
+                s_sort_ms = s_bench.sort_timing_samples.back() / 1000.;
+
+                //? Same ordering the way it was done before sort keys, comparing columns per comparison, for reference.
+                static std::vector<u32> s_rows = {};
+                s_rows.resize(table.count());
+                std::iota(s_rows.begin(), s_rows.end(), 0);
+                std::reverse(s_rows.begin(), s_rows.end());
+                f64 per_comparison_us = 0;
+                {
+                    scoped_timer<timer_unit::MICROSECONDS> per_comparison_timer(&per_comparison_us);
+                    std::sort(s_rows.begin(), s_rows.end(), [&](u32 left, u32 right) noexcept { return cwd_entries_row_less(s_bench, left, right); });
+                }
+                s_per_comparison_ms = per_comparison_us / 1000.;
+
+                s_bench.cwd_entries = {}; // release the memory
+            }
+            imgui::Text("sort keys: %.1lf ms (serial: %.1lf ms), per comparison: %.1lf ms", s_sort_ms, s_serial_sort_ms, s_per_comparison_ms);
+        }
+
+        imgui::SeparatorText("substring_matcher vs StrStrIA");
+        {
+            static s32 s_num_names = 1'000'000;
+            static std::string s_needle = "report_12";
+            static f64 s_matcher_ms = NAN;
+            static f64 s_strstria_ms = NAN;
+            static u64 s_num_matches = 0;
+            static bool s_counts_agree = true;
+
+            {
+                imgui::ScopedItemWidth w(imgui::CalcTextSize("1000000000").x);
+                imgui::InputInt("Names", &s_num_names, 0, 0);
+                s_num_names = std::clamp(s_num_names, 1, 10'000'000);
+                imgui::SameLine();
+                imgui::InputText("Needle", &s_needle);
+            }
+            imgui::SameLine();
+            if (imgui::Button("Search") && !s_needle.empty()) {
+                std::vector<char> names = {};
+                std::vector<u32> name_offsets = {};
+                names.reserve((u64)s_num_names * 20);
+                name_offsets.reserve((u64)s_num_names);
+
+                seed_fast_rand((u64)s_num_names);
+                for (s32 i = 0; i < s_num_names; ++i) {
+                    char name[32];
+                    s32 name_len = snprintf(name, sizeof(name), "%s_%07zu.%s", chance(2) ? "Report" : "image", fast_rand(0, 9'999'999), chance(3) ? "txt" : "PNG");
+                    name_offsets.push_back((u32)names.size());
+                    names.insert(names.end(), name, name + name_len + 1);
+                }
+
+                substring_matcher matcher(s_needle, false);
+                u64 matcher_matches = 0, strstria_matches = 0;
+                f64 matcher_us = 0, strstria_us = 0;
+                {
+                    scoped_timer<timer_unit::MICROSECONDS> matcher_timer(&matcher_us);
+                    for (u64 i = 0; i < name_offsets.size(); ++i) {
+                        u64 name_end = i + 1 < name_offsets.size() ? name_offsets[i + 1] - 1 : names.size() - 1;
+                        matcher_matches += matcher.matches(std::string_view(names.data() + name_offsets[i], name_end - name_offsets[i]));
+                    }
+                }
+                {
+                    scoped_timer<timer_unit::MICROSECONDS> strstria_timer(&strstria_us);
+                    for (u32 name_offset : name_offsets) {
+                        strstria_matches += StrStrIA(names.data() + name_offset, s_needle.c_str()) != nullptr;
+                    }
+                }
+                s_matcher_ms = matcher_us / 1000.;
+                s_strstria_ms = strstria_us / 1000.;
+                s_num_matches = matcher_matches;
+                s_counts_agree = matcher_matches == strstria_matches;
+            }
+            imgui::Text("%s: %.1lf ms, StrStrIA: %.1lf ms, %zu matches%s", substring_search_isa(), s_matcher_ms, s_strstria_ms, s_num_matches,
+                        s_counts_agree ? "" : " (StrStrIA disagrees)");
+        }
         imgui::TreePop();
     }
 
@@ -2055,6 +3733,7 @@ bool render_filter_reset_button(explorer_window &expl) noexcept
             && !expl.filter_case_sensitive
             && expl.filter_mode == explorer_window::filter_mode::contains
             && expl.filter_polarity == true
+            && expl.filter_sort_by_score
             && expl.filter_show_directories
             && expl.filter_show_files
             && expl.filter_show_invalid_symlinks
@@ -2089,9 +3768,6 @@ void render_drives_table(explorer_window &expl, char dir_sep_utf8, u64 size_unit
             expl.last_drives_refresh_time = get_time_precise();
             auto drives_info = query_available_drives_info();
 
-            for (auto &d : expl.drives) {
-                if (d.icon_GLtexID > 0) delete_icon_texture(d.icon_GLtexID, "drive_entry");
-            }
             expl.drives.clear();
 
             // only repopulate drives found by `query_available_drives_info`, nullified ones won't get rendered
@@ -2099,11 +3775,9 @@ void render_drives_table(explorer_window &expl, char dir_sep_utf8, u64 size_unit
                 if (di.letter == 0) continue;
 
                 assert(di.letter >= 'A' && di.letter <= 'Z');
-                char root[] = { di.letter, ':', dir_sep_utf8, '\0' };
 
                 drive_entry d;
                 d.info = di;
-                std::tie(d.icon_GLtexID, d.icon_size) = load_icon_texture(root, nullptr, "drive_entry");
                 expl.drives.push_back(d);
             }
         }
@@ -2156,7 +3830,20 @@ void render_drives_table(explorer_window &expl, char dir_sep_utf8, u64 size_unit
             }
 
             if (imgui::TableSetColumnIndex(drive_table_col_id_letter)) {
-                imgui::Image((ImTextureID)std::max(drive.icon_GLtexID, s64(0)), drive.icon_size);
+                static ImVec2 s_last_known_icon_size = { 16, 16 };
+
+                //? Acquired again after every refresh, the cache (and data\icons.bin) answers without asking the shell.
+                if (drive.icon.empty()) {
+                    char root[] = { drive.info.letter, ':', dir_sep_utf8, '\0' };
+                    drive.icon = global_state::icons().acquire(root, true);
+                }
+                icon_view icon = global_state::icons().view(drive.icon);
+                if (icon.ready()) {
+                    s_last_known_icon_size = icon.size;
+                    imgui::Image((ImTextureID)icon.texture, icon.size, icon.uv0, icon.uv1);
+                } else {
+                    imgui::Dummy(s_last_known_icon_size);
+                }
                 imgui::SameLine();
                 imgui::Text("%C:", drive.info.letter);
             }
@@ -2346,6 +4033,8 @@ bool render_filter_type_toggler_buttons(explorer_window &expl, cwd_count_info co
             switch (expl.filter_mode) {
                 case explorer_window::filter_mode::contains: filter_desc = contains_desc.data(); break;
                 case explorer_window::filter_mode::regex_match: filter_desc = regex_desc.data(); break;
+                case explorer_window::filter_mode::glob: filter_desc = contains_desc.data(); break;
+                case explorer_window::filter_mode::fuzzy: filter_desc = contains_desc.data(); break;
                 default: break;
             }
 
@@ -2397,6 +4086,8 @@ bool render_filter_mode_button(explorer_window &expl) noexcept
     static char const *s_filter_modes[] = {
          ICON_CI_WHOLE_WORD, // ICON_FA_FONT,
          ICON_CI_REGEX, // ICON_FA_ASTERISK,
+         ICON_CI_STAR_FULL,
+         ICON_CI_SPARKLE,
         // "(" ICON_CI_REGEX ")",
     };
 
@@ -2421,6 +4112,8 @@ bool render_filter_mode_button(explorer_window &expl) noexcept
         switch (expl.filter_mode) {
             case explorer_window::filter_mode::contains: mode = "CONTAINS"; break;
             case explorer_window::filter_mode::regex_match: mode = "REGEXP_MATCH"; break;
+            case explorer_window::filter_mode::glob: mode = "GLOB"; break;
+            case explorer_window::filter_mode::fuzzy: mode = "FUZZY"; break;
             // case explorer_window::filter_mode::regex_find: mode = "REGEXP_FIND"; break;
             default: break;
         }
@@ -2471,6 +4164,27 @@ bool render_filter_polarity_button(explorer_window &expl) noexcept
     return retval_cwd_entries_affected;
 }
 
+static
+bool render_filter_sort_by_score_button(explorer_window &expl) noexcept
+{
+    bool retval_cwd_entries_affected = false;
+    {
+        imgui::ScopedStyle<f32> s(imgui::GetStyle().Alpha, expl.filter_sort_by_score ? 1 : imgui::GetStyle().DisabledAlpha);
+        imgui::ScopedItemFlag no_nav(ImGuiItemFlags_NoNav, true);
+
+        if (imgui::Button(ICON_LC_ARROW_DOWN_WIDE_NARROW "## filter_sort_by_score")) {
+            flip_bool(expl.filter_sort_by_score);
+            (void) expl.update_cwd_entries(filter, expl.cwd.data());
+            (void) expl.save_to_disk();
+            retval_cwd_entries_affected = true;
+        }
+    }
+    if (imgui::IsItemHovered({}, 1)) {
+        imgui::SetTooltip("%s", expl.filter_sort_by_score ? "Best matches first" : "Matches in column order");
+    }
+    return retval_cwd_entries_affected;
+}
+
 static
 void render_button_pin_cwd(explorer_window &expl, bool cwd_exists) noexcept
 {
@@ -2868,6 +4582,10 @@ bool swan_windows::render_explorer(explorer_window &expl, bool &open, finder_win
     }
 #endif
 
+    //? Before Begin so batches keep flowing into cwd_entries while the window is hidden behind another tab.
+    (void) expl.merge_cwd_listing();
+    (void) expl.merge_resolved_links();
+
     imgui::SetNextWindowSize({ 1280, 720 }, ImGuiCond_Appearing);
 
     if (!imgui::Begin(expl.name, &open, ImGuiWindowFlags_NoCollapse)) {
@@ -2887,7 +4605,7 @@ bool swan_windows::render_explorer(explorer_window &expl, bool &open, finder_win
     bool window_hovered = imgui::IsWindowHovered(ImGuiFocusedFlags_ChildWindows);
     bool window_focused = imgui::IsWindowFocused(ImGuiFocusedFlags_ChildWindows);
 
-    static explorer_window::dirent const *s_dirent_to_be_renamed = nullptr;
+    static basic_dirent s_dirent_to_be_renamed = {};
 
     std::optional<swan_path> descend_target = std::nullopt;
     std::optional<swan_path> open_target = std::nullopt;
@@ -2903,8 +4621,7 @@ bool swan_windows::render_explorer(explorer_window &expl, bool &open, finder_win
         bool window_focused_or_hovered = window_focused || window_hovered;
 
         if (window_focused_or_hovered && imgui::IsKeyPressed(ImGuiKey_Delete)) {
-            u64 num_entries_selected = std::count_if(expl.cwd_entries.begin(), expl.cwd_entries.end(),
-                                                     [](explorer_window::dirent const &e) noexcept { return e.selected; });
+            u64 num_entries_selected = expl.cwd_entries.selected.count_set();
 
             if (num_entries_selected > 0) {
                 imgui::OpenConfirmationModalWithCallback(
@@ -2927,13 +4644,12 @@ bool swan_windows::render_explorer(explorer_window &expl, bool &open, finder_win
             }
         }
         else if (window_focused_or_hovered && (imgui::IsKeyPressed(ImGuiKey_F2) || (io.KeyCtrl && imgui::IsKeyPressed(ImGuiKey_R)))) {
-            u64 num_entries_selected = std::count_if(expl.cwd_entries.begin(), expl.cwd_entries.end(),
-                                                     [](explorer_window::dirent const &e) noexcept { return e.selected; });
+            u64 num_entries_selected = expl.cwd_entries.selected.count_set();
 
             if (num_entries_selected == 0) {
                 if (expl.tabbing_focus_idx >= 0) {
                     open_single_rename_popup = true;
-                    s_dirent_to_be_renamed = &expl.cwd_entries[expl.tabbing_focus_idx];
+                    s_dirent_to_be_renamed = expl.cwd_entries.make_basic_dirent((u64)expl.tabbing_focus_idx);
                 }
                 else {
                     // TODO notification
@@ -2941,10 +4657,12 @@ bool swan_windows::render_explorer(explorer_window &expl, bool &open, finder_win
                 }
             }
             else if (num_entries_selected == 1) {
-                auto selected_dirent = std::find_if(expl.cwd_entries.begin(), expl.cwd_entries.end(),
-                                                    [](explorer_window::dirent const &e) noexcept { return e.selected; });
+                u64 selected_row = 0;
+                while (!expl.cwd_entries.selected.get(selected_row)) {
+                    ++selected_row;
+                }
                 open_single_rename_popup = true;
-                s_dirent_to_be_renamed = &(*selected_dirent);
+                s_dirent_to_be_renamed = expl.cwd_entries.make_basic_dirent(selected_row);
             }
             else if (num_entries_selected > 1) {
                 open_bulk_rename_popup = true;
@@ -3105,7 +4823,27 @@ bool swan_windows::render_explorer(explorer_window &expl, bool &open, finder_win
                 }
             };
 
+            //? Keep watching the same handle so changes made between the signal and the new call are buffered rather than lost.
+            auto rearm_read_dir_changes = [&]() noexcept {
+                auto success = ReadDirectoryChangesW(
+                    expl.read_dir_changes_handle,
+                    reinterpret_cast<void *>(expl.read_dir_changes_buffer.data()),
+                    (s32)expl.read_dir_changes_buffer.size(),
+                    FALSE, // watch subtree
+                    FILE_NOTIFY_CHANGE_CREATION|FILE_NOTIFY_CHANGE_DIR_NAME|FILE_NOTIFY_CHANGE_FILE_NAME|FILE_NOTIFY_CHANGE_LAST_WRITE|FILE_NOTIFY_CHANGE_SIZE,
+                    &expl.read_dir_changes_buffer_bytes_written,
+                    &expl.read_dir_changes_overlapped,
+                    nullptr);
+
+                if (!success) {
+                    print_debug_msg("[ %d ] FAILED ReadDirectoryChangesW (rearm): %s", expl.id, get_last_winapi_error().formatted_message.c_str());
+                    CloseHandle(expl.read_dir_changes_handle);
+                    expl.read_dir_changes_handle = INVALID_HANDLE_VALUE; // reissued with a fresh handle next frame
+                }
+            };
+
             if (expl.read_dir_changes_refresh_request_time != time_point_precise_t() &&
+                !expl.cwd_listing_pending && // don't let a stream of changes keep restarting a slow listing
                 time_diff_ms(expl.last_filesystem_query_time, get_time_precise()) >= 250)
             {
                 refresh(full_refresh);
@@ -3131,9 +4869,16 @@ bool swan_windows::render_explorer(explorer_window &expl, bool &open, finder_win
                     // print_debug_msg("[ %d ] GetOverlappedResult FAILED: %d %s", expl.id, GetLastError(), get_last_error_string().c_str());
                 } else {
                     if (global_state::settings().explorer_refresh_mode == swan_settings::explorer_refresh_mode_automatic) {
-                        issue_read_dir_changes();
-                        if (expl.read_dir_changes_refresh_request_time == time_point_precise_t()) {
-                            // no refresh pending, submit request to refresh
+                        // decode before re-arming, which reuses the buffer. 0 bytes (or a failed wait) means the system buffer overflowed.
+                        static directory_change_batch s_changes = {};
+                        s_changes.clear();
+                        decode_file_notify_information(expl.read_dir_changes_buffer.data(),
+                                                       overlap_check ? expl.read_dir_changes_buffer_bytes_written : 0,
+                                                       s_changes);
+                        rearm_read_dir_changes();
+
+                        if (!expl.apply_cwd_changes(s_changes) && expl.read_dir_changes_refresh_request_time == time_point_precise_t()) {
+                            // can't apply incrementally and no refresh pending, submit request to refresh
                             expl.read_dir_changes_refresh_request_time = get_time_precise();
                         }
                     } else { // explorer_options::refresh_mode::notify
@@ -3144,7 +4889,7 @@ bool swan_windows::render_explorer(explorer_window &expl, bool &open, finder_win
                         expl.refresh_message_tooltip = "Directory content has changed since it was last updated.\n"
                                                        "To see the changes, click to refresh.\n"
                                                        "Alternatively, you can set refresh mode to 'Automatic' in [Settings] > Explorer > Refresh mode.";
-                        issue_read_dir_changes();
+                        rearm_read_dir_changes();
                     }
                 }
             }
@@ -3155,43 +4900,21 @@ bool swan_windows::render_explorer(explorer_window &expl, bool &open, finder_win
     }
     // refresh logic end
 
-    auto do_counting = [](explorer_window const &expl) noexcept -> cwd_count_info {
-        // print_debug_msg("[ %d ] do_counting [%s]", expl.id, expl.cwd.data());
-
-        cwd_count_info cnt = {};
-
-        for (auto &dirent : expl.cwd_entries) {
-            static_assert(u64(false) == 0);
-            static_assert(u64(true)  == 1);
-
-            [[maybe_unused]] char const *path = dirent.basic.path.data();
-
-            bool is_path_dotdot = dirent.basic.is_path_dotdot();
-            bool is_dir = dirent.basic.is_directory() || dirent.basic.is_symlink_to_directory();
-            bool is_file = dirent.basic.is_file() || dirent.basic.is_symlink_to_file();
-
-            cnt.filtered_directories += u64(dirent.filtered && is_dir);
-            cnt.filtered_files       += u64(dirent.filtered && is_file);
-
-            cnt.child_dirents     += 1; // u64(!is_path_dotdot);
-            cnt.child_directories += u64(dirent.basic.is_directory() || dirent.basic.is_symlink_to_directory());
-            cnt.child_files       += u64(is_file || dirent.basic.is_symlink_ambiguous());
-
-            // cnt.filtered_symlinks += u64(dirent.filtered && dirent.basic.is_symlink());
-            // cnt.child_symlinks += u64(dirent.basic.is_symlink());
-
-            if (!dirent.filtered && dirent.selected) {
-                cnt.selected_directories += u64(dirent.selected && is_dir && !is_path_dotdot);
-                cnt.selected_files       += u64(dirent.selected && is_file);
-                cnt.selected_files_size  += u64(is_file) * dirent.basic.size;
-
-                // cnt.selected_symlinks += u64(dirent.selected && dirent.basic.is_symlink());
+    auto do_counting = [](explorer_window &expl) noexcept -> cwd_count_info {
+        cwd_count_info const &cnt = expl.cwd_entries.up_to_date_counts();
+
+        if (expl.debug_verify_cwd_counts) {
+            cwd_count_info full = expl.cwd_entries.recount();
+            if (!(full == cnt)) {
+                print_debug_msg("[ %d ] cwd counts out of sync: selected %zu/%zu, filtered %zu/%zu, children %zu/%zu",
+                                expl.id, cnt.selected_dirents, full.selected_dirents, cnt.filtered_dirents, full.filtered_dirents,
+                                cnt.child_dirents, full.child_dirents);
+                assert(full == cnt);
+                expl.cwd_entries.invalidate_counts();
+                return full;
             }
         }
 
-        cnt.filtered_dirents = cnt.filtered_directories + cnt.filtered_files; // + cnt.filtered_symlinks
-        cnt.selected_dirents = cnt.selected_directories + cnt.selected_files; // + cnt.selected_symlinks
-
         return cnt;
     };
 
@@ -3270,7 +4993,7 @@ bool swan_windows::render_explorer(explorer_window &expl, bool &open, finder_win
                 s64 min = 0;
                 s64 max = b_render_drives_table
                     ? (expl.drives.size() - 1)
-                    : std::distance(expl.cwd_entries.begin(), expl.first_filtered_cwd_dirent_iter) - 1
+                    : s64(expl.first_filtered_cwd_dirent_row) - 1
                 ;
                 if (imgui::GetIO().KeyShift) dec_or_wrap(expl.tabbing_focus_idx, min, max);
                 else inc_or_wrap(expl.tabbing_focus_idx, min, max);
@@ -3285,8 +5008,7 @@ bool swan_windows::render_explorer(explorer_window &expl, bool &open, finder_win
     }
     else {
         for (auto &drive : expl.drives)
-            if (drive.icon_GLtexID > 0)
-                delete_icon_texture(drive.icon_GLtexID, "explorer_window::drive");
+            drive.icon.reset();
 
         // distance from top of cwd_entries table to top border of dirent we are trying to scroll to
         std::optional<f32> scrolled_to_dirent_offset_y = std::nullopt;
@@ -3295,26 +5017,30 @@ bool swan_windows::render_explorer(explorer_window &expl, bool &open, finder_win
             u64 target = expl.scroll_to_nth_selected_entry_next_frame;
             u64 counter = 0;
 
-            auto scrolled_to_dirent = std::find_if(expl.cwd_entries.begin(), expl.cwd_entries.end(), [&counter, target](explorer_window::dirent &e) noexcept {
+            u64 scrolled_to_row = 0;
+            for (; scrolled_to_row < expl.cwd_entries.count(); ++scrolled_to_row) {
                 // stop spotlighting the previous dirents, looks better when rapidly advancing the spotlighted dirent.
                 // without it multiple dirents can be spotlighted at the same time which is visually distracting and possible confusing.
-                e.spotlight_frames_remaining = 0;
+                expl.cwd_entries.ui[scrolled_to_row].spotlight_frames_remaining = 0;
 
-                return e.selected && (counter++) == target;
-            });
+                if (expl.cwd_entries.selected.get(scrolled_to_row) && (counter++) == target) {
+                    break;
+                }
+            }
 
-            if (scrolled_to_dirent != expl.cwd_entries.end()) {
-                scrolled_to_dirent->spotlight_frames_remaining = u32(imgui::GetIO().Framerate) / 3;
-                scrolled_to_dirent_offset_y = ImGui::GetTextLineHeightWithSpacing() * f32(std::distance(expl.cwd_entries.begin(), scrolled_to_dirent));
+            if (scrolled_to_row != expl.cwd_entries.count()) {
+                expl.cwd_entries.ui[scrolled_to_row].spotlight_frames_remaining = u32(imgui::GetIO().Framerate) / 3;
+                scrolled_to_dirent_offset_y = ImGui::GetTextLineHeightWithSpacing() * f32(scrolled_to_row);
 
                 // stop spotlighting any dirents ahead which could linger if we just wrapped the spotlight back to the top,
                 // looks better this way when rapidly advancing the spotlighted dirent.
                 // without it multiple dirents can be spotlighted at the same time which is visually distracting and possibly confusing.
-                std::for_each(scrolled_to_dirent + 1, expl.cwd_entries.end(),
-                              [](explorer_window::dirent &e) noexcept { e.spotlight_frames_remaining = 0; });
+                for (u64 row = scrolled_to_row + 1; row < expl.cwd_entries.count(); ++row) {
+                    expl.cwd_entries.ui[row].spotlight_frames_remaining = 0;
+                }
             }
 
-            u64 scroll_idx = std::distance(expl.cwd_entries.begin(), scrolled_to_dirent);
+            u64 scroll_idx = scrolled_to_row;
             imgui::SetNextWindowScroll(ImVec2(-1.0f, ImGui::GetTextLineHeightWithSpacing() * scroll_idx));
 
             expl.scroll_to_nth_selected_entry_next_frame = u64(-1);
@@ -3384,15 +5110,18 @@ bool swan_windows::render_explorer(explorer_window &expl, bool &open, finder_win
 
             if (table_sort_specs != nullptr && table_sort_specs->SpecsDirty) {
                 table_sort_specs->SpecsDirty = false;
-                expl.first_filtered_cwd_dirent_iter = sort_cwd_entries(expl);
+                expl.first_filtered_cwd_dirent_row = sort_cwd_entries(expl);
             } else {
                 f64 find_first_filtered_cwd_dirent_us = 0;
                 SCOPE_EXIT { expl.find_first_filtered_cwd_dirent_timing_samples.push_back(find_first_filtered_cwd_dirent_us); };
                 scoped_timer<timer_unit::MICROSECONDS> timer(&find_first_filtered_cwd_dirent_us);
 
                 // no point in binary search here, cost of linear traversal is tiny even for huge collection
-                expl.first_filtered_cwd_dirent_iter = std::find_if(expl.cwd_entries.begin(), expl.cwd_entries.end(),
-                    [](explorer_window::dirent const &ent) noexcept { return ent.filtered; });
+                u64 row = 0;
+                while (row < expl.cwd_entries.count() && !expl.cwd_entries.filtered.get(row)) {
+                    ++row;
+                }
+                expl.first_filtered_cwd_dirent_row = row;
             }
 
             // opens "Context" popup if a rendered dirent is right clicked
@@ -3405,7 +5134,7 @@ bool swan_windows::render_explorer(explorer_window &expl, bool &open, finder_win
             open_bulk_rename_popup   |= result.open_bulk_rename_popup;
             open_single_rename_popup |= result.open_single_rename_popup;
             if (result.single_dirent_to_be_renamed) {
-                s_dirent_to_be_renamed = result.single_dirent_to_be_renamed;
+                s_dirent_to_be_renamed = result.single_dirent_to_be_renamed.value();
             }
 
             if (result.context_menu_rect.has_value() && context_menu_target_row_rect.has_value() && cnt.selected_dirents <= 1) {
@@ -3454,6 +5183,10 @@ bool swan_windows::render_explorer(explorer_window &expl, bool &open, finder_win
         /* recount |= */ render_filter_case_sensitivity_button(expl);
         imgui::SameLine(0, 0);
         /* recount |= */ render_filter_polarity_button(expl);
+        if (expl.filter_mode == explorer_window::filter_mode::fuzzy) {
+            imgui::SameLine(0, 0);
+            /* recount |= */ render_filter_sort_by_score_button(expl);
+        }
 
         imgui::SameLineSpaced(3);
 
@@ -3523,6 +5256,11 @@ bool swan_windows::render_explorer(explorer_window &expl, bool &open, finder_win
             (void) render_num_cwd_items_selected(expl, cnt);
         }
 
+        if (expl.cwd_listing_pending) {
+            imgui::SameLineSpaced(2);
+            imgui::TextDisabled(ICON_LC_LOADER " Listing... %zu", expl.cwd_entries.count());
+        }
+
         if (expl.refresh_message != "") {
             imgui::SameLineSpaced(2);
             imgui::TextColored(warning_color(), "%s", expl.refresh_message.c_str());
@@ -3616,7 +5354,7 @@ bool swan_windows::render_explorer(explorer_window &expl, bool &open, finder_win
     }
 
     if (open_single_rename_popup) {
-        swan_popup_modals::open_single_rename(expl, *s_dirent_to_be_renamed, [&expl]() noexcept {
+        swan_popup_modals::open_single_rename(expl, s_dirent_to_be_renamed, [&expl]() noexcept {
             /* on rename finished: */
             if (global_state::settings().explorer_refresh_mode == swan_settings::explorer_refresh_mode_manual) {
                 (void) expl.update_cwd_entries(full_refresh, expl.cwd.data());
@@ -3812,15 +5550,19 @@ render_table_rows_for_cwd_entries_result render_table_rows_for_cwd_entries(
 
     ImGuiListClipper clipper;
     {
-        u64 num_dirents_to_render = expl.cwd_entries.size() - cnt.filtered_dirents;
+        u64 num_dirents_to_render = expl.cwd_entries.count() - cnt.filtered_dirents;
         assert(num_dirents_to_render <= (u64)INT32_MAX);
         clipper.Begin(s32(num_dirents_to_render));
     }
 
+    u32 format_generation = refresh_date_time_format();
+
     while (clipper.Step()) {
         for (u64 i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
-            auto &dirent = expl.cwd_entries[i];
-            [[maybe_unused]] char *path = dirent.basic.path.data();
+            auto dirent = expl.cwd_entries[i];
+            auto &ui = dirent.ui();
+            auto &column_text = claim_column_text_slot(expl.cwd_entries_column_text, i, format_generation, size_unit_multiplier);
+            [[maybe_unused]] char const *path = dirent.name();
 
             ImRect selectable_rect;
 
@@ -3833,54 +5575,56 @@ render_table_rows_for_cwd_entries_result render_table_rows_for_cwd_entries(
             }
 
             if (imgui::TableSetColumnIndex(explorer_window::cwd_entries_table_col_id)) {
-                auto id = make_str_static<32>("%zu", dirent.basic.id);
+                auto id = make_str_static<32>("%zu", dirent.id());
                 imgui::TextUnformatted(id.data());
                 imgui::RenderTooltipWhenColumnTextTruncated(explorer_window::cwd_entries_table_col_id, id.data());
             }
 
             if (imgui::TableSetColumnIndex(explorer_window::cwd_entries_table_col_path)) {
-                static ImVec2 s_last_known_icon_size = {};
+                static ImVec2 s_last_known_icon_size = { 16, 16 }; // SHGFI_SMALLICON at 100% scaling
 
                 if (global_state::settings().win32_file_icons) {
-                    if (dirent.icon_GLtexID == 0) {
-                        swan_path full_path_utf8 = expl.cwd;
-                        if (path_append(full_path_utf8, dirent.basic.path.data(), dir_sep_utf8, true)) {
-                            std::tie(dirent.icon_GLtexID, dirent.icon_size) = load_icon_texture(full_path_utf8.data(), 0, "explorer_window::dirent");
-                            if (dirent.icon_GLtexID > 0) {
-                                s_last_known_icon_size = dirent.icon_size;
-                            }
+                    if (ui.icon.empty()) {
+                        swan_path full_path = expl.cwd_entries_path;
+                        if (path_append(full_path, dirent.name(), global_state::settings().dir_separator_utf8, true)) {
+                            ui.icon = global_state::icons().acquire(full_path.data(), dirent.is_directory() || dirent.is_symlink_to_directory());
                         }
                     }
-                    auto const &icon_size = dirent.icon_GLtexID < 1 ? s_last_known_icon_size : dirent.icon_size;
-                    imgui::Image((ImTextureID)std::max(dirent.icon_GLtexID, s64(0)), icon_size, ImVec2(0,0), ImVec2(1,1), ImVec4(1,1,1, dirent.cut ? .3f : 1.f));
+                    icon_view icon = global_state::icons().view(ui.icon);
+                    if (icon.ready()) {
+                        s_last_known_icon_size = icon.size;
+                        imgui::Image((ImTextureID)icon.texture, icon.size, icon.uv0, icon.uv1, ImVec4(1,1,1, dirent.cut() ? .3f : 1.f));
+                    } else {
+                        imgui::Dummy(s_last_known_icon_size); // placeholder while loading (or after failing), keeps names aligned
+                    }
                 }
                 else { // fallback to generic icons
-                    char const *icon = dirent.basic.kind_icon();
-                    ImVec4 color = get_color(dirent.basic.type);
-                    if (dirent.cut) imgui::ReduceAlphaTo(color, .25f);
+                    char const *icon = dirent.kind_icon();
+                    ImVec4 color = get_color(dirent.type());
+                    if (dirent.cut()) imgui::ReduceAlphaTo(color, .25f);
                     imgui::TextColored(color, icon);
                 }
                 imgui::SameLine();
 
                 ImVec2 path_text_rect_min = imgui::GetCursorScreenPos();
                 {
-                    imgui::ScopedTextColor tc_spotlight(dirent.spotlight_frames_remaining > 0 ? success_color() : imgui::GetStyle().Colors[ImGuiCol_Text]);
-                    // imgui::ScopedStyle<ImVec4> tc_context(imgui::GetStyle().Colors[ImGuiCol_Text], error_color(), dirent.context_menu_active);
+                    imgui::ScopedTextColor tc_spotlight(ui.spotlight_frames_remaining > 0 ? success_color() : imgui::GetStyle().Colors[ImGuiCol_Text]);
+                    // imgui::ScopedStyle<ImVec4> tc_context(imgui::GetStyle().Colors[ImGuiCol_Text], error_color(), ui.context_menu_active);
 
                     auto label = make_str_static<1200>("%s##dirent%zu", path, i);
-                    if (imgui::Selectable(label.data(), dirent.selected, ImGuiSelectableFlags_SpanAllColumns|ImGuiSelectableFlags_AllowDoubleClick)) {
-                        bool selection_before_deselect = dirent.selected;
+                    if (imgui::Selectable(label.data(), dirent.selected(), ImGuiSelectableFlags_SpanAllColumns|ImGuiSelectableFlags_AllowDoubleClick)) {
+                        bool selection_before_deselect = dirent.selected();
 
                         u64 num_deselected = 0;
                         if (!io.KeyCtrl && !io.KeyShift) {
                             // entry was selected but Ctrl was not held, so deselect everything
-                            num_deselected = expl.deselect_all_cwd_entries(); // this will alter dirent.selected
+                            num_deselected = expl.deselect_all_cwd_entries(); // this will alter dirent.selected()
                         }
 
                         if (num_deselected > 1) {
-                            dirent.selected = true;
+                            dirent.set_selected(true);
                         } else {
-                            dirent.selected = !selection_before_deselect;
+                            dirent.set_selected(!selection_before_deselect);
                         }
 
                         if (io.KeyShift) {
@@ -3894,33 +5638,33 @@ render_table_rows_for_cwd_entries_result render_table_rows_for_cwd_entries(
                             // print_debug_msg("[ %d ] shift click, [%zu, %zu]", expl.id, first_idx, last_idx);
 
                             for (u64 j = first_idx; j <= last_idx; ++j) {
-                                auto &dirent_ = expl.cwd_entries[j];
-                                if (!dirent_.basic.is_path_dotdot()) {
-                                    dirent_.selected = true;
+                                auto dirent_ = expl.cwd_entries[j];
+                                if (!dirent_.is_path_dotdot()) {
+                                    dirent_.set_selected(true);
                                 }
                             }
                         }
                         else { // not shift click, check for double click
 
                             static swan_path s_last_click_path = {};
-                            swan_path const &current_click_path = dirent.basic.path;
+                            swan_path current_click_path = path_create(dirent.name(), dirent.name_len());
 
                             if (imgui::IsItemActivated() || imgui::IsMouseDoubleClicked(ImGuiMouseButton_Left) && !io.KeyCtrl && path_equals_exactly(current_click_path, s_last_click_path)) {
-                                if (dirent.basic.is_directory()) {
-                                    if (dirent.basic.is_path_dotdot()) {
+                                if (dirent.is_directory()) {
+                                    if (dirent.is_path_dotdot()) {
                                         retval.do_ascend = true;
                                     }
                                     else {
                                         retval.descend_target = current_click_path;
                                     }
                                 }
-                                else if (dirent.basic.is_symlink()) {
-                                    print_debug_msg("[ %d ] double clicked symlink [%s]", expl.id, dirent.basic.path.data());
+                                else if (dirent.is_symlink()) {
+                                    print_debug_msg("[ %d ] double clicked symlink [%s]", expl.id, dirent.name());
 
                                     auto res = open_symlink(dirent, expl);
 
                                     if (res.success) {
-                                        if (dirent.basic.is_symlink_to_directory()) {
+                                        if (dirent.is_symlink_to_directory()) {
                                             char const *target_dir_path = res.error_or_utf8_path.c_str();
 
                                             expl.cwd = path_create(target_dir_path);
@@ -3931,36 +5675,36 @@ render_table_rows_for_cwd_entries_result render_table_rows_for_cwd_entries(
                                             (void) expl.update_cwd_entries(full_refresh, expl.cwd.data());
                                             (void) expl.save_to_disk();
                                         }
-                                        else if (dirent.basic.is_symlink_to_file()) {
+                                        else if (dirent.is_symlink_to_file()) {
                                             char const *full_file_path = res.error_or_utf8_path.c_str();
                                             global_state::recent_files_update("Opened", full_file_path);
                                             (void) global_state::recent_files_save_to_disk(nullptr);
                                         }
                                     } else {
-                                        std::string action = make_str("Open symlink [%s].", dirent.basic.path.data());
+                                        std::string action = make_str("Open symlink [%s].", dirent.name());
                                         char const *failed = res.error_or_utf8_path.c_str();
                                         swan_popup_modals::open_error(action.c_str(), failed);
                                     }
                                 }
                                 else {
-                                    // print_debug_msg("[ %d ] double clicked file [%s]", expl.id, dirent.basic.path.data());
+                                    // print_debug_msg("[ %d ] double clicked file [%s]", expl.id, dirent.name());
 
                                     // TODO: async
-                                    auto res = open_file(dirent.basic.path.data(), expl.cwd.data());
+                                    auto res = open_file(dirent.name(), expl.cwd.data());
 
                                     if (res.success) {
                                         char const *full_file_path = res.error_or_utf8_path.c_str();
                                         global_state::recent_files_update("Opened", full_file_path);
                                         (void) global_state::recent_files_save_to_disk(nullptr);
                                     } else {
-                                        std::string action = make_str("Open file [%s].", dirent.basic.path.data());
+                                        std::string action = make_str("Open file [%s].", dirent.name());
                                         char const *failed = res.error_or_utf8_path.c_str();
                                         swan_popup_modals::open_error(action.c_str(), failed);
                                     }
                                 }
                             }
-                            else if (dirent.basic.is_path_dotdot()) {
-                                print_debug_msg("[ %d ] selected [%s]", expl.id, dirent.basic.path.data());
+                            else if (dirent.is_path_dotdot()) {
+                                print_debug_msg("[ %d ] selected [%s]", expl.id, dirent.name());
                             }
 
                             s_last_click_path = current_click_path;
@@ -3970,6 +5714,11 @@ render_table_rows_for_cwd_entries_result render_table_rows_for_cwd_entries(
 
                     } // imgui::Selectable
 
+                    if (i >= expl.cwd_entries.count()) {
+                        //? cwd_entries were refreshed while handling the click (e.g. opened a symlink to a directory), `dirent` is stale
+                        return retval;
+                    }
+
                     selectable_rect = imgui::GetItemRect();
 
                     if (expl.tabbing_set_focus && expl.tabbing_focus_idx == s64(i) && !imgui::IsItemFocused()) {
@@ -3983,29 +5732,29 @@ render_table_rows_for_cwd_entries_result render_table_rows_for_cwd_entries(
                     // }
                 }
 
-                if (dirent.highlight_len > 0) {
-                    imgui::HighlightTextRegion(path_text_rect_min, dirent.basic.path.data(), dirent.highlight_start_idx, dirent.highlight_len,
-                                               imgui::ReduceAlphaTo(imgui::Denormalize(warning_lite_color()), 75));
+                if (!ui.highlight.empty()) {
+                    imgui::HighlightTextRegions(path_text_rect_min, dirent.name(), ui.highlight,
+                                                imgui::ReduceAlphaTo(imgui::Denormalize(warning_lite_color()), 75));
                 }
 
-                if (dirent.basic.is_path_dotdot()) {
-                    dirent.selected = false; // do no allow [..] to be selected
+                if (dirent.is_path_dotdot()) {
+                    dirent.set_selected(false); // do no allow [..] to be selected
                 }
 
-                if (imgui::IsItemClicked(ImGuiMouseButton_Right) && !any_popups_open && !dirent.basic.is_path_dotdot()) {
-                    // print_debug_msg("[ %d ] right clicked [%s]", expl.id, dirent.basic.path.data());
+                if (imgui::IsItemClicked(ImGuiMouseButton_Right) && !any_popups_open && !dirent.is_path_dotdot()) {
+                    // print_debug_msg("[ %d ] right clicked [%s]", expl.id, dirent.name());
                     imgui::OpenPopup("## explorer context_menu");
-                    expl.context_menu_target = &dirent;
-                    dirent.context_menu_active = true;
+                    expl.context_menu_target_id = dirent.id();
+                    ui.context_menu_active = true;
 
-                    if (!dirent.selected) {
+                    if (!dirent.selected()) {
                         expl.deselect_all_cwd_entries();
                     }
                 }
 
             } // path column
 
-            if (!dirent.basic.is_path_dotdot() && imgui::BeginDragDropSource()) {
+            if (!dirent.is_path_dotdot() && imgui::BeginDragDropSource()) {
                 auto cwd_to_utf16 = [&]() noexcept {
                     std::wstring retval;
 
@@ -4024,13 +5773,14 @@ render_table_rows_for_cwd_entries_result render_table_rows_for_cwd_entries(
                     explorer_drag_drop_payload &payload,
                     std::wstring &paths,
                     std::wstring const &cwd_utf16,
-                    basic_dirent const &dirent) noexcept
+                    char const *dirent_name,
+                    basic_dirent::kind dirent_type) noexcept
                 {
                     static std::wstring dirent_full_path_utf16 = {};
                     dirent_full_path_utf16.clear();
 
                     wchar_t dirent_name_utf16[MAX_PATH];
-                    if (!utf8_to_utf16(dirent.path.data(), dirent_name_utf16, lengthof(dirent_name_utf16))) {
+                    if (!utf8_to_utf16(dirent_name, dirent_name_utf16, lengthof(dirent_name_utf16))) {
                         return;
                     }
 
@@ -4043,7 +5793,7 @@ render_table_rows_for_cwd_entries_result render_table_rows_for_cwd_entries(
 
                         paths += dirent_full_path_utf16 += L'\n';
                         payload.num_items += 1;
-                        payload.obj_type_counts[(u64)dirent.type] += 1;
+                        payload.obj_type_counts[(u64)dirent_type] += 1;
                     }
                     catch (...) {
                         // TODO report error
@@ -4059,15 +5809,15 @@ render_table_rows_for_cwd_entries_result render_table_rows_for_cwd_entries(
 
                     payload.src_explorer_id = expl.id;
 
-                    if (dirent.selected) {
-                        for (auto const &dirent_ : expl.cwd_entries) {
-                            if (!dirent_.filtered && dirent_.selected) {
-                                add_payload_item(payload, paths, cwd_utf16, dirent_.basic);
+                    if (dirent.selected()) {
+                        for (auto dirent_ : expl.cwd_entries) {
+                            if (!dirent_.filtered() && dirent_.selected()) {
+                                add_payload_item(payload, paths, cwd_utf16, dirent_.name(), dirent_.type());
                             }
                         }
                     }
                     else {
-                        add_payload_item(payload, paths, cwd_utf16, dirent.basic);
+                        add_payload_item(payload, paths, cwd_utf16, dirent.name(), dirent.type());
                         global_state::move_dirents_payload_set() = true;
                     }
 
@@ -4149,7 +5899,7 @@ render_table_rows_for_cwd_entries_result render_table_rows_for_cwd_entries(
                 imgui::EndDragDropSource();
             }
 
-            if (!dirent.basic.is_file() && !dirent.basic.is_symlink_to_file() && !dirent.selected && imgui::BeginDragDropTarget()) {
+            if (!dirent.is_file() && !dirent.is_symlink_to_file() && !dirent.selected() && imgui::BeginDragDropTarget()) {
                 auto payload_wrapper = imgui::GetDragDropPayload();
 
                 if (payload_wrapper != nullptr && cstr_eq(payload_wrapper->DataType, "explorer_drag_drop_payload")) {
@@ -4163,13 +5913,12 @@ render_table_rows_for_cwd_entries_result render_table_rows_for_cwd_entries(
             }
 
             if (imgui::TableSetColumnIndex(explorer_window::cwd_entries_table_col_object)) {
-                char const *object_desc = dirent.basic.kind_short_cstr();
+                char const *object_desc = dirent.kind_short_cstr();
                 imgui::TextUnformatted(object_desc);
                 imgui::RenderTooltipWhenColumnTextTruncated(explorer_window::cwd_entries_table_col_object, object_desc);
             }
 
             if (imgui::TableSetColumnIndex(explorer_window::cwd_entries_table_col_type)) {
-            // #if CACHE_FORMATTED_STRING_COLUMNS
                 // Not worth caching, miniscule cost to compute each frame
 
                 std::array<char, 64> type_text;
@@ -4178,12 +5927,12 @@ render_table_rows_for_cwd_entries_result render_table_rows_for_cwd_entries(
                     SCOPE_EXIT { expl.type_description_culmulative_us += func_us; };
                     scoped_timer<timer_unit::MICROSECONDS> timer(&func_us);
 
-                    if (dirent.basic.is_directory()) {
+                    if (dirent.is_directory()) {
                         type_text = { "Directory" };
                     } else {
-                        if (std::strchr(dirent.basic.path.data(), '.')) {
+                        if (std::strchr(dirent.name(), '.')) {
 
-                            char const *extension = path_cfind_file_ext(dirent.basic.path.data());
+                            char const *extension = path_cfind_file_ext(dirent.name());
                             type_text = get_type_text_for_extension(extension);
                         } else {
                             type_text = { "File" };
@@ -4195,89 +5944,58 @@ render_table_rows_for_cwd_entries_result render_table_rows_for_cwd_entries(
             }
 
             if (imgui::TableSetColumnIndex(explorer_window::cwd_entries_table_col_size_formatted)) {
-                if (!dirent.basic.is_directory()) {
-            #if CACHE_FORMATTED_STRING_COLUMNS
-                    if (cstr_empty(dirent.formatted_size.data())) {
-                        f64 func_us = 0;
-                        SCOPE_EXIT { expl.format_file_size_culmulative_us += func_us; };
-                        scoped_timer<timer_unit::MICROSECONDS> timer(&func_us);
-                        dirent.formatted_size = format_file_size(dirent.basic.size, size_unit_multiplier);
-                    }
-                    imgui::TextUnformatted(dirent.formatted_size.data());
-                    imgui::RenderTooltipWhenColumnTextTruncated(explorer_window::cwd_entries_table_col_size_formatted, dirent.formatted_size.data());
-            #else
-                    std::array<char, 32> formatted_size;
-                    {
+                if (!dirent.is_directory()) {
+                    if (column_text.size != dirent.size()) {
                         f64 func_us = 0;
                         SCOPE_EXIT { expl.format_file_size_culmulative_us += func_us; };
                         scoped_timer<timer_unit::MICROSECONDS> timer(&func_us);
-                        formatted_size = format_file_size(dirent.basic.size, size_unit_multiplier);
+                        format_file_size(dirent.size(), column_text.size_text.data(), column_text.size_text.size(), size_unit_multiplier);
+                        column_text.size = dirent.size();
                     }
-                    imgui::TextUnformatted(formatted_size.data());
-                    imgui::RenderTooltipWhenColumnTextTruncated(explorer_window::cwd_entries_table_col_size_formatted, formatted_size.data());
-            #endif
+                    imgui::TextUnformatted(column_text.size_text.data());
+                    imgui::RenderTooltipWhenColumnTextTruncated(explorer_window::cwd_entries_table_col_size_formatted, column_text.size_text.data());
                 }
             }
 
             if (imgui::TableSetColumnIndex(explorer_window::cwd_entries_table_col_size_bytes)) {
-                if (!dirent.basic.is_directory()) {
-                    auto size_text = make_str_static<32>("%zu", dirent.basic.size);
+                if (!dirent.is_directory()) {
+                    auto size_text = make_str_static<32>("%zu", dirent.size());
                     imgui::TextUnformatted(size_text.data());
                     imgui::RenderTooltipWhenColumnTextTruncated(explorer_window::cwd_entries_table_col_size_bytes, size_text.data());
                 }
             }
 
             if (imgui::TableSetColumnIndex(explorer_window::cwd_entries_table_col_creation_time)) {
-            #if CACHE_FORMATTED_STRING_COLUMNS
-                if (cstr_empty(dirent.creation_time.data())) {
-                    f64 func_us = 0;
-                    SCOPE_EXIT { expl.filetime_to_string_culmulative_us += func_us; };
-                    scoped_timer<timer_unit::MICROSECONDS> timer(&func_us);
-                    dirent.creation_time = filetime_to_string(&dirent.basic.creation_time_raw).second;
-                }
-                imgui::TextUnformatted(dirent.creation_time.data());
-                imgui::RenderTooltipWhenColumnTextTruncated(explorer_window::cwd_entries_table_col_creation_time, dirent.creation_time.data());
-            #else
-                std::pair<s32, std::array<char, 64U>> result;
-                {
+                u64 creation_time = expl.cwd_entries.creation_times[dirent.row];
+                if (column_text.creation_time != creation_time) {
                     f64 func_us = 0;
                     SCOPE_EXIT { expl.filetime_to_string_culmulative_us += func_us; };
                     scoped_timer<timer_unit::MICROSECONDS> timer(&func_us);
-                    result = filetime_to_string(&dirent.basic.creation_time_raw);
+                    g_date_time_format.format(creation_time, column_text.creation_time_text.data(), column_text.creation_time_text.size());
+                    column_text.creation_time = creation_time;
                 }
-                imgui::TextUnformatted(result.second.data());
-                imgui::RenderTooltipWhenColumnTextTruncated(explorer_window::cwd_entries_table_col_creation_time, result.second.data());
-            #endif
+                imgui::TextUnformatted(column_text.creation_time_text.data());
+                imgui::RenderTooltipWhenColumnTextTruncated(explorer_window::cwd_entries_table_col_creation_time, column_text.creation_time_text.data());
             }
 
             if (imgui::TableSetColumnIndex(explorer_window::cwd_entries_table_col_last_write_time)) {
-            #if CACHE_FORMATTED_STRING_COLUMNS
-                if (cstr_empty(dirent.last_write_time.data())) {
-                    f64 func_us = 0;
-                    SCOPE_EXIT { expl.filetime_to_string_culmulative_us += func_us; };
-                    scoped_timer<timer_unit::MICROSECONDS> timer(&func_us);
-                    dirent.last_write_time = filetime_to_string(&dirent.basic.last_write_time_raw).second;
-                }
-                imgui::TextUnformatted(dirent.last_write_time.data());
-                imgui::RenderTooltipWhenColumnTextTruncated(explorer_window::cwd_entries_table_col_last_write_time, dirent.last_write_time.data());
-            #else
-                std::pair<s32, std::array<char, 64U>> result;
-                {
+                u64 last_write_time = expl.cwd_entries.last_write_times[dirent.row];
+                if (column_text.last_write_time != last_write_time) {
                     f64 func_us = 0;
                     SCOPE_EXIT { expl.filetime_to_string_culmulative_us += func_us; };
                     scoped_timer<timer_unit::MICROSECONDS> timer(&func_us);
-                    result = filetime_to_string(&dirent.basic.last_write_time_raw);
+                    g_date_time_format.format(last_write_time, column_text.last_write_time_text.data(), column_text.last_write_time_text.size());
+                    column_text.last_write_time = last_write_time;
                 }
-                imgui::TextUnformatted(result.second.data());
-                imgui::RenderTooltipWhenColumnTextTruncated(explorer_window::cwd_entries_table_col_last_write_time, result.second.data());
-            #endif
+                imgui::TextUnformatted(column_text.last_write_time_text.data());
+                imgui::RenderTooltipWhenColumnTextTruncated(explorer_window::cwd_entries_table_col_last_write_time, column_text.last_write_time_text.data());
             }
 
-            if (dirent.context_menu_active) {
+            if (ui.context_menu_active) {
                 retval.context_menu_target_row_rect.emplace(selectable_rect.Min, selectable_rect.Max);
             }
 
-            dirent.spotlight_frames_remaining -= (dirent.spotlight_frames_remaining > 0);
+            ui.spotlight_frames_remaining -= (ui.spotlight_frames_remaining > 0);
         }
     }
 
@@ -4292,32 +6010,39 @@ render_dirent_context_menu(explorer_window &expl, cwd_count_info const &cnt, swa
     render_dirent_context_menu_result retval = {};
 
     if (imgui::BeginPopup("## explorer context_menu")) {
-        if (cnt.selected_dirents <= 1) {
-            assert(expl.context_menu_target != nullptr);
+        //? Merges and change notifications reorder rows while the menu is open, look the target up again every frame.
+        u64 context_menu_target_row = expl.cwd_entries.find_id(expl.context_menu_target_id);
 
-            if ((path_ends_with(expl.context_menu_target->basic.path, ".exe") || path_ends_with(expl.context_menu_target->basic.path, ".bat"))
+        if (cnt.selected_dirents <= 1 && context_menu_target_row == u64(-1)) {
+            //? cwd_entries were refreshed while the menu was open, the target entry is gone
+            imgui::CloseCurrentPopup();
+        }
+        else if (cnt.selected_dirents <= 1) {
+            auto context_menu_target = expl.cwd_entries[context_menu_target_row];
+
+            if ((std::string_view(context_menu_target.name()).ends_with(".exe") || std::string_view(context_menu_target.name()).ends_with(".bat"))
                 && imgui::Selectable("Run as administrator"))
             {
                 // TODO: async
-                auto res = open_file(expl.context_menu_target->basic.path.data(), expl.cwd.data(), true);
+                auto res = open_file(context_menu_target.name(), expl.cwd.data(), true);
 
                 if (res.success) {
                     char const *full_file_path = res.error_or_utf8_path.c_str();
                     global_state::recent_files_update("Opened", full_file_path);
                     (void) global_state::recent_files_save_to_disk(nullptr);
                 } else {
-                    std::string action = make_str("Open file as administrator [%s].", expl.context_menu_target->basic.path.data());
+                    std::string action = make_str("Open file as administrator [%s].", context_menu_target.name());
                     char const *failed = res.error_or_utf8_path.c_str();
                     swan_popup_modals::open_error(action.c_str(), failed);
                 }
             }
 
-            if (expl.context_menu_target->basic.is_symlink_to_file() && imgui::Selectable("Open file location")) {
+            if (context_menu_target.is_symlink_to_file() && imgui::Selectable("Open file location")) {
                 symlink_data lnk_data = {};
-                auto extract_result = lnk_data.load(expl.context_menu_target->basic.path.data(), expl.cwd.data());
+                auto extract_result = lnk_data.load(context_menu_target.name(), expl.cwd.data());
 
                 if (!extract_result.success) {
-                    std::string action = make_str("Open file location of [%s].", expl.context_menu_target->basic.path.data());
+                    std::string action = make_str("Open file location of [%s].", context_menu_target.name());
                     char const *failed = extract_result.error_or_utf8_path.c_str();
                     swan_popup_modals::open_error(action.c_str(), failed);
                 } else {
@@ -4330,7 +6055,7 @@ render_dirent_context_menu(explorer_window &expl, cwd_count_info const &cnt, swa
                     {
                         std::scoped_lock lock(expl.select_cwd_entries_on_next_update_mutex);
                         expl.select_cwd_entries_on_next_update.clear();
-                        expl.select_cwd_entries_on_next_update.push_back(select_name_utf8);
+                        expl.select_cwd_entries_on_next_update.insert(select_name_utf8.data());
                     }
 
                     expl.advance_history(expl.cwd);
@@ -4345,11 +6070,11 @@ render_dirent_context_menu(explorer_window &expl, cwd_count_info const &cnt, swa
                 static progressive_task<std::optional<generic_result>> task = {};
 
                 if (imgui::Selectable("Open with...")) {
-                    global_state::thread_pool().push_task([&expl]() noexcept {
+                    global_state::thread_pool().push_task([&expl, target_name = path_create(context_menu_target.name())]() noexcept {
                         task.active_token.store(true);
 
                         // TODO: async
-                        auto res = open_file_with(expl.context_menu_target->basic.path.data(), expl.cwd.data());
+                        auto res = open_file_with(target_name.data(), expl.cwd.data());
 
                         std::scoped_lock lock(task.result_mutex);
                         task.result = res;
@@ -4365,7 +6090,7 @@ render_dirent_context_menu(explorer_window &expl, cwd_count_info const &cnt, swa
                         bool failed = !res.success && res.error_or_utf8_path != "The operation was canceled by the user.";
 
                         if (failed) {
-                            std::string action = make_str("Open [%s] with...", expl.context_menu_target->basic.path.data());
+                            std::string action = make_str("Open [%s] with...", context_menu_target.name());
                             std::string const &failure = res.error_or_utf8_path;
                             swan_popup_modals::open_error(action.c_str(), failure.c_str());
                         }
@@ -4375,15 +6100,15 @@ render_dirent_context_menu(explorer_window &expl, cwd_count_info const &cnt, swa
 
             if (imgui::Selectable("Reveal in WFE")) {
                 swan_path full_path = expl.cwd;
-                if (!path_append(full_path, expl.context_menu_target->basic.path.data(), L'\\', true)) {
-                    std::string action = make_str("Reveal [%s] in File Explorer.", expl.context_menu_target->basic.path.data());
+                if (!path_append(full_path, context_menu_target.name(), L'\\', true)) {
+                    std::string action = make_str("Reveal [%s] in File Explorer.", context_menu_target.name());
                     char const *failed = "Append name to current working directory exceeds maximum path length.";
                     swan_popup_modals::open_error(action.c_str(), failed);
                 }
                 else {
                     auto res = reveal_in_windows_file_explorer(full_path);
                     if (!res.success) {
-                        std::string action = make_str("Reveal [%s] in File Explorer.", expl.context_menu_target->basic.path.data());
+                        std::string action = make_str("Reveal [%s] in File Explorer.", context_menu_target.name());
                         char const *failed = res.error_or_utf8_path.c_str();
                         swan_popup_modals::open_error(action.c_str(), failed);
                     }
@@ -4394,7 +6119,7 @@ render_dirent_context_menu(explorer_window &expl, cwd_count_info const &cnt, swa
 
             auto handle_failure = [&](char const *operation, generic_result const &result) noexcept {
                 if (!result.success) {
-                    std::string action = make_str("%s [%s].", operation, expl.context_menu_target->basic.path.data());
+                    std::string action = make_str("%s [%s].", operation, context_menu_target.name());
                     char const *failed = result.error_or_utf8_path.c_str();
                     swan_popup_modals::open_error(action.c_str(), failed);
                 }
@@ -4405,7 +6130,7 @@ render_dirent_context_menu(explorer_window &expl, cwd_count_info const &cnt, swa
                     global_state::file_op_cmd_buf().clear();
                 }
                 expl.deselect_all_cwd_entries();
-                expl.context_menu_target->selected = true;
+                context_menu_target.set_selected(true);
                 auto result = add_selected_entries_to_file_op_payload(expl, "Cut", file_operation_type::move);
                 handle_failure("cut", result);
             }
@@ -4415,7 +6140,7 @@ render_dirent_context_menu(explorer_window &expl, cwd_count_info const &cnt, swa
                 }
 
                 expl.deselect_all_cwd_entries();
-                expl.context_menu_target->selected = true;
+                context_menu_target.set_selected(true);
 
                 auto result = add_selected_entries_to_file_op_payload(expl, "Copy", file_operation_type::copy);
                 handle_failure("copy", result);
@@ -4424,18 +6149,18 @@ render_dirent_context_menu(explorer_window &expl, cwd_count_info const &cnt, swa
             imgui::Separator();
 
             if (imgui::Selectable("Create shortcut" "## single")) {
-                swan_path lnk_path = expl.context_menu_target->basic.path;
+                swan_path lnk_path = path_create(context_menu_target.name(), context_menu_target.name_len());
                 // TODO add something to end of path to avoid overwriting existing .lnk file
 
                 if (!path_append(lnk_path, ".lnk")) {
-                    std::string action = make_str("Create link path for [%s].", expl.context_menu_target->basic.path.data());
+                    std::string action = make_str("Create link path for [%s].", context_menu_target.name());
                     char const *failed = "Max path length exceeded when appending [.lnk] to file name.";
                     swan_popup_modals::open_error(action.c_str(), failed);
                 }
                 else {
                     symlink_data lnk;
                     lnk.show_cmd = SW_SHOWDEFAULT;
-                    lnk.target_path_utf8 = expl.context_menu_target->basic.path;
+                    lnk.target_path_utf8 = path_create(context_menu_target.name(), context_menu_target.name_len());
                     cstr_clear(lnk.target_path_utf16);
                     cstr_clear(lnk.arguments_utf16);
                     cstr_clear(lnk.working_directory_path_utf16);
@@ -4448,7 +6173,7 @@ render_dirent_context_menu(explorer_window &expl, cwd_count_info const &cnt, swa
                     auto result = lnk.save(lnk_path.data(), expl.cwd.data());
 
                     if (!result.success) {
-                        std::string action = make_str("Create link file for [%s].", expl.context_menu_target->basic.path.data());
+                        std::string action = make_str("Create link file for [%s].", context_menu_target.name());
                         char const *failed = result.error_or_utf8_path.c_str();
                         swan_popup_modals::open_error(action.c_str(), failed);
                     }
@@ -4456,7 +6181,7 @@ render_dirent_context_menu(explorer_window &expl, cwd_count_info const &cnt, swa
             }
             if (imgui::Selectable("Delete" "## single")) {
                 expl.deselect_all_cwd_entries();
-                expl.context_menu_target->selected = true;
+                context_menu_target.set_selected(true);
 
                 imgui::OpenConfirmationModalWithCallback(
                     /* confirmation_id  = */ swan_id_confirm_explorer_execute_delete,
@@ -4478,7 +6203,7 @@ render_dirent_context_menu(explorer_window &expl, cwd_count_info const &cnt, swa
             }
             if (imgui::Selectable("Rename" "## single")) {
                 retval.open_single_rename_popup = true;
-                retval.single_dirent_to_be_renamed = expl.context_menu_target;
+                retval.single_dirent_to_be_renamed = context_menu_target.basic();
             }
 
             imgui::Separator();
@@ -4491,8 +6216,8 @@ render_dirent_context_menu(explorer_window &expl, cwd_count_info const &cnt, swa
 
             if (imgui::Selectable("Properties")) {
                 swan_path full_path = path_create(expl.cwd.data());
-                if (!path_append(full_path, expl.context_menu_target->basic.path.data(), settings.dir_separator_utf8, true)) {
-                    std::string action = make_str("Open properties of [%s].", expl.context_menu_target->basic.path.data());
+                if (!path_append(full_path, context_menu_target.name(), settings.dir_separator_utf8, true)) {
+                    std::string action = make_str("Open properties of [%s].", context_menu_target.name());
                     char const *failed = "Max path length exceeded when appending name to current working directory path.";
                     swan_popup_modals::open_error(action.c_str(), failed);
                 } else {
@@ -4503,12 +6228,12 @@ render_dirent_context_menu(explorer_window &expl, cwd_count_info const &cnt, swa
 
             if (imgui::BeginMenu("Copy metadata")) {
                 if (imgui::Selectable("Name")) {
-                    imgui::SetClipboardText(expl.context_menu_target->basic.path.data());
+                    imgui::SetClipboardText(context_menu_target.name());
                 }
                 if (imgui::Selectable("Full path")) {
                     swan_path full_path = path_create(expl.cwd.data());
-                    if (!path_append(full_path, expl.context_menu_target->basic.path.data(), settings.dir_separator_utf8, true)) {
-                        std::string action = make_str("Copy full path of [%s].", expl.context_menu_target->basic.path.data());
+                    if (!path_append(full_path, context_menu_target.name(), settings.dir_separator_utf8, true)) {
+                        std::string action = make_str("Copy full path of [%s].", context_menu_target.name());
                         char const *failed = "Max path length exceeded when appending name to current working directory path.";
                         swan_popup_modals::open_error(action.c_str(), failed);
                     } else {
@@ -4516,10 +6241,10 @@ render_dirent_context_menu(explorer_window &expl, cwd_count_info const &cnt, swa
                     }
                 }
                 if (imgui::Selectable("Size in bytes")) {
-                    imgui::SetClipboardText(std::to_string(expl.context_menu_target->basic.size).c_str());
+                    imgui::SetClipboardText(std::to_string(context_menu_target.size()).c_str());
                 }
                 if (imgui::Selectable("Formatted size")) {
-                    auto formatted_size = format_file_size(expl.context_menu_target->basic.size, settings.size_unit_multiplier);
+                    auto formatted_size = format_file_size(context_menu_target.size(), settings.size_unit_multiplier);
                     imgui::SetClipboardText(formatted_size.data());
                 }
 
@@ -4567,9 +6292,9 @@ render_dirent_context_menu(explorer_window &expl, cwd_count_info const &cnt, swa
                 if (imgui::Selectable("Names")) {
                     std::string clipboard = {};
 
-                    for (auto const &dirent : expl.cwd_entries) {
-                        if (dirent.selected && !dirent.filtered) {
-                            clipboard += dirent.basic.path.data();
+                    for (auto dirent : expl.cwd_entries) {
+                        if (dirent.selected() && !dirent.filtered()) {
+                            clipboard += dirent.name();
                             clipboard += '\n';
                         }
                     }
@@ -4579,11 +6304,11 @@ render_dirent_context_menu(explorer_window &expl, cwd_count_info const &cnt, swa
                 if (imgui::Selectable("Full paths")) {
                     std::string clipboard = {};
 
-                    for (auto const &dirent : expl.cwd_entries) {
-                        if (dirent.selected && !dirent.filtered) {
+                    for (auto dirent : expl.cwd_entries) {
+                        if (dirent.selected() && !dirent.filtered()) {
                             swan_path full_path = path_create(expl.cwd.data());
-                            if (!path_append(full_path, dirent.basic.path.data(), settings.dir_separator_utf8, true)) {
-                                std::string action = make_str("Copy full path of [%s].", dirent.basic.path.data());
+                            if (!path_append(full_path, dirent.name(), settings.dir_separator_utf8, true)) {
+                                std::string action = make_str("Copy full path of [%s].", dirent.name());
                                 char const *failed = "Max path length exceeded when appending name to current working directory path.";
                                 swan_popup_modals::open_error(action.c_str(), failed);
                                 break;
@@ -4609,8 +6334,12 @@ render_dirent_context_menu(explorer_window &expl, cwd_count_info const &cnt, swa
         imgui::EndPopup();
     }
     else {
-        if (expl.context_menu_target != nullptr) {
-            expl.context_menu_target->context_menu_active = false;
+        if (expl.context_menu_target_id != UINT32_MAX) {
+            u64 context_menu_target_row = expl.cwd_entries.find_id(expl.context_menu_target_id);
+            if (context_menu_target_row != u64(-1)) {
+                expl.cwd_entries.ui[context_menu_target_row].context_menu_active = false;
+            }
+            expl.context_menu_target_id = UINT32_MAX;
         }
     }
 
@@ -4699,11 +6428,11 @@ bool find_in_swan_explorer_0(char const *full_path) noexcept
     {
         std::scoped_lock lock2(expl.select_cwd_entries_on_next_update_mutex);
         expl.select_cwd_entries_on_next_update.clear();
-        expl.select_cwd_entries_on_next_update.push_back(reveal_name_utf8);
+        expl.select_cwd_entries_on_next_update.insert(reveal_name_utf8.data());
     }
 
     swan_path containing_dir_utf8 = path_create(path_no_name_utf8.data(), path_no_name_utf8.size());
-    auto [containing_dir_exists, num_selected] = expl.update_cwd_entries(full_refresh, containing_dir_utf8.data());
+    auto [containing_dir_exists, num_selected] = expl.update_cwd_entries(full_refresh_blocking, containing_dir_utf8.data());
 
     if (!containing_dir_exists) {
         std::string action = make_str("Find [%s] in Explorer %d.", full_path, expl.id+1);
@@ -92,7 +92,7 @@ HRESULT explorer_file_op_progress_sink::PostMoveItem(
     if (dst_expl_cwd_same) {
         // Avoid asking the receiving explorer to select the moved item on refresh if the explorer has since changed cwd
         std::scoped_lock lock(dst_expl.select_cwd_entries_on_next_update_mutex);
-        dst_expl.select_cwd_entries_on_next_update.push_back(new_name_utf8);
+        dst_expl.select_cwd_entries_on_next_update.insert(new_name_utf8.data());
     }
 
     path_force_separator(src_path_utf8, this->dir_sep_utf8);
@@ -317,7 +317,7 @@ HRESULT explorer_file_op_progress_sink::PostCopyItem(
     if (dst_expl_cwd_same) {
         // Avoid asking the receiving explorer to select the moved item on refresh if the explorer has since changed cwd
         std::scoped_lock lock(dst_expl.select_cwd_entries_on_next_update_mutex);
-        dst_expl.select_cwd_entries_on_next_update.push_back(new_name_utf8);
+        dst_expl.select_cwd_entries_on_next_update.insert(new_name_utf8.data());
     }
 
     path_force_separator(src_path_utf8, global_state::settings().dir_separator_utf8);
@@ -21,17 +21,11 @@ void erase(global_state::completed_file_operations &obj,
            std::deque<completed_file_operation>::iterator first,
            std::deque<completed_file_operation>::iterator last) noexcept
 {
-    for (auto iter = first; iter != last; ++iter) {
-        if (iter->src_icon_GLtexID > 0) delete_icon_texture(iter->src_icon_GLtexID, "completed_file_operation");
-        if (iter->dst_icon_GLtexID > 0) delete_icon_texture(iter->dst_icon_GLtexID, "completed_file_operation");
-    }
-    obj.container->erase(first, last);
+    obj.container->erase(first, last); // icon handles release their cache entries
 }
 
 void pop_back(global_state::completed_file_operations &obj) noexcept
 {
-    if (obj.container->back().src_icon_GLtexID > 0) delete_icon_texture(obj.container->back().src_icon_GLtexID, "completed_file_operation");
-    if (obj.container->back().dst_icon_GLtexID > 0) delete_icon_texture(obj.container->back().dst_icon_GLtexID, "completed_file_operation");
     obj.container->pop_back();
 }
 
@@ -186,10 +180,8 @@ completed_file_operation::completed_file_operation() noexcept
 
 completed_file_operation::completed_file_operation(time_point_system_t completion_time, time_point_system_t undo_time, file_operation_type op_type,
                                                    char const *src, char const *dst, basic_dirent::kind obj_type, u32 group_id) noexcept
-    : src_icon_GLtexID(0)
-    , dst_icon_GLtexID(0)
-    , src_icon_size()
-    , dst_icon_size()
+    : src_icon()
+    , dst_icon()
     , completion_time(completion_time)
     , undo_time(undo_time)
     , group_id(group_id)
@@ -202,10 +194,8 @@ completed_file_operation::completed_file_operation(time_point_system_t completio
 }
 
 completed_file_operation::completed_file_operation(completed_file_operation const &other) noexcept
-    : src_icon_GLtexID(other.src_icon_GLtexID)
-    , dst_icon_GLtexID(other.dst_icon_GLtexID)
-    , src_icon_size(other.src_icon_size)
-    , dst_icon_size(other.dst_icon_size)
+    : src_icon(other.src_icon)
+    , dst_icon(other.dst_icon)
     , completion_time(other.completion_time)
     , undo_time(other.undo_time)
     , group_id(other.group_id)
@@ -219,10 +209,8 @@ completed_file_operation::completed_file_operation(completed_file_operation cons
 
 completed_file_operation &completed_file_operation::operator=(completed_file_operation const &other) noexcept // for boost::circular_buffer
 {
-    this->src_icon_GLtexID = other.src_icon_GLtexID;
-    this->dst_icon_GLtexID = other.dst_icon_GLtexID;
-    this->src_icon_size = other.src_icon_size;
-    this->dst_icon_size = other.dst_icon_size;
+    this->src_icon = other.src_icon;
+    this->dst_icon = other.dst_icon;
     this->completion_time = other.completion_time;
     this->undo_time = other.undo_time;
     this->group_id = other.group_id;
@@ -692,23 +680,27 @@ bool swan_windows::render_file_operations(bool &open, bool any_popups_open) noex
                 char const *src_path = settings.file_operations_src_path_full ? file_op.src_path.data() : path_find_filename(file_op.src_path.data());
 
                 if (global_state::settings().win32_file_icons) {
-                    if (file_op.src_icon_GLtexID == 0) {
-                        std::tie(file_op.src_icon_GLtexID, file_op.src_icon_size) = load_icon_texture(file_op.src_path.data(), 0, "completed_file_operation");
-                        if (file_op.src_icon_GLtexID > 0) {
-                            s_last_known_icon_size = file_op.src_icon_size;
-                        }
+                    if (file_op.src_icon.empty()) {
+                        file_op.src_icon = global_state::icons().acquire(file_op.src_path.data(), file_op.obj_type == basic_dirent::kind::directory);
+                    }
+                    icon_view icon = global_state::icons().view(file_op.src_icon);
+                    if (!icon.ready()) {
+                        icon = global_state::icons().view(file_op.dst_icon);
+                    }
+                    if (icon.ready()) {
+                        s_last_known_icon_size = icon.size;
                     }
-                    auto const &icon_size = file_op.src_icon_GLtexID < 1 ? s_last_known_icon_size : file_op.src_icon_size;
+                    auto const &icon_size = icon.ready() ? icon.size : s_last_known_icon_size;
 
                     if (file_op.op_type == file_operation_type::move) {
-                        imgui::Image((ImTextureID)(file_op.src_icon_GLtexID > 0 ? file_op.src_icon_GLtexID : file_op.dst_icon_GLtexID), icon_size, ImVec2(0,0), ImVec2(1,1), ImVec4(1,1,1,.3f));
+                        imgui::Image((ImTextureID)icon.texture, icon_size, icon.uv0, icon.uv1, ImVec4(1,1,1,.3f));
                     } else if (file_op.op_type == file_operation_type::del) {
-                        imgui::Image((ImTextureID)(file_op.src_icon_GLtexID > 0 ? file_op.src_icon_GLtexID : file_op.dst_icon_GLtexID), icon_size, ImVec2(0,0), ImVec2(1,1), ImVec4(1,1,1,.5f));
+                        imgui::Image((ImTextureID)icon.texture, icon_size, icon.uv0, icon.uv1, ImVec4(1,1,1,.5f));
                         auto icon_rect = imgui::GetItemRect();
                         imgui::GetWindowDrawList()->AddLine(icon_rect.GetTL(), icon_rect.GetBR(), imgui::ImVec4_to_ImU32(error_color(), true), 1);
                     } else {
                         // file_operation_type::copy
-                        imgui::Image((ImTextureID)(file_op.src_icon_GLtexID > 0 ? file_op.src_icon_GLtexID : file_op.dst_icon_GLtexID), icon_size);
+                        imgui::Image((ImTextureID)icon.texture, icon_size, icon.uv0, icon.uv1);
                     }
                 }
                 else { // fallback to generic icons
@@ -767,7 +759,7 @@ bool swan_windows::render_file_operations(bool &open, bool any_popups_open) noex
             }
             if (imgui::TableGetHoveredColumn() == file_ops_table_col_src_path && imgui::IsItemHovered() && io.KeyShift) {
                 if (imgui::BeginTooltip()) {
-                    render_path_with_stylish_separators(file_op.src_path.data(), appropriate_icon(file_op.src_icon_GLtexID, file_op.obj_type));
+                    render_path_with_stylish_separators(file_op.src_path.data(), appropriate_icon(file_op.src_icon, file_op.obj_type));
                     imgui::EndTooltip();
                 }
             }
@@ -776,22 +768,20 @@ bool swan_windows::render_file_operations(bool &open, bool any_popups_open) noex
                 if (global_state::settings().win32_file_icons) {
                     bool is_restored = file_op.undone() && file_op.op_type == file_operation_type::del;
                     if (is_restored) {
-                        if (file_op.dst_icon_GLtexID > 0) {
-                            delete_icon_texture(file_op.dst_icon_GLtexID);
-                            file_op.dst_icon_GLtexID = -1;
-                        }
+                        // TODO investigate weirdness where restored record has a valid dst_path and returns valid icon (I expect none).
+                        // For now we detect manually and never show one
+                        file_op.dst_icon.reset();
                     }
-                    if (file_op.dst_icon_GLtexID == 0 && !is_restored) {
-                        // TODO investigate weirdness where restored record has a valid dst_path and returns valid icon (I expect -1).
-                        // For now we detect manually and force it to -1
-                        std::tie(file_op.dst_icon_GLtexID, file_op.dst_icon_size) = load_icon_texture(file_op.dst_path.data(), 0, "completed_file_operation");
-                        if (file_op.dst_icon_GLtexID > 0) {
-                            s_last_known_icon_size = file_op.dst_icon_size;
-                        }
+                    else if (file_op.dst_icon.empty() && !path_is_empty(file_op.dst_path)) {
+                        file_op.dst_icon = global_state::icons().acquire(file_op.dst_path.data(), file_op.obj_type == basic_dirent::kind::directory);
                     }
                     if (!path_is_empty(file_op.dst_path)) {
-                        auto const &icon_size = file_op.dst_icon_GLtexID < 1 ? s_last_known_icon_size : file_op.dst_icon_size;
-                        ImGui::Image((ImTextureID)std::max(file_op.dst_icon_GLtexID, s64(0)), icon_size);
+                        icon_view icon = global_state::icons().view(file_op.dst_icon);
+                        if (icon.ready()) {
+                            s_last_known_icon_size = icon.size;
+                        }
+                        auto const &icon_size = icon.ready() ? icon.size : s_last_known_icon_size;
+                        ImGui::Image((ImTextureID)icon.texture, icon_size, icon.uv0, icon.uv1);
                         imgui::SameLine();
                     }
                 }
@@ -809,7 +799,7 @@ bool swan_windows::render_file_operations(bool &open, bool any_popups_open) noex
                 ImRect cell_rect = imgui::TableGetCellBgRect(imgui::GetCurrentTable(), file_ops_table_col_dst_path);
                 if (imgui::IsMouseHoveringRect(cell_rect) && io.KeyShift) {
                     if (imgui::BeginTooltip() && !path_is_empty(file_op.dst_path)) {
-                        render_path_with_stylish_separators(file_op.dst_path.data(), appropriate_icon(file_op.dst_icon_GLtexID, file_op.obj_type));
+                        render_path_with_stylish_separators(file_op.dst_path.data(), appropriate_icon(file_op.dst_icon, file_op.obj_type));
                         imgui::EndTooltip();
                     }
                 }
@@ -908,10 +898,8 @@ bool swan_windows::render_file_operations(bool &open, bool any_popups_open) noex
                                 }
                             }
                         }
-                        std::tie(context_target.src_icon_GLtexID, context_target.src_icon_size) = load_icon_texture(context_target.src_path.data(), 0, "completed_file_operation");
-                        if (context_target.src_icon_GLtexID > 0) {
-                            s_last_known_icon_size = context_target.src_icon_size;
-                        }
+                        context_target.src_icon.reset(); // restored, so a failed lookup of the missing file is retried
+                        context_target.src_icon = global_state::icons().acquire(context_target.src_path.data(), context_target.obj_type == basic_dirent::kind::directory);
                     }
                 }
             }
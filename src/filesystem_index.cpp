@@ -0,0 +1,664 @@
+#include "filesystem_index.hpp"
+
+#if !defined(_WIN32)
+#   include <algorithm>
+#   include <chrono>
+#   include <cstring>
+#   include <fcntl.h>
+#   include <fstream>
+#   include <mutex>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+static_assert(sizeof(filesystem_index::entry) == 32);
+
+static
+bool is_path_separator(char ch) noexcept
+{
+    return ch == '\\' || ch == '/';
+}
+
+/// Calls `on_component` for every non-empty component of `path`, stopping early if it returns false.
+template <typename Fn>
+static
+bool for_each_component(std::string_view path, Fn &&on_component) noexcept
+{
+    u64 start = 0;
+    while (start < path.size()) {
+        u64 end = start;
+        while (end < path.size() && !is_path_separator(path[end])) ++end;
+        if (end > start && !on_component(path.substr(start, end - start), end)) {
+            return false;
+        }
+        start = end + 1;
+    }
+    return true;
+}
+
+static
+void append_component(std::string &path, char separator, std::string_view name) noexcept
+{
+    if (!path.empty() && !is_path_separator(path.back())) {
+        path += separator;
+    }
+    path += name;
+}
+
+static
+u64 microseconds_since(std::chrono::steady_clock::time_point start) noexcept
+{
+    return u64(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+bool filesystem_index::build(std::string_view root_utf8, directory_traversal const &traversal) noexcept
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::string root_path(root_utf8);
+    directory_entry root_info = {};
+    if (!query_path(root_path.c_str(), root_info) || root_info.kind != directory_entry_kind::directory) {
+        return false;
+    }
+
+    std::vector<entry> new_entries = {};
+    std::vector<char> new_names = {};
+    new_entries.push_back({ 0, root_info.last_write_time, not_found, 0, 0, directory_entry_kind::directory, 0, 0 });
+
+    //? Workers only know the path of the directory they listed, this maps it back to its entry. It only lives for the walk,
+    //? the index itself never stores a full path.
+    std::unordered_map<std::string, u32> directory_entries = {};
+    directory_entries.emplace(root_path, root_entry);
+    std::mutex mutex = {};
+    std::string sub_directory = {};
+    bool consistent = true;
+
+    traversal.run({ root_path }, [&](u64, std::string_view directory_utf8, directory_entry_batch const &batch) noexcept {
+        std::scoped_lock lock(mutex);
+
+        auto parent = directory_entries.find(std::string(directory_utf8));
+        if (parent == directory_entries.end()) {
+            consistent = false;
+            return;
+        }
+        u32 parent_idx = parent->second;
+
+        for (auto const &e : batch.entries) {
+            auto name = batch.name_view(e);
+            u32 idx = u32(new_entries.size());
+
+            new_entries.push_back({ e.size, e.last_write_time, parent_idx, u32(new_names.size()), u16(name.size()), e.kind, 0, 0 });
+            new_names.insert(new_names.end(), name.begin(), name.end());
+
+            if (e.kind == directory_entry_kind::directory && !e.link) {
+                sub_directory = directory_utf8;
+                if (!sub_directory.empty() && sub_directory.back() != traversal.separator) {
+                    sub_directory += traversal.separator;
+                }
+                sub_directory += name;
+                directory_entries.emplace(sub_directory, idx);
+            }
+        }
+    });
+
+    if (traversal.cancelled() || !consistent) {
+        return false;
+    }
+
+    this->close();
+    this->owned_entries = std::move(new_entries);
+    this->owned_names = std::move(new_names);
+    this->use_owned();
+    this->root = std::move(root_path);
+    this->separator = traversal.separator;
+    this->index_names();
+    this->trigrams.shrink_to_fit();
+    this->build_us = microseconds_since(start);
+    return true;
+}
+
+void filesystem_index::close() noexcept
+{
+    this->unmap();
+    this->owned_entries = {};
+    this->owned_names = {};
+    this->entries = nullptr;
+    this->num_entries = 0;
+    this->names = nullptr;
+    this->names_size = 0;
+    this->root.clear();
+    this->build_us = 0;
+    this->file_size = 0;
+    this->num_changes_applied = 0;
+    this->sorted_children = {};
+    this->added_children = {};
+    this->children_indexed = false;
+    this->trigrams.clear();
+}
+
+void filesystem_index::unmap() noexcept
+{
+#if defined(_WIN32)
+    if (this->view != nullptr) UnmapViewOfFile(this->view);
+    if (this->mapping_handle != NULL) CloseHandle(this->mapping_handle);
+    if (this->file_handle != INVALID_HANDLE_VALUE) CloseHandle(this->file_handle);
+    this->mapping_handle = NULL;
+    this->file_handle = INVALID_HANDLE_VALUE;
+#else
+    if (this->view != nullptr) munmap(const_cast<void *>(this->view), this->view_size);
+    if (this->file_fd != -1) ::close(this->file_fd);
+    this->file_fd = -1;
+#endif
+    this->view = nullptr;
+    this->view_size = 0;
+}
+
+void filesystem_index::use_owned() noexcept
+{
+    this->entries = this->owned_entries.data();
+    this->num_entries = this->owned_entries.size();
+    this->names = this->owned_names.data();
+    this->names_size = this->owned_names.size();
+}
+
+void filesystem_index::make_owned() noexcept
+{
+    if (this->view == nullptr) {
+        return;
+    }
+    this->owned_entries.assign(this->entries, this->entries + this->num_entries);
+    this->owned_names.assign(this->names, this->names + this->names_size);
+    this->unmap();
+    this->use_owned();
+}
+
+bool filesystem_index::load(std::filesystem::path const &file_path) noexcept
+{
+    this->close();
+
+    u64 size = 0;
+    void const *mapped = nullptr;
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileW(file_path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER file_size_ = {};
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &file_size_) && u64(file_size_.QuadPart) >= header_size) {
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    if (mapping != NULL) {
+        mapped = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+    this->file_handle = file;
+    this->mapping_handle = mapping;
+    size = u64(file_size_.QuadPart);
+#else
+    s32 fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat info = {};
+    if (fstat(fd, &info) == 0 && u64(info.st_size) >= header_size) {
+        void *m = mmap(nullptr, u64(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        mapped = m == MAP_FAILED ? nullptr : m;
+    }
+    this->file_fd = fd;
+    size = u64(info.st_size);
+#endif
+
+    if (mapped == nullptr) {
+        this->unmap();
+        return false;
+    }
+    this->view = mapped;
+    this->view_size = size;
+
+    auto const *bytes = static_cast<char const *>(mapped);
+    auto read_u64 = [&](u64 offset) noexcept { u64 v; memcpy(&v, bytes + offset, sizeof(v)); return v; };
+    auto read_u32 = [&](u64 offset) noexcept { u32 v; memcpy(&v, bytes + offset, sizeof(v)); return v; };
+
+    u64 count = read_u64(16);
+    u64 names_bytes = read_u64(24);
+    u64 root_len = read_u64(32);
+    u64 entries_offset = header_size + ((root_len + 7) & ~u64(7));
+
+    //? Every size is checked against the file before it's multiplied or added, a truncated or foreign file must not wrap around.
+    bool valid = read_u64(0) == magic && read_u32(8) == version
+        && count >= 1 && count <= u64(not_found)
+        && root_len <= size && entries_offset <= size
+        && count <= (size - entries_offset) / sizeof(entry)
+        && names_bytes == size - entries_offset - count * sizeof(entry)
+        && names_bytes <= UINT32_MAX;
+
+    if (valid) {
+        auto const *mapped_entries = reinterpret_cast<entry const *>(bytes + entries_offset);
+
+        valid = mapped_entries[0].parent == not_found && mapped_entries[0].kind == directory_entry_kind::directory;
+
+        for (u64 i = 1; valid && i < count; ++i) {
+            entry const &e = mapped_entries[i];
+            valid = e.parent < i && u64(e.name_offset) + e.name_len <= names_bytes
+                && mapped_entries[e.parent].kind == directory_entry_kind::directory;
+        }
+        if (valid) {
+            this->entries = mapped_entries;
+            this->num_entries = count;
+            this->names = bytes + entries_offset + count * sizeof(entry);
+            this->names_size = names_bytes;
+            this->root.assign(bytes + header_size, root_len);
+            this->separator = char(read_u32(12));
+            this->build_us = read_u64(40);
+            this->file_size = size;
+        }
+    }
+    if (!valid) {
+        this->close();
+    }
+    return valid;
+}
+
+bool filesystem_index::save(std::filesystem::path const &file_path) noexcept
+try {
+    if (this->num_entries == 0) {
+        return false;
+    }
+
+    //? Compacting keeps the parent before child order: a parent's new index is known by the time its children are reached.
+    std::vector<entry> kept_entries = {};
+    std::vector<char> kept_names = {};
+    std::vector<u32> new_index(this->num_entries, not_found);
+    kept_entries.reserve(this->num_entries);
+    kept_names.reserve(this->names_size);
+
+    for (u64 i = 0; i < this->num_entries; ++i) {
+        entry e = this->entries[i];
+        u32 new_parent = i == root_entry ? not_found : new_index[e.parent];
+        if (e.removed || (i != root_entry && new_parent == not_found)) {
+            continue;
+        }
+        auto n = this->name(u32(i));
+        new_index[i] = u32(kept_entries.size());
+        e.parent = new_parent;
+        e.name_offset = u32(kept_names.size());
+        kept_entries.push_back(e);
+        kept_names.insert(kept_names.end(), n.begin(), n.end());
+    }
+
+    bool renumbered = kept_entries.size() != this->num_entries;
+    bool trigrams_complete = this->trigrams.end_id >= this->num_entries;
+
+    //? The file being replaced may be the one mapped, so the entries move to memory first.
+    this->unmap();
+    this->owned_entries = std::move(kept_entries);
+    this->owned_names = std::move(kept_names);
+    this->use_owned();
+    this->sorted_children = {};
+    this->added_children = {};
+    this->children_indexed = false;
+
+    if (renumbered) {
+        this->trigrams.clear();
+        if (trigrams_complete) {
+            this->index_names();
+            this->trigrams.shrink_to_fit();
+        }
+    }
+
+    std::vector<char> header(header_size + ((this->root.size() + 7) & ~u64(7)), 0);
+    u32 separator_ = u32(u8(this->separator));
+    u64 root_len = this->root.size();
+    memcpy(header.data() + 0, &magic, sizeof(magic));
+    memcpy(header.data() + 8, &version, sizeof(version));
+    memcpy(header.data() + 12, &separator_, sizeof(separator_));
+    memcpy(header.data() + 16, &this->num_entries, sizeof(u64));
+    memcpy(header.data() + 24, &this->names_size, sizeof(u64));
+    memcpy(header.data() + 32, &root_len, sizeof(root_len));
+    memcpy(header.data() + 40, &this->build_us, sizeof(u64));
+    memcpy(header.data() + header_size, this->root.data(), root_len);
+
+    std::filesystem::path temp_path = file_path;
+    temp_path += ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        file.write(header.data(), std::streamsize(header.size()));
+        file.write(reinterpret_cast<char const *>(this->entries), std::streamsize(this->num_entries * sizeof(entry)));
+        file.write(this->names, std::streamsize(this->names_size));
+        if (!file) {
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp_path, file_path, error);
+    if (error) {
+        return false;
+    }
+
+    this->file_size = header.size() + this->num_entries * sizeof(entry) + this->names_size;
+    return true;
+}
+catch (...) {
+    return false;
+}
+
+bool filesystem_index::alive(u32 idx) const noexcept
+{
+    for (; idx != not_found; idx = this->entries[idx].parent) {
+        if (this->entries[idx].removed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool filesystem_index::path_of(u32 idx, std::string &out) const noexcept
+{
+    if (idx >= this->num_entries || !this->alive(idx)) {
+        return false;
+    }
+
+    u32 chain[256];
+    u64 depth = 0;
+    for (u32 i = idx; i != root_entry; i = this->entries[i].parent) {
+        if (depth == std::size(chain)) {
+            return false;
+        }
+        chain[depth++] = i;
+    }
+
+    out = this->root;
+    while (depth > 0) {
+        u32 i = chain[--depth];
+        if (!out.empty() && out.back() != this->separator) {
+            out += this->separator;
+        }
+        out += this->name(i);
+    }
+    return true;
+}
+
+u32 filesystem_index::find(std::string_view path_utf8) const noexcept
+{
+    if (this->num_entries == 0) {
+        return not_found;
+    }
+
+    //? Drive letters and the like come in whatever case they were typed in, only the root is compared case insensitively.
+    std::string_view root_ = this->root;
+    while (!root_.empty() && is_path_separator(root_.back())) root_.remove_suffix(1);
+
+    if (path_utf8.size() < root_.size()) {
+        return not_found;
+    }
+    for (u64 i = 0; i < root_.size(); ++i) {
+        char a = path_utf8[i], b = root_[i];
+        bool same = a == b || (is_path_separator(a) && is_path_separator(b))
+            || (a >= 'A' && a <= 'Z' && a - 'A' + 'a' == b) || (b >= 'A' && b <= 'Z' && b - 'A' + 'a' == a);
+        if (!same) {
+            return not_found;
+        }
+    }
+
+    std::string_view rest = path_utf8.substr(root_.size());
+    if (!rest.empty() && !is_path_separator(rest.front())) {
+        return not_found; // "C:\foo" is not under "C:\f"
+    }
+
+    u32 idx = root_entry;
+    for_each_component(rest, [&](std::string_view component, u64) noexcept {
+        idx = this->find_child(idx, component);
+        return idx != not_found;
+    });
+    return idx;
+}
+
+u64 filesystem_index::child_key(u32 parent, std::string_view name) noexcept
+{
+    u64 hash = 0xcbf29ce484222325;
+    for (char ch : name) {
+        hash ^= u8(ch);
+        hash *= 0x100000001b3;
+    }
+    return hash ^ (u64(parent) * 0x9E3779B97F4A7C15);
+}
+
+void filesystem_index::index_children() const noexcept
+{
+    this->sorted_children.clear();
+    this->sorted_children.reserve(this->num_entries);
+    for (u64 i = 1; i < this->num_entries; ++i) {
+        this->sorted_children.emplace_back(child_key(this->entries[i].parent, this->name(u32(i))), u32(i));
+    }
+    std::sort(this->sorted_children.begin(), this->sorted_children.end());
+    this->added_children.clear();
+    this->children_indexed = true;
+}
+
+u32 filesystem_index::find_child(u32 parent, std::string_view name) const noexcept
+{
+    if (!this->children_indexed) {
+        this->index_children();
+    }
+
+    u64 key = child_key(parent, name);
+    auto matches = [&](u32 idx) noexcept {
+        entry const &e = this->entries[idx];
+        return e.parent == parent && !e.removed && this->name(idx) == name;
+    };
+
+    //? Entries replaced by one of another kind stay until the next save, the live one is the one not removed.
+    auto first = std::lower_bound(this->sorted_children.begin(), this->sorted_children.end(), std::make_pair(key, u32(0)));
+    for (auto it = first; it != this->sorted_children.end() && it->first == key; ++it) {
+        if (matches(it->second)) return it->second;
+    }
+    auto [added_first, added_last] = this->added_children.equal_range(key);
+    for (auto it = added_first; it != added_last; ++it) {
+        if (matches(it->second)) return it->second;
+    }
+    return not_found;
+}
+
+u32 filesystem_index::append(u32 parent, std::string_view name, directory_entry const &info) noexcept
+{
+    u32 idx = u32(this->owned_entries.size());
+    this->owned_entries.push_back({ info.size, info.last_write_time, parent, u32(this->owned_names.size()), u16(name.size()), info.kind, 0, 0 });
+    this->owned_names.insert(this->owned_names.end(), name.begin(), name.end());
+    this->use_owned();
+
+    if (this->children_indexed) {
+        this->added_children.emplace(child_key(parent, name), idx);
+    }
+    if (this->trigrams.end_id == idx) {
+        this->trigrams.add(idx, name);
+    }
+    return idx;
+}
+
+void filesystem_index::append_subtree(u32 directory_idx, std::string const &directory_path) noexcept
+{
+    //? Serial, changes rarely bring whole trees with them, and when they do it's a copy or move the user is waiting on anyway.
+    std::vector<std::pair<u32, std::string>> pending = { { directory_idx, directory_path } };
+    directory_entry_batch batch = {};
+
+    while (!pending.empty()) {
+        auto [parent, path] = std::move(pending.back());
+        pending.pop_back();
+
+        directory_enumerator enumerator;
+        if (!enumerator.open(path.c_str())) {
+            continue;
+        }
+        while (enumerator.next_batch(batch) > 0) {
+            for (auto const &e : batch.entries) {
+                auto name = batch.name_view(e);
+                u32 child = this->append(parent, name, e);
+                if (e.kind == directory_entry_kind::directory && !e.link) {
+                    std::string child_path = path;
+                    append_component(child_path, this->separator, name);
+                    pending.emplace_back(child, std::move(child_path));
+                }
+            }
+        }
+    }
+}
+
+void filesystem_index::apply_change(std::string_view relative_path_utf8) noexcept
+{
+    if (this->num_entries == 0) {
+        return;
+    }
+
+    std::string full_path = this->root;
+    u32 parent = root_entry;
+    u32 idx = root_entry;
+    std::string_view last = {};
+    bool parent_missing = false;
+
+    for_each_component(relative_path_utf8, [&](std::string_view component, u64 end) noexcept {
+        if (!last.empty()) {
+            parent = idx;
+            if (parent == not_found || this->entries[parent].kind != directory_entry_kind::directory) {
+                //? A notification for something inside a directory the index doesn't know yet (its own notification was lost,
+                //? or is still to come): adding the directory brings everything in it along.
+                parent_missing = true;
+                this->apply_change(relative_path_utf8.substr(0, end - component.size() - 1));
+                return false;
+            }
+        }
+        append_component(full_path, this->separator, component);
+        idx = this->find_child(parent, component);
+        last = component;
+        return true;
+    });
+
+    if (parent_missing || last.empty()) {
+        return;
+    }
+
+    directory_entry info = {};
+    bool exists = query_path(full_path.c_str(), info);
+
+    if (!exists) {
+        if (idx != not_found) {
+            this->make_owned();
+            this->owned_entries[idx].removed = 1;
+            ++this->num_changes_applied;
+        }
+        return;
+    }
+
+    this->make_owned();
+
+    if (idx != not_found && this->entries[idx].kind == info.kind) {
+        this->owned_entries[idx].size = info.size;
+        this->owned_entries[idx].last_write_time = info.last_write_time;
+    } else {
+        if (idx != not_found) {
+            this->owned_entries[idx].removed = 1;
+        }
+        std::string name(last); // `last` may point into the names about to grow
+        u32 added = this->append(parent, name, info);
+        if (info.kind == directory_entry_kind::directory && !info.link) {
+            this->append_subtree(added, full_path);
+        }
+    }
+    ++this->num_changes_applied;
+}
+
+void filesystem_index::index_names() noexcept
+{
+    for (u64 i = this->trigrams.end_id; i < this->num_entries; ++i) {
+        this->trigrams.add(u32(i), this->name(u32(i)));
+    }
+}
+
+u64 filesystem_index::search(substring_matcher const &matcher, u32 scope, std::atomic_bool const *cancellation_token,
+                             std::function<void (u32, u64, u64)> const &on_match) const noexcept
+{
+    //? The trigrams fold ASCII case, only a needle folded beyond ASCII can't be narrowed by them.
+    trigram_query query = trigram_query::for_substring(matcher.needle, !matcher.unicode_fold);
+
+    return this->search_candidates(query, [&](std::string_view name, u64 &match_start, u64 &match_len) noexcept {
+        match_start = matcher.find(name, &match_len);
+        return match_start != substring_matcher::not_found;
+    }, scope, cancellation_token, on_match);
+}
+
+u64 filesystem_index::search(name_pattern const &pattern, trigram_query const &query, u32 scope, std::atomic_bool const *cancellation_token,
+                             std::function<void (u32, u64, u64)> const &on_match) const noexcept
+{
+    return this->search_candidates(query, [&](std::string_view name, u64 &match_start, u64 &match_len) noexcept {
+        match_start = 0;
+        match_len = name.size();
+        return pattern.matches(name);
+    }, scope, cancellation_token, on_match);
+}
+
+u64 filesystem_index::search_candidates(trigram_query const &query, std::function<bool (std::string_view, u64 &, u64 &)> const &matches,
+                                        u32 scope, std::atomic_bool const *cancellation_token,
+                                        std::function<void (u32, u64, u64)> const &on_match) const noexcept
+{
+    if (scope >= this->num_entries) {
+        return 0;
+    }
+
+    //? Per directory: 0 not yet known, 1 alive and at or below `scope`, 2 otherwise. Worked out once per directory, by walking up
+    //? until a known one, so the scan stays linear however deep the tree.
+    std::vector<u8> state(this->num_entries, 0);
+    std::vector<u32> walked = {};
+
+    auto in_scope = [&](u32 directory) noexcept {
+        u32 d = directory;
+        u8 verdict;
+        walked.clear();
+        for (;;) {
+            if (state[d] != 0) { verdict = state[d]; break; }
+            walked.push_back(d);
+            if (this->entries[d].removed) { verdict = 2; break; }
+            if (d == scope) { verdict = 1; break; }
+            if (this->entries[d].parent == not_found) { verdict = 2; break; }
+            d = this->entries[d].parent;
+        }
+        for (u32 w : walked) state[w] = verdict;
+        return verdict == 1;
+    };
+
+    u64 num_looked_at = 0;
+
+    auto look_at = [&](u64 i) noexcept {
+        ++num_looked_at;
+
+        entry const &e = this->entries[i];
+        if (e.removed) {
+            return;
+        }
+        u64 match_start = 0, match_len = 0;
+        if (!matches({ this->names + e.name_offset, e.name_len }, match_start, match_len) || !in_scope(e.parent)) {
+            return;
+        }
+        on_match(u32(i), match_start, match_len);
+    };
+    auto cancelled = [&](u64 i) noexcept {
+        return (i & 0xFFFF) == 0 && cancellation_token != nullptr && cancellation_token->load(std::memory_order_relaxed);
+    };
+
+    //? Candidates cover the entries the trigrams do, whatever was added since is looked at one by one.
+    std::vector<u32> candidates = {};
+    u64 first_not_covered = 1;
+
+    if (this->trigrams.candidates(query, candidates)) {
+        for (u64 c = 0; c < candidates.size() && candidates[c] < this->num_entries && !cancelled(c + 1); ++c) {
+            if (candidates[c] != root_entry) look_at(candidates[c]);
+        }
+        first_not_covered = std::max(u64(this->trigrams.end_id), u64(1));
+    }
+    for (u64 i = first_not_covered; i < this->num_entries && !cancelled(i); ++i) {
+        look_at(i);
+    }
+
+    return num_looked_at;
+}
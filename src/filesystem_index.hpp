@@ -0,0 +1,143 @@
+#pragma once
+
+//? Names, sizes, last write times and parent links of everything under a directory, kept on disk between runs so the finder
+//? can search a large tree in milliseconds instead of walking it again.
+
+#if defined(_WIN32)
+#   include "stdafx.hpp"
+#else
+#   include <atomic>
+#   include <filesystem>
+#   include <functional>
+#   include <string>
+#   include <string_view>
+#   include <unordered_map>
+#   include <utility>
+#   include <vector>
+#endif
+
+#include "primitives.hpp"
+#include "directory_enumeration.hpp"
+#include "directory_traversal.hpp"
+#include "name_pattern.hpp"
+#include "substring_search.hpp"
+#include "trigram_index.hpp"
+
+/// One indexed root. Entry 0 is the root itself, every other entry comes after its parent, which keeps compaction and
+/// ancestor checks single pass. Loading maps the file and searches it in place, the first change copies it into memory.
+///
+/// File layout, little endian: u64 magic, u32 version, u32 separator, u64 entry count, u64 names size, u64 root length,
+/// u64 build time in microseconds, the root path padded to 8 bytes, the entries as laid out below, then the names back to back.
+///
+/// Not thread safe, the caller serializes searches and changes.
+struct filesystem_index
+{
+    static constexpr u64 magic = 0x3158444e4157535f; // "_SWANDX1"
+    static constexpr u32 version = 1;
+    static constexpr u64 header_size = 48;
+    static constexpr u32 root_entry = 0;
+    static constexpr u32 not_found = UINT32_MAX;
+
+    struct entry
+    {
+        u64 size;
+        u64 last_write_time; // 100ns ticks since 1601-01-01 UTC, like directory_entry
+        u32 parent;          // `not_found` for the root
+        u32 name_offset;     // into the names
+        u16 name_len;
+        directory_entry_kind kind;
+        u8 removed;          // and with it everything below, dropped by the next `save`
+        u32 reserved;
+    };
+
+    filesystem_index() noexcept = default;
+    filesystem_index(filesystem_index const &) = delete;
+    filesystem_index &operator=(filesystem_index const &) = delete;
+    ~filesystem_index() noexcept { close(); }
+
+    /// Walks `root_utf8` with `traversal` (which may be parallel), replacing anything indexed or loaded before.
+    /// False if the root can't be listed, or the walk was cancelled.
+    bool build(std::string_view root_utf8, directory_traversal const &traversal) noexcept;
+
+    /// Maps a file written by `save` and checks it's consistent. False if it's missing or malformed, the index is then empty.
+    bool load(std::filesystem::path const &file_path) noexcept;
+
+    /// Drops removed entries, then writes a temporary file and renames it over `file_path`.
+    bool save(std::filesystem::path const &file_path) noexcept;
+
+    void close() noexcept;
+
+    u64 size() const noexcept { return num_entries; }
+    entry const &at(u32 idx) const noexcept { return entries[idx]; }
+    std::string_view name(u32 idx) const noexcept { return { names + entries[idx].name_offset, entries[idx].name_len }; }
+
+    /// False if the entry, or a directory above it, was removed.
+    bool alive(u32 idx) const noexcept;
+
+    /// Full path of an entry, false if it isn't alive.
+    bool path_of(u32 idx, std::string &out) const noexcept;
+
+    /// The entry at `path_utf8` if it is the root or under it, `not_found` otherwise. Case sensitive, like change notifications.
+    u32 find(std::string_view path_utf8) const noexcept;
+
+    /// Brings the entry at `relative_path_utf8` (relative to the root, as ReadDirectoryChangesW reports them when watching a subtree)
+    /// in line with the filesystem: updated, added (with everything below it, for a directory) or removed.
+    void apply_change(std::string_view relative_path_utf8) noexcept;
+
+    /// Calls `on_match(idx, match_start, match_len)` for every alive entry below `scope` whose name matches, in index order.
+    /// Only the candidates `trigrams` gives are looked at, plus entries added since it was last brought up to date.
+    /// Returns the number of entries looked at.
+    u64 search(substring_matcher const &matcher, u32 scope, std::atomic_bool const *cancellation_token,
+               std::function<void (u32, u64, u64)> const &on_match) const noexcept;
+
+    /// Same for whole-name regex or glob matches, `query` being the trigrams the pattern requires. A match spans the whole name.
+    u64 search(name_pattern const &pattern, trigram_query const &query, u32 scope, std::atomic_bool const *cancellation_token,
+               std::function<void (u32, u64, u64)> const &on_match) const noexcept;
+
+    /// Adds the names of entries `trigrams` doesn't cover yet. Done by `build`, and by `apply_change` and `save` for an index
+    /// whose trigrams are up to date. A loaded index has none until this is called, its searches look at every entry until then.
+    void index_names() noexcept;
+
+    std::string root = {};
+    char separator = '\\';
+    u64 build_us = 0;   // of the walk which produced the index, kept across `save` and `load`
+    u64 file_size = 0;  // as of the last `save` or `load`
+    u64 num_changes_applied = 0;
+
+    entry const *entries = nullptr; // into the mapping, or `owned_entries`
+    u64 num_entries = 0;
+    char const *names = nullptr;    // into the mapping, or `owned_names`
+    u64 names_size = 0;
+
+    trigram_index trigrams = {}; // of the names of entries [0, `trigrams.end_id`), not persisted
+
+private:
+    void make_owned() noexcept;
+    void unmap() noexcept;
+    void use_owned() noexcept;
+    u32 append(u32 parent, std::string_view name, directory_entry const &info) noexcept;
+    void append_subtree(u32 directory_idx, std::string const &directory_path) noexcept;
+    u32 find_child(u32 parent, std::string_view name) const noexcept;
+    void index_children() const noexcept;
+    static u64 child_key(u32 parent, std::string_view name) noexcept;
+    u64 search_candidates(trigram_query const &query, std::function<bool (std::string_view, u64 &, u64 &)> const &matches,
+                          u32 scope, std::atomic_bool const *cancellation_token, std::function<void (u32, u64, u64)> const &on_match) const noexcept;
+
+    std::vector<entry> owned_entries = {};
+    std::vector<char> owned_names = {};
+
+    //? Built on the first lookup rather than on load: most sessions search an index far more than they change it.
+    //? A sorted array costs 16 bytes per entry where a hash map node costs about 40, entries added later go to the small map.
+    mutable std::vector<std::pair<u64, u32>> sorted_children = {}; // (`child_key`, entry)
+    mutable std::unordered_multimap<u64, u32> added_children = {};
+    mutable bool children_indexed = false;
+
+#if defined(_WIN32)
+    HANDLE file_handle = INVALID_HANDLE_VALUE;
+    HANDLE mapping_handle = NULL;
+#else
+    s32 file_fd = -1;
+#endif
+    void const *view = nullptr;
+    u64 view_size = 0;
+};
@@ -2,148 +2,768 @@
 #include "data_types.hpp"
 #include "common_functions.hpp"
 #include "imgui_dependent_functions.hpp"
+#include "directory_enumeration.hpp"
+#include "directory_traversal.hpp"
+#include "filesystem_index.hpp"
+#include "name_pattern.hpp"
+#include "substring_search.hpp"
+#include "trigram_index.hpp"
 
 namespace swan_finder
 {
-    static swan_thread_pool_t g_thread_pool(1);
+    //? One thread per hardware thread: the search itself runs on one of them and hands directories to the others.
+    static swan_thread_pool_t g_thread_pool(0);
 }
 
-void traverse_directory_recursively(swan_path const &directory_path_utf8,
-                                    std::atomic<u64> &num_entries_checked,
-                                    progressive_task<std::vector<finder_window::match>> &search_task,
-                                    char const *search_value,
-                                    u64 search_value_len) noexcept
+u64 finder_window::num_entries_checked() const noexcept
 {
-    wchar_t search_path_utf16[MAX_PATH];
+    u64 total = 0;
+    for (auto const &counter : this->traversal_counters) {
+        total += counter.num_entries.load(std::memory_order_relaxed);
+    }
+    return total;
+}
 
-    if (!utf8_to_utf16(directory_path_utf8.data(), search_path_utf16, lengthof(search_path_utf16))) {
-        return;
+bool finder_window::search_results::publish(match_chunk &&chunk) noexcept
+{
+    if (chunk.matches.empty()) {
+        return true;
     }
 
-    if (search_path_utf16[wcslen(search_path_utf16) - 1] != L'\\') {
-        (void) StrCatW(search_path_utf16, L"\\");
+    //? Ids in order of publication, reserved a chunk at a time so workers don't contend per match.
+    u64 first_id = this->num_matches.fetch_add(chunk.matches.size());
+    for (u64 i = 0; i < chunk.matches.size(); ++i) {
+        chunk.matches[i].id = u32(first_id + i);
     }
-    (void) StrCatW(search_path_utf16, L"*");
 
-    WIN32_FIND_DATAW find_data;
-    HANDLE find_handle = FindFirstFileW(search_path_utf16, &find_data);
-    SCOPE_EXIT { FindClose(find_handle); };
+    chunk.matches.shrink_to_fit(); // chunks published early because they got old are rarely full
+    chunk.names.shrink_to_fit();
+    this->num_bytes.fetch_add(chunk.num_bytes());
 
-    if (find_handle == INVALID_HANDLE_VALUE) {
-        print_debug_msg("find_handle == INVALID_HANDLE_VALUE [%s]", directory_path_utf8.data());
-        return;
+    return this->chunks.push_back(std::move(chunk)) != UINT64_MAX;
+}
+
+u32 finder_window::search_results::intern_directory(std::string_view directory_utf8) noexcept
+{
+    this->num_bytes.fetch_add(sizeof(std::string) + directory_utf8.size() + 1);
+
+    u64 idx = this->directories.push_back(std::string(directory_utf8));
+    return idx > UINT32_MAX ? UINT32_MAX : u32(idx);
+}
+
+void finder_window::search_results::clear() noexcept
+{
+    this->chunks.clear();
+    this->directories.clear();
+    this->num_matches.store(0);
+    this->num_bytes.store(0);
+}
+
+void finder_window::match_snapshot::update(search_results const &results) noexcept
+{
+    while (match_chunk const *chunk = results.chunks.get(this->chunks.size())) {
+        this->chunks.push_back(chunk);
+        this->first_rows.push_back(this->num_rows);
+        this->num_rows += chunk->matches.size();
+    }
+}
+
+finder_window::match_row finder_window::match_snapshot::row(u64 idx) const noexcept
+{
+    assert(idx < this->num_rows);
+    u64 chunk_idx = u64(std::upper_bound(this->first_rows.begin(), this->first_rows.end(), idx) - this->first_rows.begin()) - 1;
+    match_chunk const *chunk = this->chunks[chunk_idx];
+    return { chunk, &chunk->matches[idx - this->first_rows[chunk_idx]] };
+}
+
+void finder_window::match_snapshot::clear() noexcept
+{
+    this->chunks.clear();
+    this->first_rows.clear();
+    this->num_rows = 0;
+}
+
+bool finder_window::match_path(match_row const &row, swan_path &out) const noexcept
+{
+    std::string const *parent = this->search_task.result.directories.get(row.m->parent);
+    if (parent == nullptr || parent->size() >= out.max_size()) {
+        return false;
+    }
+    memcpy(out.data(), parent->data(), parent->size());
+    out[parent->size()] = '\0';
+    return path_append(out, row.chunk->name(*row.m), L'\\', true);
+}
+
+/// Matches a worker collected and hasn't published yet, only ever touched by that worker.
+struct alignas(64) finder_pending_chunk
+{
+    finder_window::match_chunk chunk = {};
+    time_point_precise_t first_match_time = {};
+    std::string directory = {}; // the last one interned by this worker, its directories are listed one at a time
+    u32 directory_idx = UINT32_MAX;
+};
+
+//? Big enough that publishing (a few allocations and atomic increments) is rare, small enough that a broad
+//? search fills its first chunks within a frame or two.
+static constexpr u64 finder_chunk_capacity = 256;
+static constexpr s64 finder_max_chunk_age_ms = 50; // so matches trickling in from a sparse search still show up promptly
+
+static
+void add_match(finder_window::search_results &results,
+               finder_pending_chunk &pending,
+               u32 directory_idx,
+               std::string_view name,
+               u64 size,
+               u64 last_write_time,
+               directory_entry_kind kind,
+               u64 match_start,
+               u64 match_len) noexcept
+{
+    auto &chunk = pending.chunk;
+    if (chunk.matches.empty()) {
+        chunk.matches.reserve(finder_chunk_capacity);
+        chunk.names.reserve(finder_chunk_capacity * 16);
+        pending.first_match_time = get_time_precise();
+    }
+
+    finder_window::match match;
+    match.size = size;
+    match.last_write_time = last_write_time;
+    match.id = 0; // see `search_results::publish`
+    match.parent = directory_idx;
+    match.name_offset = u32(chunk.names.size());
+    match.name_len = u16(name.size());
+    match.highlight_start = u16(match_start);
+    match.highlight_len = u16(match_len);
+
+    if (kind == directory_entry_kind::directory) {
+        match.type = basic_dirent::kind::directory;
+    }
+    else if (name.ends_with(".lnk")) {
+        match.type = basic_dirent::kind::symlink_ambiguous; // TODO: resolve when finder.detailed_symlinks
     }
+    else {
+        match.type = basic_dirent::kind::file;
+    }
+
+    chunk.matches.push_back(match);
+    chunk.names.insert(chunk.names.end(), name.begin(), name.end());
+    chunk.names.push_back('\0');
+
+    if (chunk.matches.size() == finder_chunk_capacity) {
+        (void) results.publish(std::move(chunk));
+        chunk = {};
+    }
+}
 
-    do {
+/// What a search looks for: a substring of names, or with `regex` a pattern whole names match.
+struct finder_query
+{
+    bool regex = false;
+    substring_matcher substring = {};
+    name_pattern pattern = {};
+    trigram_query trigrams = {}; // what `pattern` requires, for indexed roots
+
+    bool find(std::string_view name, u64 &match_start, u64 &match_len) const noexcept
+    {
+        if (!this->regex) {
+            match_start = this->substring.find(name, &match_len);
+            return match_start != substring_matcher::not_found;
+        }
+        match_start = 0;
+        match_len = name.size();
+        return this->pattern.matches(name);
+    }
+};
+
+static
+void search_directory_batch(std::string_view directory_utf8,
+                            directory_entry_batch const &batch,
+                            async_task<finder_window::search_results> &search_task,
+                            finder_pending_chunk &pending,
+                            finder_query const &query) noexcept
+{
+    auto &results = search_task.result;
+
+    for (auto const &found : batch.entries) {
         if (search_task.cancellation_token.load() == true) {
             return;
         }
 
-        swan_path found_file_name = path_create("");
+        std::string_view found_name = batch.name_view(found);
 
-        if (!utf16_to_utf8(find_data.cFileName, found_file_name.data(), found_file_name.size())) {
+        u64 found_substr_idx = 0, found_substr_len = 0;
+        if (!query.find(found_name, found_substr_idx, found_substr_len)) {
             continue;
         }
 
-        if (path_equals_exactly(found_file_name, ".") || path_equals_exactly(found_file_name, "..")) {
-            continue;
+        if (pending.directory_idx == UINT32_MAX || pending.directory != directory_utf8) {
+            pending.directory = directory_utf8;
+            pending.directory_idx = results.intern_directory(directory_utf8);
+            if (pending.directory_idx == UINT32_MAX) {
+                return;
+            }
         }
 
-        u64 num_entries_checked_ = num_entries_checked++;
+        add_match(results, pending, pending.directory_idx, found_name, found.size, found.last_write_time, found.kind,
+                  found_substr_idx, found_substr_len);
+    }
+
+    if (!pending.chunk.matches.empty() && time_diff_ms(pending.first_match_time, get_time_precise()) >= finder_max_chunk_age_ms) {
+        (void) results.publish(std::move(pending.chunk));
+        pending.chunk = {};
+    }
+}
 
-        bool is_directory = find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY;
+/// Everything under `scope` in the index of `root`, on the calling thread with `root.mutex` held. A scan takes tens of
+/// milliseconds even for millions of entries, so chunks are only published when full, the rest once the search is done.
+static
+void search_indexed_root(finder_window::indexed_root &root,
+                         u32 scope,
+                         async_task<finder_window::search_results> &search_task,
+                         finder_pending_chunk &pending,
+                         finder_query const &query,
+                         directory_traversal_counter &counter) noexcept
+{
+    auto &results = search_task.result;
+    filesystem_index const &index = *root.index;
 
-        char const *found_substr = strstr(found_file_name.data(), search_value);
+    std::unordered_map<u32, u32> interned = {}; // index entry of a parent directory -> its place in `results.directories`
+    std::string parent_path = {};
 
-        finder_window::match match = {};
+    auto on_match = [&](u32 idx, u64 match_start, u64 match_len) noexcept {
+        filesystem_index::entry const &found = index.at(idx);
 
-        if (found_substr) {
-            match.highlight_start_idx = found_substr - found_file_name.data();
-            match.highlight_len = search_value_len;
+        auto [parent, inserted] = interned.try_emplace(found.parent, UINT32_MAX);
+        if (inserted && index.path_of(found.parent, parent_path)) {
+            parent->second = results.intern_directory(parent_path);
+        }
+        if (parent->second == UINT32_MAX) {
+            return;
+        }
+
+        add_match(results, pending, parent->second, index.name(idx), found.size, found.last_write_time, found.kind, match_start, match_len);
+    };
 
-            match.basic.id = (u32)num_entries_checked_;
-            match.basic.size = two_u32_to_one_u64(find_data.nFileSizeLow, find_data.nFileSizeHigh);
-            match.basic.creation_time_raw = find_data.ftCreationTime;
-            match.basic.last_write_time_raw = find_data.ftLastWriteTime;
+    u64 num_looked_at = query.regex
+        ? index.search(query.pattern, query.trigrams, scope, &search_task.cancellation_token, on_match)
+        : index.search(query.substring, scope, &search_task.cancellation_token, on_match);
 
-            match.basic.path = directory_path_utf8;
-            if (!path_append(match.basic.path, found_file_name.data(), L'\\', true)) {
+    counter.num_entries.fetch_add(num_looked_at, std::memory_order_relaxed);
+}
+
+void search_proc(finder_window &finder,
+                 std::vector<finder_window::search_directory> search_directories,
+                 std::array<char, 1024> search_value,
+                 bool regex,
+                 std::vector<std::shared_ptr<finder_window::indexed_root>> indexed_roots,
+                 u64 num_threads) noexcept
+{
+    auto &search_task = finder.search_task;
+
+    search_task.active_token.store(true);
+    SCOPE_EXIT {
+        finder.search_duration_us.store(std::max(u64(time_diff_us(finder.search_start_time, get_time_precise())), u64(1)));
+        search_task.active_token.store(false);
+    };
+
+    //? Case sensitive, like the strstr this replaced. Patterns were checked by `start_search`.
+    finder_query query = {};
+    query.regex = regex;
+    if (regex) {
+        (void) query.pattern.compile(search_value.data(), name_pattern::syntax::regex, true);
+        query.trigrams = trigram_query::for_regex(search_value.data(), true);
+    } else {
+        query.substring.compile(search_value.data(), true);
+    }
+
+    auto pending = std::make_unique<finder_pending_chunk[]>(directory_traversal::max_threads);
+
+    //? Search directories inside an indexed root are answered from the index by this thread, before the walk whose
+    //? worker 0 it becomes, so `pending[0]` is never used by two at once. The rest are walked.
+    std::vector<std::string> roots = {};
+    u64 num_indexed = 0;
+
+    for (auto const &search_dir : search_directories) {
+        swan_path search_dir_path_ut8_normalized = search_dir.path_utf8;
+        path_force_separator(search_dir_path_ut8_normalized, L'\\');
+        std::string_view search_dir_path = search_dir_path_ut8_normalized.data();
+
+        bool indexed = false;
+
+        for (auto const &root : indexed_roots) {
+            if (root->state.load() != finder_window::indexed_root::status::ready) {
                 continue;
             }
+            std::scoped_lock lock(root->mutex);
 
-            if (is_directory) {
-                match.basic.type = basic_dirent::kind::directory;
+            u32 scope = root->index->find(search_dir_path);
+            if (scope == filesystem_index::not_found) {
+                continue;
             }
-            else if (path_ends_with(match.basic.path, ".lnk")) {
-                match.basic.type = basic_dirent::kind::symlink_ambiguous;
-
-                // TODO:
-            #if 0
-                if (finder.detailed_symlinks) {
-                    match.basic.type = basic_dirent::kind::invalid_symlink; // default value, if something fails below
-
-                    static std::wstring full_path_utf16 = {};
-                    full_path_utf16.clear();
-                    full_path_utf16.append(search_path_utf16);
-                    full_path_utf16.pop_back(); // remove '*'
-                    full_path_utf16.append(find_data.cFileName);
-
-                    // Load the shortcut
-                    HRESULT com_handle = s_persist_file_interface->Load(full_path_utf16.c_str(), STGM_READ);
-                    if (FAILED(com_handle)) {
-                        WCOUT_IF_DEBUG("FAILED IPersistFile::Load [" << full_path_utf16.c_str() << "]\n");
-                    }
-                    else {
-                        // Get the target path
-                        wchar_t target_path_utf16[MAX_PATH];
-                        com_handle = s_shell_link->GetPath(target_path_utf16, lengthof(target_path_utf16), NULL, SLGP_RAWPATH);
-                        if (FAILED(com_handle)) {
-                            WCOUT_IF_DEBUG("FAILED IShellLinkW::GetPath [" << full_path_utf16.c_str() << "]\n");
-                        }
-                        else {
-                            if      (PathIsDirectoryW(target_path_utf16)) entry.basic.type = basic_dirent::kind::symlink_to_directory;
-                            else if (PathFileExistsW(target_path_utf16))  entry.basic.type = basic_dirent::kind::symlink_to_file;
-                            else                                          entry.basic.type = basic_dirent::kind::invalid_symlink;
-                        }
-                    }
-                }
-            #endif
+
+            auto query_start = get_time_precise();
+            search_indexed_root(*root, scope, search_task, pending[0], query, finder.traversal_counters[0]);
+            u64 query_us = u64(time_diff_us(query_start, get_time_precise()));
+
+            root->last_query_us.store(std::max(query_us, u64(1)));
+            finder.search_index_us.fetch_add(query_us);
+            indexed = true;
+            break;
+        }
+
+        if (indexed) ++num_indexed;
+        else roots.emplace_back(search_dir_path);
+    }
+    finder.num_indexed_search_dirs.store(num_indexed);
+
+    directory_traversal traversal = {};
+    traversal.push_task = [](std::function<void ()> task) noexcept { swan_finder::g_thread_pool.push_task(std::move(task)); };
+    traversal.num_threads = num_threads;
+    traversal.separator = '\\';
+    traversal.cancellation_token = &search_task.cancellation_token;
+    traversal.counters = finder.traversal_counters.data();
+
+    if (!roots.empty()) {
+        traversal.run(roots, [&](u64 worker, std::string_view directory_utf8, directory_entry_batch const &batch) noexcept {
+            search_directory_batch(directory_utf8, batch, search_task, pending[worker], query);
+        });
+    }
+
+    //? Every worker is done, whatever they hold is published from here. Also after cancellation, so what was found stays visible.
+    for (u64 i = 0; i < directory_traversal::max_threads; ++i) {
+        (void) search_task.result.publish(std::move(pending[i].chunk));
+    }
+}
+
+/// How many threads a search or an index walk may use, per the "Search threads" setting.
+static
+u64 finder_num_threads() noexcept
+{
+    u64 max_threads = std::min(u64(swan_finder::g_thread_pool.get_thread_count()), directory_traversal::max_threads);
+    s32 setting = global_state::settings().finder_num_threads;
+    return setting > 0 ? std::min(u64(setting), max_threads) : max_threads;
+}
+
+static
+void start_search(finder_window &finder) noexcept
+{
+    if (finder.search_regex) {
+        name_pattern pattern = {};
+        if (!pattern.compile(finder.search_value.data(), name_pattern::syntax::regex, true)) {
+            std::string action = make_str("Search for /%s/.", finder.search_value.data());
+            swan_popup_modals::open_error(action.c_str(), pattern.error.c_str());
+            return;
+        }
+    }
+
+    //? No search is running, so nothing publishes and the snapshot is the only reader.
+    finder.matches.clear();
+    finder.search_task.result.clear();
+    finder.search_task.cancellation_token.store(false);
+    for (auto &counter : finder.traversal_counters) {
+        counter.reset();
+    }
+
+    finder.search_num_threads = finder_num_threads();
+    finder.search_start_time = get_time_precise();
+    finder.search_duration_us.store(0);
+    finder.search_index_us.store(0);
+    finder.num_indexed_search_dirs.store(0);
+    finder.search_task.active_token.store(true); // right away, so this frame can't start a second search
+
+    swan_finder::g_thread_pool.push_task([&finder, indexed_roots = finder.indexed_roots, num_threads = finder.search_num_threads]() {
+        search_proc(finder, finder.search_directories, finder.search_value, finder.search_regex, indexed_roots, num_threads);
+    });
+}
+
+/// data\finder_index_<hash>.bin, named after the lower cased root so several can be kept side by side.
+static
+std::filesystem::path indexed_root_file_path(std::string_view root_utf8) noexcept
+{
+    u64 hash = 0xcbf29ce484222325;
+    for (char ch : root_utf8) {
+        hash ^= u8(std::tolower(u8(ch)));
+        hash *= 0x100000001b3;
+    }
+    return global_state::execution_path() / make_str("data\\finder_index_%016llx.bin", hash);
+}
+
+/// Walks the root into a new index which replaces the current one once complete, so searches keep using the old one meanwhile.
+/// Whoever queues this sets `root->building` first.
+static
+void build_indexed_root(std::shared_ptr<finder_window::indexed_root> root, u64 num_threads) noexcept
+{
+    using status = finder_window::indexed_root::status;
+
+    auto fresh = std::make_unique<filesystem_index>();
+
+    directory_traversal traversal = {};
+    traversal.push_task = [](std::function<void ()> task) noexcept { swan_finder::g_thread_pool.push_task(std::move(task)); };
+    traversal.num_threads = num_threads;
+    traversal.separator = '\\';
+    traversal.cancellation_token = &root->cancellation_token;
+
+    bool built = fresh->build(root->path_utf8, traversal);
+
+    std::scoped_lock lock(root->mutex);
+
+    if (built && !root->cancellation_token.load()) {
+        for (auto const &change : root->changes_during_build) {
+            fresh->apply_change(change);
+        }
+        root->index.swap(fresh);
+
+        bool saved = root->index->save(root->file_path);
+        root->dirty.store(!saved);
+        root->state.store(status::ready);
+
+        print_debug_msg("%s [%s] %zu entries in %zu ms, %zu bytes", saved ? "SUCCESS" : "FAILED save", root->path_utf8.c_str(),
+                        root->index->size(), root->index->build_us / 1000, root->index->file_size);
+    }
+    else if (root->state.load() != status::ready) {
+        root->state.store(status::failed);
+    }
+
+    root->changes_during_build.clear();
+    root->building.store(false);
+}
+
+/// Searchable as soon as the file is mapped, then walked again since it can't know what changed while swan wasn't running.
+static
+void open_indexed_root(std::shared_ptr<finder_window::indexed_root> root, u64 num_threads) noexcept
+{
+    using status = finder_window::indexed_root::status;
+
+    bool loaded;
+    {
+        std::scoped_lock lock(root->mutex);
+
+        loaded = root->index->load(root->file_path) && root->index->root == root->path_utf8;
+        if (!loaded) {
+            root->index->close();
+        }
+    }
+    root->state.store(loaded ? status::ready : status::building);
+
+    build_indexed_root(root, num_threads);
+}
+
+static
+bool arm_indexed_root_watch(finder_window::indexed_root &root) noexcept
+{
+    auto success = ReadDirectoryChangesW(
+        root.watch_handle,
+        reinterpret_cast<void *>(root.watch_buffer.data()),
+        (s32)root.watch_buffer.size(),
+        TRUE, // watch subtree
+        FILE_NOTIFY_CHANGE_CREATION|FILE_NOTIFY_CHANGE_DIR_NAME|FILE_NOTIFY_CHANGE_FILE_NAME|FILE_NOTIFY_CHANGE_LAST_WRITE|FILE_NOTIFY_CHANGE_SIZE,
+        &root.watch_bytes_written,
+        &root.watch_overlapped,
+        nullptr);
+
+    if (!success) {
+        print_debug_msg("FAILED ReadDirectoryChangesW [%s]: %s", root.path_utf8.c_str(), get_last_winapi_error().formatted_message.c_str());
+        CloseHandle(root.watch_handle);
+        root.watch_handle = INVALID_HANDLE_VALUE;
+    }
+    return success;
+}
+
+static
+void close_indexed_root_watch(finder_window::indexed_root &root) noexcept
+{
+    if (root.watch_handle != INVALID_HANDLE_VALUE) {
+        //? Wait for the cancelled read to complete, the system writes to the buffer and OVERLAPPED until then.
+        CancelIo(root.watch_handle);
+        (void) GetOverlappedResult(root.watch_handle, &root.watch_overlapped, &root.watch_bytes_written, TRUE);
+        CloseHandle(root.watch_handle);
+        root.watch_handle = INVALID_HANDLE_VALUE;
+    }
+}
+
+bool finder_window::add_indexed_root(std::string_view path_utf8) noexcept
+{
+    std::string path(path_utf8);
+    std::replace(path.begin(), path.end(), '/', '\\');
+    while (path.size() > 3 && path.back() == '\\') {
+        path.pop_back();
+    }
+    if (path.size() == 2 && path[1] == ':') {
+        path += '\\'; // "C:" alone means the current directory of drive C
+    }
+    if (path.empty()) {
+        return false;
+    }
+    for (auto const &root : this->indexed_roots) {
+        if (path_loosely_same(root->path_utf8.c_str(), path.c_str())) {
+            return false;
+        }
+    }
+
+    auto root = std::make_shared<indexed_root>();
+    root->path_utf8 = std::move(path);
+    root->file_path = indexed_root_file_path(root->path_utf8);
+    root->building.store(true);
+    this->indexed_roots.push_back(root);
+
+    swan_finder::g_thread_pool.push_task([root, num_threads = finder_num_threads()]() noexcept {
+        open_indexed_root(root, num_threads);
+    });
+    return true;
+}
+
+void finder_window::remove_indexed_root(u64 idx) noexcept
+{
+    auto root = this->indexed_roots[idx];
+    this->indexed_roots.erase(this->indexed_roots.begin() + s64(idx));
+
+    root->cancellation_token.store(true);
+    close_indexed_root_watch(*root);
+
+    swan_finder::g_thread_pool.push_task([root]() noexcept {
+        std::scoped_lock lock(root->mutex);
+        root->index->close(); // a mapped file can't be deleted
+        std::error_code error;
+        std::filesystem::remove(root->file_path, error);
+    });
+}
+
+void finder_window::update_indexed_roots() noexcept
+{
+    using status = indexed_root::status;
+
+    static directory_change_batch s_changes = {};
+    static std::vector<directory_change_net> s_net = {};
+
+    for (auto const &root : this->indexed_roots) {
+        if (root->state.load() == status::failed) {
+            continue;
+        }
+
+        if (root->watch_handle == INVALID_HANDLE_VALUE) {
+            //? Armed while the first walk runs, so what changes during it isn't missed. Retried every few seconds if it fails,
+            //? e.g. while a removable drive is away.
+            if (root->watch_attempt_time != time_point_precise_t() && time_diff_ms(root->watch_attempt_time, get_time_precise()) < 5000) {
+                continue;
+            }
+            root->watch_attempt_time = get_time_precise();
+
+            wchar_t path_utf16[MAX_PATH];
+            if (!utf8_to_utf16(root->path_utf8.c_str(), path_utf16, lengthof(path_utf16))) {
+                continue;
             }
-            else {
-                match.basic.type = basic_dirent::kind::file;
+            root->watch_handle = CreateFileW(path_utf16, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                             NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+            if (root->watch_handle != INVALID_HANDLE_VALUE) {
+                root->watch_overlapped = {};
+                (void) arm_indexed_root_watch(*root);
             }
+            continue;
+        }
 
-            std::scoped_lock lock(search_task.result_mutex);
-            search_task.result.push_back(match);
+        BOOL overlap_check = GetOverlappedResult(root->watch_handle, &root->watch_overlapped, &root->watch_bytes_written, FALSE);
+        if (!overlap_check && GetLastError() == ERROR_IO_INCOMPLETE) {
+            continue; // nothing changed
         }
 
-        if (is_directory) {
-            swan_path sub_directory_utf8 = directory_path_utf8;
-            if (!path_append(sub_directory_utf8, found_file_name.data(), '\\', true, true)) {
-                return;
+        //? Decode before re-arming, which reuses the buffer. 0 bytes (or a failed wait) means the system buffer overflowed.
+        s_changes.clear();
+        decode_file_notify_information(root->watch_buffer.data(), overlap_check ? root->watch_bytes_written : 0, s_changes);
+        (void) arm_indexed_root_watch(*root);
+
+        if (s_changes.overflowed) {
+            //? Too much changed to know what, only walking again tells.
+            if (!root->building.exchange(true)) {
+                swan_finder::g_thread_pool.push_task([root, num_threads = finder_num_threads()]() noexcept {
+                    build_indexed_root(root, num_threads);
+                });
             }
-            traverse_directory_recursively(sub_directory_utf8, num_entries_checked, search_task, search_value, search_value_len);
+            continue;
         }
+
+        summarize_directory_changes(s_changes, s_net);
+        if (s_net.empty()) {
+            continue;
+        }
+
+        //? Only the names, whether each still exists is asked when the change is applied.
+        std::vector<std::string> changed = {};
+        for (auto const &net : s_net) {
+            changed.emplace_back(net.name);
+        }
+
+        swan_finder::g_thread_pool.push_task([root, changed = std::move(changed)]() noexcept {
+            std::scoped_lock lock(root->mutex);
+
+            for (auto const &relative_path : changed) {
+                root->index->apply_change(relative_path);
+                if (root->building.load()) {
+                    root->changes_during_build.push_back(relative_path);
+                }
+            }
+            root->dirty.store(true);
+        });
     }
-    while (FindNextFileW(find_handle, &find_data));
 }
 
-void search_proc(progressive_task<std::vector<finder_window::match>> &search_task,
-                 std::vector<finder_window::search_directory> search_directories,
-                 std::atomic<u64> &num_entries_checked,
-                 std::array<char, 1024> search_value) noexcept
+void finder_window::save_indexes() noexcept
 {
-    search_task.active_token.store(true);
-    SCOPE_EXIT { search_task.active_token.store(false); };
+    for (auto const &root : this->indexed_roots) {
+        root->cancellation_token.store(true);
+        close_indexed_root_watch(*root);
+    }
+    for (auto const &root : this->indexed_roots) {
+        if (!root->dirty.load()) {
+            continue;
+        }
+        std::scoped_lock lock(root->mutex);
 
-    u64 search_value_len = strlen(search_value.data());
+        if (root->state.load() == indexed_root::status::ready && root->index->save(root->file_path)) {
+            root->dirty.store(false);
+            print_debug_msg("SUCCESS [%s] %zu entries, %zu changes applied", root->path_utf8.c_str(), root->index->size(), root->index->num_changes_applied);
+        }
+    }
+}
 
-    for (auto const &search_dir : search_directories) {
-        swan_path search_dir_path_ut8_normalized = search_dir.path_utf8;
-        path_force_separator(search_dir_path_ut8_normalized, L'\\');
+bool finder_window::save_indexed_roots_to_disk() const noexcept
+try {
+    std::filesystem::path full_path = global_state::execution_path() / "data\\finder_indexed_roots.txt";
+
+    std::ofstream out(full_path);
+
+    if (!out) {
+        return false;
+    }
+
+    for (auto const &root : this->indexed_roots) {
+        out << root->path_utf8 << '\n';
+    }
+
+    print_debug_msg("SUCCESS saved %zu items", this->indexed_roots.size());
+    return true;
+}
+catch (...) {
+    print_debug_msg("FAILED");
+    return false;
+}
 
-        traverse_directory_recursively(search_dir_path_ut8_normalized, num_entries_checked, search_task, search_value.data(), search_value_len);
+bool finder_window::load_indexed_roots_from_disk() noexcept
+try {
+    std::filesystem::path full_path = global_state::execution_path() / "data\\finder_indexed_roots.txt";
+
+    std::ifstream in(full_path);
+
+    if (!in) {
+        return false;
     }
+
+    std::string line = {};
+    while (std::getline(in, line)) {
+        if (!line.empty()) {
+            (void) this->add_indexed_root(line);
+        }
+    }
+
+    print_debug_msg("SUCCESS loaded %zu items", this->indexed_roots.size());
+    return true;
+}
+catch (...) {
+    print_debug_msg("FAILED");
+    return false;
+}
+
+static
+void render_indexed_roots_popup(finder_window &finder) noexcept
+{
+    using status = finder_window::indexed_root::status;
+
+    if (!imgui::BeginPopup("## finder indexes")) {
+        return;
+    }
+
+    imgui::TextUnformatted("Searches inside these directories scan an index rather than the disk.");
+    imgui::Spacing();
+
+    u64 remove_idx = u64(-1);
+
+    if (!finder.indexed_roots.empty() && imgui::BeginTable("## finder indexes table", 8, ImGuiTableFlags_SizingFixedFit|ImGuiTableFlags_BordersInnerV)) {
+        imgui::TableSetupColumn("Directory");
+        imgui::TableSetupColumn("Status");
+        imgui::TableSetupColumn("Entries");
+        imgui::TableSetupColumn("On disk");
+        imgui::TableSetupColumn("Trigrams");
+        imgui::TableSetupColumn("Walked in");
+        imgui::TableSetupColumn("Last query");
+        imgui::TableSetupColumn("## remove");
+        imgui::TableHeadersRow();
+
+        for (u64 i = 0; i < finder.indexed_roots.size(); ++i) {
+            auto &root = *finder.indexed_roots[i];
+            status state = root.state.load();
+
+            imgui::TableNextRow();
+
+            imgui::TableNextColumn();
+            imgui::TextUnformatted(root.path_utf8.c_str());
+
+            imgui::TableNextColumn();
+            switch (state) {
+                case status::loading:  imgui::TextUnformatted("Loading"); break;
+                case status::building: imgui::TextUnformatted("Building"); break;
+                case status::ready:    imgui::TextUnformatted(root.building.load() ? "Ready, refreshing" : "Ready"); break;
+                case status::failed:   imgui::TextUnformatted("Failed"); break;
+            }
+
+            //? Not waiting for a search or a batch of changes to finish, the numbers show up next frame.
+            std::unique_lock lock(root.mutex, std::try_to_lock);
+
+            imgui::TableNextColumn();
+            if (lock.owns_lock() && state == status::ready) imgui::Text("%zu", root.index->size());
+
+            imgui::TableNextColumn();
+            if (lock.owns_lock() && state == status::ready) imgui::Text("%.1lf MB", f64(root.index->file_size) / (1024.0 * 1024.0));
+
+            imgui::TableNextColumn();
+            if (lock.owns_lock() && state == status::ready) {
+                //? A loaded index has none until its refresh walk completes, searches look at every name meanwhile.
+                if (root.index->trigrams.end_id == 0) imgui::TextDisabled("-");
+                else imgui::Text("%.1lf MB", f64(root.index->trigrams.num_bytes()) / (1024.0 * 1024.0));
+            }
+
+            imgui::TableNextColumn();
+            if (lock.owns_lock() && state == status::ready) imgui::Text("%.0lf ms", f64(root.index->build_us) / 1000.0);
+
+            imgui::TableNextColumn();
+            if (u64 query_us = root.last_query_us.load()) imgui::Text("%.1lf ms", f64(query_us) / 1000.0);
+
+            imgui::TableNextColumn();
+            auto label = make_str_static<64>(ICON_LC_TRASH "## finder index %zu", i);
+            if (imgui::SmallButton(label.data())) {
+                remove_idx = i;
+            }
+        }
+
+        imgui::EndTable();
+    }
+
+    if (remove_idx != u64(-1)) {
+        finder.remove_indexed_root(remove_idx);
+        (void) finder.save_indexed_roots_to_disk();
+    }
+
+    auto const &search_directory = finder.search_directories[0];
+    {
+        imgui::ScopedDisable d(!search_directory.found);
+
+        if (imgui::Button(ICON_LC_PLUS " Index search directory")) {
+            if (finder.add_indexed_root(search_directory.path_utf8.data())) {
+                (void) finder.save_indexed_roots_to_disk();
+            }
+        }
+    }
+
+    imgui::EndPopup();
 }
 
 bool swan_windows::render_finder(finder_window &finder, bool &open, [[maybe_unused]] bool any_popups_open) noexcept
@@ -222,6 +842,8 @@ bool swan_windows::render_finder(finder_window &finder, bool &open, [[maybe_unus
     }
 
     bool search_active = finder.search_task.active_token.load();
+
+    finder.matches.update(finder.search_task.result);
     [[maybe_unused]] bool search_cancelled = finder.search_task.cancellation_token.load();
 
     {
@@ -237,12 +859,7 @@ bool swan_windows::render_finder(finder_window &finder, bool &open, [[maybe_unus
             imgui::ScopedDisable d(search_value_empty || any_search_dirs_not_found);
 
             if (imgui::Button(ICON_LC_SEARCH "## finder")) {
-                finder.search_task.result.clear();
-                finder.num_entries_checked.store(0);
-
-                swan_finder::g_thread_pool.push_task([&finder]() {
-                    search_proc(std::ref(finder.search_task), finder.search_directories, std::ref(finder.num_entries_checked), finder.search_value);
-                });
+                start_search(finder);
             }
         }
     }
@@ -263,16 +880,13 @@ bool swan_windows::render_finder(finder_window &finder, bool &open, [[maybe_unus
             imgui::ActivateItemByID(imgui::GetID("## finder search_value"));
         }
 
-        imgui::InputTextWithHint("## finder search_value", "Search for...", finder.search_value.data(), finder.search_value.max_size(),
-                                 ImGuiInputTextFlags_CallbackCharFilter, filter_chars_callback, (void *)windows_illegal_path_chars());
+        //? Regex syntax needs characters which can't be in a name.
+        imgui::InputTextWithHint("## finder search_value", finder.search_regex ? "Names matching..." : "Search for...",
+                                 finder.search_value.data(), finder.search_value.max_size(),
+                                 finder.search_regex ? 0 : ImGuiInputTextFlags_CallbackCharFilter, filter_chars_callback, (void *)windows_illegal_path_chars());
 
         if (imgui::IsItemFocused() && imgui::IsKeyPressed(ImGuiKey_Enter)) {
-            finder.search_task.result.clear();
-            finder.num_entries_checked.store(0);
-
-            swan_finder::g_thread_pool.push_task([&finder]() {
-                search_proc(std::ref(finder.search_task), finder.search_directories, std::ref(finder.num_entries_checked), finder.search_value);
-            });
+            start_search(finder);
         }
     }
 
@@ -292,16 +906,58 @@ bool swan_windows::render_finder(finder_window &finder, bool &open, [[maybe_unus
         // imgui::SetTooltip("Case sensitive: %s\n", expl.filter_case_sensitive ? "ON" : "OFF");
     }
 
+    imgui::SameLine();
+
     {
-        u64 num_entries_checked = finder.num_entries_checked.load();
+        imgui::ScopedDisable d(search_active);
+        imgui::ScopedStyle<f32> s(imgui::GetStyle().Alpha, finder.search_regex ? 1 : imgui::GetStyle().DisabledAlpha);
+
+        if (imgui::Button(ICON_CI_REGEX "## finder regex")) {
+            flip_bool(finder.search_regex);
+        }
+    }
+    if (imgui::IsItemHovered()) {
+        imgui::SetTooltip("Regular expression: %s\nWhole names must match, indexed directories only verify names with the trigrams it requires",
+                          finder.search_regex ? "ON" : "OFF");
+    }
+
+    imgui::SameLine();
+
+    if (imgui::Button(ICON_LC_DATABASE "## finder indexes")) {
+        imgui::OpenPopup("## finder indexes");
+    }
+    if (imgui::IsItemHovered()) {
+        imgui::SetTooltip("Indexed directories: %zu", finder.indexed_roots.size());
+    }
+    render_indexed_roots_popup(finder);
+
+    {
+        u64 num_entries_checked = finder.num_entries_checked();
         if (num_entries_checked > 0) {
             imgui::SameLineSpaced(1);
-            u64 num_matches = 0;
-            {
-                std::scoped_lock lock(finder.search_task.result_mutex);
-                num_matches = finder.search_task.result.size();
-            }
+            u64 num_matches = finder.matches.num_rows;
             imgui::Text("%zu of %zu (%.2lf %%) entries matched", num_matches, num_entries_checked, (f64(num_matches) / f64(num_entries_checked) * 100.0));
+
+            u64 duration_us = finder.search_duration_us.load();
+            if (duration_us == 0) {
+                duration_us = std::max(u64(time_diff_us(finder.search_start_time, get_time_precise())), u64(1));
+            }
+            imgui::SameLineSpaced(1);
+            imgui::TextDisabled("%.0lf entries/s, %zu threads", f64(num_entries_checked) / (f64(duration_us) / 1'000'000.0), finder.search_num_threads);
+
+            if (imgui::IsItemHovered()) {
+                u64 num_directories = 0, num_steals = 0;
+                for (auto const &counter : finder.traversal_counters) {
+                    num_directories += counter.num_directories.load(std::memory_order_relaxed);
+                    num_steals += counter.num_steals.load(std::memory_order_relaxed);
+                }
+                u64 num_published = finder.search_task.result.num_matches.load();
+                f64 bytes_per_match = num_published ? f64(finder.search_task.result.num_bytes.load()) / f64(num_published) : 0;
+                imgui::SetTooltip("%zu directories in %.1lf ms\n%zu taken from another thread's queue\n%.1lf bytes per match\n"
+                                  "%zu of %zu search directories from an index, in %.1lf ms",
+                                  num_directories, f64(duration_us) / 1000.0, num_steals, bytes_per_match,
+                                  finder.num_indexed_search_dirs.load(), finder.search_directories.size(), f64(finder.search_index_us.load()) / 1000.0);
+            }
         }
     }
 
@@ -333,18 +989,16 @@ bool swan_windows::render_finder(finder_window &finder, bool &open, [[maybe_unus
             ImGui::TableSetupScrollFreeze(0, 1);
             imgui::TableHeadersRow();
 
-            auto &matches = finder.search_task.result;
-            auto &mutex = finder.search_task.result_mutex;
-
-            std::scoped_lock lock(mutex);
+            auto const &matches = finder.matches;
 
             ImGuiListClipper clipper;
-            assert(matches.size() <= (u64)INT32_MAX);
-            clipper.Begin((s32)matches.size());
+            assert(matches.num_rows <= (u64)INT32_MAX);
+            clipper.Begin((s32)matches.num_rows);
 
             while (clipper.Step())
             for (u64 i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
-                finder_window::match const &m = matches[i];
+                finder_window::match_row row = matches.row(i);
+                finder_window::match const &m = *row.m;
 
                 imgui::TableNextRow();
 
@@ -353,41 +1007,46 @@ bool swan_windows::render_finder(finder_window &finder, bool &open, [[maybe_unus
                 }
 
                 if (imgui::TableSetColumnIndex(matches_table_col_id)) {
-                    imgui::Text("%zu", m.basic.id);
+                    imgui::Text("%u", m.id);
                 }
 
                 if (imgui::TableSetColumnIndex(matches_table_col_name)) {
-                    char const *icon = m.basic.kind_icon();
-                    ImVec4 icon_color = get_color(m.basic.type);
+                    char const *icon = get_icon(m.type);
+                    ImVec4 icon_color = get_color(m.type);
 
                     imgui::TextColored(icon_color, icon);
                     imgui::SameLine();
 
                     ImVec2 path_text_rect_min = imgui::GetCursorScreenPos();
-                    char const *file_name = path_cfind_filename(m.basic.path.data());
-                    auto label = make_str_static<2048>("%s ## %zu", file_name, m.basic.id);
+                    char const *file_name = row.chunk->name(m);
+                    auto label = make_str_static<2048>("%s ## %u", file_name, m.id);
 
                     if (imgui::Selectable(label.data(), false, ImGuiSelectableFlags_SpanAllColumns|ImGuiSelectableFlags_AllowDoubleClick)) {
-                        if (imgui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
-                            (void) find_in_swan_explorer_0(m.basic.path.data());
+                        swan_path full_path;
+                        if (imgui::IsMouseDoubleClicked(ImGuiMouseButton_Left) && finder.match_path(row, full_path)) {
+                            (void) find_in_swan_explorer_0(full_path.data());
                         }
                     }
 
-                    imgui::HighlightTextRegion(path_text_rect_min, file_name, m.highlight_start_idx, m.highlight_len,
-                                               imgui::ReduceAlphaTo(imgui::Denormalize(warning_lite_color()), 75));
+                    highlight_spans highlight = {};
+                    highlight.set(m.highlight_start, m.highlight_len);
+                    imgui::HighlightTextRegions(path_text_rect_min, file_name, highlight,
+                                                imgui::ReduceAlphaTo(imgui::Denormalize(warning_lite_color()), 75));
 
                     f32 offset_for_icon = imgui::CalcTextSize(icon).x + imgui::GetStyle().ItemSpacing.x;
 
                     if (imgui::RenderTooltipWhenColumnTextTruncated(matches_table_col_name, file_name, offset_for_icon)) {
                         // TODO: highlight inside tooltip
                         // ImVec2 tooltip_text_rect_min = imgui::GetCursorScreenPos();
-                        // imgui::HighlightTextRegion(tooltip_text_rect_min, file_name, m.highlight_start_idx, m.highlight_len);
+                        // imgui::HighlightTextRegions(tooltip_text_rect_min, file_name, m.highlight);
                     }
                 }
 
                 if (imgui::TableSetColumnIndex(matches_table_col_parent)) {
-                    std::string_view parent = path_extract_location(m.basic.path.data());
-                    imgui::TextUnformatted(parent.data(), parent.data() + parent.length() - 1);
+                    std::string const *parent = finder.search_task.result.directories.get(m.parent);
+                    if (parent != nullptr) { // always, interned before the chunk was published
+                        imgui::TextUnformatted(parent->data(), parent->data() + parent->size());
+                    }
                 }
             }
 
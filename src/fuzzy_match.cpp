@@ -0,0 +1,224 @@
+#include "fuzzy_match.hpp"
+
+#if !defined(_WIN32)
+#   include <algorithm>
+#   include <bit>
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__)
+#   define FUZZY_MATCH_SSE2 1
+#   include <emmintrin.h>
+#else
+#   define FUZZY_MATCH_SSE2 0
+#endif
+
+void highlight_spans::add(u64 start, u64 len) noexcept
+{
+    if (len == 0) {
+        return;
+    }
+    if (this->count > 0) {
+        auto &last = this->spans[this->count - 1];
+        if (start <= u64(last.start) + last.len || this->count == max_spans) {
+            last.len = u16(std::max(u64(last.start) + last.len, start + len) - last.start);
+            return;
+        }
+    }
+    this->spans[this->count++] = { u16(start), u16(len) };
+}
+
+//? Scoring constants from fzf (algo.go), so rankings feel the same as in the tool most people know this behaviour from.
+static constexpr s32 g_score_match = 16;
+static constexpr s32 g_score_gap_start = -3;
+static constexpr s32 g_score_gap_extension = -1;
+static constexpr s32 g_bonus_boundary = g_score_match / 2;
+static constexpr s32 g_bonus_boundary_white = g_bonus_boundary + 2;
+static constexpr s32 g_bonus_boundary_delimiter = g_bonus_boundary + 1;
+static constexpr s32 g_bonus_non_word = g_score_match / 2;
+static constexpr s32 g_bonus_camel_123 = g_bonus_boundary - 1;
+static constexpr s32 g_bonus_consecutive = -(g_score_gap_start + g_score_gap_extension);
+static constexpr s32 g_bonus_first_char_multiplier = 2;
+
+enum class char_class : u8
+{
+    white,
+    delimiter,
+    non_word,
+    lower,
+    upper,
+    number,
+};
+
+static
+char_class class_of(u8 ch) noexcept
+{
+    if (ch >= 'a' && ch <= 'z') return char_class::lower;
+    if (ch >= 'A' && ch <= 'Z') return char_class::upper;
+    if (ch >= '0' && ch <= '9') return char_class::number;
+    if (ch >= 0x80)             return char_class::lower; // part of a non-ASCII character, treated as a letter
+    if (ch == ' ' || ch == '\t') return char_class::white;
+    if (ch == '/' || ch == '\\' || ch == ',' || ch == ':' || ch == ';' || ch == '|') return char_class::delimiter;
+    return char_class::non_word;
+}
+
+static
+s32 bonus_for(char_class prev, char_class curr) noexcept
+{
+    bool curr_is_word = curr > char_class::non_word;
+
+    if (curr_is_word) {
+        if (prev == char_class::white)     return g_bonus_boundary_white;
+        if (prev == char_class::delimiter) return g_bonus_boundary_delimiter;
+        if (prev == char_class::non_word)  return g_bonus_boundary;
+    }
+    if ((prev == char_class::lower && curr == char_class::upper) || (prev != char_class::number && curr == char_class::number)) {
+        return g_bonus_camel_123;
+    }
+    switch (curr) {
+        case char_class::non_word:
+        case char_class::delimiter: return g_bonus_non_word;
+        case char_class::white:     return g_bonus_boundary_white;
+        default:                    return 0;
+    }
+}
+
+/// Index of the first byte at or after `from` which equals `target` once OR-ed with `fold_mask`, or `len` if there is none.
+static
+u64 find_byte(u8 const *name, u64 len, u64 from, u8 target, u8 fold_mask) noexcept
+{
+    u64 i = from;
+
+#if FUZZY_MATCH_SSE2
+    __m128i target_vec = _mm_set1_epi8((char)target);
+    __m128i mask_vec = _mm_set1_epi8((char)fold_mask);
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i block = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<__m128i const *>(name + i)), mask_vec);
+        u32 hits = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(block, target_vec));
+        if (hits != 0) {
+            return i + (u64)std::countr_zero(hits);
+        }
+    }
+#endif
+
+    for (; i < len; ++i) {
+        if ((name[i] | fold_mask) == target) {
+            return i;
+        }
+    }
+    return len;
+}
+
+bool fuzzy_matcher::compile(std::string_view pattern_utf8, bool case_sensitive) noexcept
+{
+    this->error.clear();
+    this->pattern.clear();
+    this->ignore_ascii_case = !case_sensitive;
+
+    if (pattern_utf8.size() > max_pattern_len) {
+        this->error = "Fuzzy pattern is longer than 64 bytes";
+        return false;
+    }
+
+    for (u64 i = 0; i < pattern_utf8.size(); ++i) {
+        u8 ch = u8(pattern_utf8[i]);
+        bool letter = (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
+        bool fold = letter && this->ignore_ascii_case;
+        this->fold_masks[i] = fold ? 0x20 : 0;
+        this->pattern.push_back(char(fold ? (ch | 0x20) : ch));
+    }
+    return true;
+}
+
+s32 fuzzy_matcher::score(std::string_view name_utf8, highlight_spans *spans) const noexcept
+{
+    if (spans != nullptr) {
+        spans->clear();
+    }
+
+    u8 const *name = reinterpret_cast<u8 const *>(name_utf8.data());
+    u8 const *pattern_bytes = reinterpret_cast<u8 const *>(this->pattern.data());
+    u64 name_len = name_utf8.size();
+    u64 pattern_len = this->pattern.size();
+
+    if (pattern_len == 0) {
+        return 0;
+    }
+    if (name_len < pattern_len) {
+        return no_match;
+    }
+
+    // forward: first occurrence of the whole subsequence, this rejects most names
+    u64 start = 0;
+    u64 end = 0;
+    for (u64 p = 0; p < pattern_len; ++p) {
+        end = find_byte(name, name_len, end, pattern_bytes[p], this->fold_masks[p]);
+        if (end == name_len) {
+            return no_match;
+        }
+        if (p == 0) {
+            start = end;
+        }
+        ++end;
+    }
+
+    // backward: the latest start for that end, so "a_xab" for "ab" scores the tight "ab" rather than "a_xab"
+    {
+        u64 p = pattern_len;
+        for (u64 i = end; i-- > start; ) {
+            if ((name[i] | this->fold_masks[p - 1]) == pattern_bytes[p - 1] && --p == 0) {
+                start = i;
+                break;
+            }
+        }
+    }
+
+    s32 total = 0;
+    s32 first_bonus = 0;
+    u64 consecutive = 0;
+    u64 p = 0;
+    bool in_gap = false;
+    char_class prev_class = start > 0 ? class_of(name[start - 1]) : char_class::white;
+    u64 run_start = 0;
+
+    for (u64 i = start; i < end; ++i) {
+        char_class curr_class = class_of(name[i]);
+
+        if (p < pattern_len && (name[i] | this->fold_masks[p]) == pattern_bytes[p]) {
+            s32 bonus = bonus_for(prev_class, curr_class);
+
+            if (consecutive == 0) {
+                first_bonus = bonus;
+                run_start = i;
+            } else {
+                // a run keeps the bonus of the boundary it started at
+                if (bonus >= g_bonus_boundary && bonus > first_bonus) {
+                    first_bonus = bonus;
+                }
+                bonus = std::max({ bonus, first_bonus, g_bonus_consecutive });
+            }
+
+            total += g_score_match + (p == 0 ? bonus * g_bonus_first_char_multiplier : bonus);
+            in_gap = false;
+            ++consecutive;
+            ++p;
+        }
+        else {
+            if (consecutive > 0 && spans != nullptr) {
+                spans->add(run_start, consecutive);
+            }
+            total += in_gap ? g_score_gap_extension : g_score_gap_start;
+            in_gap = true;
+            consecutive = 0;
+            first_bonus = 0;
+        }
+
+        prev_class = curr_class;
+    }
+
+    if (consecutive > 0 && spans != nullptr) {
+        spans->add(run_start, consecutive);
+    }
+
+    return total;
+}
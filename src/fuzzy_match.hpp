@@ -0,0 +1,68 @@
+#pragma once
+
+//? Fuzzy subsequence matching with fzf-style scoring, for filters where typing a few characters of a name should find it.
+
+#if defined(_WIN32)
+#   include "stdafx.hpp"
+#else
+#   include <array>
+#   include <limits>
+#   include <string>
+#   include <string_view>
+#endif
+
+#include "primitives.hpp"
+
+/// Byte ranges of a name to highlight, e.g. where a filter matched. Fixed capacity so a row can hold one without allocating.
+struct highlight_spans
+{
+    struct span
+    {
+        u16 start;
+        u16 len;
+    };
+
+    static constexpr u64 max_spans = 6;
+
+    void clear() noexcept { this->count = 0; }
+    void set(u64 start, u64 len) noexcept { clear(); add(start, len); }
+
+    /// Appends a span after the existing ones, merged into the last one if they touch.
+    /// Once `max_spans` are used the last span is stretched to cover it instead, over-highlighting rather than losing the end.
+    void add(u64 start, u64 len) noexcept;
+
+    bool empty() const noexcept { return this->count == 0; }
+    span const *begin() const noexcept { return this->spans.data(); }
+    span const *end() const noexcept { return this->spans.data() + this->count; }
+
+    std::array<span, max_spans> spans = {};
+    u8 count = 0;
+};
+
+/// Matches a pattern as a subsequence of names, e.g. "expcpp" matches "explorer.cpp", and scores how good the match is.
+/// The score follows fzf's v1 algorithm: the first occurrence is found scanning forward, then shrunk by scanning backward from its
+/// end, and the characters in that window are scored with bonuses for word starts, camelCase humps and runs of consecutive
+/// characters, and penalties for gaps. Only ASCII letters are folded when ignoring case, other bytes compare exactly.
+///
+/// `score` doesn't allocate. The pattern is lower cased once by `compile`, names are folded in registers while SSE2 searches
+/// 16 bytes at a time for the next pattern character, which is where names that don't match spend all their time.
+struct fuzzy_matcher
+{
+    static constexpr s32 no_match = std::numeric_limits<s32>::min();
+    static constexpr u64 max_pattern_len = 64;
+
+    /// Returns false and sets `error` if the pattern is longer than `max_pattern_len` bytes.
+    bool compile(std::string_view pattern_utf8, bool case_sensitive) noexcept;
+
+    /// Higher is better, `no_match` if the pattern isn't a subsequence of `name_utf8`. An empty pattern matches everything with score 0.
+    /// `spans`, if given, receives the matched characters merged into runs.
+    s32 score(std::string_view name_utf8, highlight_spans *spans = nullptr) const noexcept;
+
+    bool matches(std::string_view name_utf8) const noexcept { return score(name_utf8) != no_match; }
+    bool empty() const noexcept { return this->pattern.empty(); }
+
+    std::string error = {};
+    std::string pattern = {};                         // lower case if `ignore_ascii_case`
+    std::array<u8, max_pattern_len> fold_masks = {};  // per pattern byte, 0x20 if a letter compared case insensitively
+    bool ignore_ascii_case = false;
+};
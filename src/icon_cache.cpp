@@ -0,0 +1,780 @@
+#include "stdafx.hpp"
+#include "common_functions.hpp"
+#include "icon_cache.hpp"
+#include "imgui_dependent_functions.hpp"
+#include "util.hpp"
+
+//? imgui_draw.cpp keeps its copy of the packer static, so this translation unit compiles its own.
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imgui/imstb_rectpack.h"
+
+icon_cache &global_state::icons() noexcept
+{
+    //? Never destroyed: explorers, recent files and file operations are static too and release their handles during exit,
+    //? and workers may still be publishing into it, neither may find the cache already gone.
+    static icon_cache *s_icons = new icon_cache();
+    return *s_icons;
+}
+
+icon_handle::icon_handle(icon_handle const &other) noexcept : slot(other.slot)
+{
+    if (this->slot != 0) {
+        global_state::icons().add_ref(this->slot);
+    }
+}
+
+icon_handle::icon_handle(icon_handle &&other) noexcept : slot(std::exchange(other.slot, 0)) {}
+
+icon_handle &icon_handle::operator=(icon_handle const &other) noexcept
+{
+    if (this != &other) {
+        if (other.slot != 0) {
+            global_state::icons().add_ref(other.slot);
+        }
+        this->reset();
+        this->slot = other.slot;
+    }
+    return *this;
+}
+
+icon_handle &icon_handle::operator=(icon_handle &&other) noexcept
+{
+    if (this != &other) {
+        this->reset();
+        this->slot = std::exchange(other.slot, 0);
+    }
+    return *this;
+}
+
+icon_handle::~icon_handle() noexcept
+{
+    this->reset();
+}
+
+void icon_handle::reset() noexcept
+{
+    if (this->slot != 0) {
+        global_state::icons().release(this->slot);
+        this->slot = 0;
+    }
+}
+
+icon_atlas::~icon_atlas() noexcept
+{
+    for (auto &pg : this->pages) {
+        delete pg.packer;
+        delete[] pg.nodes;
+    }
+}
+
+bool icon_atlas::allocate(u32 width, u32 height, u64 max_pages, placement &out) noexcept
+{
+    u32 padded_width = width + padding;
+    u32 padded_height = height + padding;
+    if (width == 0 || height == 0 || padded_width > page_size || padded_height > page_size) {
+        return false;
+    }
+
+    auto try_page = [&](u64 page_idx) noexcept {
+        page &pg = this->pages[page_idx];
+        stbrp_rect rect = {};
+        rect.w = (stbrp_coord)padded_width;
+        rect.h = (stbrp_coord)padded_height;
+        if (!stbrp_pack_rects(pg.packer, &rect, 1)) {
+            return false;
+        }
+        out = { u16(page_idx), u16(rect.x), u16(rect.y), u16(width), u16(height) };
+        pg.packed_pixels += u64(padded_width) * padded_height;
+        pg.live_pixels += u64(padded_width) * padded_height;
+        return true;
+    };
+
+    for (u64 i = 0; i < this->pages.size(); ++i) {
+        if (try_page(i)) {
+            return true;
+        }
+    }
+    if (this->pages.size() >= max_pages) {
+        return false;
+    }
+
+    page pg = {};
+    pg.packer = new stbrp_context();
+    pg.nodes = new stbrp_node[page_size];
+    stbrp_init_target(pg.packer, page_size, page_size, pg.nodes, page_size);
+
+    //? Cleared once so the padding between icons is transparent.
+    static std::vector<u8> const s_transparent(u64(page_size) * page_size * 4, 0);
+
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, page_size, page_size, 0, GL_BGRA, GL_UNSIGNED_BYTE, s_transparent.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    pg.texture = tex;
+
+    this->pages.push_back(pg);
+    return try_page(this->pages.size() - 1);
+}
+
+void icon_atlas::free(placement const &p) noexcept
+{
+    assert(p.valid() && p.page < this->pages.size());
+    this->pages[p.page].live_pixels -= u64(p.width + padding) * (p.height + padding);
+}
+
+void icon_atlas::upload(placement const &p, icon_pixels const &pixels) noexcept
+{
+    assert(p.valid() && p.width == pixels.width && p.height == pixels.height);
+
+    glBindTexture(GL_TEXTURE_2D, this->pages[p.page].texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, p.x, p.y, p.width, p.height, GL_BGRA, GL_UNSIGNED_BYTE, pixels.bgra.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void icon_atlas::reset_packing() noexcept
+{
+    for (auto &pg : this->pages) {
+        stbrp_init_target(pg.packer, page_size, page_size, pg.nodes, page_size);
+        pg.packed_pixels = 0;
+        pg.live_pixels = 0;
+    }
+}
+
+void icon_atlas::clear() noexcept
+{
+    for (auto &pg : this->pages) {
+        global_state::delete_icon_textures_queue().push_back(s64(pg.texture));
+        delete pg.packer;
+        delete[] pg.nodes;
+    }
+    this->pages.clear();
+}
+
+f64 icon_atlas::occupancy() const noexcept
+{
+    u64 live = 0;
+    for (auto const &pg : this->pages) live += pg.live_pixels;
+    return this->pages.empty() ? 0.0 : f64(live) / (f64(this->pages.size()) * page_size * page_size);
+}
+
+f64 icon_atlas::fragmentation() const noexcept
+{
+    u64 dead = 0;
+    for (auto const &pg : this->pages) dead += pg.packed_pixels - pg.live_pixels;
+    return this->pages.empty() ? 0.0 : f64(dead) / (f64(this->pages.size()) * page_size * page_size);
+}
+
+bool icon_store::open(std::filesystem::path const &full_path) noexcept
+{
+    this->close();
+
+    HANDLE file = CreateFileW(full_path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false; // first launch
+    }
+
+    LARGE_INTEGER file_size = {};
+    HANDLE mapping = NULL;
+    void const *view = nullptr;
+
+    if (GetFileSizeEx(file, &file_size) && u64(file_size.QuadPart) >= header_size) {
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    if (mapping != NULL) {
+        view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+    if (view == nullptr) {
+        if (mapping != NULL) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    bool indexed;
+    {
+        std::scoped_lock lock(this->mutex);
+        this->file = file;
+        this->mapping = mapping;
+        indexed = this->index(static_cast<u8 const *>(view), u64(file_size.QuadPart));
+        this->data = static_cast<u8 const *>(view); // unmapped by `close` even if malformed
+    }
+    if (!indexed) {
+        this->close();
+    }
+    return indexed;
+}
+
+void icon_store::close() noexcept
+{
+    std::scoped_lock lock(this->mutex);
+
+    if (this->mapping != NULL) {
+        if (this->data != nullptr) UnmapViewOfFile(this->data);
+        CloseHandle(this->mapping);
+    }
+    if (this->file != INVALID_HANDLE_VALUE) {
+        CloseHandle(this->file);
+    }
+    this->records.clear();
+    this->data = nullptr;
+    this->size = 0;
+    this->mapping = NULL;
+    this->file = INVALID_HANDLE_VALUE;
+}
+
+bool icon_store::index(u8 const *bytes, u64 num_bytes) noexcept
+{
+    this->records.clear();
+    this->data = nullptr;
+    this->size = 0;
+
+    auto read = [&](u64 offset, auto &value) noexcept {
+        if (offset + sizeof(value) > num_bytes) return false;
+        memcpy(&value, bytes + offset, sizeof(value));
+        return true;
+    };
+
+    u64 file_magic;
+    u32 file_version;
+    u32 num_records;
+    if (!read(0, file_magic) || !read(8, file_version) || !read(12, num_records) || file_magic != magic || file_version != version) {
+        return false;
+    }
+
+    u64 offset = header_size;
+    for (u32 i = 0; i < num_records; ++i) {
+        record rec = {};
+        u32 key_len;
+        if (!read(offset, rec.last_write_time) || !read(offset + 8, rec.width) || !read(offset + 12, rec.height) || !read(offset + 16, key_len)) {
+            this->records.clear();
+            return false;
+        }
+        offset += 20;
+
+        u64 pixels_size = u64(rec.width) * rec.height * 4;
+        bool sane = rec.width > 0 && rec.width <= max_icon_dimension && rec.height > 0 && rec.height <= max_icon_dimension
+                 && key_len > 0 && key_len <= 4096 && offset + key_len + pixels_size <= num_bytes;
+        if (!sane) {
+            this->records.clear();
+            return false;
+        }
+
+        std::string key(reinterpret_cast<char const *>(bytes + offset), key_len);
+        rec.pixels_offset = offset + key_len;
+        offset = rec.pixels_offset + pixels_size;
+
+        this->records.insert_or_assign(std::move(key), rec);
+    }
+
+    this->data = bytes;
+    this->size = num_bytes;
+    return true;
+}
+
+bool icon_store::find(std::string const &key, u64 last_write_time, icon_pixels &out) noexcept
+{
+    std::scoped_lock lock(this->mutex);
+
+    if (this->data == nullptr) {
+        return false;
+    }
+    auto found = this->records.find(key);
+    if (found == this->records.end()) {
+        return false;
+    }
+    record const &rec = found->second;
+    if (rec.last_write_time != last_write_time) {
+        ++this->num_stale;
+        return false;
+    }
+
+    u8 const *pixels = this->data + rec.pixels_offset;
+    out.bgra.assign(pixels, pixels + u64(rec.width) * rec.height * 4);
+    out.width = rec.width;
+    out.height = rec.height;
+    ++this->num_hits;
+    return true;
+}
+
+void icon_store::append_header(std::vector<u8> &out, u32 num_records) noexcept
+{
+    u64 offset = out.size();
+    out.resize(offset + header_size);
+    memcpy(out.data() + offset, &magic, 8);
+    memcpy(out.data() + offset + 8, &version, 4);
+    memcpy(out.data() + offset + 12, &num_records, 4);
+}
+
+void icon_store::append_record(std::vector<u8> &out, std::string_view key, u64 last_write_time, u32 width, u32 height, u8 const *bgra) noexcept
+{
+    u32 key_len = (u32)key.size();
+    u64 pixels_size = u64(width) * height * 4;
+    u64 offset = out.size();
+
+    out.resize(offset + 20 + key_len + pixels_size);
+    u8 *dst = out.data() + offset;
+    memcpy(dst, &last_write_time, 8);
+    memcpy(dst + 8, &width, 4);
+    memcpy(dst + 12, &height, 4);
+    memcpy(dst + 16, &key_len, 4);
+    memcpy(dst + 20, key.data(), key_len);
+    memcpy(dst + 20 + key_len, bgra, pixels_size);
+}
+
+bool icon_cache::has_unique_icon(std::string_view name_utf8) noexcept
+{
+    u64 dot = name_utf8.find_last_of('.');
+    if (dot == std::string_view::npos) {
+        return false;
+    }
+    std::string_view ext = name_utf8.substr(dot);
+    if (ext.size() != 4) {
+        return false;
+    }
+
+    std::array<char, 4> lower = {};
+    for (u64 i = 0; i < 4; ++i) {
+        lower[i] = (ext[i] >= 'A' && ext[i] <= 'Z') ? char(ext[i] + ('a' - 'A')) : ext[i];
+    }
+    std::string_view lower_ext(lower.data(), lower.size());
+
+    for (std::string_view unique : { ".exe", ".lnk", ".ico", ".url", ".cur", ".ani", ".scr" }) {
+        if (lower_ext == unique) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string icon_cache::key_for(std::string_view full_path_utf8, bool is_directory) noexcept
+{
+    u64 last_separator = full_path_utf8.find_last_of("\\/");
+    std::string_view name = last_separator == std::string_view::npos ? full_path_utf8 : full_path_utf8.substr(last_separator + 1);
+
+    std::string key;
+    if (is_directory || has_unique_icon(name)) {
+        key = "path:";
+        key.append(full_path_utf8);
+    } else {
+        u64 dot = name.find_last_of('.');
+        key = "ext:";
+        key.append(dot == std::string_view::npos ? std::string_view() : name.substr(dot));
+    }
+
+    for (char &ch : key) {
+        if (ch >= 'A' && ch <= 'Z') ch += 'a' - 'A';
+    }
+    return key;
+}
+
+icon_handle icon_cache::acquire(std::string_view full_path_utf8, bool is_directory) noexcept
+{
+    std::string key = key_for(full_path_utf8, is_directory);
+
+    std::scoped_lock lock(this->mutex);
+
+    if (auto found = this->slot_of_key.find(key); found != this->slot_of_key.end()) {
+        entry &e = this->entries[found->second];
+        if (e.ref_count++ == 0) {
+            --this->num_unreferenced;
+            //? Failures are only remembered while something refers to them, the file may exist by now (e.g. was restored).
+            if (e.state == entry_state::failed) {
+                e.state = entry_state::loading;
+                this->queued.push_back(found->second);
+                ++this->num_loading;
+            }
+        }
+        ++this->num_hits;
+        return icon_handle(found->second + 1);
+    }
+
+    ++this->num_misses;
+
+    u32 slot;
+    if (this->free_slots.empty()) {
+        slot = (u32)this->entries.size();
+        this->entries.emplace_back();
+    } else {
+        slot = this->free_slots.back();
+        this->free_slots.pop_back();
+    }
+
+    entry &e = this->entries[slot];
+    e.by_extension = key.starts_with("ext:");
+    e.path_utf8 = e.by_extension ? "icon" + key.substr(4) : std::string(full_path_utf8);
+    e.key = key;
+    e.placement = {};
+    e.pixels = {};
+    e.size = {};
+    e.ref_count = 1;
+    e.state = entry_state::loading;
+
+    this->slot_of_key.emplace(std::move(key), slot);
+    this->queued.push_back(slot);
+    ++this->num_loading;
+
+    return icon_handle(slot + 1);
+}
+
+icon_view icon_cache::view(icon_handle const &handle) noexcept
+{
+    if (handle.empty()) {
+        return {};
+    }
+    std::scoped_lock lock(this->mutex);
+    entry const &e = this->entries[handle.slot - 1];
+    if (e.state != entry_state::ready) {
+        return {};
+    }
+    return { s64(this->atlas.pages[e.placement.page].texture), e.size, this->atlas.uv0(e.placement), this->atlas.uv1(e.placement) };
+}
+
+void icon_cache::add_ref(u32 slot) noexcept
+{
+    std::scoped_lock lock(this->mutex);
+    entry &e = this->entries[slot - 1];
+    assert(e.state != entry_state::unused);
+    if (e.ref_count++ == 0) {
+        --this->num_unreferenced;
+    }
+}
+
+void icon_cache::release(u32 slot) noexcept
+{
+    std::scoped_lock lock(this->mutex);
+    entry &e = this->entries[slot - 1];
+    assert(e.ref_count > 0);
+    if (--e.ref_count == 0) {
+        e.release_tick = ++this->tick;
+        ++this->num_unreferenced;
+    }
+}
+
+namespace
+{
+    struct icon_request
+    {
+        u32 slot;
+        bool by_extension;
+        std::string key;
+        std::string path_utf8;
+    };
+}
+
+static
+void extract_icons_proc(icon_cache &cache, std::vector<icon_request> job) noexcept
+{
+    //? SHGetFileInfoW wants COM initialized on the calling thread.
+    HRESULT com_result = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+    SCOPE_EXIT { if (SUCCEEDED(com_result)) CoUninitialize(); };
+
+    std::vector<icon_cache::loaded_icon> loaded = {};
+    loaded.reserve(job.size());
+
+    for (auto const &request : job) {
+        icon_cache::loaded_icon icon = { request.slot, 0, {} };
+        wchar_t path_utf16[MAX_PATH];
+        if (!utf8_to_utf16(request.path_utf8.c_str(), path_utf16, lengthof(path_utf16))) {
+            loaded.push_back(std::move(icon));
+            continue;
+        }
+
+        //? Files which can't be queried are neither looked up nor persisted, their icon comes from the shell every time.
+        bool write_time_known = request.by_extension;
+        if (!request.by_extension) {
+            WIN32_FILE_ATTRIBUTE_DATA attributes;
+            if (GetFileAttributesExW(path_utf16, GetFileExInfoStandard, &attributes)) {
+                icon.last_write_time = (u64(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+                write_time_known = true;
+            }
+        }
+        if (!write_time_known || !cache.store.find(request.key, icon.last_write_time, icon.pixels)) {
+            (void) extract_icon_pixels(path_utf16, icon.pixels, request.by_extension);
+        }
+        loaded.push_back(std::move(icon));
+    }
+
+    std::scoped_lock lock(cache.mutex);
+    cache.loaded_icons.insert(cache.loaded_icons.end(), std::make_move_iterator(loaded.begin()), std::make_move_iterator(loaded.end()));
+}
+
+void icon_cache::update(u64 max_uploads, f64 budget_us) noexcept
+{
+    static std::vector<u32> s_queued = {};
+    static std::vector<loaded_icon> s_batch = {};
+    s_queued.clear();
+    s_batch.clear();
+    {
+        std::scoped_lock lock(this->mutex);
+        s_queued.swap(this->queued);
+
+        //? Newest first, they belong to the rows most recently scrolled to.
+        u64 num_taken = std::min(max_uploads, this->loaded_icons.size());
+        auto first_taken = this->loaded_icons.end() - s64(num_taken);
+        s_batch.insert(s_batch.end(), std::make_move_iterator(first_taken), std::make_move_iterator(this->loaded_icons.end()));
+        this->loaded_icons.erase(first_taken, this->loaded_icons.end());
+    }
+
+    //? Small jobs publish often, so icons pop in while scrolling rather than a screenful at a time.
+    //? Only the UI thread adds entries, so reading them without the lock is fine here.
+    for (u64 first = 0; first < s_queued.size(); first += icons_per_job) {
+        u64 last = std::min(first + icons_per_job, s_queued.size());
+        std::vector<icon_request> job = {};
+        job.reserve(last - first);
+        for (u64 i = first; i < last; ++i) {
+            entry const &e = this->entries[s_queued[i]];
+            job.push_back({ s_queued[i], e.by_extension, e.key, e.path_utf8 });
+        }
+        global_state::thread_pool().push_task(extract_icons_proc, std::ref(*this), std::move(job));
+    }
+
+    time_point_precise_t start = get_time_precise();
+    u64 num_done = 0;
+
+    for (; num_done < s_batch.size(); ++num_done) {
+        if (num_done > 0 && f64(time_diff_us(start, get_time_precise())) >= budget_us) {
+            break;
+        }
+        auto &icon = s_batch[num_done];
+
+        icon_atlas::placement placement = {};
+        if (!icon.pixels.bgra.empty()) {
+            u32 width = icon.pixels.width;
+            u32 height = icon.pixels.height;
+            bool placed = this->atlas.allocate(width, height, icon_atlas::soft_max_pages, placement);
+            if (!placed) {
+                this->make_room();
+                placed = this->atlas.allocate(width, height, icon_atlas::soft_max_pages, placement)
+                      || this->atlas.allocate(width, height, UINT64_MAX, placement); // everything left is in use
+            }
+            if (placed) {
+                this->atlas.upload(placement, icon.pixels);
+            }
+        }
+
+        //? Loading entries are never evicted, the slot still holds what was asked for.
+        //? Stored right away rather than after the loop, `make_room` must see every placed icon.
+        std::scoped_lock lock(this->mutex);
+        entry &e = this->entries[icon.slot];
+        assert(e.state == entry_state::loading);
+        e.placement = placement;
+        e.last_write_time = icon.last_write_time;
+        e.size = { f32(icon.pixels.width), f32(icon.pixels.height) };
+        e.pixels = std::move(icon.pixels);
+        e.state = placement.valid() ? entry_state::ready : entry_state::failed;
+        this->num_icons += placement.valid();
+        --this->num_loading;
+    }
+
+    if (num_done < s_batch.size()) {
+        std::scoped_lock lock(this->mutex);
+        this->loaded_icons.insert(this->loaded_icons.end(), std::make_move_iterator(s_batch.begin() + s64(num_done)), std::make_move_iterator(s_batch.end()));
+    }
+
+    this->uploads_last_frame = num_done;
+    this->upload_us_last_frame = f64(time_diff_us(start, get_time_precise()));
+
+    if (this->cold_start_us < 0 && this->num_hits + this->num_misses > 0 && this->num_loading == 0) {
+        this->cold_start_us = f64(time_diff_us(this->store_open_time, get_time_precise()));
+        print_debug_msg("icons complete %.1lf ms after startup, %zu icons, %zu from icons.bin (%zu stale)",
+                        this->cold_start_us / 1000.0, this->num_icons, this->store.num_hits, this->store.num_stale);
+    }
+
+    //? A quarter of slack, so one more release doesn't mean another scan of every entry next frame.
+    if (this->num_unreferenced > max_unreferenced) {
+        this->evict_unreferenced(max_unreferenced - max_unreferenced / 4);
+    }
+}
+
+void icon_cache::evict_unreferenced(u64 num_to_keep) noexcept
+{
+    std::scoped_lock lock(this->mutex);
+
+    if (this->num_unreferenced <= num_to_keep) {
+        return;
+    }
+
+    static std::vector<u32> s_candidates = {};
+    s_candidates.clear();
+
+    for (u32 slot = 0; slot < this->entries.size(); ++slot) {
+        entry const &e = this->entries[slot];
+        if (e.ref_count == 0 && (e.state == entry_state::ready || e.state == entry_state::failed)) {
+            s_candidates.push_back(slot);
+        }
+    }
+
+    std::sort(s_candidates.begin(), s_candidates.end(), [&](u32 left, u32 right) noexcept {
+        return this->entries[left].release_tick < this->entries[right].release_tick;
+    });
+
+    u64 num_to_evict = std::min(this->num_unreferenced - num_to_keep, u64(s_candidates.size()));
+
+    for (u64 i = 0; i < num_to_evict; ++i) {
+        u32 slot = s_candidates[i];
+        entry &e = this->entries[slot];
+
+        if (e.placement.valid()) {
+            this->atlas.free(e.placement);
+            --this->num_icons;
+        }
+        this->slot_of_key.erase(e.key);
+        e = {};
+        this->free_slots.push_back(slot);
+
+        --this->num_unreferenced;
+        ++this->num_evictions;
+    }
+
+    if (this->num_icons == 0) {
+        this->atlas.clear(); // e.g. file icons were turned off, nothing will be drawn from the pages
+    }
+}
+
+void icon_cache::make_room() noexcept
+{
+    this->evict_unreferenced(this->num_unreferenced / 2);
+
+    std::scoped_lock lock(this->mutex);
+
+    //? Tallest first packs tighter, and the order is deterministic so packing again after a refresh gives the same layout.
+    static std::vector<u32> s_live = {};
+    s_live.clear();
+    for (u32 slot = 0; slot < this->entries.size(); ++slot) {
+        if (this->entries[slot].placement.valid()) {
+            s_live.push_back(slot);
+        }
+    }
+    std::sort(s_live.begin(), s_live.end(), [&](u32 left, u32 right) noexcept {
+        auto const &l = this->entries[left].pixels;
+        auto const &r = this->entries[right].pixels;
+        return l.height != r.height ? l.height > r.height : left < right;
+    });
+
+    this->atlas.reset_packing();
+
+    //? Whole pages are rebuilt in memory and uploaded once, which also clears the space of evicted icons.
+    static std::vector<std::vector<u8>> s_page_pixels = {};
+    s_page_pixels.resize(this->atlas.pages.size());
+    for (auto &page_pixels : s_page_pixels) {
+        page_pixels.assign(u64(icon_atlas::page_size) * icon_atlas::page_size * 4, 0);
+    }
+
+    for (u32 slot : s_live) {
+        entry &e = this->entries[slot];
+        //? Fits, the same icons were packed into these pages before. Growing beyond them only covers a worse packing.
+        if (!this->atlas.allocate(e.pixels.width, e.pixels.height, UINT64_MAX, e.placement)) {
+            e.placement = {};
+            e.state = entry_state::failed;
+            --this->num_icons;
+            continue;
+        }
+        if (e.placement.page >= s_page_pixels.size()) {
+            this->atlas.upload(e.placement, e.pixels);
+            continue;
+        }
+        auto &page_pixels = s_page_pixels[e.placement.page];
+        for (u32 row = 0; row < e.pixels.height; ++row) {
+            u64 dst = ((u64(e.placement.y) + row) * icon_atlas::page_size + e.placement.x) * 4;
+            memcpy(page_pixels.data() + dst, e.pixels.bgra.data() + u64(row) * e.pixels.width * 4, u64(e.pixels.width) * 4);
+        }
+    }
+
+    for (u64 i = 0; i < s_page_pixels.size(); ++i) {
+        glBindTexture(GL_TEXTURE_2D, this->atlas.pages[i].texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, icon_atlas::page_size, icon_atlas::page_size, GL_BGRA, GL_UNSIGNED_BYTE, s_page_pixels[i].data());
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    ++this->num_repacks;
+}
+
+void icon_cache::open_store(std::filesystem::path const &full_path) noexcept
+{
+    this->store_path = full_path;
+    this->store_open_time = get_time_precise();
+
+    if (this->store.open(full_path)) {
+        print_debug_msg("SUCCESS %zu icons in [%s]", this->store.records.size(), full_path.generic_string().c_str());
+    } else {
+        print_debug_msg("no usable icon store at [%s]", full_path.generic_string().c_str());
+    }
+}
+
+bool icon_cache::save_store() noexcept
+try {
+    if (this->store_path.empty()) {
+        return false;
+    }
+
+    std::vector<u8> out = {};
+    icon_store::append_header(out, 0);
+    u32 num_records = 0;
+    std::unordered_set<std::string> written = {};
+
+    auto fits = [&](u64 key_len, u32 width, u32 height) noexcept {
+        return out.size() + 20 + key_len + u64(width) * height * 4 <= icon_store::max_bytes;
+    };
+
+    {
+        std::scoped_lock lock(this->mutex);
+
+        for (auto const &e : this->entries) {
+            bool persistable = e.state == entry_state::ready && (e.by_extension || e.last_write_time != 0);
+            if (!persistable || !fits(e.key.size(), e.pixels.width, e.pixels.height)) {
+                continue;
+            }
+            icon_store::append_record(out, e.key, e.last_write_time, e.pixels.width, e.pixels.height, e.pixels.bgra.data());
+            written.insert(e.key);
+            ++num_records;
+        }
+    }
+    {
+        //? Records this session never needed are carried over unchecked, they are validated when next used.
+        std::scoped_lock lock(this->store.mutex);
+
+        for (auto const &[key, rec] : this->store.records) {
+            if (written.contains(key) || !fits(key.size(), rec.width, rec.height)) {
+                continue;
+            }
+            icon_store::append_record(out, key, rec.last_write_time, rec.width, rec.height, this->store.data + rec.pixels_offset);
+            ++num_records;
+        }
+    }
+    memcpy(out.data() + 12, &num_records, sizeof(num_records));
+
+    this->store.close(); // a mapped file can't be replaced
+
+    std::filesystem::path temp_path = this->store_path;
+    temp_path += ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<char const *>(out.data()), (std::streamsize)out.size())) {
+            print_debug_msg("FAILED write [%s]", temp_path.generic_string().c_str());
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp_path, this->store_path, error);
+    if (error) {
+        print_debug_msg("FAILED rename [%s] %s", temp_path.generic_string().c_str(), error.message().c_str());
+        return false;
+    }
+
+    print_debug_msg("SUCCESS %u icons, %zu bytes", num_records, out.size());
+    return true;
+}
+catch (std::exception const &except) {
+    print_debug_msg("FAILED catch(std::exception) %s", except.what());
+    return false;
+}
+catch (...) {
+    print_debug_msg("FAILED catch(...)");
+    return false;
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+//? One atlas slot per distinct icon rather than one texture per row: a folder of thousands of .cpp files needs a single icon,
+//? shared by every explorer, the recent files and the file operations tables.
+
+#include "stdafx.hpp"
+#include "util.hpp"
+
+/// An icon as extracted from the shell, before it becomes a texture. Workers produce these, only the UI thread uploads them.
+struct icon_pixels
+{
+    std::vector<u8> bgra = {}; // 4 bytes per pixel, top row first, empty if extraction failed
+    u32 width = 0;
+    u32 height = 0;
+};
+
+/// A counted reference to an entry of the global `icon_cache`, held by anything which shows a file icon.
+/// Copying adds a reference, destroying or resetting drops one, so containers of them need no manual bookkeeping.
+/// Default constructed handles refer to nothing, meaning no icon was requested yet.
+struct icon_handle
+{
+    icon_handle() noexcept = default;
+    explicit icon_handle(u32 slot) noexcept : slot(slot) {} // adopts a reference already counted by the cache
+    icon_handle(icon_handle const &other) noexcept;
+    icon_handle(icon_handle &&other) noexcept;
+    icon_handle &operator=(icon_handle const &other) noexcept;
+    icon_handle &operator=(icon_handle &&other) noexcept;
+    ~icon_handle() noexcept;
+
+    bool empty() const noexcept { return slot == 0; }
+    void reset() noexcept;
+
+    u32 slot = 0; // index into icon_cache::entries plus 1, 0 means none
+};
+
+/// What to draw for a handle: `texture` is 0 while the icon is loading, or if it failed to load.
+/// Icons share atlas pages, so `uv0` and `uv1` must be passed on to `imgui::Image`.
+struct icon_view
+{
+    s64 texture = 0;
+    ImVec2 size = {};
+    ImVec2 uv0 = { 0, 0 };
+    ImVec2 uv1 = { 1, 1 };
+
+    bool ready() const noexcept { return texture > 0; }
+};
+
+struct stbrp_context;
+struct stbrp_node;
+
+/// A few large textures icons are packed into with imstb_rectpack, so consecutive rows draw from the same texture and
+/// ImGui can batch them, rather than switching textures for every row. Placements are never freed individually,
+/// space left by evicted icons comes back when everything still alive is packed again (see `icon_cache::make_room`).
+/// UI thread only.
+struct icon_atlas
+{
+    static constexpr u32 page_size = 512;
+    static constexpr u32 padding = 1;       // transparent gap, so icons drawn scaled (e.g. in tooltips) don't sample their neighbours
+    static constexpr u64 soft_max_pages = 4; // full beyond this means evicting, only icons in use may grow the atlas further
+
+    struct placement
+    {
+        u16 page = UINT16_MAX;
+        u16 x = 0;
+        u16 y = 0;
+        u16 width = 0;
+        u16 height = 0;
+
+        bool valid() const noexcept { return page != UINT16_MAX; }
+    };
+
+    struct page
+    {
+        u32 texture = 0;
+        stbrp_context *packer = nullptr;
+        stbrp_node *nodes = nullptr;
+        u64 packed_pixels = 0; // including the space of freed placements, until the next `reset_packing`
+        u64 live_pixels = 0;
+    };
+
+    icon_atlas() noexcept = default;
+    icon_atlas(icon_atlas const &) = delete;
+    icon_atlas &operator=(icon_atlas const &) = delete;
+    ~icon_atlas() noexcept;
+
+    /// Space for a `width` by `height` icon in one of the pages, adding pages while there are fewer than `max_pages`.
+    bool allocate(u32 width, u32 height, u64 max_pages, placement &out) noexcept;
+    void free(placement const &p) noexcept;
+    void upload(placement const &p, icon_pixels const &pixels) noexcept;
+
+    /// Forgets every placement, pages and their textures are kept to be packed again.
+    void reset_packing() noexcept;
+
+    /// Deletes every page, their textures after the current frame.
+    void clear() noexcept;
+
+    ImVec2 uv0(placement const &p) const noexcept { return { f32(p.x) / page_size, f32(p.y) / page_size }; }
+    ImVec2 uv1(placement const &p) const noexcept { return { f32(p.x + p.width) / page_size, f32(p.y + p.height) / page_size }; }
+
+    f64 occupancy() const noexcept;     // live icon pixels over the pixels of all pages
+    f64 fragmentation() const noexcept; // pixels of freed placements over the pixels of all pages
+
+    std::vector<page> pages = {};
+};
+
+/// Icons extracted in earlier sessions, persisted in data\icons.bin so a cold start doesn't ask the shell for every icon again.
+/// The file is memory mapped and only its keys are read when opened. Pixels are copied out, and records keyed by path checked
+/// against the file's last write time, when an icon is first needed. `icon_cache::save_store` rewrites it on exit.
+///
+/// Layout, little endian: u64 magic, u32 version, u32 record count, then per record u64 last write time (0 for extension keys),
+/// u32 width, u32 height, u32 key length, the key, and width * height BGRA pixels.
+/// Thread safe, workers look icons up while the UI thread runs.
+struct icon_store
+{
+    static constexpr u64 magic = 0x314f43494e415753; // "SWANICO1"
+    static constexpr u32 version = 1;
+    static constexpr u64 header_size = 16;
+    static constexpr u64 max_bytes = 32 * 1024 * 1024; // what `save_store` writes at most
+    static constexpr u32 max_icon_dimension = 256;
+
+    struct record
+    {
+        u64 last_write_time;
+        u32 width;
+        u32 height;
+        u64 pixels_offset; // into the mapping
+    };
+
+    icon_store() noexcept = default;
+    icon_store(icon_store const &) = delete;
+    icon_store &operator=(icon_store const &) = delete;
+    ~icon_store() noexcept { this->close(); }
+
+    /// Maps the file and indexes it, false if it's missing or malformed, in which case the store stays empty.
+    bool open(std::filesystem::path const &full_path) noexcept;
+    void close() noexcept;
+
+    /// Reads the keys of a mapped (or, in tests, any) buffer which must outlive the store's use of it.
+    bool index(u8 const *data, u64 size) noexcept;
+
+    /// Copies the pixels of the record for `key` if its last write time matches. Counts a hit, a stale record, or nothing.
+    bool find(std::string const &key, u64 last_write_time, icon_pixels &out) noexcept;
+
+    static void append_header(std::vector<u8> &out, u32 num_records) noexcept;
+    static void append_record(std::vector<u8> &out, std::string_view key, u64 last_write_time, u32 width, u32 height, u8 const *bgra) noexcept;
+
+    std::mutex mutex = {};
+    std::unordered_map<std::string, record> records = {};
+    u8 const *data = nullptr;
+    u64 size = 0;
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+    u64 num_hits = 0;
+    u64 num_stale = 0;
+};
+
+/// Reference counted icon textures keyed by extension for ordinary files, and by full path for directories and for types
+/// whose icon belongs to the individual file (see `has_unique_icon`). Icons are extracted by thread pool workers and
+/// uploaded by the UI thread in `update`. Entries nothing refers to keep their texture for a while, so coming back to a folder
+/// (or refreshing it) doesn't load everything again, the least recently released are freed beyond `max_unreferenced`
+/// or when the atlas is full.
+///
+/// Thread safe: handles may be copied and destroyed on any thread. `acquire`, `view`, `update` and `evict_unreferenced`
+/// touch OpenGL or queue work and belong to the UI thread.
+struct icon_cache
+{
+    enum class entry_state : u8
+    {
+        unused,  // free slot
+        loading, // queued or with a worker
+        ready,
+        failed,
+    };
+
+    struct entry
+    {
+        std::string key = {};       // "ext:.cpp" or "path:c:\dir\app.exe", see `key_for`
+        std::string path_utf8 = {}; // what the shell is asked about
+        icon_atlas::placement placement = {};
+        icon_pixels pixels = {};    // kept to pack the atlas again
+        ImVec2 size = {};
+        u64 release_tick = 0;       // orders unreferenced entries for eviction
+        u32 ref_count = 0;
+        entry_state state = entry_state::unused;
+        u64 last_write_time = 0;    // of the file when its icon was extracted, persisted along with path keyed icons
+        bool by_extension = false;  // the shell is asked about the extension alone, without touching the disk
+    };
+
+    struct loaded_icon
+    {
+        u32 slot;
+        u64 last_write_time; // of the file, 0 if unknown or keyed by extension
+        icon_pixels pixels;  // empty if extraction failed
+    };
+
+    static constexpr u64 max_unreferenced = 512;
+    static constexpr u64 icons_per_job = 8;
+
+    /// Files whose icon is embedded in (.exe, .ico) or borrowed by (.lnk, .url) the file itself, rather than given by their type.
+    static bool has_unique_icon(std::string_view name_utf8) noexcept;
+
+    /// "ext:" and the lower cased extension for ordinary files, "path:" and the lower cased path otherwise.
+    static std::string key_for(std::string_view full_path_utf8, bool is_directory) noexcept;
+
+    /// A handle to the icon for `full_path_utf8`, queueing its extraction if no entry has it. Counts a hit or a miss.
+    icon_handle acquire(std::string_view full_path_utf8, bool is_directory) noexcept;
+
+    /// UI thread only, the atlas may change between frames.
+    icon_view view(icon_handle const &handle) noexcept;
+
+    void add_ref(u32 slot) noexcept;
+    void release(u32 slot) noexcept;
+
+    /// Once per frame: hands queued extractions to the thread pool, uploads what workers extracted (at most `max_uploads`
+    /// for about `budget_us`, the rest wait for the next frame) and evicts down to `max_unreferenced`.
+    void update(u64 max_uploads, f64 budget_us) noexcept;
+
+    /// Frees the atlas space of all but the `num_to_keep` most recently released entries nothing refers to.
+    void evict_unreferenced(u64 num_to_keep) noexcept;
+
+    /// For when the atlas is full: evicts the least recently released half of the unreferenced entries,
+    /// then packs the remaining icons again from their kept pixels. UI thread only.
+    void make_room() noexcept;
+
+    /// Opens data\icons.bin, also where cold start timing starts from.
+    void open_store(std::filesystem::path const &full_path) noexcept;
+
+    /// Writes every icon of this session and the records of the old file it didn't get to, up to `icon_store::max_bytes`.
+    bool save_store() noexcept;
+
+    std::mutex mutex = {};
+    std::vector<entry> entries = {};
+    std::vector<u32> free_slots = {};
+    std::unordered_map<std::string, u32> slot_of_key = {};
+    std::vector<u32> queued = {};               // slots waiting to be handed to workers
+    std::vector<loaded_icon> loaded_icons = {}; // published by workers
+    icon_atlas atlas = {};
+    icon_store store = {};
+    std::filesystem::path store_path = {};
+    time_point_precise_t store_open_time = {};
+
+    u64 tick = 0;
+    u64 num_hits = 0;
+    u64 num_misses = 0;
+    u64 num_evictions = 0;
+    u64 num_icons = 0; // in the atlas
+    u64 num_repacks = 0;
+    u64 num_loading = 0; // queued or with a worker
+    u64 num_unreferenced = 0;
+    u64 uploads_last_frame = 0;
+    f64 upload_us_last_frame = 0;
+    f64 cold_start_us = -1; // from `open_store` to the first frame where every requested icon could be drawn, -1 until then
+};
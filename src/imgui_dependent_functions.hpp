@@ -7,6 +7,7 @@
 #include "stdafx.hpp"
 #include "common_functions.hpp"
 #include "imgui_extension.hpp"
+#include "substring_search.hpp"
 
 void BeginFrame_GLFW_OpenGL3(char const *ini_file_path) noexcept;
 void EndFrame_GLFW_OpenGL3(GLFWwindow *) noexcept;
@@ -41,9 +42,9 @@ ImGuiStyle swan_default_imgui_style() noexcept;
 typedef wchar_t* filter_chars_callback_user_data_t;
 s32 filter_chars_callback(ImGuiInputTextCallbackData *data) noexcept;
 
-std::variant<s64, basic_dirent::kind> appropriate_icon(s64 tex_id, basic_dirent::kind obj_type) noexcept;
+std::variant<icon_view, basic_dirent::kind> appropriate_icon(icon_handle const &icon, basic_dirent::kind obj_type) noexcept;
 
-void render_path_with_stylish_separators(char const *path, std::variant<s64, basic_dirent::kind> icon) noexcept;
+void render_path_with_stylish_separators(char const *path, std::variant<icon_view, basic_dirent::kind> icon) noexcept;
 
 struct debug_log_record
 {
@@ -54,15 +55,15 @@ struct debug_log_record
     s32 thread_id;
     u32 num_repeats; // when a duplicate message is printed, this counter is incremented instead of creating a new instance
 
-    bool matches_search_text(char const *search_substr) const noexcept
+    bool matches_search_text(substring_matcher const &search) const noexcept
     {
-        assert(!cstr_empty(search_substr));
+        assert(!search.empty());
         bool match =
-            StrStrIA(this->loc.file_name(),                               search_substr) ||
-            StrStrIA(this->loc.function_name(),                           search_substr) ||
-            StrStrIA(this->message.c_str(),                               search_substr) ||
-            StrStrIA(make_str_static<32>("%zu", this->loc.line()).data(), search_substr) ||
-            StrStrIA(make_str_static<32>("%zu", this->thread_id).data(),  search_substr)
+            search.matches(this->loc.file_name())                               ||
+            search.matches(this->loc.function_name())                           ||
+            search.matches(this->message)                                       ||
+            search.matches(make_str_static<32>("%zu", this->loc.line()).data()) ||
+            search.matches(make_str_static<32>("%zu", this->thread_id).data())
         ;
         return match;
     }
@@ -74,6 +75,7 @@ struct debug_log
     std::source_location loc;
 
     static std::string g_search_text;
+    static substring_matcher g_search_matcher; // compiled from g_search_text whenever it's edited, guarded by g_mutex
     static std::vector<debug_log_record> g_records;
     static std::vector<u64> g_records_visible_indices;
     static std::mutex g_mutex;
@@ -127,15 +129,12 @@ void print_debug_msg([[maybe_unused]] debug_log pack, [[maybe_unused]] Args&&...
 
         bool record_matches_search_text = false;
 
-        if (debug_log::g_search_text.size()) {
-            auto markdown_line_copy = markdown_line;
-            char const *piece = strtok(markdown_line_copy.data(), "|");
-            while (piece != nullptr) {
-                if (StrStrIA(piece, debug_log::g_search_text.c_str())) {
-                    record_matches_search_text = true;
-                    break;
-                }
-                piece = strtok(nullptr, "|");
+        if (!debug_log::g_search_matcher.empty()) {
+            std::string_view remaining(markdown_line.data());
+            while (!remaining.empty() && !record_matches_search_text) {
+                u64 piece_len = std::min(remaining.find('|'), remaining.size());
+                record_matches_search_text = debug_log::g_search_matcher.matches(remaining.substr(0, piece_len));
+                remaining.remove_prefix(std::min(piece_len + 1, remaining.size()));
             }
         }
 
@@ -152,7 +151,7 @@ void print_debug_msg([[maybe_unused]] debug_log pack, [[maybe_unused]] Args&&...
 
             debug_log::g_records.emplace_back(formatted_message.data(), pack.loc, system_time, imgui_time, thread_id, 0);
 
-            if (debug_log::g_search_text.empty() || record_matches_search_text) {
+            if (debug_log::g_search_matcher.empty() || record_matches_search_text) {
                 debug_log::g_records_visible_indices.push_back(std::max<u64>(debug_log::g_records.size(), 1) - 1);
             }
         }
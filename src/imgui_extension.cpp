@@ -301,6 +301,13 @@ void imgui::HighlightTextRegion(ImVec2 const &text_rect_min, char const *text, u
     ImGui::GetWindowDrawList()->AddRect(min, max, imgui::ImVec4_to_ImU32(border_color));
 }
 
+void imgui::HighlightTextRegions(ImVec2 const &text_rect_min, char const *text, highlight_spans const &spans, ImVec4 color) noexcept
+{
+    for (auto const &span : spans) {
+        imgui::HighlightTextRegion(text_rect_min, text, span.start, span.len, color);
+    }
+}
+
 f32 imgui::CalcLineLength(ImVec2 const &p1, ImVec2 const &p2) noexcept
 {
     f32 dx = p2.x - p1.x;
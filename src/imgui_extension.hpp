@@ -6,6 +6,7 @@
 #pragma once
 
 #include "stdafx.hpp"
+#include "fuzzy_match.hpp"
 
 namespace ImGui
 {
@@ -43,6 +44,8 @@ namespace ImGui
 
     void HighlightTextRegion(ImVec2 const &text_rect_min, char const *text, u64 highlight_start_idx, u64 highlight_len, ImVec4 color) noexcept;
 
+    void HighlightTextRegions(ImVec2 const &text_rect_min, char const *text, highlight_spans const &spans, ImVec4 color) noexcept;
+
     bool IsColumnTextVisuallyTruncated(s32 table_column_index, char const *column_text, f32 column_text_offset_x = 0) noexcept;
 
     bool RenderTooltipWhenColumnTextTruncated(s32 table_column_index, char const *possibly_truncated_text, f32 possibly_truncated_text_offset_x = 0, char const *tooltip_content = nullptr) noexcept;
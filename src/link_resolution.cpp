@@ -0,0 +1,118 @@
+#include "link_resolution.hpp"
+
+#if !defined(_WIN32)
+#   include <sys/stat.h>
+#endif
+
+#if defined(_WIN32)
+
+shell_link_classifier::~shell_link_classifier() noexcept
+{
+    if (this->persist_file) this->persist_file->Release();
+    if (this->shell_link) this->shell_link->Release();
+    if (this->com_initialized) CoUninitialize();
+}
+
+bool shell_link_classifier::is_link(std::string_view name_utf8, directory_entry_kind kind) const noexcept
+{
+    return kind == directory_entry_kind::file && name_utf8.ends_with(".lnk");
+}
+
+link_target_kind shell_link_classifier::classify(char const *full_path_utf8) noexcept
+{
+    if (this->persist_file == nullptr && !this->com_failed) {
+        this->com_initialized = SUCCEEDED(CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED));
+        this->com_failed = !this->com_initialized
+            || FAILED(CoCreateInstance(CLSID_ShellLink, nullptr, CLSCTX_INPROC_SERVER, IID_IShellLinkW, (LPVOID *)&this->shell_link))
+            || FAILED(this->shell_link->QueryInterface(IID_IPersistFile, (LPVOID *)&this->persist_file));
+    }
+    if (this->com_failed) {
+        return link_target_kind::unresolved;
+    }
+
+    wchar_t full_path_utf16[2048];
+    if (MultiByteToWideChar(CP_UTF8, 0, full_path_utf8, -1, full_path_utf16, (s32)std::size(full_path_utf16)) <= 1) {
+        return link_target_kind::invalid;
+    }
+
+    if (FAILED(this->persist_file->Load(full_path_utf16, STGM_READ))) {
+        return link_target_kind::invalid;
+    }
+
+    wchar_t target_path_utf16[MAX_PATH];
+    if (FAILED(this->shell_link->GetPath(target_path_utf16, (s32)std::size(target_path_utf16), NULL, SLGP_RAWPATH))) {
+        return link_target_kind::invalid;
+    }
+
+    if      (PathIsDirectoryW(target_path_utf16)) return link_target_kind::directory;
+    else if (PathFileExistsW(target_path_utf16))  return link_target_kind::file;
+    else                                          return link_target_kind::invalid;
+}
+
+std::unique_ptr<link_classifier> make_link_classifier() noexcept
+{
+    return std::make_unique<shell_link_classifier>();
+}
+
+#else // POSIX
+
+bool symlink_classifier::is_link([[maybe_unused]] std::string_view name_utf8, directory_entry_kind kind) const noexcept
+{
+    return kind == directory_entry_kind::symlink;
+}
+
+link_target_kind symlink_classifier::classify(char const *full_path_utf8) noexcept
+{
+    struct stat target;
+    if (::stat(full_path_utf8, &target) != 0) { // follows the link
+        return link_target_kind::invalid;
+    }
+    return S_ISDIR(target.st_mode) ? link_target_kind::directory : link_target_kind::file;
+}
+
+std::unique_ptr<link_classifier> make_link_classifier() noexcept
+{
+    return std::make_unique<symlink_classifier>();
+}
+
+#endif
+
+bool link_resolution_cache::find(std::string_view full_path_utf8, u64 last_write_time, link_target_kind &out) noexcept
+{
+    std::scoped_lock lock(this->mutex);
+
+    auto iter = this->map.find(std::string(full_path_utf8));
+    if (iter == this->map.end() || iter->second.last_write_time != last_write_time) {
+        ++this->num_misses;
+        return false;
+    }
+    ++this->num_hits;
+    out = iter->second.kind;
+    return true;
+}
+
+void link_resolution_cache::store(std::string_view full_path_utf8, u64 last_write_time, link_target_kind kind) noexcept
+{
+    if (kind == link_target_kind::unresolved) {
+        return; // worth retrying next time
+    }
+
+    std::scoped_lock lock(this->mutex);
+
+    if (this->map.size() >= max_entries) {
+        this->map.clear();
+    }
+    this->map.insert_or_assign(std::string(full_path_utf8), value{ last_write_time, kind });
+}
+
+void link_resolution_cache::clear() noexcept
+{
+    std::scoped_lock lock(this->mutex);
+    this->map.clear();
+}
+
+u64 link_resolution_cache::size() noexcept
+{
+    std::scoped_lock lock(this->mutex);
+    return this->map.size();
+}
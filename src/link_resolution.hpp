@@ -0,0 +1,94 @@
+#pragma once
+
+//? Classification of link entries (.lnk shortcuts on Win32, symlinks on POSIX) by what their target is.
+
+#if defined(_WIN32)
+#   include "stdafx.hpp"
+#else
+#   include <atomic>
+#   include <memory>
+#   include <mutex>
+#   include <string>
+#   include <string_view>
+#   include <unordered_map>
+#endif
+
+#include "primitives.hpp"
+#include "directory_enumeration.hpp"
+
+enum class link_target_kind : u8
+{
+    unresolved, // the classifier couldn't find out, e.g. COM unavailable
+    directory,
+    file,
+    invalid,    // broken link or missing target
+};
+
+/// Decides which directory entries are links and what their targets are.
+/// Instances are not thread safe and may hold per-thread resources (COM objects), every worker creates its own.
+struct link_classifier
+{
+    virtual ~link_classifier() noexcept = default;
+
+    /// Cheap, only looks at what the directory listing already reported.
+    virtual bool is_link(std::string_view name_utf8, directory_entry_kind kind) const noexcept = 0;
+
+    /// Potentially slow, may touch the network for links to remote targets.
+    virtual link_target_kind classify(char const *full_path_utf8) noexcept = 0;
+};
+
+#if defined(_WIN32)
+
+/// .lnk files, resolved through IShellLinkW. COM is initialized for the calling thread on the first `classify`.
+struct shell_link_classifier final : link_classifier
+{
+    shell_link_classifier() noexcept = default;
+    shell_link_classifier(shell_link_classifier const &) = delete;
+    shell_link_classifier &operator=(shell_link_classifier const &) = delete;
+    ~shell_link_classifier() noexcept override;
+
+    bool is_link(std::string_view name_utf8, directory_entry_kind kind) const noexcept override;
+    link_target_kind classify(char const *full_path_utf8) noexcept override;
+
+    IShellLinkW *shell_link = nullptr;
+    IPersistFile *persist_file = nullptr;
+    bool com_initialized = false;
+    bool com_failed = false;
+};
+
+#else
+
+/// Symbolic links, resolved with stat().
+struct symlink_classifier final : link_classifier
+{
+    bool is_link(std::string_view name_utf8, directory_entry_kind kind) const noexcept override;
+    link_target_kind classify(char const *full_path_utf8) noexcept override;
+};
+
+#endif
+
+/// The native classifier of the platform.
+std::unique_ptr<link_classifier> make_link_classifier() noexcept;
+
+/// Thread safe memo of classified links keyed by (full path, last write time of the link itself),
+/// so that re-listing a folder of shortcuts doesn't resolve them all over again. Cleared wholesale once full.
+struct link_resolution_cache
+{
+    static constexpr u64 max_entries = 64 * 1024;
+
+    bool find(std::string_view full_path_utf8, u64 last_write_time, link_target_kind &out) noexcept;
+    void store(std::string_view full_path_utf8, u64 last_write_time, link_target_kind kind) noexcept;
+    void clear() noexcept;
+    u64 size() noexcept;
+
+    struct value
+    {
+        u64 last_write_time;
+        link_target_kind kind;
+    };
+
+    std::mutex mutex = {};
+    std::unordered_map<std::string, value> map = {};
+    std::atomic<u64> num_hits = 0;
+    std::atomic<u64> num_misses = 0;
+};
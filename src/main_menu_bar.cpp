@@ -189,25 +189,26 @@ void render_main_menu_bar(GLFWwindow *window, std::array<explorer_window, global
                 setting_change = true;
 
                 for (auto &expl : global_state::explorers()) {
-                    for (auto &dirent : expl.cwd_entries) {
-                        if (dirent.icon_GLtexID > 0) delete_icon_texture(dirent.icon_GLtexID, "explorer_window::dirent");
+                    for (auto &ui : expl.cwd_entries.ui) {
+                        ui.icon.reset();
                     }
                 }
                 {
                     auto recent_files = global_state::recent_files_get();
                     std::scoped_lock lock(*recent_files.mutex);
                     for (auto &rf : *recent_files.container) {
-                        if (rf.icon_GLtexID > 0) delete_icon_texture(rf.icon_GLtexID, "recent_file");
+                        rf.icon.reset();
                     }
                 }
                 {
                     auto completed_file_operations = global_state::completed_file_operations_get();
                     std::scoped_lock lock(*completed_file_operations.mutex);
                     for (auto &cfo : *completed_file_operations.container) {
-                        if (cfo.src_icon_GLtexID > 0) delete_icon_texture(cfo.src_icon_GLtexID, "completed_file_operation");
-                        if (cfo.dst_icon_GLtexID > 0) delete_icon_texture(cfo.dst_icon_GLtexID, "completed_file_operation");
+                        cfo.src_icon.reset();
+                        cfo.dst_icon.reset();
                     }
                 }
+                global_state::icons().evict_unreferenced(0);
             }
 
             setting_change |= imgui::MenuItem("Alternating table rows background", nullptr, &global_state::settings().tables_alt_row_bg);
@@ -240,6 +241,28 @@ void render_main_menu_bar(GLFWwindow *window, std::array<explorer_window, global
 
                 setting_change |= imgui::MenuItem("Clear filter on navigation", nullptr, &global_state::settings().explorer_clear_filter_on_cwd_change);
 
+                {
+                    imgui::ScopedItemWidth w(imgui::CalcTextSize("1000000000").x + 50);
+                    auto &min_entries = global_state::settings().explorer_parallel_filter_min_entries;
+                    setting_change |= imgui::InputInt("Filter in parallel from N entries", &min_entries, 0);
+                    min_entries = std::clamp(min_entries, 0, INT32_MAX);
+                    if (imgui::IsItemHovered()) {
+                        imgui::SetTooltip("Directories with at least this many entries are filtered on several threads, 0 to never");
+                    }
+                }
+
+                imgui::EndMenu();
+            }
+
+            if (imgui::BeginMenu("Finder")) {
+                imgui::ScopedItemWidth w(imgui::CalcTextSize("1000").x + 50);
+                auto &num_threads = global_state::settings().finder_num_threads;
+                setting_change |= imgui::InputInt("Search threads", &num_threads, 0);
+                num_threads = std::clamp(num_threads, 0, (s32)directory_traversal::max_threads);
+                if (imgui::IsItemHovered()) {
+                    imgui::SetTooltip("How many directories a search lists at once, 0 for one per hardware thread.\n"
+                                      "Takes effect with the next search.");
+                }
                 imgui::EndMenu();
             }
 
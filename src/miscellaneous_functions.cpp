@@ -56,9 +56,14 @@ char const *basic_dirent::kind_description(basic_dirent::kind t) noexcept
 
 char const *basic_dirent::kind_short_cstr() const noexcept
 {
-    assert(this->type >= basic_dirent::kind::nil && this->type <= basic_dirent::kind::count);
+    return basic_dirent::kind_short_cstr(this->type);
+}
 
-    switch (this->type) {
+char const *basic_dirent::kind_short_cstr(basic_dirent::kind t) noexcept
+{
+    assert(t >= basic_dirent::kind::nil && t <= basic_dirent::kind::count);
+
+    switch (t) {
         case basic_dirent::kind::directory:            return "dir";
         case basic_dirent::kind::file:                 return "file";
         case basic_dirent::kind::symlink_to_directory: return ICON_CI_ARROW_SMALL_RIGHT "d";
@@ -74,6 +79,11 @@ char const *basic_dirent::kind_icon() const noexcept
     return get_icon(this->type);
 }
 
+char const *basic_dirent::kind_icon(basic_dirent::kind t) noexcept
+{
+    return get_icon(t);
+}
+
 char const *get_icon(basic_dirent::kind t) noexcept
 {
     switch (t) {
@@ -88,6 +98,123 @@ char const *get_icon(basic_dirent::kind t) noexcept
     return ICON_CI_ERROR;
 }
 
+u64 name_hash_set::hash(std::string_view name) noexcept
+{
+    // FNV-1a, names are short so anything fancier doesn't pay off
+    u64 h = 14695981039346656037ULL;
+    for (char ch : name) {
+        h ^= (u8)ch;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+void name_hash_set::clear() noexcept
+{
+    std::fill(this->slots.begin(), this->slots.end(), slot{});
+    this->names.clear();
+    this->num_occupied = 0;
+    this->num_erased = 0;
+}
+
+void name_hash_set::reserve(u64 num_names) noexcept
+{
+    u64 num_slots = std::max(u64(16), std::bit_ceil(num_names * 2));
+    if (num_slots > this->slots.size()) {
+        rehash(num_slots);
+    }
+}
+
+u64 name_hash_set::find_slot(std::string_view name, u64 name_hash) const noexcept
+{
+    assert(!this->slots.empty());
+
+    u64 mask = this->slots.size() - 1;
+    u64 first_erased = u64(-1);
+
+    for (u64 idx = name_hash & mask; ; idx = (idx + 1) & mask) {
+        slot const &s = this->slots[idx];
+
+        if (s.state == 0) {
+            return first_erased != u64(-1) ? first_erased : idx;
+        }
+        if (s.state == 2) {
+            if (first_erased == u64(-1)) first_erased = idx;
+            continue;
+        }
+        if (s.hash == name_hash && s.name_len == name.size() && memcmp(this->names.data() + s.name_offset, name.data(), name.size()) == 0) {
+            return idx;
+        }
+    }
+}
+
+void name_hash_set::rehash(u64 num_slots) noexcept
+{
+    std::vector<slot> old_slots = std::move(this->slots);
+    this->slots.assign(num_slots, slot{});
+    this->num_erased = 0;
+
+    u64 mask = num_slots - 1;
+    for (slot const &s : old_slots) {
+        if (s.state == 1) {
+            u64 idx = s.hash & mask;
+            while (this->slots[idx].state != 0) {
+                idx = (idx + 1) & mask;
+            }
+            this->slots[idx] = s;
+        }
+    }
+}
+
+bool name_hash_set::insert(std::string_view name) noexcept
+{
+    if ((this->num_occupied + this->num_erased + 1) * 2 > this->slots.size()) {
+        rehash(std::max(u64(16), std::bit_ceil((this->num_occupied + 1) * 4)));
+    }
+
+    u64 name_hash = hash(name);
+    slot &s = this->slots[find_slot(name, name_hash)];
+
+    if (s.state == 1) {
+        return false;
+    }
+    if (s.state == 2) {
+        --this->num_erased;
+    }
+
+    s.hash = name_hash;
+    s.name_offset = (u32)this->names.size();
+    s.name_len = (u16)name.size();
+    s.state = 1;
+    this->names.insert(this->names.end(), name.begin(), name.end());
+    ++this->num_occupied;
+
+    return true;
+}
+
+bool name_hash_set::contains(std::string_view name) const noexcept
+{
+    if (this->num_occupied == 0) {
+        return false;
+    }
+    return this->slots[find_slot(name, hash(name))].state == 1;
+}
+
+bool name_hash_set::erase(std::string_view name) noexcept
+{
+    if (this->num_occupied == 0) {
+        return false;
+    }
+    slot &s = this->slots[find_slot(name, hash(name))];
+    if (s.state != 1) {
+        return false;
+    }
+    s.state = 2;
+    --this->num_occupied;
+    ++this->num_erased;
+    return true;
+}
+
 std::array<char, 64> get_type_text_for_extension(char const *extension) noexcept
 {
     if (extension == nullptr) {
@@ -625,13 +752,13 @@ generic_result open_file_with(char const *file_name, char const *file_directory)
     }
 }
 
-std::variant<s64, basic_dirent::kind> appropriate_icon(s64 tex_id, basic_dirent::kind obj_type) noexcept
+std::variant<icon_view, basic_dirent::kind> appropriate_icon(icon_handle const &icon, basic_dirent::kind obj_type) noexcept
 {
-    if (global_state::settings().win32_file_icons) return tex_id;
+    if (global_state::settings().win32_file_icons) return global_state::icons().view(icon);
     else return obj_type;
 }
 
-void render_path_with_stylish_separators(char const *path, std::variant<s64, basic_dirent::kind> icon) noexcept
+void render_path_with_stylish_separators(char const *path, std::variant<icon_view, basic_dirent::kind> icon) noexcept
 {
     swan_path segmented_path = path_create(path);
     assert(!path_is_empty(segmented_path));
@@ -670,10 +797,11 @@ void render_path_with_stylish_separators(char const *path, std::variant<s64, bas
         imgui::AlignTextToFramePadding();
         imgui::TextColored(color, icon_);
     }
-    else if (std::holds_alternative<s64>(icon)) {
+    else if (std::holds_alternative<icon_view>(icon)) {
+        auto const &view = std::get<icon_view>(icon);
         f32 icon_size = ImGui::GetFont()->FontSize;
         imgui::SetCursorPosY(imgui::GetCursorPosY() + imgui::GetStyle().FramePadding.y);
-        ImGui::Image((ImTextureID)std::max(std::get<s64>(icon), s64(0)), ImVec2(icon_size, icon_size));
+        ImGui::Image((ImTextureID)view.texture, ImVec2(icon_size, icon_size), view.uv0, view.uv1);
     }
     else {
         assert(false);
@@ -720,58 +848,41 @@ ImVec4 compute_drive_usage_color(f32 fraction_used) noexcept
     return ImVec4(red, green, blue, 1);
 }
 
-std::pair<s64, ImVec2> load_icon_texture(char const *full_path_utf8, wchar_t const *full_path_utf16_provided, char const *debug_label) noexcept
+bool extract_icon_pixels(wchar_t const *full_path_utf16, icon_pixels &out, bool by_extension) noexcept
 {
-    assert((full_path_utf8 || full_path_utf16_provided) && "Provide at least one parameter!");
-
-    if (debug_label) print_debug_msg("load_icon_texture %s", debug_label);
-    else print_debug_msg("load_icon_texture");
+    out.bgra.clear();
+    out.width = out.height = 0;
 
-    wchar_t const *full_path_utf16;
-
-    wchar_t full_path_utf16_buf[MAX_PATH];
-    if (full_path_utf16_provided) {
-        full_path_utf16 = full_path_utf16_provided;
-    } else {
-        if (!utf8_to_utf16(full_path_utf8, full_path_utf16_buf, lengthof(full_path_utf16_buf))) {
-            return { -1, {} };
-        }
-        full_path_utf16 = full_path_utf16_buf;
-    }
+    DWORD attributes = by_extension ? FILE_ATTRIBUTE_NORMAL : 0;
+    UINT flags = SHGFI_ICON|SHGFI_SMALLICON | (by_extension ? SHGFI_USEFILEATTRIBUTES : 0);
 
     SHFILEINFOW file_info = {};
-    if (!SHGetFileInfoW(full_path_utf16, 0, &file_info, sizeof(file_info), SHGFI_ICON|SHGFI_SMALLICON)) return { -1, {} };
-    if (file_info.hIcon == nullptr) return { -1, {} };
+    if (!SHGetFileInfoW(full_path_utf16, attributes, &file_info, sizeof(file_info), flags)) return false;
+    if (file_info.hIcon == nullptr) return false;
     SCOPE_EXIT { if (!DestroyIcon(file_info.hIcon)) print_debug_msg("FAILED DestroyIcon"); };
 
     ICONINFO icon_info = {};
-    if (!GetIconInfo(file_info.hIcon, &icon_info)) return { -1, {} };
-    if (icon_info.hbmColor == nullptr) return { -1, {} };
+    if (!GetIconInfo(file_info.hIcon, &icon_info)) return false;
+    if (icon_info.hbmColor == nullptr) return false;
     SCOPE_EXIT { if (!DeleteObject(icon_info.hbmColor)) print_debug_msg("FAILED DeleteObject(hbmColor)");
                  if (!DeleteObject(icon_info.hbmMask)) print_debug_msg("FAILED DeleteObject(hbmMask)"); };
 
     DIBSECTION ds;
-    if (!GetObjectA(icon_info.hbmColor, sizeof(ds), &ds)) return { -1, {} };
+    if (!GetObjectA(icon_info.hbmColor, sizeof(ds), &ds)) return false;
+    if (ds.dsBm.bmBitsPixel != 32) return false; // uploaded as 4 bytes per pixel
 
     u64 num_bytes_pixels = ds.dsBm.bmWidth * ds.dsBm.bmHeight * (ds.dsBm.bmBitsPixel / 8);
-    if (num_bytes_pixels == 0) return { -1, {} };
-
-    auto pixel_data = std::make_unique<u8[]>(num_bytes_pixels);
-    if (!GetBitmapBits(icon_info.hbmColor, (LONG)num_bytes_pixels, pixel_data.get())) return { -1, {} };
-
-    char fmt = 0;
-    GLuint tex;
-    glGenTextures(1, &tex);
-    glBindTexture(GL_TEXTURE_2D, tex);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, ds.dsBm.bmWidth, ds.dsBm.bmHeight, 0, (fmt == 0) ? GL_BGRA : GL_RGBA, GL_UNSIGNED_BYTE, pixel_data.get());
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    return { tex, { f32(ds.dsBm.bmWidth), f32(ds.dsBm.bmHeight) } };
+    if (num_bytes_pixels == 0) return false;
+
+    out.bgra.resize(num_bytes_pixels);
+    if (!GetBitmapBits(icon_info.hbmColor, (LONG)num_bytes_pixels, out.bgra.data())) {
+        out.bgra.clear();
+        return false;
+    }
+    out.width = (u32)ds.dsBm.bmWidth;
+    out.height = (u32)ds.dsBm.bmHeight;
+
+    return true;
 }
 
 void delete_icon_texture(s64 &id, char const *debug_label) noexcept
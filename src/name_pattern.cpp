@@ -0,0 +1,776 @@
+#include "name_pattern.hpp"
+
+#if !defined(_WIN32)
+#   include <algorithm>
+#   include <map>
+#endif
+
+namespace name_pattern_detail
+{
+    struct byte_set
+    {
+        u64 bits[4] = {};
+
+        void add(u8 byte) noexcept { bits[byte >> 6] |= u64(1) << (byte & 63); }
+        bool has(u8 byte) const noexcept { return (bits[byte >> 6] >> (byte & 63)) & 1; }
+        bool empty() const noexcept { return (bits[0] | bits[1] | bits[2] | bits[3]) == 0; }
+
+        void add_range(u8 first, u8 last) noexcept
+        {
+            for (u32 byte = first; byte <= last; ++byte) {
+                add(u8(byte));
+            }
+        }
+    };
+
+    static constexpr u32 unbounded = u32(-1);
+    static constexpr u32 none = u32(-1);
+
+    struct ast_node
+    {
+        enum class kind : u8 { empty, bytes, concat, alternate, repeat };
+
+        kind type;
+        u32 set = 0;                    // bytes: index into `sets`
+        u32 min = 0;                    // repeat
+        u32 max = 0;                    // repeat, `unbounded` for no upper limit
+        std::vector<u32> children = {}; // concat, alternate, repeat (exactly one)
+    };
+
+    struct nfa_state
+    {
+        enum class kind : u8 { epsilon, split, bytes, accept };
+
+        kind type;
+        u32 set = 0;
+        u32 out = none;
+        u32 out2 = none; // split only
+    };
+
+    /// What a bracket expression (`[...]`) contains: ASCII bytes, whole non-ASCII characters, or every non-ASCII character.
+    struct bracket
+    {
+        byte_set ascii = {};
+        std::vector<std::string_view> non_ascii = {};
+        bool all_non_ascii = false;
+    };
+
+    struct compiler
+    {
+        static constexpr u64 max_nfa_states = 100'000;
+
+        std::string_view pattern;
+        u64 pos = 0;
+        bool fold_case = false;
+        std::string error = {};
+        std::vector<ast_node> nodes = {};
+        std::vector<byte_set> sets = {};
+        std::vector<nfa_state> states = {};
+
+        bool at_end() const noexcept { return this->pos >= this->pattern.size(); }
+        char peek() const noexcept { return this->pattern[this->pos]; }
+
+        bool fail(char const *message) noexcept
+        {
+            if (this->error.empty()) {
+                this->error = message;
+            }
+            return false;
+        }
+
+        u32 add_node(ast_node &&node) noexcept
+        {
+            this->nodes.push_back(std::move(node));
+            return u32(this->nodes.size() - 1);
+        }
+
+        u32 add_bytes(byte_set set) noexcept
+        {
+            if (this->fold_case) {
+                //? Input bytes are folded to lower case before lookup, the set only needs the lower case letter,
+                //? adding both keeps complements computed before this call correct.
+                for (u8 lower = 'a'; lower <= 'z'; ++lower) {
+                    u8 upper = u8(lower - 'a' + 'A');
+                    if (set.has(lower) || set.has(upper)) {
+                        set.add(lower);
+                        set.add(upper);
+                    }
+                }
+            }
+            this->sets.push_back(set);
+            return add_node({ ast_node::kind::bytes, u32(this->sets.size() - 1) });
+        }
+
+        u32 add_byte_range(u8 first, u8 last) noexcept
+        {
+            byte_set set = {};
+            set.add_range(first, last);
+            return add_bytes(set);
+        }
+
+        u32 add_list(ast_node::kind type, std::vector<u32> &&children) noexcept
+        {
+            if (children.size() == 1) {
+                return children.front();
+            }
+            if (children.empty()) {
+                return add_node({ ast_node::kind::empty });
+            }
+            ast_node node = { type };
+            node.children = std::move(children);
+            return add_node(std::move(node));
+        }
+
+        u32 add_repeat(u32 child, u32 min, u32 max) noexcept
+        {
+            ast_node node = { ast_node::kind::repeat };
+            node.min = min;
+            node.max = max;
+            node.children.push_back(child);
+            return add_node(std::move(node));
+        }
+
+        /// Length of the UTF-8 sequence starting with `lead`, 0 if it can't start one.
+        static u64 utf8_sequence_len(u8 lead) noexcept
+        {
+            if (lead < 0x80)         return 1;
+            if ((lead >> 5) == 0x6)  return 2;
+            if ((lead >> 4) == 0xE)  return 3;
+            if ((lead >> 3) == 0x1E) return 4;
+            return 0;
+        }
+
+        /// Takes one whole UTF-8 character off the pattern.
+        bool take_character(std::string_view &out) noexcept
+        {
+            u64 len = utf8_sequence_len(u8(peek()));
+            if (len == 0 || this->pos + len > this->pattern.size()) {
+                return fail("Pattern is not valid UTF-8");
+            }
+            out = this->pattern.substr(this->pos, len);
+            this->pos += len;
+            return true;
+        }
+
+        u32 add_literal(std::string_view character) noexcept
+        {
+            std::vector<u32> bytes = {};
+            for (char ch : character) {
+                bytes.push_back(add_byte_range(u8(ch), u8(ch)));
+            }
+            return add_list(ast_node::kind::concat, std::move(bytes));
+        }
+
+        /// Any single non-ASCII character, as its 2, 3 and 4 byte UTF-8 forms.
+        void add_non_ascii_character(std::vector<u32> &alternatives) noexcept
+        {
+            u8 const leads[][2] = { { 0xC0, 0xDF }, { 0xE0, 0xEF }, { 0xF0, 0xF7 } };
+
+            for (u64 num_continuations = 1; num_continuations <= 3; ++num_continuations) {
+                std::vector<u32> sequence = { add_byte_range(leads[num_continuations - 1][0], leads[num_continuations - 1][1]) };
+                for (u64 i = 0; i < num_continuations; ++i) {
+                    sequence.push_back(add_byte_range(0x80, 0xBF));
+                }
+                alternatives.push_back(add_list(ast_node::kind::concat, std::move(sequence)));
+            }
+        }
+
+        u32 add_any_character() noexcept
+        {
+            std::vector<u32> alternatives = { add_byte_range(0x00, 0x7F) };
+            add_non_ascii_character(alternatives);
+            return add_list(ast_node::kind::alternate, std::move(alternatives));
+        }
+
+        u32 add_bracket(bracket &&contents, bool negated) noexcept
+        {
+            std::vector<u32> alternatives = {};
+
+            if (negated) {
+                if (!contents.non_ascii.empty()) {
+                    fail("Non-ASCII characters in negated sets are not supported");
+                    return add_node({ ast_node::kind::empty });
+                }
+                byte_set members = contents.ascii;
+                if (this->fold_case) {
+                    for (u8 lower = 'a'; lower <= 'z'; ++lower) {
+                        if (members.has(lower) || members.has(u8(lower - 'a' + 'A'))) {
+                            members.add(lower);
+                            members.add(u8(lower - 'a' + 'A'));
+                        }
+                    }
+                }
+                byte_set complement = {};
+                for (u32 byte = 0; byte < 0x80; ++byte) {
+                    if (!members.has(u8(byte))) {
+                        complement.add(u8(byte));
+                    }
+                }
+                if (!complement.empty()) {
+                    alternatives.push_back(add_bytes(complement));
+                }
+                if (!contents.all_non_ascii) {
+                    add_non_ascii_character(alternatives);
+                }
+            }
+            else {
+                if (!contents.ascii.empty()) {
+                    alternatives.push_back(add_bytes(contents.ascii));
+                }
+                for (std::string_view character : contents.non_ascii) {
+                    alternatives.push_back(add_literal(character));
+                }
+                if (contents.all_non_ascii) {
+                    add_non_ascii_character(alternatives);
+                }
+            }
+
+            if (alternatives.empty()) {
+                fail("Set matches no character");
+                return add_node({ ast_node::kind::empty });
+            }
+            return add_list(ast_node::kind::alternate, std::move(alternatives));
+        }
+
+        /// `\d \w \s` and their negations, within ASCII. Returns false if `letter` isn't one of them.
+        static bool shorthand_class(char letter, bracket &out) noexcept
+        {
+            byte_set set = {};
+            switch (letter | 0x20) {
+                case 'd': set.add_range('0', '9'); break;
+                case 'w': set.add_range('0', '9'); set.add_range('a', 'z'); set.add_range('A', 'Z'); set.add('_'); break;
+                case 's': set.add(' '); set.add_range('\t', '\r'); break;
+                default: return false;
+            }
+            bool negated = letter >= 'A' && letter <= 'Z';
+            for (u32 byte = 0; byte < 0x80; ++byte) {
+                if (set.has(u8(byte)) != negated) {
+                    out.ascii.add(u8(byte));
+                }
+            }
+            out.all_non_ascii |= negated;
+            return true;
+        }
+
+        /// Parses `[...]` with the opening bracket already consumed. Glob sets negate with `!` (or `^`) and have no escapes.
+        u32 parse_bracket(bool glob) noexcept
+        {
+            bool negated = !at_end() && (peek() == '^' || (glob && peek() == '!'));
+            if (negated) {
+                ++this->pos;
+            }
+
+            bracket contents = {};
+            bool first = true;
+
+            while (true) {
+                if (at_end()) {
+                    fail("Missing ]");
+                    return add_node({ ast_node::kind::empty });
+                }
+                if (peek() == ']' && (!first || !glob)) { // a leading ] is literal in globs, ECMAScript closes the set
+                    ++this->pos;
+                    break;
+                }
+                first = false;
+
+                if (!glob && peek() == '\\' && this->pos + 1 < this->pattern.size()) {
+                    char escaped = this->pattern[this->pos + 1];
+                    if (shorthand_class(escaped, contents)) {
+                        this->pos += 2;
+                        continue;
+                    }
+                }
+
+                std::string_view low;
+                if (!take_escapable_character(glob, low)) {
+                    return add_node({ ast_node::kind::empty });
+                }
+
+                bool is_range = this->pos + 1 < this->pattern.size() && peek() == '-' && this->pattern[this->pos + 1] != ']';
+                if (!is_range) {
+                    if (low.size() == 1) contents.ascii.add(u8(low[0]));
+                    else                 contents.non_ascii.push_back(low);
+                    continue;
+                }
+
+                ++this->pos; // -
+                std::string_view high;
+                if (!take_escapable_character(glob, high)) {
+                    return add_node({ ast_node::kind::empty });
+                }
+                if (low.size() != 1 || high.size() != 1) {
+                    fail("Ranges of non-ASCII characters are not supported");
+                    return add_node({ ast_node::kind::empty });
+                }
+                if (u8(low[0]) > u8(high[0])) {
+                    fail("Range out of order in set");
+                    return add_node({ ast_node::kind::empty });
+                }
+                contents.ascii.add_range(u8(low[0]), u8(high[0]));
+            }
+
+            return add_bracket(std::move(contents), negated);
+        }
+
+        /// One character of a set, `\x` meaning a literal `x` for regexes.
+        bool take_escapable_character(bool glob, std::string_view &out) noexcept
+        {
+            if (!glob && peek() == '\\') {
+                ++this->pos;
+                if (at_end()) {
+                    return fail("Trailing \\");
+                }
+                char const *control = nullptr;
+                switch (peek()) {
+                    case 't': control = "\t"; break;
+                    case 'n': control = "\n"; break;
+                    case 'r': control = "\r"; break;
+                    case 'f': control = "\f"; break;
+                    case 'v': control = "\v"; break;
+                    default: break;
+                }
+                if (control) {
+                    ++this->pos;
+                    out = control;
+                    return true;
+                }
+            }
+            return take_character(out);
+        }
+
+        u32 parse_glob() noexcept
+        {
+            std::vector<u32> sequence = {};
+
+            while (!at_end() && this->error.empty()) {
+                char ch = peek();
+                if (ch == '*') {
+                    ++this->pos;
+                    //? Any bytes: the name is valid UTF-8, so whatever `*` skips over consists of whole characters.
+                    sequence.push_back(add_repeat(add_byte_range(0x00, 0xFF), 0, unbounded));
+                }
+                else if (ch == '?') {
+                    ++this->pos;
+                    sequence.push_back(add_any_character());
+                }
+                else if (ch == '[') {
+                    ++this->pos;
+                    sequence.push_back(parse_bracket(true));
+                }
+                else {
+                    std::string_view character;
+                    if (!take_character(character)) {
+                        break;
+                    }
+                    sequence.push_back(add_literal(character));
+                }
+            }
+            return add_list(ast_node::kind::concat, std::move(sequence));
+        }
+
+        u32 parse_regex_alternation(u64 depth) noexcept
+        {
+            if (depth > 100) {
+                fail("Groups nested too deeply");
+                return add_node({ ast_node::kind::empty });
+            }
+            std::vector<u32> alternatives = { parse_regex_concatenation(depth) };
+
+            while (!at_end() && peek() == '|' && this->error.empty()) {
+                ++this->pos;
+                alternatives.push_back(parse_regex_concatenation(depth));
+            }
+            return add_list(ast_node::kind::alternate, std::move(alternatives));
+        }
+
+        u32 parse_regex_concatenation(u64 depth) noexcept
+        {
+            std::vector<u32> sequence = {};
+
+            while (!at_end() && peek() != '|' && peek() != ')' && this->error.empty()) {
+                sequence.push_back(parse_regex_repetition(depth));
+            }
+            return add_list(ast_node::kind::concat, std::move(sequence));
+        }
+
+        bool parse_number(u32 &out) noexcept
+        {
+            u64 start = this->pos;
+            u64 value = 0;
+            while (!at_end() && peek() >= '0' && peek() <= '9') {
+                value = std::min<u64>((value * 10) + u64(peek() - '0'), u64(name_pattern::max_repeat) + 1);
+                ++this->pos;
+            }
+            out = u32(value);
+            return this->pos != start;
+        }
+
+        u32 parse_regex_repetition(u64 depth) noexcept
+        {
+            u32 atom = parse_regex_atom(depth);
+
+            while (!at_end() && this->error.empty()) {
+                u32 min, max;
+                char ch = peek();
+
+                if      (ch == '*') { min = 0; max = unbounded; ++this->pos; }
+                else if (ch == '+') { min = 1; max = unbounded; ++this->pos; }
+                else if (ch == '?') { min = 0; max = 1;         ++this->pos; }
+                else if (ch == '{') {
+                    ++this->pos;
+                    if (!parse_number(min)) {
+                        fail("Malformed {m,n} quantifier");
+                        break;
+                    }
+                    max = min;
+                    if (!at_end() && peek() == ',') {
+                        ++this->pos;
+                        max = parse_number(max) ? max : unbounded;
+                    }
+                    if (at_end() || peek() != '}') {
+                        fail("Malformed {m,n} quantifier");
+                        break;
+                    }
+                    ++this->pos;
+                    if (min > name_pattern::max_repeat || (max != unbounded && max > name_pattern::max_repeat)) {
+                        fail("Repetition count too large");
+                        break;
+                    }
+                    if (min > max) {
+                        fail("Quantifier range out of order");
+                        break;
+                    }
+                }
+                else {
+                    break;
+                }
+
+                if (!at_end() && peek() == '?') {
+                    ++this->pos; // lazy, same set of whole-name matches
+                }
+                atom = add_repeat(atom, min, max);
+            }
+            return atom;
+        }
+
+        u32 parse_regex_atom(u64 depth) noexcept
+        {
+            char ch = peek();
+
+            switch (ch) {
+                case '(': {
+                    ++this->pos;
+                    if (this->pattern.substr(this->pos).starts_with("?:")) {
+                        this->pos += 2;
+                    }
+                    else if (!at_end() && peek() == '?') {
+                        fail("Lookaround and named groups are not supported");
+                        return add_node({ ast_node::kind::empty });
+                    }
+                    u32 group = parse_regex_alternation(depth + 1);
+                    if (at_end() || peek() != ')') {
+                        fail("Missing )");
+                    } else {
+                        ++this->pos;
+                    }
+                    return group;
+                }
+                case '[':
+                    ++this->pos;
+                    return parse_bracket(false);
+
+                case '.':
+                    ++this->pos;
+                    return add_any_character();
+
+                case '^':
+                    if (this->pos != 0) {
+                        fail("^ is only supported at the start of the pattern");
+                    }
+                    ++this->pos;
+                    return add_node({ ast_node::kind::empty });
+
+                case '$':
+                    if (this->pos + 1 != this->pattern.size()) {
+                        fail("$ is only supported at the end of the pattern");
+                    }
+                    ++this->pos;
+                    return add_node({ ast_node::kind::empty });
+
+                case '*': case '+': case '?': case '{':
+                    fail("Nothing to repeat");
+                    return add_node({ ast_node::kind::empty });
+
+                case '\\': {
+                    if (this->pos + 1 < this->pattern.size()) {
+                        char escaped = this->pattern[this->pos + 1];
+                        bracket shorthand = {};
+                        if (shorthand_class(escaped, shorthand)) {
+                            this->pos += 2;
+                            return add_bracket(std::move(shorthand), false);
+                        }
+                        if (escaped >= '1' && escaped <= '9') {
+                            fail("Backreferences are not supported");
+                            return add_node({ ast_node::kind::empty });
+                        }
+                        if (escaped == 'b' || escaped == 'B') {
+                            fail("Word boundaries are not supported");
+                            return add_node({ ast_node::kind::empty });
+                        }
+                    }
+                    std::string_view character;
+                    if (!take_escapable_character(false, character)) {
+                        return add_node({ ast_node::kind::empty });
+                    }
+                    return add_literal(character);
+                }
+                default: {
+                    std::string_view character;
+                    if (!take_character(character)) {
+                        return add_node({ ast_node::kind::empty });
+                    }
+                    return add_literal(character);
+                }
+            }
+        }
+
+        u32 add_state(nfa_state::kind type, u32 set = 0) noexcept
+        {
+            this->states.push_back({ type, set });
+            return u32(this->states.size() - 1);
+        }
+
+        struct fragment
+        {
+            u32 start;
+            u32 end; // epsilon state whose `out` is patched by whatever follows
+        };
+
+        fragment concatenate(fragment first, fragment second) noexcept
+        {
+            this->states[first.end].out = second.start;
+            return { first.start, second.end };
+        }
+
+        fragment build(u32 node_idx) noexcept
+        {
+            if (this->states.size() > max_nfa_states) {
+                fail("Pattern too large");
+                u32 state = add_state(nfa_state::kind::epsilon);
+                return { state, state };
+            }
+
+            ast_node const &node = this->nodes[node_idx];
+
+            switch (node.type) {
+                default:
+                case ast_node::kind::empty: {
+                    u32 state = add_state(nfa_state::kind::epsilon);
+                    return { state, state };
+                }
+                case ast_node::kind::bytes: {
+                    u32 start = add_state(nfa_state::kind::bytes, node.set);
+                    u32 end = add_state(nfa_state::kind::epsilon);
+                    this->states[start].out = end;
+                    return { start, end };
+                }
+                case ast_node::kind::concat: {
+                    fragment result = build(node.children.front());
+                    for (u64 i = 1; i < node.children.size(); ++i) {
+                        result = concatenate(result, build(this->nodes[node_idx].children[i]));
+                    }
+                    return result;
+                }
+                case ast_node::kind::alternate: {
+                    u32 end = add_state(nfa_state::kind::epsilon);
+                    u32 start = none;
+                    u64 num_children = node.children.size();
+
+                    // split(first, split(second, ... last)), built back to front
+                    for (u64 i = num_children; i-- > 0; ) {
+                        fragment child = build(this->nodes[node_idx].children[i]);
+                        this->states[child.end].out = end;
+
+                        if (start == none) {
+                            start = child.start;
+                        } else {
+                            u32 split = add_state(nfa_state::kind::split);
+                            this->states[split].out = child.start;
+                            this->states[split].out2 = start;
+                            start = split;
+                        }
+                    }
+                    return { start, end };
+                }
+                case ast_node::kind::repeat: {
+                    u32 child = node.children.front();
+                    u32 min = node.min;
+                    u32 max = node.max;
+
+                    u32 empty = add_state(nfa_state::kind::epsilon);
+                    fragment result = { empty, empty };
+
+                    for (u32 i = 0; i < min && this->error.empty(); ++i) {
+                        result = concatenate(result, build(child));
+                    }
+                    if (max == unbounded) {
+                        u32 split = add_state(nfa_state::kind::split);
+                        u32 end = add_state(nfa_state::kind::epsilon);
+                        fragment body = build(child);
+                        this->states[split].out = body.start;
+                        this->states[split].out2 = end;
+                        this->states[body.end].out = split;
+                        result = concatenate(result, { split, end });
+                    }
+                    else {
+                        for (u32 i = min; i < max && this->error.empty(); ++i) {
+                            u32 split = add_state(nfa_state::kind::split);
+                            u32 end = add_state(nfa_state::kind::epsilon);
+                            fragment body = build(child);
+                            this->states[split].out = body.start;
+                            this->states[split].out2 = end;
+                            this->states[body.end].out = end;
+                            result = concatenate(result, { split, end });
+                        }
+                    }
+                    return result;
+                }
+            }
+        }
+
+        /// Sorted `bytes` and `accept` states reachable from `seeds` through epsilon and split states.
+        void closure(std::vector<u32> &seeds, std::vector<u32> &out, std::vector<u32> &visited_mark, u32 mark) const noexcept
+        {
+            out.clear();
+            while (!seeds.empty()) {
+                u32 state_idx = seeds.back();
+                seeds.pop_back();
+                if (state_idx == none || visited_mark[state_idx] == mark) {
+                    continue;
+                }
+                visited_mark[state_idx] = mark;
+
+                nfa_state const &state = this->states[state_idx];
+                switch (state.type) {
+                    case nfa_state::kind::epsilon: seeds.push_back(state.out); break;
+                    case nfa_state::kind::split:   seeds.push_back(state.out2); seeds.push_back(state.out); break;
+                    default:                       out.push_back(state_idx); break;
+                }
+            }
+            std::sort(out.begin(), out.end());
+        }
+    };
+}
+
+bool name_pattern::compile(std::string_view pattern_utf8, syntax pattern_syntax, bool case_sensitive) noexcept
+{
+    using namespace name_pattern_detail;
+
+    this->error.clear();
+    this->transitions.clear();
+    this->accepting.clear();
+    this->num_byte_classes = 0;
+    this->start_state = dead_state;
+
+    compiler comp = {};
+    comp.pattern = pattern_utf8;
+    comp.fold_case = !case_sensitive;
+
+    u32 root;
+    if (pattern_syntax == syntax::glob) {
+        root = comp.parse_glob();
+    } else {
+        root = comp.parse_regex_alternation(0);
+        if (comp.error.empty() && !comp.at_end()) {
+            comp.fail("Unmatched )");
+        }
+    }
+    if (!comp.error.empty()) {
+        this->error = std::move(comp.error);
+        return false;
+    }
+
+    compiler::fragment whole = comp.build(root);
+    u32 accept = comp.add_state(nfa_state::kind::accept);
+    comp.states[whole.end].out = accept;
+
+    if (!comp.error.empty()) {
+        this->error = std::move(comp.error);
+        return false;
+    }
+
+    //? Bytes which every set treats alike share a transition column, most patterns need a handful instead of 256.
+    u8 representative[256];
+    {
+        std::map<std::vector<bool>, u8> class_of_signature = {};
+        std::vector<bool> signature(comp.sets.size());
+
+        for (u32 byte = 0; byte < 256; ++byte) {
+            bool folded = !case_sensitive && byte >= 'A' && byte <= 'Z';
+            if (folded) {
+                continue; // shares the column of its lower case letter, assigned below
+            }
+            for (u64 i = 0; i < comp.sets.size(); ++i) {
+                signature[i] = comp.sets[i].has(u8(byte));
+            }
+            auto [iter, inserted] = class_of_signature.try_emplace(signature, u8(class_of_signature.size()));
+            if (inserted) {
+                representative[iter->second] = u8(byte);
+            }
+            this->byte_classes[byte] = iter->second;
+        }
+        if (!case_sensitive) {
+            for (u32 byte = 'A'; byte <= 'Z'; ++byte) {
+                this->byte_classes[byte] = this->byte_classes[byte - 'A' + 'a'];
+            }
+        }
+        this->num_byte_classes = u32(class_of_signature.size());
+    }
+
+    // subset construction, state 0 is the dead (empty) set
+    std::map<std::vector<u32>, u32> dfa_state_of_set = {};
+    std::vector<std::vector<u32>> dfa_sets = {};
+    std::vector<u32> visited_mark(comp.states.size(), 0);
+    u32 mark = 0;
+    std::vector<u32> seeds = {};
+    std::vector<u32> next_set = {};
+
+    auto intern = [&](std::vector<u32> const &nfa_set) noexcept -> u32 {
+        auto [iter, inserted] = dfa_state_of_set.try_emplace(nfa_set, u32(dfa_sets.size()));
+        if (inserted) {
+            dfa_sets.push_back(nfa_set);
+            this->accepting.push_back(std::binary_search(nfa_set.begin(), nfa_set.end(), accept) ? 1 : 0);
+        }
+        return iter->second;
+    };
+
+    (void) intern({});
+    seeds.push_back(whole.start);
+    comp.closure(seeds, next_set, visited_mark, ++mark);
+    this->start_state = intern(next_set);
+
+    for (u32 dfa_state = 0; dfa_state < dfa_sets.size(); ++dfa_state) {
+        if (dfa_sets.size() > max_dfa_states) {
+            this->error = "Pattern too complex";
+            this->transitions.clear();
+            this->accepting.clear();
+            return false;
+        }
+        for (u32 byte_class = 0; byte_class < this->num_byte_classes; ++byte_class) {
+            u8 byte = representative[byte_class];
+
+            seeds.clear();
+            for (u32 nfa_state_idx : dfa_sets[dfa_state]) {
+                auto const &state = comp.states[nfa_state_idx];
+                if (state.type == nfa_state::kind::bytes && comp.sets[state.set].has(byte)) {
+                    seeds.push_back(state.out);
+                }
+            }
+            comp.closure(seeds, next_set, visited_mark, ++mark);
+            this->transitions.push_back(intern(next_set));
+        }
+    }
+
+    return true;
+}
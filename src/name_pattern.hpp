@@ -0,0 +1,65 @@
+#pragma once
+
+//? Whole-name matching of glob and regular expression patterns, compiled to a DFA so that every name is matched in one pass
+//? over its bytes without backtracking: no pattern can make filtering superlinear.
+
+#if defined(_WIN32)
+#   include "stdafx.hpp"
+#else
+#   include <array>
+#   include <string>
+#   include <string_view>
+#   include <vector>
+#endif
+
+#include "primitives.hpp"
+
+/// A pattern compiled once (per filter edit) and matched against many names.
+///
+/// Glob: `*` any run of characters, `?` one character, `[abc]` `[a-z]` `[!abc]` one character in (not in) a set, everything else literal.
+/// Regex: ECMAScript-like subset without backtracking features. Literals, `.`, classes (`[a-z]`, `[^...]`, `\d \w \s` and negations),
+/// groups `(...)` `(?:...)`, alternation, quantifiers `* + ? {m} {m,} {m,n}` (a lazy `?` suffix is accepted, it can't change a whole-name match),
+/// `^` and `$` at the ends. Backreferences and lookaround are rejected with an error.
+///
+/// `.` `?` and negated classes consume whole UTF-8 characters. Case insensitive patterns fold ASCII letters, other characters match exactly.
+struct name_pattern
+{
+    enum class syntax : u8
+    {
+        glob,
+        regex,
+    };
+
+    static constexpr u64 max_dfa_states = 4096;
+    static constexpr u32 max_repeat = 1000;
+
+    /// Returns false and sets `error` if the pattern is malformed, uses unsupported features, or needs more than `max_dfa_states`.
+    bool compile(std::string_view pattern_utf8, syntax pattern_syntax, bool case_sensitive) noexcept;
+
+    /// True if the pattern matches the whole of `name_utf8`. Always false for a pattern that failed to compile.
+    bool matches(std::string_view name_utf8) const noexcept
+    {
+        if (this->transitions.empty()) {
+            return false;
+        }
+        u32 state = this->start_state;
+        for (char ch : name_utf8) {
+            state = this->transitions[(state * this->num_byte_classes) + this->byte_classes[u8(ch)]];
+            if (state == dead_state) {
+                return false;
+            }
+        }
+        return this->accepting[state] != 0;
+    }
+
+    u64 num_states() const noexcept { return this->accepting.size(); }
+
+    static constexpr u32 dead_state = 0;
+
+    std::string error = {};
+    std::array<u8, 256> byte_classes = {}; // input byte -> transition column, upper case letters share their lower case column when folding
+    u32 num_byte_classes = 0;
+    u32 start_state = dead_state;
+    std::vector<u32> transitions = {};     // [state * num_byte_classes + byte class] -> next state
+    std::vector<u8> accepting = {};        // [state]
+};
@@ -94,7 +94,7 @@ void swan_popup_modals::render_new_directory() noexcept
                 explorer_window &expl = global_state::explorers()[g_initiating_expl_id];
                 expl.deselect_all_cwd_entries();
                 std::scoped_lock lock(expl.select_cwd_entries_on_next_update_mutex);
-                expl.select_cwd_entries_on_next_update.push_back(s_dir_name_utf8);
+                expl.select_cwd_entries_on_next_update.insert(s_dir_name_utf8.data());
             }
             cleanup_and_close_popup();
         }
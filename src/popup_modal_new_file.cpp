@@ -104,7 +104,7 @@ void swan_popup_modals::render_new_file() noexcept
                 explorer_window &expl = global_state::explorers()[g_initiating_expl_id];
                 expl.deselect_all_cwd_entries();
                 std::scoped_lock lock(expl.select_cwd_entries_on_next_update_mutex);
-                expl.select_cwd_entries_on_next_update.push_back(s_file_name_utf8);
+                expl.select_cwd_entries_on_next_update.insert(s_file_name_utf8.data());
             }
 
             cleanup_and_close_popup();
@@ -6,21 +6,20 @@ namespace single_rename_modal_global_state
 {
     static bool                             g_open = false;
     static explorer_window *                g_expl_opened_from = nullptr;
-    static explorer_window::dirent const *  g_expl_dirent_to_rename = nullptr;
+    static basic_dirent                     g_dirent_to_rename = {};
     static std::function<void ()>           g_on_rename_callback = {};
 }
 
 void swan_popup_modals::open_single_rename(
     explorer_window &expl,
-    explorer_window::dirent const &entry_to_be_renamed,
+    basic_dirent const &entry_to_be_renamed,
     std::function<void ()> on_rename_finish_callback) noexcept
 {
     using namespace single_rename_modal_global_state;
 
     g_open = true;
 
-    assert(g_expl_dirent_to_rename == nullptr);
-    g_expl_dirent_to_rename = &entry_to_be_renamed;
+    g_dirent_to_rename = entry_to_be_renamed;
 
     assert(g_expl_opened_from == nullptr);
     g_expl_opened_from = &expl;
@@ -37,7 +36,7 @@ void swan_popup_modals::render_single_rename() noexcept
 
     if (g_open) {
         imgui::OpenPopup(swan_popup_modals::label_single_rename);
-        f32 initial_name_width = imgui::CalcTextSize(g_expl_dirent_to_rename->basic.path.data()).x;
+        f32 initial_name_width = imgui::CalcTextSize(g_dirent_to_rename.path.data()).x;
         f32 initial_name_width_plus_paddings = initial_name_width + stuff_on_the_right_width + style.WindowPadding.x*2 + style.FramePadding.x*2;
         f32 window_width = initial_name_width_plus_paddings + imgui::CalcTextSize(" ").x*5;
         window_width = std::max(window_width, 500.f);
@@ -48,7 +47,7 @@ void swan_popup_modals::render_single_rename() noexcept
     }
 
     assert(g_expl_opened_from != nullptr);
-    assert(g_expl_dirent_to_rename != nullptr);
+    assert(!path_is_empty(g_dirent_to_rename.path));
 
     char dir_sep_utf8 = global_state::settings().dir_separator_utf8;
     wchar_t dir_sep_utf16 = global_state::settings().dir_separator_utf16;
@@ -59,7 +58,7 @@ void swan_popup_modals::render_single_rename() noexcept
     auto cleanup_and_close_popup = [&]() noexcept {
         g_open = false;
         g_expl_opened_from = nullptr;
-        g_expl_dirent_to_rename = nullptr;
+        g_dirent_to_rename = {};
         g_on_rename_callback = {};
 
         s_new_name_utf8[0] = L'\0';
@@ -77,7 +76,7 @@ void swan_popup_modals::render_single_rename() noexcept
         s32 result = {};
 
         swan_path old_path_utf8 = g_expl_opened_from->cwd;
-        if (!path_append(old_path_utf8, g_expl_dirent_to_rename->basic.path.data(), dir_sep_utf8, true)) {
+        if (!path_append(old_path_utf8, g_dirent_to_rename.path.data(), dir_sep_utf8, true)) {
             cleanup_and_close_popup();
             return;
         }
@@ -93,7 +92,7 @@ void swan_popup_modals::render_single_rename() noexcept
             return;
         }
 
-        if (!utf8_to_utf16(g_expl_dirent_to_rename->basic.path.data(), buffer_old_name_utf16, lengthof(buffer_old_name_utf16))) {
+        if (!utf8_to_utf16(g_dirent_to_rename.path.data(), buffer_old_name_utf16, lengthof(buffer_old_name_utf16))) {
             cleanup_and_close_popup();
             return;
         }
@@ -206,7 +205,7 @@ void swan_popup_modals::render_single_rename() noexcept
     // set initial focus on input text below
     if (imgui::IsWindowAppearing() && !imgui::IsAnyItemActive() && !imgui::IsMouseClicked(0)) {
         imgui::SetKeyboardFocusHere(0);
-        s_new_name_utf8 = g_expl_dirent_to_rename->basic.path;
+        s_new_name_utf8 = g_dirent_to_rename.path;
     }
     {
         imgui::ScopedAvailWidth w(imgui::CalcTextSize(ICON_CI_DEBUG_RESTART).x + style.FramePadding.x*2 + style.ItemSpacing.x*2 + help_indicator_size().x);
@@ -225,12 +224,12 @@ void swan_popup_modals::render_single_rename() noexcept
     imgui::SameLine();
 
     if (imgui::Button(ICON_CI_DEBUG_RESTART "##reset_name")) {
-        s_new_name_utf8 = path_create(g_expl_dirent_to_rename->basic.path.data());
+        s_new_name_utf8 = path_create(g_dirent_to_rename.path.data());
     }
     if (imgui::IsItemHovered()) {
         if (imgui::BeginTooltip()) {
             imgui::TextUnformatted("Click to reset name to:");
-            imgui::TextColored(get_color(g_expl_dirent_to_rename->basic.type), g_expl_dirent_to_rename->basic.path.data());
+            imgui::TextColored(get_color(g_dirent_to_rename.type), g_dirent_to_rename.path.data());
             imgui::EndTooltip();
         }
     }
@@ -11,15 +11,9 @@ global_state::recent_files global_state::recent_files_get() noexcept { return {
 
 void erase(global_state::recent_files &obj,
            std::deque<recent_file>::iterator first,
-           std::deque<recent_file>::iterator last,
-           bool perform_delete_icon_texture) noexcept
+           std::deque<recent_file>::iterator last) noexcept
 {
-    if (perform_delete_icon_texture) {
-        for (auto iter = first; iter != last; ++iter) {
-            if (iter->icon_GLtexID > 0) delete_icon_texture(iter->icon_GLtexID, "recent_file");
-        }
-    }
-    obj.container->erase(first, last);
+    obj.container->erase(first, last); // icon handles release their cache entries
 }
 
 void global_state::recent_files_update(char const *action, char const *full_path) noexcept
@@ -68,7 +62,7 @@ void global_state::recent_files_move_to_front(u64 recent_file_idx, char const *n
         temp.action = new_action;
     }
     auto delete_iter = g_recent_files.begin() + recent_file_idx;
-    erase(recent_files, delete_iter, delete_iter + 1, false);
+    erase(recent_files, delete_iter, delete_iter + 1);
     recent_files.container->push_front(temp);
 }
 
@@ -83,7 +77,7 @@ void global_state::recent_files_add(char const *action, char const *full_file_pa
     if (recent_files.container->size() >= global_constants::MAX_RECENT_FILES) {
         erase(recent_files, recent_files.container->begin() + global_constants::MAX_RECENT_FILES, recent_files.container->end());
     }
-    g_recent_files.emplace_front(action, get_time_system(), 0, ImVec2(), path, "", false);
+    g_recent_files.emplace_front(action, get_time_system(), icon_handle(), path, "", false);
 }
 
 void global_state::recent_files_remove(u64 recent_file_idx) noexcept
@@ -171,7 +165,7 @@ try {
 
         path_force_separator(stored_path, dir_separator);
 
-        g_recent_files.emplace_back(stored_action, stored_time, 0, ImVec2(), stored_path, "", false);
+        g_recent_files.emplace_back(stored_action, stored_time, icon_handle(), stored_path, "", false);
 
         ++num_loaded_successfully;
 
@@ -210,14 +204,15 @@ bool swan_windows::render_recent_files(bool &open, bool any_popups_open) noexcep
         return false;
     }
 
-    std::string dummy_buf = {};
-    bool search_text_edited;
+    static std::string s_search_text = {};
+    static fuzzy_matcher s_search_matcher = {};
     {
-        imgui::ScopedDisable d(true);
         imgui::ScopedItemWidth w(imgui::CalcTextSize("123456789_123456789_123456789_").x);
         imgui::ScopedItemFlag no_nav(ImGuiItemFlags_NoNav, true);
 
-        search_text_edited = imgui::InputTextWithHint("## recent_files search", ICON_CI_SEARCH " TODO", &dummy_buf);
+        if (imgui::InputTextWithHint("## recent_files search", ICON_CI_SEARCH " Fuzzy search", &s_search_text)) {
+            (void) s_search_matcher.compile(s_search_text, false); // too long a pattern matches nothing
+        }
     }
 
     imgui::SameLineSpaced(1);
@@ -233,6 +228,7 @@ bool swan_windows::render_recent_files(bool &open, bool any_popups_open) noexcep
             imgui::TextUnformatted("- Double click a file to open");
             imgui::TextUnformatted("- Right click a file for context menu");
             imgui::TextUnformatted("- Hold Shift + Hover File Name to see full path");
+            imgui::TextUnformatted("- Type in the search box to find files by a few characters of their name, best matches first");
 
             imgui::EndTooltip();
         }
@@ -326,12 +322,41 @@ bool swan_windows::render_recent_files(bool &open, bool any_popups_open) noexcep
 
         std::scoped_lock recent_files_lock(g_recent_files_mutex);
 
+        //? Rows are shown in the order of `s_rows`: every file while not searching, else the matching ones by descending score.
+        //? Rescored every frame since files come and go, cheap for MAX_RECENT_FILES names.
+        struct displayed_row
+        {
+            u32 idx;
+            s32 score;
+            highlight_spans highlight;
+        };
+        static std::vector<displayed_row> s_rows = {};
+        s_rows.clear();
+
+        bool searching = !s_search_text.empty();
+
+        for (u64 i = 0; i < g_recent_files.size(); ++i) {
+            displayed_row row = { u32(i), 0, {} };
+            if (searching) {
+                row.score = s_search_matcher.error.empty() ? s_search_matcher.score(path_cfind_filename(g_recent_files[i].path.data()), &row.highlight)
+                                                           : fuzzy_matcher::no_match;
+                if (row.score == fuzzy_matcher::no_match) {
+                    continue;
+                }
+            }
+            s_rows.push_back(row);
+        }
+        if (searching) {
+            std::stable_sort(s_rows.begin(), s_rows.end(), [](displayed_row const &a, displayed_row const &b) noexcept { return a.score > b.score; });
+        }
+
         ImGuiListClipper clipper;
-        assert(g_recent_files.size() <= (u64)INT32_MAX);
-        clipper.Begin((s32)g_recent_files.size());
+        assert(s_rows.size() <= (u64)INT32_MAX);
+        clipper.Begin((s32)s_rows.size());
 
         while (clipper.Step())
-        for (u64 i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+        for (u64 display_idx = clipper.DisplayStart; display_idx < clipper.DisplayEnd; ++display_idx) {
+            u64 i = s_rows[display_idx].idx;
             auto &file = g_recent_files[i];
             char *full_path = file.path.data();
             char *file_name = path_find_filename(full_path);
@@ -356,14 +381,15 @@ bool swan_windows::render_recent_files(bool &open, bool any_popups_open) noexcep
                 static ImVec2 s_last_known_icon_size = {};
 
                 if (global_state::settings().win32_file_icons) {
-                    if (file.icon_GLtexID == 0) {
-                        std::tie(file.icon_GLtexID, file.icon_size) = load_icon_texture(file.path.data(), 0, "recent_file");
-                        if (file.icon_GLtexID > 0) {
-                            s_last_known_icon_size = file.icon_size;
-                        }
+                    if (file.icon.empty()) {
+                        file.icon = global_state::icons().acquire(file.path.data(), false);
                     }
-                    auto const &icon_size = file.icon_GLtexID < 1 ? s_last_known_icon_size : file.icon_size;
-                    ImGui::Image((ImTextureID)std::max(file.icon_GLtexID, s64(0)), icon_size);
+                    icon_view icon = global_state::icons().view(file.icon);
+                    if (icon.ready()) {
+                        s_last_known_icon_size = icon.size;
+                    }
+                    auto const &icon_size = icon.ready() ? icon.size : s_last_known_icon_size;
+                    ImGui::Image((ImTextureID)icon.texture, icon_size, icon.uv0, icon.uv1);
                 }
                 else { // fallback to generic icons
                     char const *icon = get_icon(basic_dirent::kind::file);
@@ -372,6 +398,7 @@ bool swan_windows::render_recent_files(bool &open, bool any_popups_open) noexcep
                 }
                 imgui::SameLine();
 
+                ImVec2 file_name_text_min = imgui::GetCursorScreenPos();
                 auto label = make_str_static<1200>("%s ## recent_file_%zu", file_name, i);
                 if (imgui::Selectable(label.data(), file.selected, ImGuiSelectableFlags_SpanAllColumns|ImGuiSelectableFlags_AllowDoubleClick)) {
                     bool selection_state_before_activate = file.selected;
@@ -388,19 +415,25 @@ bool swan_windows::render_recent_files(bool &open, bool any_popups_open) noexcep
                         file.selected = !selection_state_before_activate;
                     }
 
+                    // ranges are over displayed rows, which are not contiguous in `g_recent_files` while searching
                     if (io.KeyShift) {
-                        auto [first_idx, last_idx] = imgui::SelectRange(s_latest_selected_row_idx, i);
+                        auto [first_idx, last_idx] = imgui::SelectRange(s_latest_selected_row_idx, display_idx);
                         s_latest_selected_row_idx = last_idx;
-                        for (u64 j = first_idx; j <= last_idx; ++j) {
-                            g_recent_files[j].selected = true;
+                        for (u64 j = first_idx; j <= last_idx && j < s_rows.size(); ++j) {
+                            g_recent_files[s_rows[j].idx].selected = true;
                         }
                     } else {
-                        s_latest_selected_row_idx = i;
+                        s_latest_selected_row_idx = display_idx;
                     }
 
                     double_clicked |= imgui::IsMouseDoubleClicked(ImGuiMouseButton_Left);
                 }
                 right_clicked |= imgui::IsItemClicked(ImGuiMouseButton_Right);
+
+                if (!s_rows[display_idx].highlight.empty()) {
+                    imgui::HighlightTextRegions(file_name_text_min, file_name, s_rows[display_idx].highlight,
+                                                imgui::ReduceAlphaTo(imgui::Denormalize(warning_lite_color()), 75));
+                }
             }
             if (double_clicked) {
                 auto res = open_file(file_name, file_directory.data()); // TODO async
@@ -427,7 +460,7 @@ bool swan_windows::render_recent_files(bool &open, bool any_popups_open) noexcep
             }
             if (imgui::TableGetHoveredColumn() == recent_files_table_col_file_name && imgui::IsItemHovered() && io.KeyShift) {
                 if (imgui::BeginTooltip()) {
-                    render_path_with_stylish_separators(full_path, appropriate_icon(file.icon_GLtexID, basic_dirent::kind::file));
+                    render_path_with_stylish_separators(full_path, appropriate_icon(file.icon, basic_dirent::kind::file));
                     imgui::EndTooltip();
                 }
             }
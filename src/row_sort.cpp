@@ -0,0 +1,461 @@
+#include "row_sort.hpp"
+
+#if !defined(_WIN32)
+#   include <algorithm>
+#   include <atomic>
+#   include <bit>
+#   include <cassert>
+#   include <cstring>
+#   include <memory>
+#   include <thread>
+#endif
+
+void row_sort_executor::run(u64 num_jobs, std::function<void (u64)> const &job) const noexcept
+{
+    u64 num_helpers = this->push_task ? std::min(std::max(this->num_threads, u64(1)), num_jobs) - 1 : 0;
+
+    if (num_helpers == 0) {
+        for (u64 i = 0; i < num_jobs; ++i) {
+            job(i);
+        }
+        return;
+    }
+
+    struct shared_state
+    {
+        std::atomic<u64> next_job = 0;
+        std::atomic<u64> num_finished = 0;
+        u64 num_jobs = 0;
+        std::function<void (u64)> const *job = nullptr;
+    };
+
+    //? Helpers may only get to run after every job is done and this function has returned,
+    //? so they share ownership of the counters and never touch `job` once all jobs are claimed.
+    auto state = std::make_shared<shared_state>();
+    state->num_jobs = num_jobs;
+    state->job = &job;
+
+    auto work = [state]() noexcept {
+        for (u64 i = state->next_job.fetch_add(1); i < state->num_jobs; i = state->next_job.fetch_add(1)) {
+            (*state->job)(i);
+            state->num_finished.fetch_add(1, std::memory_order_release);
+        }
+    };
+
+    for (u64 i = 0; i < num_helpers; ++i) {
+        this->push_task(work);
+    }
+    work();
+
+    // only jobs already running on helpers are left, no waiting on queued tasks
+    while (state->num_finished.load(std::memory_order_acquire) < num_jobs) {
+        std::this_thread::yield();
+    }
+}
+
+static
+u64 collation_prefix_of(u8 const *key, u64 key_len) noexcept
+{
+    u64 len = std::min<u64>(key_len, sizeof(u64));
+
+    u64 prefix = 0;
+    for (u64 i = 0; i < len; ++i) {
+        prefix |= u64(key[i]) << ((sizeof(u64) - 1 - i) * 8);
+    }
+    return prefix;
+}
+
+void row_sort_column::set_collation_prefix(u32 row) noexcept
+{
+    this->collation_prefixes[row] = collation_prefix_of(this->collation_bytes.data() + this->collation_offsets[row], this->collation_lengths[row]);
+}
+
+void row_sort_column::reset(key_kind new_kind, u64 num_rows, bool new_descending) noexcept
+{
+    this->kind = new_kind;
+    this->descending = new_descending;
+
+    if (new_kind == key_kind::numeric) {
+        this->numeric_keys.resize(num_rows);
+    } else {
+        this->collation_prefixes.resize(num_rows);
+        this->collation_offsets.resize(num_rows);
+        this->collation_lengths.resize(num_rows);
+        this->collation_bytes.clear();
+    }
+}
+
+#if defined(_WIN32)
+
+void row_sort_column::append_collation_key(std::vector<u8> &bytes, std::string_view name_utf8) noexcept
+{
+    u64 offset = bytes.size();
+
+    wchar_t name_utf16[2048];
+    s32 name_len = MultiByteToWideChar(CP_UTF8, 0, name_utf8.data(), (s32)name_utf8.size(), name_utf16, (s32)std::size(name_utf16));
+    if (name_len <= 0) {
+        return;
+    }
+
+    //? A sort key compares with memcmp exactly like CompareStringEx compares the strings, so the expensive
+    //? linguistic work happens once per row instead of once per comparison.
+    DWORD flags = LCMAP_SORTKEY | NORM_IGNORECASE;
+    s32 capacity = (name_len * 8) + 16;
+    bytes.resize(offset + (u64)capacity);
+
+    s32 written = LCMapStringEx(LOCALE_NAME_USER_DEFAULT, flags, name_utf16, name_len,
+                                reinterpret_cast<LPWSTR>(bytes.data() + offset), capacity, nullptr, nullptr, 0);
+    if (written == 0) {
+        capacity = LCMapStringEx(LOCALE_NAME_USER_DEFAULT, flags, name_utf16, name_len, nullptr, 0, nullptr, nullptr, 0);
+        bytes.resize(offset + (u64)std::max(capacity, 0));
+        written = capacity <= 0 ? 0 : LCMapStringEx(LOCALE_NAME_USER_DEFAULT, flags, name_utf16, name_len,
+                                                    reinterpret_cast<LPWSTR>(bytes.data() + offset), capacity, nullptr, nullptr, 0);
+    }
+
+    bytes.resize(offset + (u64)written);
+}
+
+s32 collate_names(std::string_view left_utf8, std::string_view right_utf8) noexcept
+{
+    wchar_t left_utf16[2048], right_utf16[2048];
+    s32 left_len = MultiByteToWideChar(CP_UTF8, 0, left_utf8.data(), (s32)left_utf8.size(), left_utf16, (s32)std::size(left_utf16));
+    s32 right_len = MultiByteToWideChar(CP_UTF8, 0, right_utf8.data(), (s32)right_utf8.size(), right_utf16, (s32)std::size(right_utf16));
+
+    s32 result = CompareStringEx(LOCALE_NAME_USER_DEFAULT, NORM_IGNORECASE, left_utf16, std::max(left_len, 0), right_utf16, std::max(right_len, 0),
+                                 nullptr, nullptr, 0);
+    return result == 0 ? 0 : result - CSTR_EQUAL;
+}
+
+#else // POSIX
+
+static
+u8 fold_ascii_case(char ch) noexcept
+{
+    return (ch >= 'A' && ch <= 'Z') ? u8(ch - 'A' + 'a') : u8(ch);
+}
+
+void row_sort_column::append_collation_key(std::vector<u8> &bytes, std::string_view name_utf8) noexcept
+{
+    for (char ch : name_utf8) {
+        bytes.push_back(fold_ascii_case(ch));
+    }
+}
+
+s32 collate_names(std::string_view left_utf8, std::string_view right_utf8) noexcept
+{
+    u64 common_len = std::min(left_utf8.size(), right_utf8.size());
+
+    for (u64 i = 0; i < common_len; ++i) {
+        s32 delta = s32(fold_ascii_case(left_utf8[i])) - s32(fold_ascii_case(right_utf8[i]));
+        if (delta != 0) {
+            return delta;
+        }
+    }
+    return s32(left_utf8.size() > right_utf8.size()) - s32(left_utf8.size() < right_utf8.size());
+}
+
+#endif
+
+void row_sort_column::set_collation_key(u32 row, std::string_view name_utf8) noexcept
+{
+    u64 offset = this->collation_bytes.size();
+    append_collation_key(this->collation_bytes, name_utf8);
+
+    this->collation_offsets[row] = (u32)offset;
+    this->collation_lengths[row] = u32(this->collation_bytes.size() - offset);
+    set_collation_prefix(row);
+}
+
+void row_sort_column::set_collation_keys(u32 const *rows, u64 num_rows, std::function<std::string_view (u32)> const &name_of,
+                                         row_sort_executor const &executor) noexcept
+{
+    if (!executor.parallel(num_rows)) {
+        for (u64 i = 0; i < num_rows; ++i) {
+            set_collation_key(rows[i], name_of(rows[i]));
+        }
+        return;
+    }
+
+    //? More parts than threads so that a slow part (long names, a helper starting late) doesn't hold up the rest.
+    u64 num_parts = executor.num_threads * 4;
+    auto part_begin = [&](u64 part) noexcept { return num_rows * part / num_parts; };
+
+    //? Named through a reference, a thread_local mentioned inside the job would be the helper thread's own instance.
+    thread_local std::vector<std::vector<u8>> t_part_bytes = {};
+    std::vector<std::vector<u8>> &part_bytes = t_part_bytes;
+    part_bytes.resize(num_parts);
+
+    executor.run(num_parts, [&](u64 part) noexcept {
+        std::vector<u8> &bytes = part_bytes[part];
+        bytes.clear();
+
+        for (u64 i = part_begin(part); i < part_begin(part + 1); ++i) {
+            u32 row = rows[i];
+            u64 offset = bytes.size();
+            append_collation_key(bytes, name_of(row));
+
+            this->collation_offsets[row] = (u32)offset; // relative to the part until joined
+            this->collation_lengths[row] = u32(bytes.size() - offset);
+            this->collation_prefixes[row] = collation_prefix_of(bytes.data() + offset, bytes.size() - offset);
+        }
+    });
+
+    for (u64 part = 0; part < num_parts; ++part) {
+        std::vector<u8> const &bytes = part_bytes[part];
+        u32 base = (u32)this->collation_bytes.size();
+
+        for (u64 i = part_begin(part); i < part_begin(part + 1); ++i) {
+            this->collation_offsets[rows[i]] += base;
+        }
+        this->collation_bytes.insert(this->collation_bytes.end(), bytes.begin(), bytes.end());
+    }
+}
+
+s32 row_sort_column::compare_collation(u32 left, u32 right) const noexcept
+{
+    //? Names don't contain NUL, so zero padding of a short key's prefix can't tie with a real byte of a longer key
+    //? unless the rest of the longer key decides, which the full comparison below handles.
+    u64 left_prefix = this->collation_prefixes[left];
+    u64 right_prefix = this->collation_prefixes[right];
+    if (left_prefix != right_prefix) {
+        return left_prefix < right_prefix ? -1 : 1;
+    }
+
+    u32 left_len = this->collation_lengths[left];
+    u32 right_len = this->collation_lengths[right];
+
+    s32 delta = memcmp(this->collation_bytes.data() + this->collation_offsets[left],
+                       this->collation_bytes.data() + this->collation_offsets[right],
+                       std::min(left_len, right_len));
+    if (delta != 0) {
+        return delta;
+    }
+    return s32(left_len > right_len) - s32(left_len < right_len);
+}
+
+row_sort_column &row_sort_keys::add_column(row_sort_column::key_kind kind, u64 num_rows, bool descending) noexcept
+{
+    assert(this->num_columns < max_columns);
+    row_sort_column &column = this->columns[this->num_columns++];
+    column.reset(kind, num_rows, descending);
+    return column;
+}
+
+bool row_sort_keys::less_from(u64 first_column, u32 left, u32 right) const noexcept
+{
+    for (u64 i = first_column; i < this->num_columns; ++i) {
+        row_sort_column const &column = this->columns[i];
+
+        if (column.kind == row_sort_column::key_kind::numeric) {
+            u64 left_key = column.numeric_keys[left];
+            u64 right_key = column.numeric_keys[right];
+            if (left_key != right_key) {
+                return left_key < right_key;
+            }
+        } else {
+            s32 delta = column.compare_collation(left, right);
+            if (delta != 0) {
+                return column.descending ? delta > 0 : delta < 0;
+            }
+        }
+    }
+
+    return this->tiebreak ? this->tiebreak[left] < this->tiebreak[right] : left < right;
+}
+
+namespace row_sort_detail
+{
+    struct radix_item
+    {
+        u64 key;
+        u32 row;
+    };
+}
+
+/// Stable LSD radix sort by key, one byte per pass, then runs of equal keys are put in tiebreak order.
+/// All histograms are counted in a single read of the input and passes where every item has the same byte
+/// (e.g. the high bytes of sizes or timestamps) are skipped.
+static
+void radix_sort_rows(u64 const *keys, u32 const *tiebreak, u32 *rows, u64 num_rows) noexcept
+{
+    using row_sort_detail::radix_item;
+
+    thread_local std::vector<radix_item> t_items = {};
+    thread_local std::vector<radix_item> t_items_swap = {};
+    t_items.resize(num_rows);
+    t_items_swap.resize(num_rows);
+
+    u64 counts[sizeof(u64)][256] = {};
+
+    for (u64 i = 0; i < num_rows; ++i) {
+        u32 row = rows[i];
+        u64 key = keys[row];
+        t_items[i] = { key, row };
+
+        for (u64 pass = 0; pass < sizeof(u64); ++pass) {
+            ++counts[pass][u8(key >> (pass * 8))];
+        }
+    }
+
+    radix_item *src = t_items.data();
+    radix_item *dst = t_items_swap.data();
+
+    for (u64 pass = 0; pass < sizeof(u64); ++pass) {
+        u64 shift = pass * 8;
+        if (counts[pass][u8(src[0].key >> shift)] == num_rows) {
+            continue; // every item lands in the same bucket, order is unchanged
+        }
+
+        u64 offsets[256];
+        u64 running = 0;
+        for (u64 b = 0; b < 256; ++b) {
+            offsets[b] = running;
+            running += counts[pass][b];
+        }
+        for (u64 i = 0; i < num_rows; ++i) {
+            dst[offsets[u8(src[i].key >> shift)]++] = src[i];
+        }
+        std::swap(src, dst);
+    }
+
+    for (u64 i = 0; i < num_rows; ++i) {
+        rows[i] = src[i].row;
+    }
+
+    for (u64 run_begin = 0; run_begin < num_rows; ) {
+        u64 run_end = run_begin + 1;
+        while (run_end < num_rows && src[run_end].key == src[run_begin].key) {
+            ++run_end;
+        }
+        if (run_end - run_begin > 1) {
+            std::sort(rows + run_begin, rows + run_end, [&](u32 left, u32 right) noexcept {
+                return tiebreak ? tiebreak[left] < tiebreak[right] : left < right;
+            });
+        }
+        run_begin = run_end;
+    }
+}
+
+static
+void sort_rows_serial(row_sort_keys const &keys, u32 *rows, u64 num_rows) noexcept
+{
+    //? Below this, histogram setup costs more than comparison sorting saves.
+    static constexpr u64 radix_threshold = 512;
+
+    if (num_rows < 2) {
+        return;
+    }
+
+    u32 *rows_end = rows + num_rows;
+
+    if (keys.num_columns == 0) {
+        std::sort(rows, rows_end, [&](u32 left, u32 right) noexcept { return keys.less_from(0, left, right); });
+        return;
+    }
+
+    row_sort_column const &leading = keys.columns[0];
+
+    if (leading.kind == row_sort_column::key_kind::numeric) {
+        if (keys.num_columns == 1 && num_rows >= radix_threshold) {
+            radix_sort_rows(leading.numeric_keys.data(), keys.tiebreak, rows, num_rows);
+            return;
+        }
+        u64 const *numeric_keys = leading.numeric_keys.data();
+        std::sort(rows, rows_end, [&](u32 left, u32 right) noexcept {
+            u64 left_key = numeric_keys[left], right_key = numeric_keys[right];
+            return left_key != right_key ? left_key < right_key : keys.less_from(1, left, right);
+        });
+    }
+    else if (leading.descending) {
+        std::sort(rows, rows_end, [&](u32 left, u32 right) noexcept {
+            s32 delta = leading.compare_collation(left, right);
+            return delta != 0 ? delta > 0 : keys.less_from(1, left, right);
+        });
+    }
+    else {
+        std::sort(rows, rows_end, [&](u32 left, u32 right) noexcept {
+            s32 delta = leading.compare_collation(left, right);
+            return delta != 0 ? delta < 0 : keys.less_from(1, left, right);
+        });
+    }
+}
+
+/// Index into `left` at which the first `out_pos` elements of merging `left` and `right` split, i.e. they are
+/// left[0, result) and right[0, out_pos - result). Lets several threads produce disjoint parts of one merge.
+static
+u64 merge_split(row_sort_keys const &keys, u32 const *left, u64 left_len, u32 const *right, u64 right_len, u64 out_pos) noexcept
+{
+    u64 low = out_pos > right_len ? out_pos - right_len : 0;
+    u64 high = std::min(out_pos, left_len);
+
+    // smallest i where every taken element of `right` goes before left[i]
+    while (low < high) {
+        u64 i = low + ((high - low) / 2);
+        u64 j = out_pos - i;
+        if (j > 0 && keys.less(left[i], right[j - 1])) {
+            low = i + 1;
+        } else {
+            high = i;
+        }
+    }
+    return low;
+}
+
+static
+void sort_rows_parallel(row_sort_keys const &keys, u32 *rows, u64 num_rows, row_sort_executor const &executor) noexcept
+{
+    //? Power of two chunks so that every merge round pairs them all up, each round split into as many jobs as there are chunks.
+    u64 num_chunks = std::bit_floor(std::clamp<u64>(executor.num_threads, 2, 64));
+    auto chunk_begin = [&](u64 chunk) noexcept { return num_rows * chunk / num_chunks; };
+
+    executor.run(num_chunks, [&](u64 chunk) noexcept {
+        sort_rows_serial(keys, rows + chunk_begin(chunk), chunk_begin(chunk + 1) - chunk_begin(chunk));
+    });
+
+    thread_local std::vector<u32> t_merged = {};
+    t_merged.resize(num_rows);
+
+    u32 *src = rows;
+    u32 *dst = t_merged.data();
+    auto less = [&](u32 left, u32 right) noexcept { return keys.less(left, right); };
+
+    for (u64 width = 1; width < num_chunks; width *= 2) {
+        u64 parts_per_merge = width * 2;
+
+        executor.run(num_chunks, [&](u64 job) noexcept {
+            u64 first_chunk = (job / parts_per_merge) * parts_per_merge;
+            u64 part = job % parts_per_merge;
+
+            u64 left_begin = chunk_begin(first_chunk);
+            u64 right_begin = chunk_begin(first_chunk + width);
+            u64 right_end = chunk_begin(first_chunk + parts_per_merge);
+            u64 left_len = right_begin - left_begin;
+            u64 right_len = right_end - right_begin;
+            u64 merged_len = left_len + right_len;
+
+            u64 out_begin = merged_len * part / parts_per_merge;
+            u64 out_end = merged_len * (part + 1) / parts_per_merge;
+            u64 left_split_begin = merge_split(keys, src + left_begin, left_len, src + right_begin, right_len, out_begin);
+            u64 left_split_end = merge_split(keys, src + left_begin, left_len, src + right_begin, right_len, out_end);
+
+            std::merge(src + left_begin + left_split_begin, src + left_begin + left_split_end,
+                       src + right_begin + (out_begin - left_split_begin), src + right_begin + (out_end - left_split_end),
+                       dst + left_begin + out_begin, less);
+        });
+
+        std::swap(src, dst);
+    }
+
+    if (src != rows) {
+        std::memcpy(rows, src, num_rows * sizeof(u32));
+    }
+}
+
+void sort_rows(row_sort_keys const &keys, u32 *rows, u64 num_rows, row_sort_executor const &executor) noexcept
+{
+    if (executor.parallel(num_rows)) {
+        sort_rows_parallel(keys, rows, num_rows, executor);
+    } else {
+        sort_rows_serial(keys, rows, num_rows);
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+//? Sorting of row indices by keys prepared once per sort, for tables stored column-wise like explorer_window::dirent_table.
+
+#if defined(_WIN32)
+#   include "stdafx.hpp"
+#else
+#   include <functional>
+#   include <string_view>
+#   include <vector>
+#endif
+
+#include "primitives.hpp"
+
+/// Lets sorting use a thread pool without depending on one. `push_task` hands a task to some other thread,
+/// `num_threads` is how many tasks may run at once. A default constructed executor runs everything on the calling thread.
+struct row_sort_executor
+{
+    std::function<void (std::function<void ()>)> push_task = {};
+    u64 num_threads = 1;
+
+    /// Inputs smaller than this are handled on the calling thread alone, fanning out costs more than it saves.
+    static constexpr u64 parallel_threshold = 64 * 1024;
+
+    /// Runs `job(i)` for every i in [0, num_jobs) on the calling thread and up to `num_threads - 1` pushed tasks, returns once all are done.
+    /// The calling thread claims jobs as well and never waits for a job nobody has started, so a pool busy with slow tasks
+    /// (e.g. resolving links to network targets) only costs parallelism, it can't stall the caller.
+    void run(u64 num_jobs, std::function<void (u64)> const &job) const noexcept;
+
+    bool parallel(u64 num_items) const noexcept { return push_task && num_threads > 1 && num_items >= parallel_threshold; }
+};
+
+/// Keys of one sort column, indexed by row. Only rows being sorted need a key.
+struct row_sort_column
+{
+    enum class key_kind : u8
+    {
+        numeric,   // row a goes before row b if numeric_keys[a] < numeric_keys[b], direction is folded into the keys
+        collation, // row a goes before row b if its collation key compares less (greater when `descending`)
+    };
+
+    key_kind kind = key_kind::numeric;
+    bool descending = false;
+    std::vector<u64> numeric_keys = {};
+    std::vector<u64> collation_prefixes = {}; // first 8 key bytes, big endian, decides most comparisons without touching collation_bytes
+    std::vector<u32> collation_offsets = {};  // into collation_bytes
+    std::vector<u32> collation_lengths = {};
+    std::vector<u8> collation_bytes = {};
+
+    void reset(key_kind new_kind, u64 num_rows, bool new_descending = false) noexcept;
+    void set_collation_key(u32 row, std::string_view name_utf8) noexcept;
+    s32 compare_collation(u32 left, u32 right) const noexcept;
+
+    /// Sets the collation keys of `num_rows` rows, `name_of(row)` giving their names. Building keys is the expensive part of sorting
+    /// by name, with a parallel `executor` every job builds into its own arena and the arenas are joined at the end.
+    void set_collation_keys(u32 const *rows, u64 num_rows, std::function<std::string_view (u32)> const &name_of,
+                            row_sort_executor const &executor = {}) noexcept;
+
+private:
+    static void append_collation_key(std::vector<u8> &bytes, std::string_view name_utf8) noexcept;
+    void set_collation_prefix(u32 row) noexcept;
+};
+
+/// Sort columns (most significant first) plus a final ascending tiebreak, e.g. entry ids, so that results are deterministic.
+struct row_sort_keys
+{
+    static constexpr u64 max_columns = 10; // every explorer table column plus the fuzzy filter score
+
+    row_sort_column columns[max_columns] = {};
+    u64 num_columns = 0;
+    u32 const *tiebreak = nullptr; // indexed by row
+
+    row_sort_column &add_column(row_sort_column::key_kind kind, u64 num_rows, bool descending = false) noexcept;
+    void clear() noexcept { num_columns = 0; tiebreak = nullptr; }
+
+    bool less(u32 left, u32 right) const noexcept { return less_from(0, left, right); }
+    bool less_from(u64 first_column, u32 left, u32 right) const noexcept; // skips columns known to compare equal
+};
+
+/// Sorts `rows` by `keys`. Picks a comparator specialized for the leading column, or an LSD radix sort when
+/// the only column is numeric. Scratch memory is kept per thread between calls.
+/// With a parallel `executor` and enough rows, chunks are sorted concurrently and then merged pairwise, every merge split
+/// across all threads. The order is exactly the serial one since `keys` (with its tiebreak) is a total order.
+void sort_rows(row_sort_keys const &keys, u32 *rows, u64 num_rows, row_sort_executor const &executor = {}) noexcept;
+
+/// Case insensitive collation of two UTF-8 names, consistent with comparing their keys from `row_sort_column::set_collation_key`.
+/// Win32: user locale, same as CompareStringEx with NORM_IGNORECASE. POSIX: ASCII case folding.
+s32 collate_names(std::string_view left_utf8, std::string_view right_utf8) noexcept;
@@ -78,6 +78,8 @@ try {
     };
 
     ofs << "num_max_file_operations " << this->num_max_file_operations << '\n';
+    ofs << "explorer_parallel_filter_min_entries " << this->explorer_parallel_filter_min_entries << '\n';
+    ofs << "finder_num_threads " << this->finder_num_threads << '\n';
 
     ofs << "window_x " << this->window_x << '\n';
     ofs << "window_y " << this->window_y << '\n';
@@ -999,6 +1001,12 @@ try {
             if (property == "num_max_file_operations") {
                 ss >> this->num_max_file_operations;
             }
+            else if (property == "explorer_parallel_filter_min_entries") {
+                ss >> this->explorer_parallel_filter_min_entries;
+            }
+            else if (property == "finder_num_threads") {
+                ss >> this->finder_num_threads;
+            }
             else if (property == "window_x") {
                 ss >> this->window_x;
             }
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <array>
 #include <atomic>
+#include <bit>
 #include <boost/circular_buffer.hpp>
 #include <boost/container/static_vector.hpp>
 #include <boost/static_string.hpp>
@@ -19,6 +20,8 @@
 #include <fstream>
 #include <future>
 #include <iostream>
+#include <limits>
+#include <map>
 #include <mutex>
 #include <numbers>
 #include <numeric>
@@ -0,0 +1,342 @@
+#include "substring_search.hpp"
+
+#if !defined(_WIN32)
+#   include <algorithm>
+#   include <bit>
+#   include <cstring>
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__)
+#   define SUBSTRING_SEARCH_X86 1
+#   include <immintrin.h>
+#   if defined(_MSC_VER)
+#       include <intrin.h>
+#       define SUBSTRING_SEARCH_TARGET_AVX2
+#   else
+#       define SUBSTRING_SEARCH_TARGET_AVX2 __attribute__((target("avx2")))
+#   endif
+#else
+#   define SUBSTRING_SEARCH_X86 0
+#endif
+
+static
+u8 fold_ascii(u8 ch) noexcept
+{
+    return (ch >= 'A' && ch <= 'Z') ? u8(ch - 'A' + 'a') : ch;
+}
+
+static
+bool is_ascii_letter(u8 ch) noexcept
+{
+    return (fold_ascii(ch) >= 'a' && fold_ascii(ch) <= 'z');
+}
+
+//? The scan loops below all report candidates where the first and last needle bytes match (after OR-ing the fold masks),
+//? every candidate is then verified in full. A letter OR 0x20 is its lower case, a non-letter's mask is 0 and compares exactly.
+
+static
+bool verify_candidate(u8 const *haystack, substring_matcher const &matcher) noexcept
+{
+    u8 const *needle = reinterpret_cast<u8 const *>(matcher.needle.data());
+    u64 needle_len = matcher.needle.size();
+
+    if (!matcher.ignore_ascii_case) {
+        return std::memcmp(haystack, needle, needle_len) == 0;
+    }
+    for (u64 i = 0; i < needle_len; ++i) {
+        if (fold_ascii(haystack[i]) != needle[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static
+u64 find_scalar(u8 const *haystack, u64 haystack_len, u64 start, substring_matcher const &matcher) noexcept
+{
+    u64 needle_len = matcher.needle.size();
+    u8 first = u8(matcher.needle.front());
+    u8 last = u8(matcher.needle.back());
+
+    for (u64 i = start; i + needle_len <= haystack_len; ++i) {
+        if ((haystack[i] | matcher.first_fold_mask) == first
+         && (haystack[i + needle_len - 1] | matcher.last_fold_mask) == last
+         && verify_candidate(haystack + i, matcher))
+        {
+            return i;
+        }
+    }
+    return substring_matcher::not_found;
+}
+
+#if SUBSTRING_SEARCH_X86
+
+static
+u64 find_sse2(u8 const *haystack, u64 haystack_len, u64 start, substring_matcher const &matcher) noexcept
+{
+    u64 needle_len = matcher.needle.size();
+    __m128i first = _mm_set1_epi8((char)matcher.needle.front());
+    __m128i last = _mm_set1_epi8((char)matcher.needle.back());
+    __m128i first_mask = _mm_set1_epi8((char)matcher.first_fold_mask);
+    __m128i last_mask = _mm_set1_epi8((char)matcher.last_fold_mask);
+
+    u64 i = start;
+    for (; i + needle_len - 1 + 16 <= haystack_len; i += 16) {
+        __m128i block_first = _mm_loadu_si128(reinterpret_cast<__m128i const *>(haystack + i));
+        __m128i block_last = _mm_loadu_si128(reinterpret_cast<__m128i const *>(haystack + i + needle_len - 1));
+
+        __m128i candidates = _mm_and_si128(_mm_cmpeq_epi8(_mm_or_si128(block_first, first_mask), first),
+                                           _mm_cmpeq_epi8(_mm_or_si128(block_last, last_mask), last));
+
+        for (u32 bits = (u32)_mm_movemask_epi8(candidates); bits != 0; bits &= bits - 1) {
+            u64 candidate = i + (u64)std::countr_zero(bits);
+            if (verify_candidate(haystack + candidate, matcher)) {
+                return candidate;
+            }
+        }
+    }
+    return find_scalar(haystack, haystack_len, i, matcher);
+}
+
+SUBSTRING_SEARCH_TARGET_AVX2 static
+u64 find_avx2(u8 const *haystack, u64 haystack_len, substring_matcher const &matcher) noexcept
+{
+    u64 needle_len = matcher.needle.size();
+    __m256i first = _mm256_set1_epi8((char)matcher.needle.front());
+    __m256i last = _mm256_set1_epi8((char)matcher.needle.back());
+    __m256i first_mask = _mm256_set1_epi8((char)matcher.first_fold_mask);
+    __m256i last_mask = _mm256_set1_epi8((char)matcher.last_fold_mask);
+
+    u64 i = 0;
+    for (; i + needle_len - 1 + 32 <= haystack_len; i += 32) {
+        __m256i block_first = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(haystack + i));
+        __m256i block_last = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(haystack + i + needle_len - 1));
+
+        __m256i candidates = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_or_si256(block_first, first_mask), first),
+                                              _mm256_cmpeq_epi8(_mm256_or_si256(block_last, last_mask), last));
+
+        for (u32 bits = (u32)_mm256_movemask_epi8(candidates); bits != 0; bits &= bits - 1) {
+            u64 candidate = i + (u64)std::countr_zero(bits);
+            if (verify_candidate(haystack + candidate, matcher)) {
+                return candidate;
+            }
+        }
+    }
+    return find_sse2(haystack, haystack_len, i, matcher); // file names are mostly shorter than one AVX2 block
+}
+
+static
+bool cpu_has_avx2() noexcept
+{
+#if defined(_MSC_VER)
+    s32 regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7) {
+        return false;
+    }
+    __cpuid(regs, 1);
+    bool os_saves_ymm = (regs[2] & (1 << 27)) && (_xgetbv(0) & 0b110) == 0b110; // OSXSAVE, then XMM and YMM state enabled
+    __cpuidex(regs, 7, 0);
+    return os_saves_ymm && (regs[1] & (1 << 5));
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static bool const g_cpu_has_avx2 = cpu_has_avx2();
+
+#endif // SUBSTRING_SEARCH_X86
+
+char const *substring_search_isa() noexcept
+{
+#if SUBSTRING_SEARCH_X86
+    return g_cpu_has_avx2 ? "AVX2" : "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+u64 substring_matcher::find(std::string_view haystack_utf8, u64 *match_len) const noexcept
+{
+    if (this->unicode_fold) {
+        return find_unicode(haystack_utf8, match_len);
+    }
+    if (match_len) {
+        *match_len = this->needle.size();
+    }
+    if (this->needle.empty()) {
+        return 0;
+    }
+    if (this->needle.size() > haystack_utf8.size()) {
+        return not_found;
+    }
+
+    u8 const *haystack = reinterpret_cast<u8 const *>(haystack_utf8.data());
+
+#if SUBSTRING_SEARCH_X86
+    if (g_cpu_has_avx2) {
+        return find_avx2(haystack, haystack_utf8.size(), *this);
+    }
+    return find_sse2(haystack, haystack_utf8.size(), 0, *this);
+#else
+    return find_scalar(haystack, haystack_utf8.size(), 0, *this);
+#endif
+}
+
+#if defined(_WIN32)
+
+u64 substring_matcher::find_unicode(std::string_view haystack_utf8, u64 *match_len) const noexcept
+{
+    u64 needle_len = this->folded_needle_utf16.size();
+    if (match_len) {
+        *match_len = 0;
+    }
+    if (needle_len == 0) {
+        return this->needle.empty() ? 0 : not_found; // a needle which failed conversion matches nothing
+    }
+
+    thread_local std::wstring t_haystack_utf16 = {};
+    thread_local std::wstring t_folded_utf16 = {};
+    t_haystack_utf16.resize(haystack_utf8.size());
+    t_folded_utf16.resize(haystack_utf8.size());
+
+    s32 len = MultiByteToWideChar(CP_UTF8, 0, haystack_utf8.data(), (s32)haystack_utf8.size(), t_haystack_utf16.data(), (s32)t_haystack_utf16.size());
+    if (len <= 0 || LCMapStringEx(LOCALE_NAME_INVARIANT, LCMAP_LOWERCASE, t_haystack_utf16.data(), len, t_folded_utf16.data(), len, nullptr, nullptr, 0) != len) {
+        return not_found;
+    }
+
+    //? LCMAP_LOWERCASE maps one UTF-16 unit to one, so positions in the folded text are positions in the original.
+    u64 pos = std::wstring_view(t_folded_utf16.data(), (u64)len).find(this->folded_needle_utf16);
+    if (pos == std::wstring_view::npos) {
+        return not_found;
+    }
+
+    s32 offset = pos == 0 ? 0 : WideCharToMultiByte(CP_UTF8, 0, t_haystack_utf16.data(), (s32)pos, nullptr, 0, nullptr, nullptr);
+    if (match_len) {
+        *match_len = (u64)WideCharToMultiByte(CP_UTF8, 0, t_haystack_utf16.data() + pos, (s32)needle_len, nullptr, 0, nullptr, nullptr);
+    }
+    return (u64)offset;
+}
+
+#else // POSIX
+
+/// Decodes one UTF-8 sequence at `text`, malformed sequences decode as U+FFFD one byte at a time.
+static
+u32 decode_utf8(u8 const *text, u64 available, u64 &seq_len) noexcept
+{
+    u8 lead = text[0];
+    u64 len = lead < 0x80 ? 1 : (lead >> 5) == 0b110 ? 2 : (lead >> 4) == 0b1110 ? 3 : (lead >> 3) == 0b11110 ? 4 : 0;
+
+    if (len == 0 || len > available) {
+        seq_len = 1;
+        return 0xFFFD;
+    }
+    u32 codepoint = len == 1 ? lead : u32(lead & (0x7F >> len));
+    for (u64 i = 1; i < len; ++i) {
+        if ((text[i] & 0xC0) != 0x80) {
+            seq_len = 1;
+            return 0xFFFD;
+        }
+        codepoint = (codepoint << 6) | (text[i] & 0x3F);
+    }
+    seq_len = len;
+    return codepoint;
+}
+
+static
+u32 simple_lowercase(u32 cp) noexcept
+{
+    if (cp >= 'A' && cp <= 'Z')                  return cp + 32;
+    if (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7)  return cp + 32;        // Latin-1
+    if (cp >= 0x100 && cp <= 0x137)              return cp | 1;         // Latin Extended-A, upper/lower pairs
+    if (cp >= 0x391 && cp <= 0x3AB && cp != 0x3A2) return cp + 32;      // Greek
+    if (cp >= 0x410 && cp <= 0x42F)              return cp + 32;        // Cyrillic
+    if (cp >= 0x400 && cp <= 0x40F)              return cp + 80;
+    return cp;
+}
+
+static
+void fold_utf8(std::string_view text_utf8, std::vector<u32> &codepoints, std::vector<u32> *byte_offsets) noexcept
+{
+    codepoints.clear();
+    if (byte_offsets) {
+        byte_offsets->clear();
+    }
+    u8 const *text = reinterpret_cast<u8 const *>(text_utf8.data());
+
+    for (u64 i = 0, seq_len = 0; i < text_utf8.size(); i += seq_len) {
+        codepoints.push_back(simple_lowercase(decode_utf8(text + i, text_utf8.size() - i, seq_len)));
+        if (byte_offsets) {
+            byte_offsets->push_back((u32)i);
+        }
+    }
+    if (byte_offsets) {
+        byte_offsets->push_back((u32)text_utf8.size());
+    }
+}
+
+u64 substring_matcher::find_unicode(std::string_view haystack_utf8, u64 *match_len) const noexcept
+{
+    if (match_len) {
+        *match_len = 0;
+    }
+    if (this->folded_needle_codepoints.empty()) {
+        return 0;
+    }
+
+    thread_local std::vector<u32> t_codepoints = {};
+    thread_local std::vector<u32> t_byte_offsets = {};
+    fold_utf8(haystack_utf8, t_codepoints, &t_byte_offsets);
+
+    auto match = std::search(t_codepoints.begin(), t_codepoints.end(), this->folded_needle_codepoints.begin(), this->folded_needle_codepoints.end());
+    if (match == t_codepoints.end()) {
+        return not_found;
+    }
+
+    u64 first = (u64)std::distance(t_codepoints.begin(), match);
+    u64 last = first + this->folded_needle_codepoints.size();
+    if (match_len) {
+        *match_len = t_byte_offsets[last] - t_byte_offsets[first];
+    }
+    return t_byte_offsets[first];
+}
+
+#endif
+
+void substring_matcher::compile(std::string_view needle_utf8, bool case_sensitive) noexcept
+{
+    this->needle.assign(needle_utf8);
+    this->ignore_ascii_case = !case_sensitive;
+    this->unicode_fold = !case_sensitive && std::any_of(needle_utf8.begin(), needle_utf8.end(), [](char ch) noexcept { return u8(ch) >= 0x80; });
+    this->first_fold_mask = 0;
+    this->last_fold_mask = 0;
+
+    if (this->ignore_ascii_case) {
+        for (char &ch : this->needle) {
+            ch = (char)fold_ascii(u8(ch));
+        }
+    }
+    if (!this->needle.empty() && this->ignore_ascii_case) {
+        this->first_fold_mask = is_ascii_letter(u8(this->needle.front())) ? 0x20 : 0;
+        this->last_fold_mask = is_ascii_letter(u8(this->needle.back())) ? 0x20 : 0;
+    }
+
+#if defined(_WIN32)
+    this->folded_needle_utf16.clear();
+
+    if (this->unicode_fold) {
+        std::wstring needle_utf16(needle_utf8.size(), L'\0'); // never more UTF-16 units than UTF-8 bytes
+        s32 len = MultiByteToWideChar(CP_UTF8, 0, needle_utf8.data(), (s32)needle_utf8.size(), needle_utf16.data(), (s32)needle_utf16.size());
+        this->folded_needle_utf16.resize((u64)std::max(len, 0));
+        if (len > 0) {
+            LCMapStringEx(LOCALE_NAME_INVARIANT, LCMAP_LOWERCASE, needle_utf16.data(), len, this->folded_needle_utf16.data(), len, nullptr, nullptr, 0);
+        }
+    }
+#else
+    this->folded_needle_codepoints.clear();
+
+    if (this->unicode_fold) {
+        fold_utf8(needle_utf8, this->folded_needle_codepoints, nullptr);
+    }
+#endif
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+//? Substring search for filtering names and log records: the needle is prepared once, haystacks are scanned 16 or 32 bytes at a time.
+
+#if defined(_WIN32)
+#   include "stdafx.hpp"
+#else
+#   include <string>
+#   include <string_view>
+#   include <vector>
+#endif
+
+#include "primitives.hpp"
+
+/// Finds a fixed needle in UTF-8 haystacks, optionally ignoring case.
+/// ASCII needles, the common case, are compared byte-wise with ASCII case folding: SSE2 or AVX2 finds positions where the first
+/// and last byte of the needle both match, only those are verified. UTF-8 lead and continuation bytes are never ASCII, so this is
+/// exact for ASCII needles in non-ASCII names too. Case insensitive non-ASCII needles fall back to comparing lowercased text
+/// (Win32: LCMapStringEx on UTF-16, POSIX: simple Latin/Greek/Cyrillic mappings).
+struct substring_matcher
+{
+    static constexpr u64 not_found = u64(-1);
+
+    substring_matcher() noexcept = default;
+    substring_matcher(std::string_view needle_utf8, bool case_sensitive) noexcept { compile(needle_utf8, case_sensitive); }
+
+    void compile(std::string_view needle_utf8, bool case_sensitive) noexcept;
+
+    /// Byte offset of the first match in `haystack_utf8`, or `not_found`. An empty needle matches at 0.
+    /// `match_len`, if given, receives the length of the match in bytes, which can differ from the needle's when non-ASCII case is folded.
+    u64 find(std::string_view haystack_utf8, u64 *match_len = nullptr) const noexcept;
+    bool matches(std::string_view haystack_utf8) const noexcept { return find(haystack_utf8) != not_found; }
+
+    bool empty() const noexcept { return needle.empty(); }
+
+    std::string needle = {};    // lower case if `ignore_ascii_case`
+    bool ignore_ascii_case = false;
+    bool unicode_fold = false;  // case insensitive and the needle has non-ASCII characters, `find` takes the fallback path
+    u8 first_fold_mask = 0;     // 0x20 if the first byte is a letter compared case insensitively, OR-ing it into a byte lowers A-Z
+    u8 last_fold_mask = 0;
+#if defined(_WIN32)
+    std::wstring folded_needle_utf16 = {};
+#else
+    std::vector<u32> folded_needle_codepoints = {};
+#endif
+
+private:
+    u64 find_unicode(std::string_view haystack_utf8, u64 *match_len) const noexcept;
+};
+
+/// Widest instruction set `substring_matcher::find` uses on this CPU: "AVX2", "SSE2" or "scalar".
+char const *substring_search_isa() noexcept;
@@ -148,6 +148,8 @@ try {
         global_state::page_size() = system_info.dwPageSize;
         print_debug_msg("global_state::page_size = %d", global_state::page_size());
 
+        global_state::icons().open_store(global_state::execution_path() / "data\\icons.bin");
+
         (void) global_state::settings().load_from_disk();
         (void) global_state::pinned_load_from_disk(global_state::settings().dir_separator_utf8);
         {
@@ -180,6 +182,8 @@ try {
         }
     }
 
+    SCOPE_EXIT { (void) global_state::icons().save_store(); };
+
     auto &explorers = global_state::explorers();
     // init explorers
     {
@@ -216,6 +220,8 @@ try {
     finder_window finder = {
         .search_directories = { { false, path_create("") } }
     };
+    (void) finder.load_indexed_roots_from_disk();
+    SCOPE_EXIT { finder.save_indexes(); };
 
     // last elem is the last window to be rendered, the most forward window
     std::array<swan_windows::id, (u64)swan_windows::id::count - 1> window_render_order = window_render_order_load_from_disk();
@@ -267,6 +273,12 @@ try {
         auto visib_at_frame_start = global_state::settings().show;
 
         SCOPE_EXIT {
+            //? After every window had the chance to ask for icons, so extraction starts this frame.
+            //? Uploads are capped so scrolling through thousands of new icons spreads them over a few frames instead of dropping one.
+            u64 const max_icon_uploads_per_frame = 64;
+            f64 const icon_upload_budget_us = 2000;
+            global_state::icons().update(max_icon_uploads_per_frame, icon_upload_budget_us);
+
             EndFrame_GLFW_OpenGL3(window);
 
             for (auto &id : global_state::delete_icon_textures_queue()) {
@@ -280,6 +292,8 @@ try {
             }
         };
 
+        finder.update_indexed_roots();
+
         imgui::DockSpaceOverViewport(0, ImGuiDockNodeFlags_PassthruCentralNode);
 
         render_main_menu_bar(window, explorers);
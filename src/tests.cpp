@@ -1,5 +1,14 @@
 #include "stdafx.hpp"
 #include "common_functions.hpp"
+#include "directory_changes.hpp"
+#include "date_time_format.hpp"
+#include "directory_enumeration.hpp"
+#include "directory_traversal.hpp"
+#include "fuzzy_match.hpp"
+#include "link_resolution.hpp"
+#include "name_pattern.hpp"
+#include "row_sort.hpp"
+#include "substring_search.hpp"
 
 std::optional<ntest::report_result> run_tests(std::filesystem::path const &output_path,
                                               void (*assertion_callback)(ntest::assertion const &, bool)) noexcept
@@ -388,6 +397,1149 @@ try {
     }
     #endif
 
+    // directory_enumerator
+    #if 1
+    {
+        auto dir = output_path / "directory_enumerator";
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir / "sub");
+        std::ofstream(dir / "abc.txt") << "abc";
+        std::ofstream(dir / L"Юникод.txt");
+
+        std::string dir_utf8 = dir.string();
+
+        directory_entry_batch batch = {};
+        u64 num_entries = 0, num_directories = 0, size_of_abc = 0;
+        bool found_unicode_name = false;
+
+        bool opened = enumerate_directory(dir_utf8.c_str(), batch, [&](directory_entry_batch const &b, directory_entry const &e) noexcept {
+            ++num_entries;
+            num_directories += e.kind == directory_entry_kind::directory;
+            if (b.name_view(e) == "abc.txt") size_of_abc = e.size;
+            if (b.name_view(e) == (char const *)u8"Юникод.txt") found_unicode_name = true;
+            return true;
+        });
+
+        if (ntest::assert_bool(true, opened)) {
+            ntest::assert_uint64(3, num_entries);
+            ntest::assert_uint64(1, num_directories);
+            ntest::assert_uint64(3, size_of_abc);
+            ntest::assert_bool(true, found_unicode_name);
+        }
+
+        directory_enumerator enumerator;
+        if (ntest::assert_bool(true, enumerator.open(dir_utf8.c_str(), true))) {
+            u64 num_batches = 0;
+            while (enumerator.next_batch(batch, 1) > 0) {
+                ntest::assert_uint64(1, batch.entries.size());
+                ++num_batches;
+            }
+            ntest::assert_uint64(4, num_batches); // includes ".."
+        }
+
+        ntest::assert_bool(false, enumerator.open((dir_utf8 + "_does_not_exist").c_str()));
+    }
+    #endif
+
+    // directory_traversal
+    #if 1
+    {
+        auto dir = output_path / "directory_traversal";
+        std::filesystem::remove_all(dir);
+        for (char const *sub : { "a\\aa\\aaa", "a\\ab", "b", "c\\ca" }) {
+            std::filesystem::create_directories(dir / sub);
+            std::ofstream(dir / sub / "match.txt");
+            std::ofstream(dir / sub / "other.txt");
+        }
+
+        for (u64 num_threads : { 1, 4 }) {
+            swan_thread_pool_t pool(3);
+            std::array<directory_traversal_counter, 4> counters = {};
+            std::atomic_bool cancellation_token = false;
+            std::mutex found_mutex;
+            std::vector<std::string> found = {};
+
+            directory_traversal traversal = {};
+            traversal.push_task = [&pool](std::function<void ()> task) noexcept { pool.push_task(std::move(task)); };
+            traversal.num_threads = num_threads;
+            traversal.cancellation_token = &cancellation_token;
+            traversal.counters = counters.data();
+
+            traversal.run({ dir.string() }, [&](u64, std::string_view directory, directory_entry_batch const &batch) noexcept {
+                for (auto const &entry : batch.entries) {
+                    if (batch.name_view(entry) == "match.txt") {
+                        std::scoped_lock lock(found_mutex);
+                        found.emplace_back(directory);
+                    }
+                }
+            });
+
+            u64 num_entries = 0, num_directories = 0;
+            for (auto const &counter : counters) {
+                num_entries += counter.num_entries.load();
+                num_directories += counter.num_directories.load();
+            }
+            ntest::assert_uint64(4, found.size());
+            ntest::assert_uint64(7 + 8, num_entries); // 7 directories below the root, 2 files in 4 of them
+            ntest::assert_uint64(8, num_directories);
+
+            // cancelled before starting, nothing but the roots is touched
+            cancellation_token.store(true);
+            found.clear();
+            traversal.run({ dir.string() }, [&](u64, std::string_view, directory_entry_batch const &) noexcept { found.emplace_back(); });
+            ntest::assert_uint64(0, found.size());
+        }
+    }
+    #endif
+
+    // filesystem_index
+    #if 1
+    {
+        auto dir = output_path / "filesystem_index";
+        std::filesystem::remove_all(dir);
+        for (char const *sub : { "a\\aa", "b", "c" }) {
+            std::filesystem::create_directories(dir / sub);
+            std::ofstream(dir / sub / "match.txt");
+            std::ofstream(dir / sub / "other.txt");
+        }
+        std::string root = dir.string();
+
+        filesystem_index index = {};
+        ntest::assert_bool(true, index.build(root, directory_traversal()));
+        ntest::assert_uint64(1 + 4 + 6, index.size()); // the root, 4 directories below it, 2 files in each but "a"
+
+        substring_matcher matcher("match", true);
+        auto search = [&](filesystem_index const &idx, u32 scope) noexcept {
+            std::vector<std::string> found = {};
+            (void) idx.search(matcher, scope, nullptr, [&](u32 i, u64, u64) noexcept {
+                std::string path;
+                if (idx.path_of(i, path)) found.push_back(path);
+            });
+            std::sort(found.begin(), found.end());
+            return found;
+        };
+
+        ntest::assert_stdvec({ root + "\\a\\aa\\match.txt", root + "\\b\\match.txt", root + "\\c\\match.txt" }, search(index, filesystem_index::root_entry));
+        ntest::assert_stdvec({ root + "\\b\\match.txt" }, search(index, index.find(root + "\\b")));
+        ntest::assert_uint64(filesystem_index::root_entry, index.find(root));
+        ntest::assert_uint64(filesystem_index::not_found, index.find(root + "\\d"));
+        ntest::assert_uint64(filesystem_index::not_found, index.find(root + "_other\\b"));
+
+        // round trip, the loaded index is searched in place
+        auto file_path = output_path / "filesystem_index.bin";
+        ntest::assert_bool(true, index.save(file_path));
+        filesystem_index loaded = {};
+        ntest::assert_bool(true, loaded.load(file_path));
+        ntest::assert_stdstr(root, loaded.root);
+        ntest::assert_uint64(index.size(), loaded.size());
+        ntest::assert_stdvec(search(index, filesystem_index::root_entry), search(loaded, filesystem_index::root_entry));
+
+        // an added file, one inside a directory added along with it, a removed directory, a file which grew
+        std::ofstream(dir / "b" / "match_2.txt");
+        std::filesystem::create_directories(dir / "d" / "da");
+        std::ofstream(dir / "d" / "da" / "match.txt");
+        std::filesystem::remove_all(dir / "a");
+        std::ofstream(dir / "c" / "match.txt") << "grown";
+
+        loaded.apply_change("b\\match_2.txt");
+        loaded.apply_change("d\\da\\match.txt");
+        loaded.apply_change("a");
+        loaded.apply_change("c\\match.txt");
+        ntest::assert_uint64(4, loaded.num_changes_applied);
+        ntest::assert_stdvec({ root + "\\b\\match.txt", root + "\\b\\match_2.txt", root + "\\c\\match.txt", root + "\\d\\da\\match.txt" },
+                             search(loaded, filesystem_index::root_entry));
+        ntest::assert_uint64(5, loaded.at(loaded.find(root + "\\c\\match.txt")).size);
+        ntest::assert_uint64(filesystem_index::not_found, loaded.find(root + "\\a\\aa"));
+
+        // removed entries are dropped by saving, what's left loads again
+        ntest::assert_bool(true, loaded.save(file_path));
+        filesystem_index reloaded = {};
+        ntest::assert_bool(true, reloaded.load(file_path));
+        ntest::assert_uint64(1 + 4 + 6, reloaded.size()); // "a", "a\aa" and its 2 files are gone, "d", "d\da" and 2 files are new
+        ntest::assert_stdvec(search(loaded, filesystem_index::root_entry), search(reloaded, filesystem_index::root_entry));
+
+        // anything but a complete file is refused
+        std::filesystem::resize_file(file_path, std::filesystem::file_size(file_path) - 1);
+        ntest::assert_bool(false, reloaded.load(file_path));
+        ntest::assert_uint64(0, reloaded.size());
+    }
+    #endif
+
+    // trigram_index
+    #if 1
+    {
+        std::vector<std::string> names = { "main.cpp", "Main.hpp", "readme.md", "ab", "domain.txt", "mainframe", "README.txt", "été.txt" };
+
+        trigram_index index = {};
+        for (u32 i = 0; i < names.size(); ++i) {
+            index.add(i, names[i]);
+        }
+        ntest::assert_uint64(names.size(), index.end_id);
+
+        auto candidates = [&](trigram_query const &query) noexcept {
+            std::vector<u32> out = {};
+            if (!index.candidates(query, out)) out = { UINT32_MAX }; // anything
+            return out;
+        };
+
+        // ASCII case is folded, verification is left to the caller
+        ntest::assert_stdvec({ 0, 1, 4, 5 }, candidates(trigram_query::for_substring("main", true)));
+        ntest::assert_stdvec({ 2, 6 }, candidates(trigram_query::for_substring("README", true)));
+        ntest::assert_stdvec({}, candidates(trigram_query::for_substring("xyz", true)));
+        ntest::assert_stdvec({ 7 }, candidates(trigram_query::for_substring("été", true)));
+        ntest::assert_stdvec({ UINT32_MAX }, candidates(trigram_query::for_substring("ab", true)));
+        ntest::assert_stdvec({ UINT32_MAX }, candidates(trigram_query::for_substring("été", false)));
+
+        // what patterns require
+        ntest::assert_stdvec({ 0, 1, 4, 5 }, candidates(trigram_query::for_regex("main.*", true)));
+        ntest::assert_stdvec({ 0, 1 }, candidates(trigram_query::for_regex("main\\.(cpp|hpp)", true)));
+        ntest::assert_stdvec({ 0, 1, 2, 4, 5, 6 }, candidates(trigram_query::for_regex(".*(main|readme).*", true)));
+        ntest::assert_stdvec({ 0, 1, 4 }, candidates(trigram_query::for_regex("(ma)+in\\.[ch]pp", true))); // a superset, "pp" is too short
+        ntest::assert_stdvec({ 0, 1, 4, 5 }, candidates(trigram_query::for_regex("m?ain.*", true)));
+        ntest::assert_stdvec({ UINT32_MAX }, candidates(trigram_query::for_regex(".*\\.txt|ab", true)));
+        ntest::assert_stdvec({ UINT32_MAX }, candidates(trigram_query::for_regex("(main", true)));
+
+        // appending keeps lists ascending, candidates include names added later
+        index.add(u32(names.size()), "main_2.cpp");
+        ntest::assert_stdvec({ 0, 1, 4, 5, 8 }, candidates(trigram_query::for_substring("main", true)));
+
+        // delta varints: consecutive ids take a byte each
+        trigram_index dense = {};
+        for (u32 i = 0; i < 1000; ++i) {
+            dense.add(i, "abc");
+        }
+        ntest::assert_uint64(1000, dense.num_postings);
+        ntest::assert_uint64(1000, dense.lists.at(trigram_index::trigram('a', 'b', 'c')).bytes.size());
+    }
+    #endif
+
+    // finder_window::search_results
+    #if 1
+    {
+        ntest::assert_uint64(40, sizeof(finder_window::match));
+
+        auto finder = std::make_unique<finder_window>();
+        auto &results = finder->search_task.result;
+        finder_window::match_snapshot snapshot = {};
+
+        snapshot.update(results);
+        ntest::assert_uint64(0, snapshot.num_rows);
+
+        // more chunks than fit one segment, from several threads at once, while the snapshot keeps catching up
+        u64 const num_publishers = 4, chunks_per_publisher = 300;
+        {
+            swan_thread_pool_t pool(num_publishers);
+            for (u64 p = 0; p < num_publishers; ++p) {
+                pool.push_task([&results, p]() noexcept {
+                    u32 parent = results.intern_directory(make_str("C:\\publisher_%zu", p));
+                    for (u64 c = 0; c < chunks_per_publisher; ++c) {
+                        finder_window::match_chunk chunk = {};
+                        for (u64 i = 0; i < 1 + (c % 3); ++i) {
+                            finder_window::match m = {};
+                            m.size = p;
+                            m.parent = parent;
+                            m.name_offset = u32(chunk.names.size());
+                            m.name_len = 5;
+                            chunk.matches.push_back(m);
+                            for (char ch : std::string_view("a.txt\0", 6)) chunk.names.push_back(ch);
+                        }
+                        (void) results.publish(std::move(chunk));
+                    }
+                });
+            }
+            while (pool.get_tasks_total() > 0) {
+                snapshot.update(results);
+            }
+        }
+        snapshot.update(results);
+
+        u64 expected_rows = num_publishers * (chunks_per_publisher / 3) * (1 + 2 + 3);
+        ntest::assert_uint64(num_publishers * chunks_per_publisher, snapshot.chunks.size());
+        ntest::assert_uint64(expected_rows, snapshot.num_rows);
+        ntest::assert_uint64(expected_rows, results.num_matches.load());
+
+        std::vector<bool> seen_ids(expected_rows, false);
+        std::array<u64, num_publishers> rows_per_publisher = {};
+        bool paths_agree = true;
+        for (u64 row_idx = 0; row_idx < snapshot.num_rows; ++row_idx) {
+            auto row = snapshot.row(row_idx);
+            if (row.m->id < expected_rows) seen_ids[row.m->id] = true;
+            ++rows_per_publisher[row.m->size];
+
+            swan_path full_path;
+            paths_agree &= finder->match_path(row, full_path) && make_str("C:\\publisher_%zu\\a.txt", row.m->size) == full_path.data();
+        }
+        ntest::assert_bool(true, std::all_of(seen_ids.begin(), seen_ids.end(), [](bool seen) { return seen; }));
+        for (u64 rows : rows_per_publisher) {
+            ntest::assert_uint64(expected_rows / num_publishers, rows);
+        }
+        ntest::assert_bool(true, paths_agree);
+
+        ntest::assert_bool(true, results.publish({})); // empty chunks are ignored
+        ntest::assert_uint64(num_publishers * chunks_per_publisher, results.chunks.num_reserved.load());
+
+        snapshot.clear();
+        results.clear();
+        snapshot.update(results);
+        ntest::assert_uint64(0, snapshot.num_rows);
+        ntest::assert_bool(true, results.directories.get(0) == nullptr);
+    }
+    #endif
+
+    // packed_bits
+    #if 1
+    {
+        packed_bits bits = {};
+        for (u64 i = 0; i < 130; ++i) {
+            bits.push_back(i % 3 == 0);
+        }
+        ntest::assert_uint64(130, bits.size());
+        ntest::assert_uint64(44, bits.count_set());
+        ntest::assert_bool(true, bits.get(129));
+        ntest::assert_bool(false, bits.get(128));
+
+        bits.set(128, true);
+        ntest::assert_uint64(45, bits.count_set());
+
+        bits.assign(70, true);
+        ntest::assert_uint64(70, bits.count_set());
+        ntest::assert_bool(true, bits.get(69));
+    }
+    #endif
+
+    // name_hash_set
+    #if 1
+    {
+        name_hash_set set = {};
+        ntest::assert_bool(false, set.contains("a"));
+        ntest::assert_bool(false, set.erase("a"));
+
+        for (u64 i = 0; i < 1000; ++i) {
+            ntest::assert_bool(true, set.insert(std::to_string(i)));
+        }
+        ntest::assert_bool(false, set.insert("500"));
+        ntest::assert_uint64(1000, set.size());
+        ntest::assert_bool(true, set.contains("999"));
+        ntest::assert_bool(false, set.contains("1000"));
+        ntest::assert_bool(false, set.contains("99 "));
+
+        ntest::assert_bool(true, set.erase("500"));
+        ntest::assert_bool(false, set.contains("500"));
+        ntest::assert_bool(true, set.contains("501"));
+        ntest::assert_bool(true, set.insert("500"));
+        ntest::assert_uint64(1000, set.size());
+
+        set.clear();
+        ntest::assert_bool(true, set.empty());
+        ntest::assert_bool(false, set.contains("1"));
+        ntest::assert_bool(true, set.insert(""));
+        ntest::assert_bool(true, set.contains(""));
+    }
+    #endif
+
+    // link_resolution_cache, link_classifier
+    #if 1
+    {
+        link_resolution_cache cache = {};
+        link_target_kind kind = link_target_kind::unresolved;
+
+        ntest::assert_bool(false, cache.find("C:\\a.lnk", 1, kind));
+        cache.store("C:\\a.lnk", 1, link_target_kind::directory);
+        ntest::assert_bool(true, cache.find("C:\\a.lnk", 1, kind));
+        ntest::assert_bool(true, kind == link_target_kind::directory);
+        ntest::assert_bool(false, cache.find("C:\\a.lnk", 2, kind)); // rewritten since
+        cache.store("C:\\b.lnk", 1, link_target_kind::unresolved);   // not remembered, worth another try
+        ntest::assert_uint64(1, cache.size());
+        ntest::assert_uint64(1, cache.num_hits.load());
+        ntest::assert_uint64(2, cache.num_misses.load());
+
+        auto classifier = make_link_classifier();
+        ntest::assert_bool(true, classifier->is_link("x.lnk", directory_entry_kind::file));
+        ntest::assert_bool(false, classifier->is_link("x.lnk", directory_entry_kind::directory));
+        ntest::assert_bool(false, classifier->is_link("x.txt", directory_entry_kind::file));
+    }
+    #endif
+
+    // directory_listing_cache
+    #if 1
+    {
+        auto make_listing = [](u64 num_entries) {
+            explorer_window::cwd_listing::batch listing = {};
+            for (u64 i = 0; i < num_entries; ++i) {
+                directory_entry entry = {};
+                entry.name_offset = (u32)listing.entries.names.size();
+                entry.name_len = 1;
+                listing.entries.names.push_back('a');
+                listing.entries.names.push_back('\0');
+                listing.entries.entries.push_back(entry);
+                listing.kinds.push_back(basic_dirent::kind::file);
+            }
+            return listing;
+        };
+
+        ntest::assert_stdstr("c:\\users\\bob", directory_listing_cache::normalize_key("C:/Users/Bob\\ "));
+        ntest::assert_stdstr("c:", directory_listing_cache::normalize_key("C:\\"));
+
+        directory_listing_cache cache = {};
+        cache.max_entries = 2;
+
+        ntest::assert_bool(true, cache.find("C:\\a") == nullptr);
+        cache.store("C:\\a", 1, make_listing(1));
+        cache.store("C:\\b", 2, make_listing(2));
+
+        auto const *hit = cache.find("c:/A/");
+        ntest::assert_bool(true, hit != nullptr);
+        ntest::assert_uint64(1, hit->dir_last_write_time);
+        ntest::assert_uint64(1, hit->listing.entries.entries.size());
+        ntest::assert_uint64(1, cache.num_hits);
+        ntest::assert_uint64(1, cache.num_misses);
+
+        cache.store("C:\\c", 3, make_listing(3)); // evicts b, a was used more recently
+        ntest::assert_uint64(2, cache.entries.size());
+        ntest::assert_uint64(1, cache.num_evictions);
+        ntest::assert_bool(true, cache.find("C:\\b") == nullptr);
+        ntest::assert_bool(true, cache.find("C:\\a") != nullptr);
+
+        cache.store("C:\\a", 4, make_listing(4)); // replaces, doesn't evict
+        ntest::assert_uint64(2, cache.entries.size());
+        ntest::assert_uint64(4, cache.find("C:\\A")->dir_last_write_time);
+
+        u64 bytes_before = cache.bytes_used;
+        cache.memory_budget = bytes_before; // full, the next store has to evict
+        cache.store("C:\\d", 5, make_listing(1));
+        ntest::assert_bool(true, cache.bytes_used <= cache.memory_budget);
+        ntest::assert_bool(true, cache.find("C:\\d") != nullptr);
+
+        cache.store("C:\\huge", 6, make_listing(100'000)); // bigger than the whole budget
+        ntest::assert_bool(true, cache.find("C:\\huge") == nullptr);
+
+        ntest::assert_bool(true, cache.erase("C:\\d"));
+        ntest::assert_bool(false, cache.erase("C:\\d"));
+        cache.clear();
+        ntest::assert_uint64(0, cache.bytes_used);
+        ntest::assert_bool(true, cache.entries.empty());
+    }
+    #endif
+
+    // explorer_window::cache_cwd_entries_before_leaving
+    #if 1
+    {
+        auto dir = output_path / "cache_cwd_entries_before_leaving";
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        std::ofstream(dir / "old.txt");
+        std::string dir_utf8 = dir.string();
+
+        directory_entry dir_info = {};
+        ntest::assert_bool(true, query_path(dir_utf8.c_str(), dir_info));
+        u64 listed_write_time = dir_info.last_write_time;
+
+        auto expl = std::make_unique<explorer_window>();
+        expl->cwd_entries_path = path_create(dir_utf8.c_str());
+        expl->cwd_entries.push_back("old.txt", basic_dirent::kind::file, 0, 0, 0, 0);
+        expl->cwd_entries_dir_write_time = listed_write_time;
+
+        // a change which couldn't be applied, the rows lack it until the requested refresh
+        std::ofstream(dir / "new.txt");
+        expl->read_dir_changes_refresh_request_time = get_time_precise();
+        expl->cache_cwd_entries_before_leaving();
+        ntest::assert_bool(true, global_state::listing_cache().find(dir_utf8) == nullptr);
+        ntest::assert_bool(false, expl->cwd_entries_cached);
+
+        // a listing in progress may still add rows
+        expl->read_dir_changes_refresh_request_time = time_point_precise_t();
+        expl->cwd_listing_pending = true;
+        expl->cache_cwd_entries_before_leaving();
+        ntest::assert_bool(true, global_state::listing_cache().find(dir_utf8) == nullptr);
+
+        // stamped with the write time the rows are current for, so coming back lists "new.txt"
+        expl->cwd_listing_pending = false;
+        expl->cache_cwd_entries_before_leaving();
+        auto const *hit = global_state::listing_cache().find(dir_utf8);
+        ntest::assert_bool(true, hit != nullptr);
+        if (hit != nullptr) {
+            ntest::assert_uint64(listed_write_time, hit->dir_last_write_time);
+            ntest::assert_uint64(1, hit->listing.entries.entries.size());
+        }
+        ntest::assert_bool(true, expl->cwd_entries_cached);
+
+        (void) global_state::listing_cache().erase(dir_utf8);
+        std::filesystem::remove_all(dir);
+    }
+    #endif
+
+    // row_sort_keys, sort_rows
+    #if 1
+    {
+        //                        0      1      2      3      4
+        char const *names[] = { "b",   "A",   "a",   "C",   "b" };
+        u64 sizes[]         = { 10,    30,    20,    30,    10 };
+        u32 ids[]           = { 4,     3,     2,     1,     0 };
+
+        row_sort_keys keys = {};
+        keys.tiebreak = ids;
+
+        auto &by_name = keys.add_column(row_sort_column::key_kind::collation, lengthof(names));
+        for (u32 row = 0; row < lengthof(names); ++row) {
+            by_name.set_collation_key(row, names[row]);
+        }
+        std::vector<u32> rows = { 0, 1, 2, 3, 4 };
+        sort_rows(keys, rows.data(), rows.size());
+        ntest::assert_stdvec({ 2, 1, 4, 0, 3 }, rows); // "A" and "a" tie, broken by id
+
+        keys.clear();
+        keys.tiebreak = ids;
+        auto &by_size = keys.add_column(row_sort_column::key_kind::numeric, lengthof(sizes));
+        for (u32 row = 0; row < lengthof(sizes); ++row) {
+            by_size.numeric_keys[row] = sizes[row] ^ u64(-1); // biggest first
+        }
+        sort_rows(keys, rows.data(), rows.size());
+        ntest::assert_stdvec({ 3, 1, 2, 4, 0 }, rows);
+
+        auto &then_name_descending = keys.add_column(row_sort_column::key_kind::collation, lengthof(names), true);
+        for (u32 row = 0; row < lengthof(names); ++row) {
+            then_name_descending.set_collation_key(row, names[row]);
+        }
+        sort_rows(keys, rows.data(), rows.size());
+        ntest::assert_stdvec({ 3, 1, 2, 4, 0 }, rows);
+
+        // radix path, compared against the generic comparator
+        std::vector<u64> big_keys(5000);
+        std::vector<u32> big_ids(big_keys.size());
+        for (u64 i = 0; i < big_keys.size(); ++i) {
+            big_keys[i] = fast_rand(0, 100) << 40;
+            big_ids[i] = u32(big_keys.size() - i);
+        }
+        keys.clear();
+        keys.tiebreak = big_ids.data();
+        keys.add_column(row_sort_column::key_kind::numeric, big_keys.size()).numeric_keys = big_keys;
+
+        std::vector<u32> radix_rows(big_keys.size());
+        std::iota(radix_rows.begin(), radix_rows.end(), 0);
+        std::vector<u32> expected_rows = radix_rows;
+        sort_rows(keys, radix_rows.data(), radix_rows.size());
+        std::sort(expected_rows.begin(), expected_rows.end(), [&](u32 left, u32 right) noexcept { return keys.less(left, right); });
+        ntest::assert_stdvec(expected_rows, radix_rows);
+
+        // parallel path, must give exactly the serial order
+        {
+            swan_thread_pool_t pool(4);
+            row_sort_executor executor = {};
+            executor.push_task = [&pool](std::function<void ()> task) noexcept { pool.push_task(std::move(task)); };
+            executor.num_threads = 5; // more than the pool has, the calling thread picks up the slack
+
+            u64 num_big = row_sort_executor::parallel_threshold * 2 + 7;
+            std::vector<std::string> big_names(num_big);
+            std::vector<u32> parallel_ids(num_big);
+            for (u64 i = 0; i < num_big; ++i) {
+                big_names[i] = std::to_string(fast_rand(0, 999)) + (chance(2) ? "a" : "A");
+                parallel_ids[i] = u32(num_big - i);
+            }
+            std::vector<u32> serial_rows(num_big);
+            std::iota(serial_rows.begin(), serial_rows.end(), 0);
+            std::vector<u32> parallel_rows = serial_rows;
+            auto name_of = [&](u32 row) noexcept { return std::string_view(big_names[row]); };
+
+            row_sort_keys serial_keys = {};
+            serial_keys.tiebreak = parallel_ids.data();
+            serial_keys.add_column(row_sort_column::key_kind::collation, num_big, true).set_collation_keys(serial_rows.data(), num_big, name_of);
+            sort_rows(serial_keys, serial_rows.data(), num_big);
+
+            row_sort_keys parallel_keys = {};
+            parallel_keys.tiebreak = parallel_ids.data();
+            parallel_keys.add_column(row_sort_column::key_kind::collation, num_big, true).set_collation_keys(parallel_rows.data(), num_big, name_of, executor);
+            sort_rows(parallel_keys, parallel_rows.data(), num_big, executor);
+
+            ntest::assert_stdvec(serial_rows, parallel_rows);
+            pool.wait_for_tasks();
+        }
+
+        ntest::assert_bool(true, collate_names("abc", "ABD") < 0);
+        ntest::assert_bool(true, collate_names("ABC", "abc") == 0);
+        ntest::assert_bool(true, collate_names("ab", "abc") < 0);
+    }
+    #endif
+
+    // substring_matcher
+    #if 1
+    {
+        u64 len = 0;
+
+        substring_matcher ignore_case("PNG", false);
+        ntest::assert_uint64(10, ignore_case.find("image_1234.png", &len));
+        ntest::assert_uint64(3, len);
+        ntest::assert_uint64(substring_matcher::not_found, ignore_case.find("image_1234.pn"));
+        ntest::assert_uint64(substring_matcher::not_found, ignore_case.find(""));
+
+        substring_matcher match_case("PNG", true);
+        ntest::assert_uint64(substring_matcher::not_found, match_case.find("image_1234.png"));
+        ntest::assert_uint64(10, match_case.find("image_1234.PNG"));
+
+        // '@' | 0x20 == '`', only letters may be folded
+        ntest::assert_uint64(substring_matcher::not_found, substring_matcher("`b", false).find("@B"));
+        ntest::assert_uint64(1, substring_matcher("[", false).find("{["));
+
+        // candidates in every SIMD lane and the scalar tail, compared against StrStrIA
+        std::string haystack = {};
+        for (u64 i = 0; i < 100; ++i) {
+            haystack.push_back("aAbB_z"[fast_rand(0, 5)]);
+        }
+        char const *needles[] = { "a", "ab", "Bz_", "zzzz", "aBaB", "_" };
+        for (char const *needle : needles) {
+            for (u64 offset = 0; offset < haystack.size(); ++offset) {
+                char const *expected = StrStrIA(haystack.c_str() + offset, needle);
+                u64 actual = substring_matcher(needle, false).find(std::string_view(haystack).substr(offset));
+                ntest::assert_uint64(expected ? u64(expected - haystack.c_str()) - offset : substring_matcher::not_found, actual);
+            }
+        }
+
+        // non-ASCII needles fold by character, match length is in haystack bytes
+        substring_matcher unicode("ÄÖ", false);
+        ntest::assert_uint64(2, unicode.find("x_äö.txt", &len));
+        ntest::assert_uint64(4, len);
+        ntest::assert_uint64(substring_matcher::not_found, unicode.find("x_ao.txt"));
+
+        substring_matcher cyrillic("файл", false);
+        ntest::assert_uint64(0, cyrillic.find("ФАЙЛ.txt"));
+
+        ntest::assert_uint64(0, substring_matcher("", false).find("abc"));
+    }
+    #endif
+
+    // name_pattern
+    #if 1
+    {
+        name_pattern pattern = {};
+        auto const glob = name_pattern::syntax::glob;
+        auto const regex = name_pattern::syntax::regex;
+
+        ntest::assert_bool(true, pattern.compile("*.txt", glob, false));
+        ntest::assert_bool(true, pattern.matches("notes.TXT"));
+        ntest::assert_bool(true, pattern.matches(".txt"));
+        ntest::assert_bool(false, pattern.matches("notes.txt.bak"));
+
+        ntest::assert_bool(true, pattern.compile("?[a-c][!0-9]*", glob, true));
+        ntest::assert_bool(true, pattern.matches("éax"));
+        ntest::assert_bool(false, pattern.matches("xa1"));
+        ntest::assert_bool(false, pattern.matches("xAx"));
+
+        ntest::assert_bool(true, pattern.compile("(image|report)_\\d{2,}\\.(png|txt)", regex, false));
+        ntest::assert_bool(true, pattern.matches("Report_123.PNG"));
+        ntest::assert_bool(false, pattern.matches("report_1.png"));
+        ntest::assert_bool(false, pattern.matches("report_123.png.bak"));
+
+        ntest::assert_bool(true, pattern.compile("^[^.]+$", regex, true));
+        ntest::assert_bool(true, pattern.matches("Makefile"));
+        ntest::assert_bool(false, pattern.matches("main.cpp"));
+
+        //? Exponential for backtracking engines, linear here.
+        ntest::assert_bool(true, pattern.compile("(a+)+b", regex, true));
+        ntest::assert_bool(false, pattern.matches(std::string(10'000, 'a')));
+
+        ntest::assert_bool(false, pattern.compile("(a", regex, true));
+        ntest::assert_bool(false, pattern.error.empty());
+        ntest::assert_bool(false, pattern.matches("a"));
+        ntest::assert_bool(false, pattern.compile("(\\w)\\1", regex, true));
+        ntest::assert_bool(false, pattern.compile("(a|b)*a(a|b){20}", regex, true)); // more DFA states than allowed
+    }
+    #endif
+
+    // date_time_format
+    #if 1
+    {
+        u64 ticks_per_second = 10'000'000;
+        u64 leap_day = (1'709'211'909 + 11'644'473'600) * ticks_per_second; // 2024-02-29 13:05:09 UTC, a Thursday
+        std::array<char, 64> buffer;
+
+        date_time_format format = {};
+        format.format(leap_day, buffer.data(), buffer.size());
+        ntest::assert_cstr("2024-02-29 13:05", buffer.data()); // not compiled yet, ISO 8601 like
+
+        format.compile("M/d/yy", "h:mm tt", date_time_format::english_names(), 60);
+        format.format(leap_day, buffer.data(), buffer.size());
+        ntest::assert_cstr("2/29/24 2:05 PM", buffer.data());
+
+        format.compile("dddd, d MMMM yyyy", "H:mm:ss 'Uhr'", date_time_format::english_names(), -14 * 60);
+        format.format(leap_day, buffer.data(), buffer.size());
+        ntest::assert_cstr("Wednesday, 28 February 2024 23:05:09 Uhr", buffer.data());
+
+        format.compile("ddd dd.MM.yyyy", "HH:mm", date_time_format::english_names(), 0);
+        format.format(0, buffer.data(), buffer.size());
+        ntest::assert_cstr("Mon 01.01.1601 00:00", buffer.data());
+
+        ntest::assert_uint64(7, format.format(leap_day, buffer.data(), 8));
+        ntest::assert_cstr("Thu 29.", buffer.data());
+    }
+    #endif
+
+    // format_file_size
+    #if 1
+    {
+        ntest::assert_cstr("0 B", format_file_size(0, 1024).data());
+        ntest::assert_cstr("1023 B", format_file_size(1023, 1024).data());
+        ntest::assert_cstr("1.00 KB", format_file_size(1024, 1024).data());
+        ntest::assert_cstr("1.50 KB", format_file_size(1536, 1024).data());
+        ntest::assert_cstr("10.00 KB", format_file_size(10239, 1024).data()); // rounds up into the next whole number
+        ntest::assert_cstr("1.50 MB", format_file_size(1'500'000, 1000).data());
+        ntest::assert_cstr("1024.00 TB", format_file_size(u64(1) << 50, 1024).data());
+    }
+    #endif
+
+    // icon_cache keys
+    #if 1
+    {
+        ntest::assert_bool(true, icon_cache::has_unique_icon("setup.EXE"));
+        ntest::assert_bool(true, icon_cache::has_unique_icon("Shortcut.lnk"));
+        ntest::assert_bool(false, icon_cache::has_unique_icon("notes.txt"));
+        ntest::assert_bool(false, icon_cache::has_unique_icon("exe"));
+        ntest::assert_bool(false, icon_cache::has_unique_icon("archive.exe.bak"));
+
+        ntest::assert_stdstr("ext:.cpp", icon_cache::key_for("C:\\src\\Main.CPP", false));
+        ntest::assert_stdstr("ext:.cpp", icon_cache::key_for("D:/other/util.cpp", false));
+        ntest::assert_stdstr("ext:", icon_cache::key_for("C:\\src\\Makefile", false));
+        ntest::assert_stdstr("ext:", icon_cache::key_for("C:\\v1.2\\LICENSE", false)); // dot in the directory, not the name
+        ntest::assert_stdstr("path:c:\\apps\\tool.exe", icon_cache::key_for("C:\\Apps\\Tool.exe", false));
+        ntest::assert_stdstr("path:c:\\src.d", icon_cache::key_for("C:\\src.d", true));
+    }
+    #endif
+
+    // icon_store
+    #if 1
+    {
+        u8 const red[4 * 2 * 1] = { 0,0,255,255, 0,0,255,255 };
+        u8 const blue[4 * 1 * 1] = { 255,0,0,255 };
+
+        std::vector<u8> buffer = {};
+        icon_store::append_header(buffer, 2);
+        icon_store::append_record(buffer, "ext:.cpp", 0, 2, 1, red);
+        icon_store::append_record(buffer, "path:c:\\apps\\tool.exe", 1234, 1, 1, blue);
+
+        icon_store store = {};
+        ntest::assert_bool(true, store.index(buffer.data(), buffer.size()));
+        ntest::assert_uint64(2, store.records.size());
+
+        icon_pixels pixels = {};
+        ntest::assert_bool(true, store.find("ext:.cpp", 0, pixels));
+        ntest::assert_uint64(2, pixels.width);
+        ntest::assert_uint64(1, pixels.height);
+        ntest::assert_bool(true, pixels.bgra == std::vector<u8>(red, red + sizeof(red)));
+
+        ntest::assert_bool(false, store.find("path:c:\\apps\\tool.exe", 5678, pixels)); // modified since
+        ntest::assert_uint64(1, store.num_stale);
+        ntest::assert_bool(true, store.find("path:c:\\apps\\tool.exe", 1234, pixels));
+        ntest::assert_bool(true, pixels.bgra == std::vector<u8>(blue, blue + sizeof(blue)));
+        ntest::assert_uint64(2, store.num_hits);
+        ntest::assert_bool(false, store.find("ext:.txt", 0, pixels));
+
+        ntest::assert_bool(false, store.index(buffer.data(), buffer.size() - 1)); // truncated
+        ntest::assert_uint64(0, store.records.size());
+        ntest::assert_bool(false, store.find("ext:.cpp", 0, pixels));
+
+        buffer[0] ^= 0xFF;
+        ntest::assert_bool(false, store.index(buffer.data(), buffer.size())); // not ours
+    }
+    #endif
+
+    // fuzzy_matcher
+    #if 1
+    {
+        fuzzy_matcher fuzzy = {};
+        highlight_spans spans = {};
+
+        ntest::assert_bool(true, fuzzy.compile("expcpp", false));
+        ntest::assert_bool(true, fuzzy.score("Explorer.cpp", &spans) != fuzzy_matcher::no_match);
+        ntest::assert_uint64(2, spans.count);
+        ntest::assert_uint64(0, spans.spans[0].start); ntest::assert_uint64(3, spans.spans[0].len);
+        ntest::assert_uint64(9, spans.spans[1].start); ntest::assert_uint64(3, spans.spans[1].len);
+        ntest::assert_bool(false, fuzzy.matches("explorer.hpp"));
+        ntest::assert_bool(false, fuzzy.matches("cpp"));
+
+        // consecutive characters and word starts rank higher
+        ntest::assert_bool(true, fuzzy.compile("fb", false));
+        ntest::assert_bool(true, fuzzy.score("foo_bar") > fuzzy.score("fxxxxb"));
+        ntest::assert_bool(true, fuzzy.score("fooBar") > fuzzy.score("foobar"));
+        ntest::assert_bool(true, fuzzy.compile("ab", false));
+        ntest::assert_bool(true, fuzzy.score("ab") > fuzzy.score("a_b"));
+        ntest::assert_bool(true, fuzzy.score("a_xab", &spans) != fuzzy_matcher::no_match);
+        ntest::assert_uint64(3, spans.spans[0].start); // the tight window, not the first 'a'
+
+        // more runs than spans fit, the last span covers the rest
+        ntest::assert_bool(true, fuzzy.compile("abcdefgh", false));
+        ntest::assert_bool(true, fuzzy.score("a1b2c3d4e5f6g7h", &spans) != fuzzy_matcher::no_match);
+        ntest::assert_uint64(highlight_spans::max_spans, spans.count);
+        ntest::assert_uint64(14, u64(spans.spans[spans.count - 1].start) + spans.spans[spans.count - 1].len - 1);
+
+        ntest::assert_bool(true, fuzzy.compile("AB", true));
+        ntest::assert_bool(false, fuzzy.matches("ab"));
+        ntest::assert_bool(true, fuzzy.matches("xAyB"));
+
+        ntest::assert_bool(true, fuzzy.compile("", false));
+        ntest::assert_bool(true, fuzzy.score("anything") == 0);
+        ntest::assert_bool(false, fuzzy.compile(std::string(fuzzy_matcher::max_pattern_len + 1, 'a'), false));
+    }
+    #endif
+
+    // explorer_window::dirent_table
+    #if 1
+    {
+        explorer_window::dirent_table table = {};
+        table.push_back("b.txt", basic_dirent::kind::file, 3, 0, 0, 0);
+        table.push_back("..", basic_dirent::kind::directory, 0, 0, 0, 1);
+        table.push_back("a", basic_dirent::kind::directory, 0, 0, 0, 2);
+        table.selected.set(0, true);
+        table.cut.set(2, true);
+
+        ntest::assert_uint64(3, table.count());
+        ntest::assert_cstr("b.txt", table.name(0));
+        ntest::assert_bool(true, table.is_path_dotdot(1));
+        ntest::assert_bool(true, table[1].is_dotdot_dir());
+
+        table.swap_rows(1, 0);
+        ntest::assert_cstr("..", table.name(0));
+        ntest::assert_cstr("b.txt", table.name(1));
+        ntest::assert_bool(true, table.selected.get(1));
+        ntest::assert_bool(false, table.selected.get(0));
+
+        table.apply_permutation({ 2, 0, 1 });
+        ntest::assert_cstr("a", table.name(0));
+        ntest::assert_cstr("..", table.name(1));
+        ntest::assert_cstr("b.txt", table.name(2));
+        ntest::assert_uint64(3, table[2].size());
+        ntest::assert_bool(true, table[2].selected());
+        ntest::assert_bool(true, table[0].cut());
+
+        table.permute_prefix({ 1, 0 });
+        ntest::assert_cstr("..", table.name(0));
+        ntest::assert_cstr("a", table.name(1));
+        ntest::assert_cstr("b.txt", table.name(2));
+        ntest::assert_bool(true, table[1].cut());
+        table.permute_prefix({ 1, 0 });
+
+        basic_dirent basic = table.make_basic_dirent(2);
+        ntest::assert_cstr("b.txt", basic.path.data());
+        ntest::assert_uint64(3, basic.size);
+
+        table.clear();
+        ntest::assert_bool(true, table.empty());
+        ntest::assert_uint64(0, table.selected.size());
+    }
+    #endif
+
+    // explorer_window::dirent_table::apply_changes
+    #if 1
+    {
+        // display order: visible rows sorted by name, then rows whose name starts with 'x' filtered out
+        explorer_window::dirent_table table = {};
+        table.push_back("a", basic_dirent::kind::file, 1, 0, 0, 0);
+        table.push_back("c", basic_dirent::kind::file, 1, 0, 0, 1);
+        table.push_back("e", basic_dirent::kind::file, 1, 0, 0, 2);
+        table.push_back("x1", basic_dirent::kind::file, 1, 0, 0, 3);
+        table.filtered.set(3, true);
+        table.selected.set(1, true);
+        table.selected.set(3, true);
+        table.ui[1].context_menu_active = true;
+
+        auto filter_new_rows = [&](u64 first_row) noexcept {
+            for (u64 row = first_row; row < table.count(); ++row) {
+                table.filtered.set(row, table.name(row)[0] == 'x');
+            }
+        };
+        auto row_less = [&](u32 left, u32 right) noexcept { return strcmp(table.name(left), table.name(right)) < 0; };
+
+        auto make_change = [](char const *name, bool exists, basic_dirent::kind kind = basic_dirent::kind::file, u64 size = 1) noexcept {
+            explorer_window::dirent_table::change change = {};
+            change.name = name;
+            change.exists = exists;
+            change.kind = kind;
+            change.size = size;
+            return change;
+        };
+
+        std::vector<explorer_window::dirent_table::change> changes = {
+            make_change("b", true),                                   // created
+            make_change("e", false),                                  // deleted
+            make_change("a", true, basic_dirent::kind::file, 10),     // modified
+            make_change("c", true, basic_dirent::kind::directory),    // replaced by a directory
+            make_change("x2", true),                                  // created, filtered
+            make_change("d", true),                                   // created by swan, selected
+            make_change("x1", false),                                 // renamed ...
+            make_change("f", true),                                   // ... to a name the filter lets through
+        };
+        changes[5].select = true;
+        changes[7].renamed_from = "x1";
+
+        u64 first_filtered_row = table.apply_changes(changes, filter_new_rows, row_less);
+
+        ntest::assert_uint64(5, first_filtered_row);
+        ntest::assert_uint64(6, table.count());
+        std::vector<std::string> names = {};
+        std::vector<u32> ids = {};
+        std::vector<u32> selected = {};
+        for (u64 row = 0; row < table.count(); ++row) {
+            names.emplace_back(table.name(row));
+            ids.push_back(table.ids[row]);
+            selected.push_back(table.selected.get(row));
+        }
+        std::vector<std::string> expected_names = { "a", "b", "c", "d", "f", "x2" };
+        ntest::assert_stdvec(expected_names, names);
+        ntest::assert_stdvec({ 0, 4, 1, 6, 3, 5 }, ids);
+        ntest::assert_stdvec({ 0, 0, 1, 1, 1, 0 }, selected);
+        ntest::assert_bool(false, table.filtered.get(4));
+        ntest::assert_bool(true, table.filtered.get(5));
+        ntest::assert_uint64(10, table.sizes[0]);
+        ntest::assert_bool(true, table.kinds[2] == basic_dirent::kind::directory);
+        ntest::assert_bool(true, table.ui[2].context_menu_active);
+
+        std::vector<u64> rows = {};
+        for (auto const &change : changes) rows.push_back(change.row);
+        ntest::assert_stdvec({ 1, u64(-1), 0, 2, 5, 3, u64(-1), 4 }, rows);
+
+        ntest::assert_uint64(3, table.up_to_date_counts().selected_dirents);
+        ntest::assert_uint64(2, table.up_to_date_counts().selected_files_size); // "d" and "f", "c" is a directory now
+    }
+    #endif
+
+    // explorer_window::narrow_cwd_entries_filter
+    #if 1
+    {
+        auto expl = std::make_unique<explorer_window>();
+        auto &table = expl->cwd_entries;
+        table.push_back("abc", basic_dirent::kind::file, 0, 0, 0, 0);
+        table.push_back("abd", basic_dirent::kind::file, 0, 0, 0, 1);
+        table.push_back("xab", basic_dirent::kind::directory, 0, 0, 0, 2);
+        table.push_back("zzz", basic_dirent::kind::file, 0, 0, 0, 3);
+
+        explorer_window::update_cwd_entries_timers timers = {};
+        auto set_filter_text = [&](char const *text) noexcept { strncpy(expl->filter_text.data(), text, expl->filter_text.size() - 1); };
+
+        set_filter_text("a");
+        expl->filter_cwd_entries(0, timers);
+        ntest::assert_bool(true, table.filtered.get(3));
+        expl->first_filtered_cwd_dirent_row = 3;
+
+        set_filter_text("ab");
+        ntest::assert_bool(true, expl->narrow_cwd_entries_filter(timers));
+        ntest::assert_uint64(3, expl->first_filtered_cwd_dirent_row);
+
+        set_filter_text("abd");
+        ntest::assert_bool(true, expl->narrow_cwd_entries_filter(timers));
+        ntest::assert_uint64(1, expl->first_filtered_cwd_dirent_row);
+        ntest::assert_cstr("abd", table.name(0));
+        ntest::assert_cstr("abc", table.name(1)); // dropped rows follow in their old order
+        ntest::assert_cstr("xab", table.name(2));
+        ntest::assert_cstr("zzz", table.name(3));
+        ntest::assert_bool(false, table.filtered.get(0));
+        ntest::assert_bool(true, table.filtered.get(1));
+        ntest::assert_uint64(1, table.ui[0].highlight.count);
+        ntest::assert_uint64(3, table.ui[0].highlight.spans[0].len);
+
+        set_filter_text("b"); // not a refinement of "abd"
+        ntest::assert_bool(false, expl->narrow_cwd_entries_filter(timers));
+
+        set_filter_text("abd");
+        expl->filter_polarity = false;
+        ntest::assert_bool(false, expl->narrow_cwd_entries_filter(timers));
+    }
+    #endif
+
+    // explorer_window::filter_cwd_entries on the thread pool
+    #if 1
+    {
+        auto serial = std::make_unique<explorer_window>();
+        auto parallel = std::make_unique<explorer_window>();
+
+        for (u32 i = 0; i < 10'000; ++i) {
+            auto name = make_str_static<32>("%s_%u.txt", (i % 3 == 0) ? "Report" : "notes", i);
+            auto kind = (i % 7 == 0) ? basic_dirent::kind::directory : basic_dirent::kind::file;
+            serial->cwd_entries.push_back(name.data(), kind, 0, 0, 0, i);
+            parallel->cwd_entries.push_back(name.data(), kind, 0, 0, 0, i);
+        }
+        for (auto *expl : { serial.get(), parallel.get() }) {
+            strcpy(expl->filter_text.data(), "rep");
+            expl->filter_show_directories = false;
+        }
+
+        auto &min_entries = global_state::settings().explorer_parallel_filter_min_entries;
+        s32 min_entries_before = min_entries;
+
+        explorer_window::update_cwd_entries_timers serial_timers = {}, parallel_timers = {};
+        min_entries = 0;
+        serial->filter_cwd_entries(100, serial_timers); // an unaligned first row, like merging a listing batch
+        min_entries = 64;
+        parallel->filter_cwd_entries(100, parallel_timers);
+        min_entries = min_entries_before;
+
+        ntest::assert_uint64(1, serial_timers.filter_threads);
+        ntest::assert_bool(true, serial->cwd_entries.filtered.words == parallel->cwd_entries.filtered.words);
+
+        bool highlights_agree = true;
+        for (u64 row = 0; row < serial->cwd_entries.count(); ++row) {
+            auto const &l = serial->cwd_entries.ui[row].highlight, &r = parallel->cwd_entries.ui[row].highlight;
+            highlights_agree &= l.count == r.count && (l.empty() || (l.spans[0].start == r.spans[0].start && l.spans[0].len == r.spans[0].len));
+        }
+        ntest::assert_bool(true, highlights_agree);
+    }
+    #endif
+
+    // explorer_window::dirent_table counts
+    #if 1
+    {
+        auto expl = std::make_unique<explorer_window>();
+        auto &table = expl->cwd_entries;
+        table.push_back("..", basic_dirent::kind::directory, 0, 0, 0, 0);
+        table.push_back("a.txt", basic_dirent::kind::file, 10, 0, 0, 1);
+        table.push_back("b.txt", basic_dirent::kind::file, 20, 0, 0, 2);
+        table.push_back("dir", basic_dirent::kind::directory, 0, 0, 0, 3);
+        table.push_back("link", basic_dirent::kind::symlink_ambiguous, 0, 0, 0, 4);
+
+        auto counts_agree = [&]() noexcept { return table.up_to_date_counts() == table.recount(); };
+
+        ntest::assert_uint64(5, table.up_to_date_counts().child_dirents);
+        ntest::assert_uint64(3, table.counts.child_files);
+
+        expl->select_all_visible_cwd_entries();
+        ntest::assert_bool(false, table.counts_stale); // kept current, no recount needed
+        ntest::assert_uint64(3, table.counts.selected_dirents);
+        ntest::assert_uint64(30, table.counts.selected_files_size);
+        ntest::assert_bool(true, counts_agree());
+
+        table[1].set_selected(false);
+        table[1].set_selected(false); // no change, must not count twice
+        ntest::assert_uint64(20, table.counts.selected_files_size);
+        ntest::assert_bool(true, counts_agree());
+
+        strcpy(expl->filter_text.data(), "b");
+        explorer_window::update_cwd_entries_timers timers = {};
+        expl->filter_cwd_entries(0, timers);
+        ntest::assert_bool(true, table.counts_stale);
+        ntest::assert_uint64(1, table.up_to_date_counts().selected_files); // "dir" is filtered, no longer counts as selected
+        ntest::assert_bool(true, counts_agree());
+
+        expl->invert_selection_on_visible_cwd_entries();
+        ntest::assert_bool(true, counts_agree());
+
+        expl->deselect_all_cwd_entries();
+        ntest::assert_uint64(0, table.counts.selected_dirents);
+        ntest::assert_bool(true, counts_agree());
+
+        table.apply_permutation({ 2, 1, 0, 3, 4 });
+        ntest::assert_bool(false, table.counts_stale);
+        table.apply_permutation({ 0, 1 });
+        ntest::assert_uint64(2, table.up_to_date_counts().child_dirents);
+    }
+    #endif
+
+    // summarize_directory_changes
+    #if 1
+    {
+        directory_change_batch batch = {};
+        batch.push_back(directory_change_kind::added, "a.txt");
+        batch.push_back(directory_change_kind::modified, "a.txt");
+        batch.push_back(directory_change_kind::added, "tmp");
+        batch.push_back(directory_change_kind::removed, "tmp");
+        batch.push_back(directory_change_kind::renamed_from, "b.txt");
+        batch.push_back(directory_change_kind::renamed_to, "c.txt");
+        batch.push_back(directory_change_kind::renamed_from, "c.txt");
+        batch.push_back(directory_change_kind::renamed_to, "d.txt");
+        batch.push_back(directory_change_kind::modified, "d.txt");
+        batch.push_back(directory_change_kind::renamed_from, "e.txt");
+        batch.push_back(directory_change_kind::renamed_to, "f.txt");
+        batch.push_back(directory_change_kind::removed, "f.txt");
+        batch.push_back(directory_change_kind::added, "f.txt");
+
+        std::vector<directory_change_net> net = {};
+        summarize_directory_changes(batch, net);
+
+        ntest::assert_uint64(7, net.size());
+        ntest::assert_bool(true, net[0].name == "a.txt" && net[0].exists && net[0].renamed_from.empty());
+        ntest::assert_bool(true, net[1].name == "tmp" && !net[1].exists);
+        ntest::assert_bool(true, net[2].name == "b.txt" && !net[2].exists);
+        ntest::assert_bool(true, net[3].name == "c.txt" && !net[3].exists && net[3].renamed_from.empty());
+        ntest::assert_bool(true, net[4].name == "d.txt" && net[4].exists && net[4].renamed_from == "b.txt"); // b -> c -> d
+        ntest::assert_bool(true, net[5].name == "e.txt" && !net[5].exists);
+        ntest::assert_bool(true, net[6].name == "f.txt" && net[6].exists && net[6].renamed_from.empty()); // a different entry by now
+        ntest::assert_bool(false, batch.overflowed);
+    }
+    #endif
+
+    // decode_file_notify_information
+    #if 1
+    {
+        alignas(DWORD) std::byte buffer[256] = {};
+        u64 offset = 0;
+
+        auto append_record = [&](DWORD action, wchar_t const *name, bool last) {
+            auto *record = reinterpret_cast<FILE_NOTIFY_INFORMATION *>(buffer + offset);
+            u64 name_bytes = wcslen(name) * sizeof(wchar_t);
+            u64 record_bytes = (offsetof(FILE_NOTIFY_INFORMATION, FileName) + name_bytes + 3) & ~u64(3);
+            record->Action = action;
+            record->FileNameLength = (DWORD)name_bytes;
+            memcpy(record->FileName, name, name_bytes);
+            record->NextEntryOffset = last ? 0 : (DWORD)record_bytes;
+            offset += record_bytes;
+        };
+        append_record(FILE_ACTION_ADDED, L"new.txt", false);
+        append_record(FILE_ACTION_RENAMED_OLD_NAME, L"old", false);
+        append_record(FILE_ACTION_RENAMED_NEW_NAME, L"\u00e9t\u00e9", true);
+
+        directory_change_batch batch = {};
+        decode_file_notify_information(buffer, offset, batch);
+
+        ntest::assert_uint64(3, batch.changes.size());
+        ntest::assert_bool(true, batch.changes[0].kind == directory_change_kind::added);
+        ntest::assert_cstr("new.txt", batch.name(batch.changes[0]));
+        ntest::assert_bool(true, batch.changes[1].kind == directory_change_kind::renamed_from);
+        ntest::assert_cstr("old", batch.name(batch.changes[1]));
+        ntest::assert_bool(true, batch.changes[2].kind == directory_change_kind::renamed_to);
+        ntest::assert_cstr("\xc3\xa9t\xc3\xa9", batch.name(batch.changes[2]));
+
+        batch.clear();
+        decode_file_notify_information(buffer, 0, batch);
+        ntest::assert_bool(true, batch.overflowed);
+    }
+    #endif
+
+    // query_directory_entry
+    #if 1
+    {
+        auto dir = output_path / "query_directory_entry";
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir / "sub");
+        std::ofstream(dir / "file.txt") << "12345";
+
+        std::string dir_utf8 = dir.string();
+        directory_entry entry = {};
+
+        ntest::assert_bool(true, query_directory_entry(dir_utf8.c_str(), "file.txt", entry));
+        ntest::assert_uint64(5, entry.size);
+        ntest::assert_bool(true, entry.kind == directory_entry_kind::file);
+
+        ntest::assert_bool(true, query_directory_entry(dir_utf8.c_str(), "sub", entry));
+        ntest::assert_bool(true, entry.kind == directory_entry_kind::directory);
+
+        ntest::assert_bool(false, query_directory_entry(dir_utf8.c_str(), "missing", entry));
+    }
+    #endif
+
+    // explorer_window::dirent_table (dropping rows)
+    #if 1
+    {
+        explorer_window::dirent_table table = {};
+        table.push_back("gone", basic_dirent::kind::file, 0, 0, 0, 0);
+        table.push_back("stays", basic_dirent::kind::file, 7, 0, 0, 1);
+        table.selected.set(1, true);
+
+        table.apply_permutation({ 1 });
+        ntest::assert_uint64(1, table.count());
+        ntest::assert_uint64(1, table.selected.size());
+        ntest::assert_bool(true, table[0].selected());
+
+        table.compact_names();
+        ntest::assert_cstr("stays", table.name(0));
+        ntest::assert_uint64(6, table.names.size());
+    }
+    #endif
+
     //
     #if 1
     {
@@ -0,0 +1,550 @@
+#include "trigram_index.hpp"
+
+#if !defined(_WIN32)
+#   include <algorithm>
+#   include <iterator>
+#endif
+
+namespace trigram_index_detail
+{
+    static
+    void append_varint(std::vector<u8> &out, u32 value) noexcept
+    {
+        while (value >= 0x80) {
+            out.push_back(u8(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(u8(value));
+    }
+
+    /// Walks a posting list one id at a time.
+    struct posting_cursor
+    {
+        u8 const *at;
+        u8 const *end;
+        u32 id = 0;
+        bool first = true;
+
+        bool next() noexcept
+        {
+            if (at == end) {
+                return false;
+            }
+            u32 delta = 0;
+            for (u32 shift = 0; at != end; shift += 7) {
+                u8 byte = *at++;
+                delta |= u32(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0) break;
+            }
+            id = first ? delta : id + delta;
+            first = false;
+            return true;
+        }
+    };
+
+    typedef std::vector<std::vector<u32>> clause_list;
+
+    static
+    char fold(char ch) noexcept
+    {
+        return (ch >= 'A' && ch <= 'Z') ? char(ch | 0x20) : ch;
+    }
+
+    static
+    std::vector<u32> trigrams_of(std::string_view text) noexcept
+    {
+        std::vector<u32> out = {};
+        for (u64 i = 0; i + 3 <= text.size(); ++i) {
+            out.push_back(trigram_index::trigram(text[i], text[i + 1], text[i + 2]));
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        return out;
+    }
+
+    static
+    bool is_anything(clause_list const &clauses) noexcept
+    {
+        return clauses.empty() || std::any_of(clauses.begin(), clauses.end(), [](std::vector<u32> const &c) noexcept { return c.empty(); });
+    }
+
+    static
+    clause_list anything() noexcept
+    {
+        return { {} };
+    }
+
+    /// Both must hold: every clause of one combined with every clause of the other.
+    static
+    clause_list both(clause_list const &a, clause_list const &b) noexcept
+    {
+        if (is_anything(a)) return b;
+        if (is_anything(b)) return a;
+
+        if (a.size() * b.size() > trigram_query::max_clauses) {
+            //? Either alone is still implied by both, the one with fewer alternatives narrows candidates more cheaply.
+            return a.size() <= b.size() ? a : b;
+        }
+
+        clause_list out = {};
+        for (auto const &ca : a) {
+            for (auto const &cb : b) {
+                std::vector<u32> merged = {};
+                std::set_union(ca.begin(), ca.end(), cb.begin(), cb.end(), std::back_inserter(merged));
+                out.push_back(std::move(merged));
+            }
+        }
+        return out;
+    }
+
+    /// Either may hold.
+    static
+    clause_list either(clause_list const &a, clause_list const &b) noexcept
+    {
+        if (is_anything(a) || is_anything(b) || a.size() + b.size() > trigram_query::max_clauses) {
+            return anything();
+        }
+        clause_list out = a;
+        out.insert(out.end(), b.begin(), b.end());
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        return out;
+    }
+
+    /// What is known about the names a piece of the pattern matches.
+    struct regex_info
+    {
+        bool exact = true;        // always matches `literal` and nothing else
+        std::string literal = {};
+        std::string prefix = {};  // every match starts with this
+        std::string suffix = {};  // every match ends with this
+        clause_list required = anything();
+
+        clause_list all_required() const noexcept { return exact ? both(required, { trigrams_of(literal) }) : required; }
+    };
+
+    static
+    regex_info any_text() noexcept
+    {
+        regex_info info = {};
+        info.exact = false;
+        return info;
+    }
+
+    static
+    regex_info literal_text(std::string_view text) noexcept
+    {
+        regex_info info = {};
+        info.literal = text;
+        info.prefix = text;
+        info.suffix = text;
+        return info;
+    }
+
+    static
+    regex_info concatenate(regex_info const &a, regex_info const &b) noexcept
+    {
+        if (a.exact && b.exact) {
+            regex_info info = literal_text(a.literal + b.literal);
+            info.required = both(a.required, b.required);
+            return info;
+        }
+
+        regex_info info = any_text();
+        info.prefix = a.exact ? a.literal + b.prefix : a.prefix;
+        info.suffix = b.exact ? a.suffix + b.literal : b.suffix;
+        //? Where the two meet, the end of one and the start of the other are contiguous in every match.
+        info.required = both(both(a.all_required(), b.all_required()), { trigrams_of(a.suffix + b.prefix) });
+        return info;
+    }
+
+    static
+    regex_info alternate(regex_info const &a, regex_info const &b) noexcept
+    {
+        if (a.exact && b.exact && a.literal == b.literal) {
+            return a;
+        }
+
+        regex_info info = any_text();
+
+        u64 common_prefix = 0;
+        while (common_prefix < std::min(a.prefix.size(), b.prefix.size()) && a.prefix[common_prefix] == b.prefix[common_prefix]) {
+            ++common_prefix;
+        }
+        u64 common_suffix = 0;
+        while (common_suffix < std::min(a.suffix.size(), b.suffix.size())
+            && a.suffix[a.suffix.size() - 1 - common_suffix] == b.suffix[b.suffix.size() - 1 - common_suffix])
+        {
+            ++common_suffix;
+        }
+        info.prefix = a.prefix.substr(0, common_prefix);
+        info.suffix = a.suffix.substr(a.suffix.size() - common_suffix);
+        info.required = either(a.all_required(), b.all_required());
+        return info;
+    }
+
+    /// Follows the grammar of name_pattern's regex parser, only as far as what must be in a match goes.
+    struct regex_walker
+    {
+        std::string_view pattern;
+        u64 pos = 0;
+        bool case_sensitive = true;
+        bool failed = false;
+
+        bool at_end() const noexcept { return pos >= pattern.size(); }
+        char peek() const noexcept { return pattern[pos]; }
+
+        regex_info parse_alternation(u64 depth) noexcept
+        {
+            if (depth > 100) {
+                failed = true;
+                return any_text();
+            }
+            regex_info info = parse_concatenation(depth);
+            while (!failed && !at_end() && peek() == '|') {
+                ++pos;
+                info = alternate(info, parse_concatenation(depth));
+            }
+            return info;
+        }
+
+        regex_info parse_concatenation(u64 depth) noexcept
+        {
+            regex_info info = literal_text("");
+            while (!failed && !at_end() && peek() != '|' && peek() != ')') {
+                info = concatenate(info, parse_repetition(depth));
+            }
+            return info;
+        }
+
+        bool parse_number(u32 &out) noexcept
+        {
+            u64 start = pos;
+            out = 0;
+            while (!at_end() && peek() >= '0' && peek() <= '9') {
+                out = std::min(out * 10 + u32(peek() - '0'), u32(100'000));
+                ++pos;
+            }
+            return pos != start;
+        }
+
+        regex_info parse_repetition(u64 depth) noexcept
+        {
+            regex_info atom = parse_atom(depth);
+
+            while (!failed && !at_end()) {
+                u32 min = 0, max = 0;
+                char ch = peek();
+
+                if      (ch == '*') { min = 0; ++pos; }
+                else if (ch == '+') { min = 1; ++pos; }
+                else if (ch == '?') { min = 0; ++pos; }
+                else if (ch == '{') {
+                    ++pos;
+                    if (!parse_number(min)) {
+                        failed = true;
+                        break;
+                    }
+                    max = min;
+                    if (!at_end() && peek() == ',') {
+                        ++pos;
+                        max = parse_number(max) ? max : UINT32_MAX;
+                    }
+                    if (at_end() || peek() != '}') {
+                        failed = true;
+                        break;
+                    }
+                    ++pos;
+                    if (min == 1 && max == 1) {
+                        continue;
+                    }
+                }
+                else {
+                    break;
+                }
+
+                if (!at_end() && peek() == '?') {
+                    ++pos; // lazy
+                }
+
+                if (min == 0) {
+                    atom = any_text();
+                } else {
+                    //? At least one copy, so whatever one copy requires holds, and it starts and ends like one copy.
+                    regex_info repeated = any_text();
+                    repeated.prefix = atom.prefix;
+                    repeated.suffix = atom.suffix;
+                    repeated.required = atom.all_required();
+                    atom = std::move(repeated);
+                }
+            }
+            return atom;
+        }
+
+        /// One UTF-8 character as it appears in the pattern, ASCII lower cased like the index.
+        regex_info character(u64 len) noexcept
+        {
+            if (len == 0 || pos + len > pattern.size()) {
+                failed = true;
+                return any_text();
+            }
+            std::string_view text = pattern.substr(pos, len);
+            pos += len;
+
+            if (len > 1 && !case_sensitive) {
+                return any_text(); // non-ASCII letters fold in the pattern but not in the index
+            }
+            if (len == 1) {
+                char folded = fold(text[0]);
+                return literal_text({ &folded, 1 });
+            }
+            return literal_text(text);
+        }
+
+        static u64 utf8_len(u8 lead) noexcept
+        {
+            if (lead < 0x80) return 1;
+            if ((lead & 0xE0) == 0xC0) return 2;
+            if ((lead & 0xF0) == 0xE0) return 3;
+            if ((lead & 0xF8) == 0xF0) return 4;
+            return 0;
+        }
+
+        regex_info parse_atom(u64 depth) noexcept
+        {
+            char ch = peek();
+
+            switch (ch) {
+                case '(': {
+                    ++pos;
+                    if (pattern.substr(pos).starts_with("?:")) {
+                        pos += 2;
+                    }
+                    else if (!at_end() && peek() == '?') {
+                        failed = true;
+                        return any_text();
+                    }
+                    regex_info group = parse_alternation(depth + 1);
+                    if (at_end() || peek() != ')') {
+                        failed = true;
+                    } else {
+                        ++pos;
+                    }
+                    return group;
+                }
+                case '[': {
+                    //? Only skipped, a set matches one of several characters and contributes nothing.
+                    ++pos;
+                    if (!at_end() && peek() == '^') ++pos;
+                    while (!at_end() && peek() != ']') {
+                        pos += (peek() == '\\') ? 2 : 1;
+                    }
+                    if (at_end()) {
+                        failed = true;
+                    } else {
+                        ++pos;
+                    }
+                    return any_text();
+                }
+                case '.':
+                    ++pos;
+                    return any_text();
+
+                case '^':
+                case '$':
+                    ++pos;
+                    return literal_text("");
+
+                case '*': case '+': case '?': case '{': case ')':
+                    failed = true;
+                    return any_text();
+
+                case '\\': {
+                    if (pos + 1 >= pattern.size()) {
+                        failed = true;
+                        return any_text();
+                    }
+                    char escaped = pattern[pos + 1];
+                    char const *control = nullptr;
+                    switch (escaped) {
+                        case 't': control = "\t"; break;
+                        case 'n': control = "\n"; break;
+                        case 'r': control = "\r"; break;
+                        case 'f': control = "\f"; break;
+                        case 'v': control = "\v"; break;
+                        default: break;
+                    }
+                    if (control) {
+                        pos += 2;
+                        return literal_text(control);
+                    }
+                    switch (escaped | 0x20) {
+                        case 'd': case 'w': case 's': case 'b':
+                            pos += 2;
+                            return any_text();
+                        default:
+                            break;
+                    }
+                    if (escaped >= '1' && escaped <= '9') {
+                        failed = true;
+                        return any_text();
+                    }
+                    ++pos;
+                    return character(utf8_len(u8(peek())));
+                }
+                default:
+                    return character(utf8_len(u8(ch)));
+            }
+        }
+    };
+}
+
+bool trigram_query::matches_anything() const noexcept
+{
+    return trigram_index_detail::is_anything(this->clauses);
+}
+
+trigram_query trigram_query::for_substring(std::string_view needle_utf8, bool case_sensitive) noexcept
+{
+    using namespace trigram_index_detail;
+
+    trigram_query query = {};
+
+    bool has_non_ascii = std::any_of(needle_utf8.begin(), needle_utf8.end(), [](char ch) noexcept { return u8(ch) >= 0x80; });
+    if (needle_utf8.size() < 3 || (has_non_ascii && !case_sensitive)) {
+        query.clauses = anything();
+    } else {
+        query.clauses = { trigrams_of(needle_utf8) };
+    }
+    return query;
+}
+
+trigram_query trigram_query::for_regex(std::string_view pattern_utf8, bool case_sensitive) noexcept
+{
+    using namespace trigram_index_detail;
+
+    regex_walker walker = {};
+    walker.pattern = pattern_utf8;
+    walker.case_sensitive = case_sensitive;
+
+    regex_info info = walker.parse_alternation(0);
+
+    trigram_query query = {};
+    query.clauses = (walker.failed || !walker.at_end()) ? anything() : info.all_required();
+    return query;
+}
+
+u32 trigram_index::trigram(char a, char b, char c) noexcept
+{
+    using trigram_index_detail::fold;
+    return (u32(u8(fold(a))) << 16) | (u32(u8(fold(b))) << 8) | u32(u8(fold(c)));
+}
+
+void trigram_index::add(u32 id, std::string_view name_utf8) noexcept
+{
+    using trigram_index_detail::append_varint;
+
+    for (u64 i = 0; i + 3 <= name_utf8.size(); ++i) {
+        auto &list = this->lists[trigram(name_utf8[i], name_utf8[i + 1], name_utf8[i + 2])];
+
+        if (list.count != 0 && list.last_id == id) {
+            continue; // the trigram occurs again in the same name
+        }
+        append_varint(list.bytes, list.count == 0 ? id : id - list.last_id);
+        list.last_id = id;
+        ++list.count;
+        ++this->num_postings;
+    }
+    this->end_id = std::max(this->end_id, id + 1);
+}
+
+void trigram_index::shrink_to_fit() noexcept
+{
+    for (auto &[_, list] : this->lists) {
+        list.bytes.shrink_to_fit();
+    }
+}
+
+void trigram_index::clear() noexcept
+{
+    this->lists = {};
+    this->end_id = 0;
+    this->num_postings = 0;
+}
+
+u64 trigram_index::num_bytes() const noexcept
+{
+    u64 total = this->lists.bucket_count() * sizeof(void *);
+    for (auto const &[_, list] : this->lists) {
+        total += 32 + sizeof(list) + list.bytes.capacity(); // 32: a node's key, hash and link, roughly
+    }
+    return total;
+}
+
+bool trigram_index::candidates(trigram_query const &query, std::vector<u32> &out) const noexcept
+{
+    using trigram_index_detail::posting_cursor;
+
+    out.clear();
+
+    if (query.matches_anything()) {
+        return false;
+    }
+
+    std::vector<u32> clause_ids = {};
+    std::vector<u32> narrowed = {};
+    std::vector<u32> merged = {};
+    std::vector<posting_list const *> clause_lists = {};
+
+    for (auto const &clause : query.clauses) {
+        clause_lists.clear();
+        bool missing = false;
+
+        for (u32 t : clause) {
+            auto found = this->lists.find(t);
+            if (found == this->lists.end()) {
+                missing = true; // no name has it, so none satisfies the clause
+                break;
+            }
+            clause_lists.push_back(&found->second);
+        }
+        if (missing) {
+            continue;
+        }
+
+        //? Rarest first: the shortest list bounds the result, the others only ever filter it, decoded in step without materializing.
+        std::sort(clause_lists.begin(), clause_lists.end(), [](posting_list const *a, posting_list const *b) noexcept { return a->count < b->count; });
+
+        clause_ids.clear();
+        {
+            posting_cursor cursor = { clause_lists[0]->bytes.data(), clause_lists[0]->bytes.data() + clause_lists[0]->bytes.size() };
+            clause_ids.reserve(clause_lists[0]->count);
+            while (cursor.next()) clause_ids.push_back(cursor.id);
+        }
+        for (u64 l = 1; l < clause_lists.size() && !clause_ids.empty(); ++l) {
+            //? Decoding a list costs a few ns per id, verifying a candidate about a hundred. Once the candidates are far fewer than
+            //? the next list is long, verifying the few extra a longer list would filter out is cheaper than decoding it.
+            if (clause_ids.size() * 32 < clause_lists[l]->count) {
+                break;
+            }
+            posting_cursor cursor = { clause_lists[l]->bytes.data(), clause_lists[l]->bytes.data() + clause_lists[l]->bytes.size() };
+            narrowed.clear();
+            bool more = cursor.next();
+            for (u32 id : clause_ids) {
+                while (more && cursor.id < id) more = cursor.next();
+                if (!more) break;
+                if (cursor.id == id) narrowed.push_back(id);
+            }
+            clause_ids.swap(narrowed);
+        }
+
+        if (out.empty()) {
+            out.swap(clause_ids);
+        } else {
+            merged.clear();
+            std::set_union(out.begin(), out.end(), clause_ids.begin(), clause_ids.end(), std::back_inserter(merged));
+            out.swap(merged);
+        }
+    }
+    return true;
+}
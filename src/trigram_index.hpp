@@ -0,0 +1,70 @@
+#pragma once
+
+//? Trigram posting lists over names, so a substring or regex search only verifies the names which can match rather than all of them.
+
+#if defined(_WIN32)
+#   include "stdafx.hpp"
+#else
+#   include <string>
+#   include <string_view>
+#   include <unordered_map>
+#   include <vector>
+#endif
+
+#include "primitives.hpp"
+
+/// What a name must contain to possibly match, as trigrams of its bytes with ASCII letters lower cased: any one of `clauses`,
+/// each satisfied if every trigram in it is present. A clause without trigrams is satisfied by any name.
+struct trigram_query
+{
+    static constexpr u64 max_clauses = 16; // beyond this a query keeps the weaker of its parts, never more than it can prove
+
+    std::vector<std::vector<u32>> clauses = {}; // each sorted, without duplicates
+
+    /// True if every name is a candidate, e.g. for needles shorter than 3 bytes.
+    bool matches_anything() const noexcept;
+
+    /// The trigrams of `needle_utf8`. Case insensitive needles with non-ASCII characters match anything, the index only folds ASCII.
+    static trigram_query for_substring(std::string_view needle_utf8, bool case_sensitive) noexcept;
+
+    /// Trigrams every whole-name match of `pattern_utf8` (name_pattern's regex syntax) contains. Literals run together across
+    /// concatenation, alternation gives a clause per branch, anything which may repeat 0 times contributes nothing.
+    /// Patterns it can't follow match anything, candidates are verified against the compiled pattern regardless.
+    static trigram_query for_regex(std::string_view pattern_utf8, bool case_sensitive) noexcept;
+};
+
+/// Posting lists keyed by trigram: the ids of names containing it, ascending, stored as varint deltas from the previous id
+/// (typically 1 or 2 bytes per id, where plain ids take 4). Ids must be added in ascending order, which makes keeping the index
+/// current appending to it: names added later get higher ids than anything indexed, like entries appended to a filesystem_index.
+/// Names which went away are not removed, whoever verifies candidates skips them.
+///
+/// Not thread safe.
+struct trigram_index
+{
+    struct posting_list
+    {
+        std::vector<u8> bytes = {};
+        u32 last_id = 0;
+        u32 count = 0;
+    };
+
+    /// `id` must be at least `end_id`. Names shorter than 3 bytes have no trigrams and are never candidates.
+    void add(u32 id, std::string_view name_utf8) noexcept;
+
+    /// Gives back the slack lists grew with, after adding a lot of names at once.
+    void shrink_to_fit() noexcept;
+
+    void clear() noexcept;
+
+    /// Ids of names which may match, ascending. False if the query matches anything, `out` is then empty.
+    bool candidates(trigram_query const &query, std::vector<u32> &out) const noexcept;
+
+    /// Approximately, lists and the map holding them.
+    u64 num_bytes() const noexcept;
+
+    static u32 trigram(char a, char b, char c) noexcept;
+
+    std::unordered_map<u32, posting_list> lists = {};
+    u32 end_id = 0; // one past the highest id added
+    u64 num_postings = 0;
+};
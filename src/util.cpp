@@ -42,6 +42,14 @@ u64 two_u32_to_one_u64(u32 low, u32 high) noexcept
     return result;
 }
 
+FILETIME one_u64_to_filetime(u64 ticks) noexcept
+{
+    FILETIME result = {};
+    result.dwLowDateTime = static_cast<DWORD>(ticks & 0xFFFFFFFF);
+    result.dwHighDateTime = static_cast<DWORD>(ticks >> 32);
+    return result;
+}
+
 s32 directory_exists(char const *path_utf8) noexcept
 {
     wchar_t path_utf16[MAX_PATH];
@@ -63,27 +71,51 @@ void format_file_size(u64 file_size, char *out, u64 out_size, u64 unit_multiplie
 {
     assert(unit_multiplier == 1000 || unit_multiplier == 1024);
 
+    if (out_size == 0) {
+        return;
+    }
+
     char const *units[] = { "B", "KB", "MB", "GB", "TB" };
     u64 constexpr largest_unit_idx = (sizeof(units) / sizeof(*units)) - 1;
     u64 unit_idx = 0;
+    u64 divisor = 1;
 
-    f64 size = static_cast<double>(file_size);
-
-    while (size >= 1024 && unit_idx < largest_unit_idx) {
-        size /= unit_multiplier;
+    //? Same thresholds as dividing by `unit_multiplier` until below 1024, in integers: this runs for every visible
+    //? row of the explorer table and snprintf("%.2lf") was a measurable part of drawing it.
+    while (file_size >= 1024 * divisor && unit_idx < largest_unit_idx) {
+        divisor *= unit_multiplier;
         ++unit_idx;
     }
 
-    char const *const fmt =
-        unit_idx == 0
-        // no digits after decimal point for bytes
-        // because showing a fraction of a byte doesn't make sense
-        ? "%.0lf %s"
-        // 2 digits after decimal points for units above Bytes
-        // greater than bytes
-        : "%.2lf %s";
+    u64 whole = file_size / divisor;
+    u64 hundredths = ((file_size % divisor) * 100 + (divisor / 2)) / divisor; // rounded to 2 digits after the decimal point
+    if (hundredths == 100) {
+        whole += 1;
+        hundredths = 0;
+    }
+
+    char buffer[32];
+    char *end = buffer + sizeof(buffer);
+    char *p = end;
+
+    for (char const *unit = units[unit_idx] + strlen(units[unit_idx]); unit != units[unit_idx]; ) {
+        *--p = *--unit;
+    }
+    *--p = ' ';
+    // no digits after decimal point for bytes because showing a fraction of a byte doesn't make sense
+    if (unit_idx > 0) {
+        *--p = char('0' + hundredths % 10);
+        *--p = char('0' + hundredths / 10);
+        *--p = '.';
+    }
+    do {
+        *--p = char('0' + whole % 10);
+        whole /= 10;
+    } while (whole != 0);
 
-    snprintf(out, out_size, fmt, size, units[unit_idx]);
+    u64 len = std::min(u64(end - p), out_size - 1);
+    memcpy(out, p, len);
+    out[len] = '\0';
 }
 
 s64 time_diff_ms(time_point_precise_t start, time_point_precise_t end) noexcept
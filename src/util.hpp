@@ -39,6 +39,9 @@
     /// Combine 2 `u32` values into a single `u64` via bitshifting.
     u64 two_u32_to_one_u64(u32 low, u32 high) noexcept;
 
+    /// Split a `u64` of 100ns ticks back into a `FILETIME`, inverse of `two_u32_to_one_u64(ft.dwLowDateTime, ft.dwHighDateTime)`.
+    FILETIME one_u64_to_filetime(u64 ticks) noexcept;
+
     /// Seed the `fast_rand` function.
     void seed_fast_rand(u64) noexcept;
 